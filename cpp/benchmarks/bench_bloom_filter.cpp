@@ -0,0 +1,373 @@
+// bench_bloom_filter.cpp
+//
+// Throughput, latency and accuracy benchmarks for the filter library.
+// Filter sizes step from L1-resident (1K keys, ~1.2 KB) to DRAM-bound
+// (32M keys, ~40 MB), so cache effects show up as the size argument grows.
+//
+//   bench_bloom_filter --benchmark_out=current.json --benchmark_out_format=json
+//   python benchmarks/compare_baseline.py baseline.json current.json
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "binary_fuse_filter.hpp"
+#include "bloom_filter.hpp"
+#include "key_buffer.hpp"
+#include "murmur_hash3.hpp"
+#include "wyhash.hpp"
+
+using quantamental::BinaryFuseFilter;
+using quantamental::BloomFilter;
+using quantamental::KeyBuffer;
+
+namespace {
+
+// ============================================================================
+// Key Generation
+// ============================================================================
+
+constexpr size_t kKeyPool = size_t(1) << 16;   // Keys cycled through by per-key benchmarks
+constexpr size_t kKeyWidth = 24;               // Column width for KeyBuffer benchmarks
+
+// Bar-style keys "TICKER|YYYY-MM-DD"; disjoint = true draws from a ticker
+// alphabet no positive key uses, for false positive measurements
+std::vector<std::string> make_keys(size_t count, uint64_t seed, bool disjoint = false) {
+    std::mt19937_64 rng(seed);
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    const char first = disjoint ? 'a' : 'A';
+    char buffer[32];
+    for (size_t i = 0; i < count; ++i) {
+        char ticker[6] = {};
+        size_t len = 1 + rng() % 5;
+        for (size_t c = 0; c < len; ++c) ticker[c] = static_cast<char>(first + rng() % 26);
+        uint64_t day = rng() % (30 * 365);
+        std::snprintf(buffer, sizeof(buffer), "%s|%04u-%02u-%02u|%zu", ticker,
+                      static_cast<unsigned>(1995 + day / 365), static_cast<unsigned>(1 + day % 365 / 31),
+                      static_cast<unsigned>(1 + day % 31), i);
+        keys.emplace_back(buffer);
+    }
+    return keys;
+}
+
+// NumPy-style fixed-width column of the same keys
+std::vector<char> make_column(const std::vector<std::string>& keys) {
+    std::vector<char> column(keys.size() * kKeyWidth, '\0');
+    for (size_t i = 0; i < keys.size(); ++i) {
+        std::memcpy(column.data() + i * kKeyWidth, keys[i].data(), std::min(keys[i].size(), kKeyWidth));
+    }
+    return column;
+}
+
+const std::vector<std::string>& key_pool() {
+    static const std::vector<std::string> keys = make_keys(kKeyPool, 1);
+    return keys;
+}
+
+const std::vector<std::string>& absent_pool() {
+    static const std::vector<std::string> keys = make_keys(kKeyPool, 2, true);
+    return keys;
+}
+
+BloomFilter::Layout layout_arg(int64_t arg) {
+    return arg == 0 ? BloomFilter::Layout::Standard : BloomFilter::Layout::Blocked;
+}
+
+// Filter for `capacity` keys holding the first min(capacity, pool) pool keys
+BloomFilter filled_filter(size_t capacity, BloomFilter::Layout layout) {
+    BloomFilter filter(capacity, 0.01, layout);
+    const auto& keys = key_pool();
+    for (size_t i = 0; i < std::min(capacity, keys.size()); ++i) {
+        filter.insert(keys[i]);
+    }
+    return filter;
+}
+
+std::string temp_path(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+void size_counters(benchmark::State& state, const BloomFilter& filter) {
+    state.counters["filter_bytes"] = static_cast<double>(filter.size_bytes());
+    state.counters["bits_per_key"] = static_cast<double>(filter.size_bits()) / state.range(1);
+}
+
+// L1 (1K keys) through DRAM (32M keys) for both layouts
+void filter_sizes(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"layout", "capacity"});
+    b->ArgsProduct({{0, 1}, {1 << 10, 1 << 13, 1 << 16, 1 << 19, 1 << 22, 1 << 25}});
+}
+
+// ============================================================================
+// Hashing
+// ============================================================================
+
+void BM_Murmur3(benchmark::State& state) {
+    const size_t len = static_cast<size_t>(state.range(0));
+    std::string key(len, 'x');
+    uint64_t out[2];
+    for (auto _ : state) {
+        quantamental::MurmurHash3_x64_128(key.data(), static_cast<int>(len), 0, out);
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * len);
+}
+BENCHMARK(BM_Murmur3)->ArgName("len")->Arg(8)->Arg(16)->Arg(24)->Arg(64);
+
+void BM_Murmur3Multi(benchmark::State& state) {
+    constexpr size_t kKeys = 32;
+    const size_t len = static_cast<size_t>(state.range(0));
+    std::vector<std::string> keys(kKeys, std::string(len, 'x'));
+    const void* pointers[kKeys];
+    for (size_t i = 0; i < kKeys; ++i) pointers[i] = keys[i].data();
+    uint64_t out[2 * kKeys];
+    for (auto _ : state) {
+        quantamental::MurmurHash3_x64_128_multi(pointers, kKeys, static_cast<int>(len), 0, out);
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations() * kKeys);
+    state.SetBytesProcessed(state.iterations() * kKeys * len);
+    state.SetLabel(quantamental::MurmurHash3_multi_backend());
+}
+BENCHMARK(BM_Murmur3Multi)->ArgName("len")->Arg(8)->Arg(16)->Arg(24)->Arg(64);
+
+void BM_WyHash(benchmark::State& state) {
+    const size_t len = static_cast<size_t>(state.range(0));
+    std::string key(len, 'x');
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(quantamental::wy::hash(key.data(), len, 0));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * len);
+}
+BENCHMARK(BM_WyHash)->ArgName("len")->Arg(8)->Arg(16)->Arg(24)->Arg(64);
+
+// ============================================================================
+// Single-Key Operations
+// ============================================================================
+
+void BM_Insert(benchmark::State& state) {
+    BloomFilter filter(static_cast<size_t>(state.range(1)), 0.01, layout_arg(state.range(0)));
+    const auto& keys = key_pool();
+    size_t i = 0;
+    for (auto _ : state) {
+        filter.insert(keys[i++ & (kKeyPool - 1)]);
+    }
+    state.SetItemsProcessed(state.iterations());
+    size_counters(state, filter);
+}
+BENCHMARK(BM_Insert)->Apply(filter_sizes);
+
+void BM_QueryHit(benchmark::State& state) {
+    const size_t capacity = static_cast<size_t>(state.range(1));
+    BloomFilter filter = filled_filter(capacity, layout_arg(state.range(0)));
+    const auto& keys = key_pool();
+    const size_t mask = std::min(capacity, kKeyPool) - 1;
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(filter.possibly_contains(keys[i++ & mask]));
+    }
+    state.SetItemsProcessed(state.iterations());
+    size_counters(state, filter);
+}
+BENCHMARK(BM_QueryHit)->Apply(filter_sizes);
+
+void BM_QueryMiss(benchmark::State& state) {
+    BloomFilter filter = filled_filter(static_cast<size_t>(state.range(1)), layout_arg(state.range(0)));
+    const auto& keys = absent_pool();
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(filter.possibly_contains(keys[i++ & (kKeyPool - 1)]));
+    }
+    state.SetItemsProcessed(state.iterations());
+    size_counters(state, filter);
+}
+BENCHMARK(BM_QueryMiss)->Apply(filter_sizes);
+
+void BM_InsertAndCheck(benchmark::State& state) {
+    BloomFilter filter(static_cast<size_t>(state.range(1)), 0.01, layout_arg(state.range(0)));
+    const auto& keys = key_pool();
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(filter.insert_and_check(keys[i++ & (kKeyPool - 1)]));
+    }
+    state.SetItemsProcessed(state.iterations());
+    size_counters(state, filter);
+}
+BENCHMARK(BM_InsertAndCheck)->Apply(filter_sizes);
+
+// ============================================================================
+// Batch Operations
+// ============================================================================
+
+void batch_args(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"layout", "capacity", "threads"});
+    b->ArgsProduct({{0, 1}, {1 << 16, 1 << 22, 1 << 25}, {1, 0}});
+    b->UseRealTime();
+}
+
+void BM_InsertBatch(benchmark::State& state) {
+    BloomFilter filter(static_cast<size_t>(state.range(1)), 0.01, layout_arg(state.range(0)));
+    const auto& keys = key_pool();
+    const std::vector<char> column = make_column(keys);
+    const KeyBuffer buffer = KeyBuffer::fixed_width(column.data(), keys.size(), kKeyWidth);
+    for (auto _ : state) {
+        filter.insert_batch(buffer, static_cast<size_t>(state.range(2)));
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+    size_counters(state, filter);
+}
+BENCHMARK(BM_InsertBatch)->Apply(batch_args);
+
+void BM_FilterNewMask(benchmark::State& state) {
+    BloomFilter filter = filled_filter(static_cast<size_t>(state.range(1)), layout_arg(state.range(0)));
+    const auto& keys = key_pool();
+    const std::vector<char> column = make_column(keys);
+    const KeyBuffer buffer = KeyBuffer::fixed_width(column.data(), keys.size(), kKeyWidth);
+    auto is_new = std::make_unique<bool[]>(keys.size());
+    for (auto _ : state) {
+        filter.filter_new_mask(buffer, is_new.get(), static_cast<size_t>(state.range(2)));
+        benchmark::DoNotOptimize(is_new.get());
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+    size_counters(state, filter);
+}
+BENCHMARK(BM_FilterNewMask)->Apply(batch_args);
+
+// Batch over std::string keys, as the list-based Python calls use
+void BM_FilterNewVector(benchmark::State& state) {
+    BloomFilter filter = filled_filter(static_cast<size_t>(state.range(1)), layout_arg(state.range(0)));
+    const auto& keys = key_pool();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(filter.filter_new(keys));
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(BM_FilterNewVector)->ArgNames({"layout", "capacity"})
+    ->ArgsProduct({{0, 1}, {1 << 16, 1 << 22}});
+
+// Static filter over the same key pool, for comparison with BM_QueryHit
+void BM_FuseQueryHit(benchmark::State& state) {
+    const size_t capacity = static_cast<size_t>(state.range(0));
+    const std::vector<std::string> keys = make_keys(capacity, 1);
+    auto filter = BinaryFuseFilter::build(keys);
+    if (!filter) {
+        state.SkipWithError("BinaryFuseFilter construction failed");
+        return;
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(filter->possibly_contains(keys[i++ % capacity]));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["filter_bytes"] = static_cast<double>(filter->size_bytes());
+    state.counters["bits_per_key"] = filter->bits_per_key();
+}
+BENCHMARK(BM_FuseQueryHit)->ArgName("capacity")->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 22);
+
+// ============================================================================
+// Persistence
+// ============================================================================
+
+void persistence_args(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"layout", "capacity"});
+    b->ArgsProduct({{0}, {1 << 16, 1 << 22, 1 << 25}});
+    b->UseRealTime();
+}
+
+void BM_SaveToFile(benchmark::State& state) {
+    BloomFilter filter = filled_filter(static_cast<size_t>(state.range(1)), layout_arg(state.range(0)));
+    const std::string path = temp_path("bench_bloom_save.bin");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(filter.save_to_file(path));
+    }
+    state.SetBytesProcessed(state.iterations() * filter.size_bytes());
+    std::filesystem::remove(path);
+}
+BENCHMARK(BM_SaveToFile)->Apply(persistence_args);
+
+void BM_LoadFromFile(benchmark::State& state) {
+    BloomFilter filter = filled_filter(static_cast<size_t>(state.range(1)), layout_arg(state.range(0)));
+    const std::string path = temp_path("bench_bloom_load.bin");
+    filter.save_to_file(path);
+    for (auto _ : state) {
+        auto loaded = BloomFilter::load_from_file(path);
+        if (!loaded) {
+            state.SkipWithError("load_from_file failed");
+            break;
+        }
+        benchmark::DoNotOptimize(loaded);
+    }
+    state.SetBytesProcessed(state.iterations() * filter.size_bytes());
+    std::filesystem::remove(path);
+}
+BENCHMARK(BM_LoadFromFile)->Apply(persistence_args);
+
+// Mapping without verify is O(1); the cost is paid by the first queries
+void BM_OpenMapped(benchmark::State& state) {
+    BloomFilter filter = filled_filter(static_cast<size_t>(state.range(1)), layout_arg(state.range(0)));
+    const std::string path = temp_path("bench_bloom_mapped.bin");
+    filter.save_to_file(path);
+    for (auto _ : state) {
+        auto mapped = BloomFilter::open_mapped(path);
+        if (!mapped) {
+            state.SkipWithError("open_mapped failed");
+            break;
+        }
+        benchmark::DoNotOptimize(mapped);
+    }
+    std::filesystem::remove(path);
+}
+BENCHMARK(BM_OpenMapped)->Apply(persistence_args);
+
+// ============================================================================
+// Accuracy
+// ============================================================================
+
+// Fills a filter to its design capacity and counts false positives over
+// 1M absent keys. Reports the achieved rate next to the target and the
+// model's prediction for the filter's actual m, n and k.
+void BM_FalsePositiveRate(benchmark::State& state) {
+    constexpr size_t kInserted = size_t(1) << 18;
+    constexpr size_t kProbes = size_t(1) << 20;
+    const BloomFilter::Layout layout = layout_arg(state.range(0));
+    const double target = 1.0 / static_cast<double>(state.range(1));
+
+    const std::vector<std::string> inserted = make_keys(kInserted, 3);
+    const std::vector<std::string> absent = make_keys(kProbes, 4, true);
+
+    double achieved = 0.0;
+    BloomFilter filter(kInserted, target, layout);
+    for (auto _ : state) {
+        filter.clear();
+        filter.insert_batch(inserted);
+        size_t false_positives = kProbes - filter.filter_new(absent).size();
+        achieved = static_cast<double>(false_positives) / kProbes;
+    }
+
+    const double theoretical = layout == BloomFilter::Layout::Blocked
+        ? BloomFilter::blocked_false_positive_rate(filter.size_bits(), kInserted, filter.num_hashes())
+        : BloomFilter::false_positive_rate(filter.size_bits(), kInserted, filter.num_hashes());
+    state.counters["target_fpr"] = target;
+    state.counters["theoretical_fpr"] = theoretical;
+    state.counters["achieved_fpr"] = achieved;
+    state.counters["achieved_over_theoretical"] = theoretical > 0.0 ? achieved / theoretical : 0.0;
+    state.counters["bits_per_key"] = static_cast<double>(filter.size_bits()) / kInserted;
+}
+BENCHMARK(BM_FalsePositiveRate)->ArgNames({"layout", "one_in"})
+    ->ArgsProduct({{0, 1}, {10, 100, 1000, 10000}})
+    ->Iterations(1)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,123 @@
+"""
+Compare a Google Benchmark JSON run against a stored baseline.
+
+Usage:
+    bench_bloom_filter --benchmark_out=current.json --benchmark_out_format=json
+    python benchmarks/compare_baseline.py baseline.json current.json --threshold 0.10
+
+Benchmarks are matched by name. With --benchmark_repetitions the median
+aggregate is compared; otherwise the single run. A benchmark regresses when
+its time per iteration grows by more than the threshold, or when its
+achieved_fpr counter grows by more than the threshold. Exits with status 1
+if anything regressed, so CI can gate on it.
+"""
+
+import argparse
+import json
+import sys
+from pathlib import Path
+from typing import Dict, List, Tuple
+
+# Time units Google Benchmark may report, in nanoseconds
+_TIME_UNITS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load_runs(path: Path) -> Dict[str, dict]:
+    """
+    Load benchmark entries keyed by name, preferring median aggregates.
+
+    Args:
+        path: Google Benchmark JSON output file
+
+    Returns:
+        Dict[str, dict]: Benchmark name -> entry
+    """
+    with open(path) as f:
+        data = json.load(f)
+
+    runs: Dict[str, dict] = {}
+    medians: Dict[str, dict] = {}
+    for entry in data.get("benchmarks", []):
+        if entry.get("error_occurred"):
+            continue
+        name = entry.get("run_name", entry["name"])
+        if entry.get("run_type") == "aggregate":
+            if entry.get("aggregate_name") == "median":
+                medians[name] = entry
+        else:
+            runs.setdefault(name, entry)
+    runs.update(medians)
+    return runs
+
+
+def time_ns(entry: dict) -> float:
+    """Real time per iteration in nanoseconds."""
+    return entry["real_time"] * _TIME_UNITS[entry.get("time_unit", "ns")]
+
+
+def compare(baseline: Dict[str, dict], current: Dict[str, dict],
+            threshold: float) -> Tuple[List[str], List[str]]:
+    """
+    Compare matching benchmarks.
+
+    Args:
+        baseline: Entries of the baseline run
+        current: Entries of the current run
+        threshold: Allowed relative growth (0.10 = 10%)
+
+    Returns:
+        Tuple[List[str], List[str]]: Report lines, and names that regressed
+    """
+    lines = [f"{'benchmark':<60} {'baseline':>12} {'current':>12} {'change':>8}"]
+    regressions = []
+
+    for name in sorted(baseline.keys() & current.keys()):
+        base, cur = baseline[name], current[name]
+
+        base_time, cur_time = time_ns(base), time_ns(cur)
+        change = cur_time / base_time - 1.0 if base_time > 0 else 0.0
+        flag = ""
+        if change > threshold:
+            flag = "  REGRESSION"
+            regressions.append(name)
+        lines.append(f"{name:<60} {base_time:>10.1f}ns {cur_time:>10.1f}ns {change:>+7.1%}{flag}")
+
+        if "achieved_fpr" in base and "achieved_fpr" in cur:
+            base_fpr, cur_fpr = base["achieved_fpr"], cur["achieved_fpr"]
+            fpr_change = cur_fpr / base_fpr - 1.0 if base_fpr > 0 else 0.0
+            flag = ""
+            if fpr_change > threshold:
+                flag = "  REGRESSION"
+                regressions.append(f"{name} (fpr)")
+            lines.append(f"{'  achieved_fpr':<60} {base_fpr:>12.6f} {cur_fpr:>12.6f} {fpr_change:>+7.1%}{flag}")
+
+    for name in sorted(baseline.keys() - current.keys()):
+        lines.append(f"{name:<60} missing from current run")
+    for name in sorted(current.keys() - baseline.keys()):
+        lines.append(f"{name:<60} new (no baseline)")
+
+    return lines, regressions
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Compare benchmark JSON against a baseline")
+    parser.add_argument("baseline", type=Path, help="Stored baseline JSON")
+    parser.add_argument("current", type=Path, help="JSON of the run to check")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="Allowed relative slowdown / FPR growth (default 0.10)")
+    args = parser.parse_args()
+
+    lines, regressions = compare(load_runs(args.baseline), load_runs(args.current), args.threshold)
+    print("\n".join(lines))
+
+    if regressions:
+        print(f"\n{len(regressions)} regression(s) above {args.threshold:.0%}:")
+        for name in regressions:
+            print(f"  {name}")
+        return 1
+    print(f"\nNo regressions above {args.threshold:.0%}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,139 @@
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#ifndef BACKTESTER_HPP
+#define BACKTESTER_HPP
+
+namespace quantamental {
+
+// How a date's scores become portfolio weights
+enum class Weighting : uint32_t {
+    TopBottom = 0,   // Equal weights on the top_k names (long) and bottom_k (short)
+    Rank = 1,        // Proportional to the demeaned cross-sectional rank
+    VolScaled = 2    // Top / bottom top_k, each side weighted by 1 / volatility
+};
+
+struct BacktestConfig {
+    Weighting weighting = Weighting::TopBottom;
+    size_t top_k = 50;              // Names per side (TopBottom, VolScaled)
+    bool long_only = false;         // Only the long side, at the full gross exposure
+    double gross_exposure = 1.0;    // Sum of |weights| of the target portfolio
+    double cost_bps = 5.0;          // Charged on traded notional, one-way
+    double max_turnover = 0.0;      // Cap on sum |trade| per rebalance; 0 = none
+};
+
+struct BacktestSummary {
+    double total_return = 0.0;      // Compounded net return over the run
+    double annual_return = 0.0;     // Geometric, kPeriodsPerYear dates a year
+    double annual_volatility = 0.0;
+    double sharpe = 0.0;            // Mean / std of net returns, annualized
+    double max_drawdown = 0.0;      // Deepest drawdown, <= 0
+    double hit_rate = 0.0;          // Share of invested dates with a positive net return
+    double mean_turnover = 0.0;
+    double total_cost = 0.0;        // Sum of daily costs
+    double mean_ic = 0.0;           // Of the scores, the same for every config
+    double ic_ir = 0.0;             // mean / std of the daily IC
+    double mean_rank_ic = 0.0;
+    double rank_ic_ir = 0.0;
+};
+
+// Daily-rebalanced cross-sectional backtest of model scores over a dates x
+// tickers panel (element (d, j) at [d * num_tickers + j], the layout of
+// LabelBuilder). On date d the scores become target weights, the book trades
+// from its drifted weights toward them (at most max_turnover), pays cost_bps
+// on what it traded and earns returns[d], each ticker's return from d to the
+// next rebalance (e.g. fwd_return_1d). A NaN score keeps a ticker out of the
+// book that date; a NaN return counts as 0.
+//
+// Everything that does not depend on the config is done once in create():
+// each date's tickers sorted by score, tie-averaged ranks, and the daily IC
+// and rank IC against ic_target. A run is then a linear pass over the panel
+// in preallocated per-thread buffers, and sweep() spreads configs across
+// threads, so parameter grids cost little more than one run each.
+class Backtester {
+
+public:
+    static constexpr double kPeriodsPerYear = 252.0;
+
+    // Series of a run, each num_dates long, in this order
+    enum Series : size_t {
+        NetReturn = 0,
+        GrossReturn = 1,
+        Turnover = 2,
+        Drawdown = 3,
+        kNumSeries = 4
+    };
+
+    // Copies the panels. volatility (e.g. trailing daily vol known on d) is
+    // only needed for VolScaled; ic_target defaults to returns (pass a
+    // horizon's forward returns to score that horizon). nullopt without
+    // dates or tickers. num_threads == 0 sizes the buffers for the pool.
+    static std::optional<Backtester> create(const double* scores, const double* returns,
+                                            const double* volatility, const double* ic_target,
+                                            size_t num_dates, size_t num_tickers,
+                                            size_t num_threads = 0);
+
+    // Whether run() / sweep() accept the config: top_k > 0 for the top / bottom
+    // schemes, volatility present for VolScaled, gross_exposure > 0 and
+    // cost_bps, max_turnover >= 0
+    bool accepts(const BacktestConfig& config) const;
+
+    // One config; series (nullable) receives kNumSeries x num_dates values.
+    // False if the config is not accepted. Calls from several threads take
+    // turns, as every run() and sweep() shares the per-thread buffers.
+    bool run(const BacktestConfig& config, BacktestSummary& summary, double* series = nullptr);
+
+    // run() over every config, split across threads. series (nullable)
+    // receives num_configs x kNumSeries x num_dates values. False, before
+    // running anything, if any config is not accepted.
+    bool sweep(const BacktestConfig* configs, size_t num_configs, BacktestSummary* summaries,
+               double* series = nullptr);
+
+    static const std::vector<std::string>& series_names();
+    size_t num_dates() const;
+    size_t num_tickers() const;
+    size_t num_threads() const;
+    bool has_volatility() const;
+    const std::vector<double>& ic() const;        // Daily Pearson IC, NaN below 3 pairs
+    const std::vector<double>& rank_ic() const;   // Daily Spearman IC
+
+private:
+    // Per-thread buffers, reused by every run on that thread
+    struct Workspace {
+        std::vector<double> weights;   // Held, drifted through each date's returns
+        std::vector<double> target;
+        std::vector<uint32_t> picked;  // Tickers with a target weight on the date
+    };
+
+    Backtester(size_t num_dates, size_t num_tickers, size_t num_threads);
+
+    void prepare(const double* scores, const double* ic_target);
+    void run_one(Workspace& workspace, const BacktestConfig& config, BacktestSummary& summary,
+                 double* series) const;
+    void fill_target(Workspace& workspace, const BacktestConfig& config, size_t date) const;
+
+    size_t num_dates_;
+    size_t num_tickers_;
+    size_t num_threads_;
+    std::vector<double> returns_;
+    std::vector<double> volatility_;     // Empty without a volatility panel
+    std::vector<uint32_t> order_;        // Per date: scored tickers, best first
+    std::vector<double> ranks_;          // Per date: tie-averaged rank (1 = worst) by position in order_
+    std::vector<uint32_t> num_scored_;   // Per date: length of its prefix of order_
+    std::vector<double> ic_;
+    std::vector<double> rank_ic_;
+    double mean_ic_ = 0.0;
+    double ic_ir_ = 0.0;
+    double mean_rank_ic_ = 0.0;
+    double rank_ic_ir_ = 0.0;
+    std::vector<Workspace> workspaces_;
+    std::unique_ptr<std::mutex> run_mutex_ = std::make_unique<std::mutex>();  // Held over run() / sweep()
+};
+
+}
+#endif
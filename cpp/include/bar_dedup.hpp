@@ -0,0 +1,76 @@
+#include <cstddef>
+#include <cstdint>
+
+#include "bloom_filter.hpp"
+
+#ifndef BAR_DEDUP_HPP
+#define BAR_DEDUP_HPP
+
+namespace quantamental {
+
+// A batch of bars as parallel columns: row i is ticker_ids[i] at
+// timestamps[i], with num_values numbers (e.g. OHLCV) at values + i *
+// num_values. revisions is optional: a vendor sequence number that tells a
+// corrected bar apart from a resend of one already ingested.
+struct BarBatch {
+    const uint32_t* ticker_ids = nullptr;
+    const int64_t* timestamps = nullptr;
+    const int64_t* revisions = nullptr;   // Null: no revision field
+    const double* values = nullptr;
+    size_t num_values = 0;
+    size_t size = 0;
+};
+
+// Destination of the kept rows, same layout as BarBatch
+struct BarColumns {
+    uint32_t* ticker_ids = nullptr;
+    int64_t* timestamps = nullptr;
+    int64_t* revisions = nullptr;         // Only written when the batch has revisions
+    double* values = nullptr;
+};
+
+// Bar ingest dedup on binary keys. Each row is hashed as its packed ticker
+// id and timestamp (12 bytes), plus the revision (20 bytes) when the batch
+// has one, straight into a Bloom filter: no key strings are built. Rows are
+// classified in order, so repeats within one batch count too:
+//   New        (ticker, timestamp) never seen
+//   Revised    seen, but not with this revision: a correction to keep
+//   Duplicate  (ticker, timestamp, revision) seen, or (ticker, timestamp)
+//              seen when there is no revision field
+// As with any Bloom filter, a false positive can drop a new bar (at the
+// filter's FPR); duplicates are never kept.
+class BarDeduplicator {
+
+public:
+    enum class Status : uint8_t {
+        Duplicate = 0,
+        New = 1,
+        Revised = 2
+    };
+
+    // Every bar takes one key, and every bar with a revision one more; size
+    // expected_keys for both. Keys are hashed with wyhash, which is cheaper
+    // than MurmurHash3 on keys this short.
+    explicit BarDeduplicator(size_t expected_keys, double false_positive_rate = 0.01,
+                             BloomFilter::Layout layout = BloomFilter::Layout::Blocked);
+    explicit BarDeduplicator(BloomFilter filter);   // e.g. a saved filter to resume from
+
+    // Classifies and records every row; returns the number kept (not
+    // Duplicate). status holds batch.size entries.
+    size_t classify(const BarBatch& batch, Status* status);
+
+    // Copies the kept rows of a classified batch to out, in order
+    static size_t compact(const BarBatch& batch, const Status* status, const BarColumns& out);
+
+    // classify() then compact() into columns with room for batch.size rows
+    size_t ingest(const BarBatch& batch, Status* status, const BarColumns& out);
+
+    const BloomFilter& filter() const;
+    BloomFilter& filter();
+
+private:
+    BloomFilter filter_;
+};
+
+}
+#endif
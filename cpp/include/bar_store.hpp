@@ -0,0 +1,120 @@
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifndef BAR_STORE_HPP
+#define BAR_STORE_HPP
+
+namespace quantamental {
+
+namespace detail {
+    struct BarStoreMapping;
+    struct BarStoreLock;
+}
+
+// Columnar OHLCV store in one memory-mapped file: a shared ascending date
+// index, a ticker directory, and for every field and ticker one contiguous
+// column of doubles over the dates (NaN where the ticker has no bar).
+// Opening maps the file and reads nothing, so a query costs the page-ins of
+// the columns it touches and columns are handed out as pointers into the
+// mapping. Columns are preallocated to date_capacity rows, so appending a
+// day writes its row in place; only running out of capacity rewrites the
+// file, at twice the size, into a new mapping (old columns stay valid as long
+// as a mapping() reference is held). One writer at a time: a writable store
+// holds an flock on filepath + ".lock" until it is destroyed.
+class BarStore {
+
+public:
+    enum class Field : uint32_t {
+        Open = 0,
+        High = 1,
+        Low = 2,
+        Close = 3,
+        Volume = 4
+    };
+    static constexpr size_t kNumFields = 5;
+    static constexpr size_t kMaxTickerLength = 31;
+    static constexpr size_t kMaxTimezoneLength = 63;
+
+    // Creates (or overwrites) an empty store; nullopt on an I/O error, while
+    // another writer holds the lock, or for a ticker that is empty, longer
+    // than kMaxTickerLength or repeated. timezone is recorded for readers
+    // (e.g. "America/New_York"; empty for naive dates) and not interpreted.
+    static std::optional<BarStore> create(const std::string& filepath,
+                                          const std::vector<std::string>& tickers,
+                                          size_t date_capacity = 4096,
+                                          const std::string& timezone = "");
+    // writable maps the file shared for append / add_ticker; nullopt if the
+    // file is not a valid store or, when writable, another writer holds the lock
+    static std::optional<BarStore> open(const std::string& filepath, bool writable = false);
+
+    BarStore(BarStore&& other) noexcept;
+    BarStore& operator=(BarStore&& other) noexcept;
+    ~BarStore();
+
+    // num_dates() is read from the mapped header, so a reader sees the
+    // dates another process appends in place
+    size_t num_dates() const;
+    const int64_t* dates() const;   // num_dates() ascending timestamps
+    size_t num_tickers() const;
+    const std::vector<std::string>& tickers() const;
+    std::optional<size_t> find_ticker(const std::string& ticker) const;
+    const std::string& timezone() const;   // As given to create()
+
+    // Rows [begin, end) whose dates lie in [first, last]
+    std::pair<size_t, size_t> date_rows(int64_t first, int64_t last) const;
+
+    // One ticker's values for rows [0, num_dates()); consecutive tickers'
+    // columns of a field are column_stride() doubles apart
+    const double* column(Field field, size_t ticker) const;
+    size_t column_stride() const;
+
+    // Keeps the current mapping alive, e.g. under NumPy views of it
+    std::shared_ptr<const void> mapping() const;
+
+    bool writable() const;
+
+    // Catches up with changes num_dates() does not show: remaps the file
+    // if the writer replaced it (create, or grow when out of capacity) and
+    // re-reads the tickers it added. Old columns stay valid while a
+    // mapping() reference holds them. false if the file cannot be mapped.
+    bool refresh();
+
+    // New ticker with NaN for every date so far; nullopt if read-only or the
+    // name is invalid or taken
+    std::optional<size_t> add_ticker(const std::string& ticker);
+
+    // Appends n dates, which must increase strictly past the last one.
+    // values holds n rows of kNumFields x num_tickers() doubles (field-major,
+    // NaN = no bar). Returns false, appending nothing, on a bad date or I/O
+    // error, or when read-only.
+    bool append(const int64_t* dates, size_t n, const double* values);
+
+    // Syncs the mapping to disk
+    bool flush();
+
+private:
+    BarStore(std::string filepath, std::shared_ptr<detail::BarStoreMapping> mapping,
+             std::unique_ptr<detail::BarStoreLock> lock);   // Writable with a lock
+
+    bool read_directory();   // false on an invalid or repeated name
+    bool grow(size_t date_capacity, size_t ticker_capacity);
+    double* mutable_column(Field field, size_t ticker);
+
+    std::string filepath_;
+    std::shared_ptr<detail::BarStoreMapping> mapping_;
+    std::unique_ptr<detail::BarStoreLock> lock_;
+    bool writable_;
+    uint64_t generation_;                 // Of the mapped file when it was mapped
+    std::string timezone_;
+    std::vector<std::string> tickers_;
+    std::unordered_map<std::string, size_t> ticker_index_;
+};
+
+}
+#endif
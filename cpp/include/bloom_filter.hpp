@@ -1,15 +1,27 @@
 #include <cstddef>
 #include <cstdint>
+#include <iosfwd>
 #include <string_view>
 #include <vector>
 #include <optional>
 #include <memory>
 
+#include "filter_metrics.hpp"
+#include "key_buffer.hpp"
+
 #ifndef BLOOM_FILTER_HPP
 #define BLOOM_FILTER_HPP
 
 namespace quantamental {
 
+namespace detail {
+struct KeyHash;
+struct ProbeSequence;
+struct BlockProbe;
+struct BloomFileHeader;
+enum class WordOp;
+}
+
 class BloomFilter {
 
 public:
@@ -21,11 +33,47 @@ public:
         uint32_t num_hash_functions;
         double fill_ratio;
         double estimated_fpr;
+        FilterMetrics::Snapshot metrics{};    // Since construction or reset_metrics()
+        double observed_positive_rate = 0.0;  // positives / queries in metrics
+    };
+
+    // Standard scatters the k probes over the whole bit array.
+    // Blocked hashes each key to one 64-byte block and sets all k bits in it,
+    // so a query touches a single cache line at a slightly higher FPR.
+    enum class Layout : uint32_t {
+        Standard = 0,
+        Blocked = 1
+    };
+
+    // How probe positions are derived. DoubleHashing hashes each key once
+    // with MurmurHash3; WyHash does the same with the cheaper wyhash. Seeded
+    // runs MurmurHash3 once per probe and only survives for filters loaded
+    // from headerless files, which predate the file header.
+    enum class HashScheme : uint32_t {
+        Seeded = 0,
+        DoubleHashing = 1,
+        WyHash = 2
+    };
+
+    // How open_mapped() maps the file. ReadOnly faults on any write,
+    // CopyOnWrite keeps writes private to this process, and Shared writes
+    // through to the file (flush() then persists counters and checksum).
+    enum class MapMode : uint32_t {
+        ReadOnly = 0,
+        CopyOnWrite = 1,
+        Shared = 2
     };
 
+    static constexpr size_t kBlockBits = 512;   // One cache line
+    static constexpr size_t kBlockWords = kBlockBits / 64;
+
     // Constructors
-    BloomFilter(size_t expected_elements, double false_positive_rate = 0.01);
-    BloomFilter(size_t num_bits, uint32_t num_hashes);  // For testing
+    BloomFilter(size_t expected_elements, double false_positive_rate = 0.01,
+                Layout layout = Layout::Standard,
+                HashScheme hash_scheme = HashScheme::DoubleHashing);
+    BloomFilter(size_t num_bits, uint32_t num_hashes,
+                Layout layout = Layout::Standard,
+                HashScheme hash_scheme = HashScheme::DoubleHashing);  // For testing
 
     // Core operations
     void insert(std::string_view key);
@@ -36,6 +84,33 @@ public:
     void insert_batch(const std::vector<std::string>& keys);
     std::vector<size_t> filter_new(const std::vector<std::string>& keys) const;
 
+    // insert_and_check() on each key in order (a repeat within the batch is
+    // not new), with the probes of a block of keys prefetched together
+    void insert_and_check_batch(const std::string_view* keys, size_t count, bool* is_new);
+
+    // Zero-copy batch operations over a packed key column. Large batches are
+    // split across ThreadPool::shared(); num_threads == 0 uses all of it.
+    void insert_batch(const KeyBuffer& keys, size_t num_threads = 0);
+    void filter_new_mask(const KeyBuffer& keys, bool* is_new, size_t num_threads = 0) const;
+
+    // Merging. Filters with the same size, probe count, layout and hash
+    // scheme map every key to the same bits, so per-worker filters combine
+    // word by word. Returns false and leaves this filter untouched when the
+    // other one is incompatible (or this one is a ReadOnly mapping).
+    // num_insertions() is re-estimated from the set bits afterwards.
+    bool compatible_with(const BloomFilter& other) const;
+    bool merge_union(const BloomFilter& other, size_t num_threads = 0);
+    bool merge_intersection(const BloomFilter& other, size_t num_threads = 0);  // Superset of the true intersection
+
+    // Map-reduce build: each thread fills a private filter from its share of
+    // the keys without atomics, then the filters are OR-ed together. Needs
+    // one filter's memory per thread while it runs.
+    static BloomFilter build_parallel(const KeyBuffer& keys, size_t expected_elements,
+                                      double false_positive_rate = 0.01,
+                                      Layout layout = Layout::Standard,
+                                      HashScheme hash_scheme = HashScheme::DoubleHashing,
+                                      size_t num_threads = 0);
+
     // Statistics
     BloomFilterStats get_stats() const;
     double fill_ratio() const;
@@ -43,30 +118,100 @@ public:
     size_t size_bits() const;
     size_t size_bytes() const;
     uint64_t num_insertions() const;
+    uint32_t num_hashes() const;
+    Layout layout() const;
+    HashScheme hash_scheme() const;
+
+    // Instrumentation. bits_set is kept up to date by every insert, so
+    // get_stats() is O(1) apart from the first call on a loaded filter.
+    // Querying keys known to be absent makes observed_positive_rate the
+    // measured FPR, to hold against estimated_fpr.
+    void reset_metrics();
+    void set_latency_sampling(uint32_t sample_every);  // Time 1 in N single-key calls; 0 = off
 
     // Persistence
     bool save_to_file(const std::string& filepath) const;
     static std::optional<BloomFilter> load_from_file(const std::string& filepath);
     void clear();
 
+    // Same format written into / read from the current stream position, so
+    // filters can be embedded in a larger file
+    bool save_to_stream(std::ostream& out) const;
+    static std::optional<BloomFilter> load_from_stream(std::istream& in);
+
+    // Maps a saved file in place instead of reading it, so processes start
+    // without copying and ReadOnly/Shared mappings share one physical copy.
+    // The checksum is only checked up front when verify is set.
+    static std::optional<BloomFilter> open_mapped(const std::string& filepath,
+                                                  MapMode mode = MapMode::ReadOnly,
+                                                  bool verify = false);
+    bool flush();                                         // Shared mappings only
+    bool verify_checksum(size_t num_threads = 0) const;   // Against the loaded file
+    bool is_mapped() const;
+    bool writable() const;
+
     // Static utilities
     static size_t optimal_num_bits(size_t n, double p);
     static uint32_t optimal_num_hashes(size_t m, size_t n);
+    static double false_positive_rate(size_t m, size_t n, uint32_t k,
+                                      Layout layout = Layout::Standard);
+    static double estimate_insertions(size_t m, uint64_t bits_set, uint32_t k);  // From the fill
+
+    // Blocked layout sizing: FPR of a blocked filter with m bits, n keys and
+    // k probes per block, and the smallest block-multiple m that reaches p.
+    static double blocked_false_positive_rate(size_t m, size_t n, uint32_t k);
+    static size_t optimal_num_bits_blocked(size_t n, double p);
 
 private:
-    std::unique_ptr<uint64_t[]> bit_array_;  // Bit storage
+    // Frees the 64-byte aligned word array, or unmaps the file it lives in.
+    // A value-initialized deleter (no mapping) owns a heap array.
+    struct WordArrayDeleter {
+        void* mapping;
+        size_t mapping_size;
+        void operator()(uint64_t* words) const;
+    };
+
+    struct InsertCount {
+        uint64_t new_bits = 0;
+        uint64_t new_keys = 0;   // Keys that set at least one new bit
+    };
+
+    explicit BloomFilter(const detail::BloomFileHeader& header);  // No bit storage yet
+
+    std::unique_ptr<uint64_t[], WordArrayDeleter> bit_array_;  // Bit storage
     size_t num_bits_;                         // Total bits (m)
     size_t num_words_;                        // Number of 64-bit words
     uint32_t num_hashes_;                     // Hash functions (k)
+    Layout layout_;                           // Probe layout
+    HashScheme hash_scheme_;                  // Probe derivation
     uint64_t num_insertions_;                 // Counter
     mutable uint64_t num_queries_;                    // Counter
+    mutable uint64_t bits_set_;               // Set bits, maintained by inserts
+    mutable bool bits_set_known_;             // False until a loaded array is counted
+    std::unique_ptr<FilterMetrics> metrics_;  // Boxed so the filter stays movable
+    uint64_t stored_checksum_;                // Checksum of the file loaded from (0 = none)
+    std::optional<MapMode> map_mode_;         // Set when memory-mapped
 
     // Private methods
-    std::vector<size_t> compute_hashes(const void* data, size_t len) const;
+    void allocate_bits();
+    size_t seeded_index(std::string_view key, uint32_t i) const;
+    uint32_t set_key(std::string_view key);      // Returns the number of new bits
+    bool test_key(std::string_view key) const;
+    uint32_t set_probes(detail::ProbeSequence probes);
+    bool test_probes(detail::ProbeSequence probes) const;
+    uint32_t set_block(const detail::BlockProbe& probe);
+    bool test_block(const detail::BlockProbe& probe) const;
+    template <bool Shared, typename KeyAt>
+    InsertCount insert_range(size_t begin, size_t end, KeyAt&& key_at, bool* is_new = nullptr);
+    void add_inserted(const InsertCount& count);
+    bool merge(const BloomFilter& other, detail::WordOp op, size_t num_threads);
+    uint64_t bits_set() const;
+    template <typename KeyAt>
+    size_t filter_range(size_t begin, size_t end, KeyAt&& key_at, bool* is_new) const;
     void set_bit(size_t index);
     bool test_bit(size_t index) const;
     uint64_t count_set_bits() const;
 };
 
 }
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,131 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include <memory>
+
+#include "bloom_filter.hpp"
+
+#ifndef CONCURRENT_BLOOM_FILTER_HPP
+#define CONCURRENT_BLOOM_FILTER_HPP
+
+namespace quantamental {
+
+// Bloom filter that many threads may insert into and query at once.
+// Bits are set with atomic fetch-or, so insert() never blocks. Concurrent
+// insert_and_check() calls on the same key serialize on a striped spinlock
+// chosen by the key hash, so exactly one of them reports the key as new.
+// Counters and FilterMetrics are sharded per thread on separate cache
+// lines. Sizing, probe derivation and the file format are shared with
+// BloomFilter. Every insert that sets a new bit marks the bit's 64-byte
+// block dirty, so a FilterCheckpointer can persist just the blocks changed
+// since its last checkpoint while inserts continue.
+class ConcurrentBloomFilter {
+
+public:
+    using Layout = BloomFilter::Layout;
+    using BloomFilterStats = BloomFilter::BloomFilterStats;
+
+    // Constructors
+    ConcurrentBloomFilter(size_t expected_elements, double false_positive_rate = 0.01,
+                          Layout layout = Layout::Standard);
+    ConcurrentBloomFilter(size_t num_bits, uint32_t num_hashes,
+                          Layout layout = Layout::Standard);  // For testing
+
+    ConcurrentBloomFilter(const ConcurrentBloomFilter&) = delete;
+    ConcurrentBloomFilter& operator=(const ConcurrentBloomFilter&) = delete;
+
+    // Core operations (thread-safe)
+    void insert(std::string_view key);
+    bool possibly_contains(std::string_view key) const;
+    bool insert_and_check(std::string_view key);  // Linearizable per key
+
+    // Batch operations (thread-safe)
+    void insert_batch(const std::vector<std::string>& keys);
+    std::vector<size_t> filter_new(const std::vector<std::string>& keys) const;
+    void insert_batch(const KeyBuffer& keys, size_t num_threads = 0);
+    void filter_new_mask(const KeyBuffer& keys, bool* is_new, size_t num_threads = 0) const;
+
+    // Statistics
+    BloomFilterStats get_stats() const;
+    double fill_ratio() const;
+    double estimated_false_positive_rate() const;
+    size_t size_bits() const;
+    size_t size_bytes() const;
+    uint64_t num_insertions() const;
+    Layout layout() const;
+
+    // Instrumentation, as on BloomFilter; metrics start empty on load
+    void reset_metrics();
+    void set_latency_sampling(uint32_t sample_every);  // Time 1 in N single-key calls; 0 = off
+
+    // Persistence. Saving while other threads insert writes a snapshot that
+    // holds at least every insert completed before the call.
+    bool save_to_file(const std::string& filepath) const;
+    static std::unique_ptr<ConcurrentBloomFilter> load_from_file(const std::string& filepath);
+    void clear();  // Not safe to race with inserts
+
+private:
+    friend class FilterCheckpointer;
+
+    static constexpr size_t kCounterShards = 64;
+    static constexpr size_t kKeyLockStripes = 1024;
+    static constexpr size_t kDirtyBlockWords = BloomFilter::kBlockWords;  // One mark per cache line
+
+    // One cache line per shard so counting threads never share a line
+    struct alignas(64) CounterShard {
+        std::atomic<uint64_t> insertions{0};
+        std::atomic<uint64_t> queries{0};
+    };
+
+    struct alignas(64) KeyLock {
+        std::atomic<bool> locked{false};
+    };
+
+    // Marks for 64 blocks, one cache line each: writers marking blocks
+    // under different words never contend for a line
+    struct alignas(64) DirtyMarks {
+        std::atomic<uint64_t> bits{0};
+    };
+
+    struct WordArrayDeleter {
+        void operator()(uint64_t* words) const;
+    };
+
+    std::unique_ptr<uint64_t[], WordArrayDeleter> bit_array_;  // Accessed via atomic_ref
+    size_t num_bits_;
+    size_t num_words_;
+    uint32_t num_hashes_;
+    Layout layout_;
+    BloomFilter::HashScheme hash_scheme_;
+    std::unique_ptr<CounterShard[]> counters_;
+    std::unique_ptr<KeyLock[]> key_locks_;
+    size_t num_dirty_blocks_;
+    std::unique_ptr<DirtyMarks[]> dirty_blocks_;              // One bit per block
+    std::atomic<uint64_t> clear_count_{0};                   // Bumped by clear()
+    mutable FilterMetrics metrics_;                          // Counted by queries too
+
+    // Private methods
+    void allocate_bits();
+    CounterShard& local_counters() const;
+    template <typename KeyAt>
+    uint64_t insert_range(size_t begin, size_t end, KeyAt&& key_at);  // Returns the new keys
+    bool set_key(std::string_view key);          // Returns true if any bit was new
+    bool set_hash(const detail::KeyHash& hash);  // set_key() of an already hashed key
+    bool test_key(std::string_view key) const;
+    bool fetch_or(size_t word, uint64_t mask);   // Returns true if any bit was new
+    bool set_word(size_t word, uint64_t mask);   // fetch_or(), marking the word's block
+    void mark_dirty(size_t word);
+    uint64_t load_word(size_t word) const;
+    uint64_t count_set_bits() const;
+
+    // Checkpointing (FilterCheckpointer)
+    void take_dirty_blocks(std::vector<uint32_t>& blocks);        // Appends and clears the marks
+    void mark_blocks_dirty(const std::vector<uint32_t>& blocks);  // After a failed write
+    size_t copy_block(size_t block, uint64_t* out) const;         // Returns the block's words
+    void or_words(size_t first_word, const uint64_t* words, size_t num_words);
+};
+
+}
+#endif
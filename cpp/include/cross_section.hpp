@@ -0,0 +1,42 @@
+#include <cstddef>
+#include <cstdint>
+
+#ifndef CROSS_SECTION_HPP
+#define CROSS_SECTION_HPP
+
+namespace quantamental {
+
+// Per-date cross-sectional transforms of a feature panel. A panel is
+// num_dates rows of num_tickers values (element (d, j) at [d * num_tickers
+// + j]), the layout of IndicatorEngine::compute_panel; its (columns, dates,
+// tickers) output passes as num_columns * num_dates rows. Every row is
+// transformed on its own, rows are split across threads, and NaN marks a
+// missing value: it is left out of the row's statistics and stays NaN.
+// in and out may be the same array (in place); otherwise they must not
+// overlap.
+namespace cross_section {
+
+    // (x - mean) / std over the row, std with ddof = 1 as DataFrame.std();
+    // rows with fewer than two values, or all equal, come out NaN
+    void zscore(const double* in, double* out, size_t num_dates, size_t num_tickers,
+                size_t num_threads = 0);
+
+    // Rank within the row, ties averaged and 1-based, as
+    // DataFrame.rank(axis=1); pct divides by the row's count of values
+    void rank(const double* in, double* out, size_t num_dates, size_t num_tickers,
+              bool pct = false, size_t num_threads = 0);
+
+    // Clips each row to its lower / upper quantiles (numpy's "linear"
+    // interpolation, as DataFrame.quantile). Requires 0 <= lower <= upper <= 1.
+    void winsorize(const double* in, double* out, size_t num_dates, size_t num_tickers,
+                   double lower, double upper, size_t num_threads = 0);
+
+    // Subtracts the row's mean over the ticker's group (e.g. sector), with
+    // groups[j] the group id of ticker j. Tickers with a negative id belong
+    // to no group and come out NaN.
+    void demean_by_group(const double* in, double* out, size_t num_dates, size_t num_tickers,
+                         const int32_t* groups, size_t num_threads = 0);
+}
+
+}
+#endif
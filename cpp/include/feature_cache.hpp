@@ -0,0 +1,59 @@
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#ifndef FEATURE_CACHE_HPP
+#define FEATURE_CACHE_HPP
+
+namespace quantamental {
+
+namespace detail {
+    struct FeatureCacheMapping;
+}
+
+// Latest feature vector per ticker in a memory-mapped file (e.g. under
+// /dev/shm) shared between processes: row r holds dim floats and the
+// timestamp they are as of, for ticker id r. A feature pipeline writes rows
+// as bars arrive and the inference server reads them in place, so a hot
+// ticker is scored by id without its features crossing the socket. Each row
+// is guarded by a sequence lock: readers never block a writer and retry a
+// read that overlapped a write, so they see whole vectors only. Copies share
+// the mapping.
+class FeatureCache {
+
+public:
+    // Creates (or overwrites) a cache with every row unwritten; nullopt on
+    // an I/O error or a zero size
+    static std::optional<FeatureCache> create(const std::string& filepath, size_t num_rows, size_t dim);
+    // nullopt if the file is not a valid cache
+    static std::optional<FeatureCache> open(const std::string& filepath, bool writable = false);
+
+    size_t num_rows() const;
+    size_t dim() const;
+    bool writable() const;
+
+    // Stores dim floats as row's features; false if read-only or row is out
+    // of range. Concurrent writers to one row are serialized. A row left
+    // mid-write by a process that died is taken over; one held for too long
+    // by a live process makes the write give up with false.
+    bool write(size_t row, const float* features, int64_t as_of);
+
+    // Copies row's latest features to out (dim floats); false if the row is
+    // out of range, has never been written, or stays mid-write for longer
+    // than a write takes (treated as not cached)
+    bool read(size_t row, float* out, int64_t* as_of = nullptr) const;
+
+    // Syncs the mapping to its file
+    bool flush();
+
+private:
+    FeatureCache(std::shared_ptr<detail::FeatureCacheMapping> mapping, bool writable);
+
+    std::shared_ptr<detail::FeatureCacheMapping> mapping_;
+    bool writable_;
+};
+
+}
+#endif
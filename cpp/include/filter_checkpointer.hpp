@@ -0,0 +1,97 @@
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "concurrent_bloom_filter.hpp"
+
+#ifndef FILTER_CHECKPOINTER_HPP
+#define FILTER_CHECKPOINTER_HPP
+
+namespace quantamental {
+
+namespace detail {
+    struct FilterCheckpointerState;
+}
+
+struct CheckpointConfig {
+    std::string base_path;          // Whole-filter snapshot, replaced by rename
+    std::string log_path;           // Delta log; empty: base_path + ".log"
+    uint32_t interval_ms = 1000;    // Between background checkpoints; 0: only checkpoint()
+    double compact_ratio = 1.0;     // New base once the log outgrows ratio x base; 0: never
+    bool sync = true;               // fsync each record and base before it counts as written
+};
+
+// Persists a live ConcurrentBloomFilter while inserts continue. A background
+// thread wakes every interval_ms, takes the filter's dirty-block marks (one
+// per 64-byte block) and appends only those blocks to an append-only delta
+// log as one checksummed record, so a checkpoint costs in proportion to the
+// blocks changed since the last one rather than to the filter size. Once the log outgrows the base by
+// compact_ratio, the whole filter is written as a new base and the log starts
+// over. Records only ever add bits, so recover() can OR them onto the base;
+// a record torn by a crash fails its checksum and ends the replay.
+//
+// Files (native-endian, checked via endian_tag):
+//   base  a regular filter file, readable by ConcurrentBloomFilter::load_from_file
+//   log   LogHeader naming the base by its checksum, then per checkpoint a
+//         RecordHeader, the dirty block indices (uint32, padded to 8 bytes)
+//         and each block's 8 words (fewer for a short last block)
+// A base is renamed into place before its fresh log, so a crash in between
+// leaves a log naming an older base, which recover() skips: the new base
+// already holds every block the log recorded.
+class FilterCheckpointer {
+
+public:
+    struct Stats {
+        uint64_t checkpoints = 0;     // Delta records appended
+        uint64_t compactions = 0;     // Bases written, the one from start() included
+        uint64_t failures = 0;        // Failed writes; their blocks go into the next one
+        uint64_t blocks_written = 0;  // Across all delta records
+        uint64_t bytes_written = 0;   // Records and bases
+        uint64_t log_bytes = 0;       // Current log size
+        uint64_t last_blocks = 0;     // Blocks in the latest record
+        double last_checkpoint_us = 0.0;
+    };
+
+    // Writes a base and an empty log for the filter's current contents, then
+    // starts the thread; nullptr if either cannot be written. The file I/O
+    // is POSIX only: on Windows every write fails, so this always returns
+    // nullptr.
+    static std::unique_ptr<FilterCheckpointer> start(std::shared_ptr<ConcurrentBloomFilter> filter,
+                                                     CheckpointConfig config);
+
+    ~FilterCheckpointer();   // stop()
+    FilterCheckpointer(const FilterCheckpointer&) = delete;
+    FilterCheckpointer& operator=(const FilterCheckpointer&) = delete;
+
+    // Appends the blocks changed since the last checkpoint now, holding at
+    // least every insert completed before the call. False if the write
+    // failed; the blocks then stay dirty.
+    bool checkpoint();
+    // Writes the whole filter as a new base and starts an empty log
+    bool compact();
+    // Takes a last checkpoint and stops the thread; idempotent
+    void stop();
+
+    const CheckpointConfig& config() const;
+    const std::shared_ptr<ConcurrentBloomFilter>& filter() const;
+    Stats stats() const;
+
+    // The base with every intact record of its log ORed in. A missing log,
+    // or one written for another base, leaves the base as it is. nullptr if
+    // the base cannot be loaded.
+    static std::unique_ptr<ConcurrentBloomFilter> recover(const std::string& base_path,
+                                                          const std::string& log_path = "");
+
+private:
+    explicit FilterCheckpointer(std::unique_ptr<detail::FilterCheckpointerState> state);
+
+    void run();               // Background thread
+    bool append_record();     // Callers hold the state's io_mutex
+    bool rewrite_base();
+
+    std::unique_ptr<detail::FilterCheckpointerState> state_;
+};
+
+}
+#endif
@@ -0,0 +1,102 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef FILTER_METRICS_HPP
+#define FILTER_METRICS_HPP
+
+namespace quantamental {
+
+// Hot-path instrumentation for a filter: operation counters and sampled
+// latency histograms. Counters are sharded per thread on separate cache
+// lines, so the threads of a batch call never share a line. Single-key
+// calls are timed one in sample_every (per thread); batch calls are always
+// timed, since the clock read is noise next to the batch itself.
+class FilterMetrics {
+
+public:
+    static constexpr size_t kLatencyBuckets = 48;   // Bucket i holds [2^i, 2^(i+1)) ns
+    static constexpr uint32_t kDefaultSampleEvery = 1024;
+
+    enum class Op : uint32_t {
+        Single = 0,   // One key per call
+        Batch = 1     // One whole batch per call
+    };
+
+    struct Counters {
+        uint64_t inserts = 0;     // Keys passed to an insert call
+        uint64_t new_keys = 0;    // Inserted keys that set at least one new bit
+        uint64_t queries = 0;     // Keys tested by a query call
+        uint64_t positives = 0;   // Queried keys reported as possibly present
+    };
+
+    struct LatencyHistogram {
+        std::array<uint64_t, kLatencyBuckets> buckets{};
+        uint64_t samples = 0;
+        uint64_t total_ns = 0;
+
+        double mean_ns() const;
+        double percentile_ns(double q) const;  // Upper edge of the bucket holding quantile q
+    };
+
+    struct Snapshot {
+        Counters counters;
+        LatencyHistogram single;
+        LatencyHistogram batch;
+    };
+
+    // Times one call from construction to destruction when the call is
+    // sampled; costs a thread-local decrement otherwise.
+    class ScopedTimer {
+    public:
+        ScopedTimer(FilterMetrics& metrics, Op op);
+        ~ScopedTimer();
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        FilterMetrics* metrics_;   // Null when not sampled
+        Op op_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    explicit FilterMetrics(uint32_t sample_every = kDefaultSampleEvery);
+
+    void count_inserts(uint64_t keys, uint64_t new_keys);
+    void count_queries(uint64_t keys, uint64_t positives);
+    void record_latency(Op op, uint64_t ns);
+
+    Snapshot snapshot() const;
+    void reset();
+
+    uint32_t sample_every() const;
+    void set_sample_every(uint32_t every);   // 0 stops timing single-key calls
+
+private:
+    static constexpr size_t kCounterShards = 16;
+
+    struct alignas(64) CounterShard {
+        std::atomic<uint64_t> inserts{0};
+        std::atomic<uint64_t> new_keys{0};
+        std::atomic<uint64_t> queries{0};
+        std::atomic<uint64_t> positives{0};
+    };
+
+    struct alignas(64) Histogram {
+        std::array<std::atomic<uint64_t>, kLatencyBuckets> buckets{};
+        std::atomic<uint64_t> samples{0};
+        std::atomic<uint64_t> total_ns{0};
+    };
+
+    CounterShard counters_[kCounterShards];
+    Histogram histograms_[2];   // Indexed by Op
+    std::atomic<uint32_t> sample_every_;
+
+    CounterShard& local_counters();
+    bool should_sample(Op op) const;
+};
+
+}
+#endif
@@ -0,0 +1,64 @@
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+#ifndef INDICATOR_ENGINE_HPP
+#define INDICATOR_ENGINE_HPP
+
+namespace quantamental {
+
+// Windows of TechnicalFeatures (src/features/technical.py). sma_windows
+// also drives the EMA, volatility and volume features, as it does there.
+struct IndicatorConfig {
+    std::vector<int> horizons{1, 5, 10, 20};
+    std::vector<int> sma_windows{10, 20, 50, 200};
+    int rsi_period = 14;
+    int macd_fast = 12;
+    int macd_slow = 26;
+    int macd_signal = 9;
+};
+
+// Native TechnicalFeatures.compute_all: every column for one ticker in a
+// single pass over its close and volume arrays, with no temporaries.
+// Values match the pandas code bit for bit (rolling windows need all w
+// values, EWMs use adjust=False). The one difference is NaN closes, which
+// propagate into returns instead of being forward-filled by pct_change().
+class IndicatorEngine {
+
+public:
+    static std::optional<IndicatorEngine> create(IndicatorConfig config);  // nullopt if a window < 1
+
+    // Column names in compute_all order: return_{h}d, sma_{w}, ema_{w},
+    // rsi_{p}, macd, macd_signal, macd_hist, volatility_{w}d, then
+    // volume_sma_{w} / volume_ratio_{w} pairs
+    const std::vector<std::string>& columns() const;
+    size_t num_columns() const;
+    const IndicatorConfig& config() const;
+
+    // Writes column c of bar t to out[c * n + t] (one contiguous row per
+    // column, i.e. the transpose of the DataFrame)
+    void compute(const double* close, const double* volume, size_t n, double* out) const;
+
+    // Whole universe on one calendar. close and volume are dates x tickers
+    // matrices (element (d, j) at [d * num_tickers + j]) and column c is
+    // written as another at out + c * num_dates * num_tickers. A NaN close
+    // marks a date the ticker has no bar (not listed yet, delisted, halted):
+    // its state does not advance and its features there are NaN, so every
+    // ticker gets compute() over its own bars. Tickers advance side by side
+    // in SIMD lanes, blocks of them on separate threads.
+    void compute_panel(const double* close, const double* volume, size_t num_dates,
+                       size_t num_tickers, double* out, size_t num_threads = 0) const;
+
+    // Kernel compute_panel picked at startup: "avx512", "avx2" or "scalar"
+    static const char* panel_backend();
+
+private:
+    explicit IndicatorEngine(IndicatorConfig config);
+
+    IndicatorConfig config_;
+    std::vector<std::string> columns_;
+};
+
+}
+#endif
@@ -0,0 +1,70 @@
+#include "indicator_engine.hpp"
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#ifndef INDICATOR_STATE_HPP
+#define INDICATOR_STATE_HPP
+
+namespace quantamental {
+
+namespace detail {
+    struct IndicatorPass;
+}
+
+// Persistent per-ticker IndicatorEngine state for daily updates: appending
+// bars costs O(columns) each, whatever the history length, and the rows
+// equal the ones compute() gives for the full history. The state holds the
+// rolling sums, Welford variances and EMA carries plus a ring of the last
+// max(window, horizon) bars, and saves to disk between runs.
+class IndicatorState {
+
+public:
+    static std::optional<IndicatorState> create(IndicatorConfig config);  // nullopt if a window < 1
+
+    IndicatorState(IndicatorState&& other) noexcept;
+    IndicatorState& operator=(IndicatorState&& other) noexcept;
+    ~IndicatorState();
+
+    const std::vector<std::string>& columns() const;
+    size_t num_columns() const;
+    const IndicatorConfig& config() const;
+
+    uint64_t num_bars() const;
+    std::optional<int64_t> last_timestamp() const;  // nullopt before the first bar
+
+    // Timestamps must increase strictly past last_timestamp(); a bar that
+    // does not (e.g. a rerun of a day already applied) is rejected with
+    // false and leaves the state untouched.
+    // append writes the bar's features to row[0 .. num_columns)
+    bool append(int64_t timestamp, double close, double volume, double* row);
+    // append_batch checks every timestamp first and writes out[c * n + t],
+    // the layout of IndicatorEngine::compute
+    bool append_batch(const int64_t* timestamps, const double* close, const double* volume,
+                      size_t n, double* out);
+
+    // Persistence: magic "QIND" header, the config, then the state; loading
+    // fails on a different version or byte order, or a truncated file
+    bool save_to_file(const std::string& filepath) const;
+    static std::optional<IndicatorState> load_from_file(const std::string& filepath);
+
+    // Same format at the current stream position, so one file can hold the
+    // states of many tickers back to back
+    bool save_to_stream(std::ostream& out) const;
+    static std::optional<IndicatorState> load_from_stream(std::istream& in);
+
+private:
+    explicit IndicatorState(IndicatorEngine engine);
+
+    std::string serialize_body() const;  // Config and pass; the size depends only on the config
+
+    IndicatorEngine engine_;                       // Config and column names
+    std::unique_ptr<detail::IndicatorPass> pass_;
+    int64_t last_timestamp_;
+};
+
+}
+#endif
@@ -0,0 +1,130 @@
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "mlp_inference.hpp"
+
+#ifndef INFERENCE_SERVER_HPP
+#define INFERENCE_SERVER_HPP
+
+namespace quantamental {
+
+namespace detail {
+    struct InferenceServerState;
+}
+
+// Wire format of the inference server: fixed little headers in native byte
+// order (clients run on the same host), each request answered by exactly one
+// response carrying its request_id. A connection may pipeline any number of
+// requests; responses to one connection can come back out of order.
+//
+//   request   RequestHeader, then num_features floats (Score only)
+//   response  ResponseHeader, then num_outputs floats (Ok only), one per
+//             model horizon
+namespace inference_protocol {
+    constexpr uint32_t kRequestMagic = 0x464E4951;   // "QINF"
+    constexpr uint32_t kResponseMagic = 0x534E4951;  // "QINS"
+    constexpr uint16_t kVersion = 1;
+
+    enum class RequestKind : uint16_t {
+        Score = 0,         // Features inline
+        ScoreCached = 1    // Features from the server's FeatureCache row `ticker`
+    };
+
+    enum class Status : uint16_t {
+        Ok = 0,
+        BadRequest = 1,    // Unknown kind, wrong feature count, or no cache
+        NotCached = 2,     // The ticker's cache row has never been written
+        Busy = 3           // Request queue full; retry later
+    };
+
+    struct RequestHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t kind;
+        uint64_t request_id;    // Echoed in the response
+        uint32_t ticker;
+        uint32_t num_features;  // Score: the model's input_dim; ScoreCached: 0
+    };
+    static_assert(sizeof(RequestHeader) == 24, "RequestHeader layout is part of the protocol");
+
+    struct ResponseHeader {
+        uint32_t magic;
+        uint16_t status;
+        uint16_t num_outputs;
+        uint64_t request_id;
+        uint32_t queue_us;      // Arrival to start of its batch
+        uint32_t compute_us;    // Its batch's feature gather and forward pass
+    };
+    static_assert(sizeof(ResponseHeader) == 24, "ResponseHeader layout is part of the protocol");
+}
+
+struct InferenceServerConfig {
+    std::string socket_path;         // Unix domain socket; an existing file is replaced
+    size_t max_batch = 64;           // Rows per forward pass
+    uint32_t max_wait_us = 200;      // Longest a request waits for its batch to fill
+    size_t num_workers = 1;
+    bool pin_workers = true;         // One CPU each, after the I/O thread's
+    size_t queue_capacity = 4096;    // Queued requests beyond this get Busy
+    std::string feature_cache_path;  // Empty: ScoreCached requests are rejected
+};
+
+// Local scoring server in front of an MLP. One I/O thread accepts
+// connections and parses requests into preallocated slots; worker threads,
+// each with its own single-thread MlpEngine, take queued requests in
+// arrival order as soon as max_batch are waiting or the oldest has waited
+// max_wait_us, whichever comes first, and score them as one batch. A burst
+// of single-row requests thus shares one forward pass, while a lone request
+// pays at most max_wait_us for the chance. Queueing and compute latency are
+// recorded per request into log-linear histograms.
+class InferenceServer {
+
+public:
+    struct LatencySummary {
+        uint64_t samples = 0;
+        double mean_us = 0.0;
+        double p50_us = 0.0;    // Percentiles are bucket upper edges, within 1/8
+        double p99_us = 0.0;
+        double max_us = 0.0;
+    };
+
+    struct Stats {
+        uint64_t requests = 0;      // Scored (Ok or NotCached)
+        uint64_t batches = 0;
+        uint64_t rejected = 0;      // Busy
+        uint64_t bad_requests = 0;
+        uint64_t connections = 0;   // Accepted since start
+        double mean_batch_size = 0.0;
+        LatencySummary queue;
+        LatencySummary compute;
+    };
+
+    // Binds the socket and starts the threads; nullptr if the socket cannot
+    // be bound, the feature cache cannot be opened or its dim is not the
+    // model's input_dim, or max_batch, num_workers or queue_capacity is 0
+    static std::unique_ptr<InferenceServer> start(MlpModel model, InferenceServerConfig config);
+
+    ~InferenceServer();   // stop()
+    InferenceServer(const InferenceServer&) = delete;
+    InferenceServer& operator=(const InferenceServer&) = delete;
+
+    // Scores what is already queued, closes every connection and removes
+    // the socket file; idempotent. Answers a client's socket buffer cannot
+    // take at once are dropped with the connection.
+    void stop();
+
+    const InferenceServerConfig& config() const;
+    const MlpModel& model() const;
+
+    Stats stats() const;
+    void reset_stats();
+
+private:
+    explicit InferenceServer(std::unique_ptr<detail::InferenceServerState> state);
+
+    std::unique_ptr<detail::InferenceServerState> state_;
+};
+
+}
+#endif
@@ -0,0 +1,70 @@
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#ifndef KEY_BUFFER_HPP
+#define KEY_BUFFER_HPP
+
+namespace quantamental {
+
+// Non-owning view of a packed column of keys, so batch calls can read keys
+// straight out of NumPy or Arrow memory.
+//   Fixed width: key i is the `width` bytes at data + i * width, with
+//                trailing NUL padding dropped (NumPy 'S' arrays).
+//   Offsets:     key i is data[offsets[i], offsets[i + 1]) (Arrow string and
+//                large_string arrays); offsets holds count + 1 entries.
+class KeyBuffer {
+
+public:
+    static KeyBuffer fixed_width(const char* data, size_t count, size_t width) {
+        return KeyBuffer(data, count, width, nullptr, nullptr);
+    }
+
+    static KeyBuffer with_offsets(const char* data, const int32_t* offsets, size_t count) {
+        return KeyBuffer(data, count, 0, offsets, nullptr);
+    }
+
+    static KeyBuffer with_offsets(const char* data, const int64_t* offsets, size_t count) {
+        return KeyBuffer(data, count, 0, nullptr, offsets);
+    }
+
+    size_t size() const { return count_; }
+
+    std::string_view operator[](size_t i) const {
+        if (offsets32_ != nullptr) {
+            return std::string_view(data_ + offsets32_[i], offsets32_[i + 1] - offsets32_[i]);
+        }
+        if (offsets64_ != nullptr) {
+            return std::string_view(data_ + offsets64_[i], offsets64_[i + 1] - offsets64_[i]);
+        }
+        const char* key = data_ + i * width_;
+        size_t len = width_;
+        while (len > 0 && key[len - 1] == '\0') --len;
+        return std::string_view(key, len);
+    }
+
+    // Keys [begin, end) as a view over the same memory
+    KeyBuffer slice(size_t begin, size_t end) const {
+        KeyBuffer view = *this;
+        view.count_ = end - begin;
+        if (offsets32_ != nullptr) view.offsets32_ += begin;
+        else if (offsets64_ != nullptr) view.offsets64_ += begin;
+        else view.data_ += begin * width_;
+        return view;
+    }
+
+private:
+    KeyBuffer(const char* data, size_t count, size_t width,
+              const int32_t* offsets32, const int64_t* offsets64)
+        : data_(data), count_(count), width_(width),
+          offsets32_(offsets32), offsets64_(offsets64) {}
+
+    const char* data_;
+    size_t count_;
+    size_t width_;
+    const int32_t* offsets32_;
+    const int64_t* offsets64_;
+};
+
+}
+#endif
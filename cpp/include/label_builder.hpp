@@ -0,0 +1,56 @@
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+#ifndef LABEL_BUILDER_HPP
+#define LABEL_BUILDER_HPP
+
+namespace quantamental {
+
+// Forecast targets: features.horizons in configs/default.yaml
+struct LabelConfig {
+    std::vector<int> horizons{1, 5, 10, 20};
+    int vol_window = 20;   // Daily log returns behind the vol-scaled labels
+};
+
+// Forward-return training labels for a whole universe in one pass. Input is
+// a dates x tickers close panel on one shared calendar (element (d, j) at
+// [d * num_tickers + j], NaN where the ticker has no bar), the layout of
+// IndicatorEngine::compute_panel. The label of horizon h at date d runs from
+// the close on d to the close h calendar rows later, so every ticker's label
+// for a date ends on the same date; a missing close at either end gives NaN.
+class LabelBuilder {
+
+public:
+    static std::optional<LabelBuilder> create(LabelConfig config);  // nullopt if a horizon < 1 or vol_window < 2
+
+    // Four columns per horizon, in horizon order:
+    //   fwd_return_{h}d       close[d + h] / close[d] - 1
+    //   fwd_log_return_{h}d   log(close[d + h] / close[d])
+    //   fwd_vol_scaled_{h}d   fwd_log_return / (sigma * sqrt(h)), sigma the
+    //                         std (ddof = 1) of the ticker's last vol_window
+    //                         daily log returns up to d, so known on d
+    //   fwd_excess_{h}d       fwd_return minus the benchmark's, same dates
+    const std::vector<std::string>& columns() const;
+    size_t num_columns() const;
+    const LabelConfig& config() const;
+
+    // Writes column c as a dates x tickers matrix at out + c * num_dates *
+    // num_tickers. benchmark holds num_dates closes, or is null (the excess
+    // columns are then NaN). Only dates [0, num_known_dates) belong to the
+    // sample: a label whose exit date lies at or past that boundary is NaN,
+    // so no label depends on data the model must not see (pass num_dates for
+    // "everything known"). Tickers are split across threads.
+    void build(const double* close, const double* benchmark, size_t num_dates, size_t num_tickers,
+               size_t num_known_dates, double* out, size_t num_threads = 0) const;
+
+private:
+    explicit LabelBuilder(LabelConfig config);
+
+    LabelConfig config_;
+    std::vector<std::string> columns_;
+};
+
+}
+#endif
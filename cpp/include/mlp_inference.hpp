@@ -0,0 +1,116 @@
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#ifndef MLP_INFERENCE_HPP
+#define MLP_INFERENCE_HPP
+
+namespace quantamental {
+
+namespace detail {
+    struct MlpWeights;
+}
+
+// Horizon-aware MLP for inference: dense layers over a feature vector, the
+// last one producing one forecast per horizon. Weights are float32 in
+// PyTorch's nn.Linear layout (out x in, row-major) and are repacked on load
+// into column panels for the GEMM kernel. Models are immutable; copies share
+// the packed weights.
+class MlpModel {
+
+public:
+    enum class Activation : uint32_t {
+        Identity = 0,
+        ReLU = 1,
+        Tanh = 2,
+        Sigmoid = 3
+    };
+
+    struct Layer {
+        size_t in;
+        size_t out;
+        Activation activation;
+    };
+
+    // weights[i] holds layers[i].out x layers[i].in floats and biases[i]
+    // layers[i].out. nullopt unless the layers chain (each in is the previous
+    // out) and the last layer has one output per horizon.
+    static std::optional<MlpModel> create(std::vector<int> horizons, const std::vector<Layer>& layers,
+                                          const std::vector<std::vector<float>>& weights,
+                                          const std::vector<std::vector<float>>& biases);
+
+    // Versioned, checksummed binary file (format in mlp_inference.cpp)
+    bool save_to_file(const std::string& filepath) const;
+    static std::optional<MlpModel> load_from_file(const std::string& filepath);
+    bool save_to_stream(std::ostream& out) const;
+    static std::optional<MlpModel> load_from_stream(std::istream& in);
+
+    const std::vector<int>& horizons() const;
+    const std::vector<Layer>& layers() const;
+    size_t input_dim() const;
+    size_t output_dim() const;   // One per horizon
+
+    // Layer i's weights back in nn.Linear layout
+    std::vector<float> weights(size_t layer) const;
+    std::vector<float> bias(size_t layer) const;
+
+    // Kernel chosen for this CPU: "avx512", "avx2" or "scalar"
+    static const char* backend();
+
+private:
+    friend class MlpEngine;
+
+    MlpModel(std::vector<int> horizons, std::vector<Layer> layers,
+             std::shared_ptr<const detail::MlpWeights> weights);
+
+    std::vector<int> horizons_;
+    std::vector<Layer> layers_;
+    std::shared_ptr<const detail::MlpWeights> weights_;
+};
+
+// Batched forward passes of one model. Every activation lives in an arena
+// allocated up front: one pair of ping-pong buffers per thread, each a block
+// of kBlockRows rows as wide as the widest layer. predict() runs the rows
+// block by block, each layer as a cache-blocked GEMM with the bias and
+// activation applied to the accumulators before they are stored, and
+// allocates nothing on the single-thread path. Larger batches are split
+// across ThreadPool::shared(), block ranges per thread.
+class MlpEngine {
+
+public:
+    static constexpr size_t kBlockRows = 48;
+
+    // num_threads == 0 sizes the arena for the whole pool
+    explicit MlpEngine(MlpModel model, size_t num_threads = 0);
+
+    // x holds rows x input_dim() floats, row-major; writes rows x
+    // output_dim() forecasts to out. Calls from several threads take turns,
+    // as they share the arena.
+    void predict(const float* x, size_t rows, float* out);
+
+    const MlpModel& model() const;
+    size_t num_threads() const;
+    size_t arena_bytes() const;
+
+private:
+    struct ArenaDeleter {
+        void operator()(float* arena) const;
+    };
+
+    void run_blocks(size_t thread, const float* x, size_t begin_row, size_t end_row, float* out);
+
+    MlpModel model_;
+    size_t num_threads_;
+    size_t stride_;         // Floats per arena row (widest layer, padded)
+    size_t slice_floats_;   // Arena floats per thread
+    std::unique_ptr<float[], ArenaDeleter> arena_;
+    std::unique_ptr<std::mutex> predict_mutex_ = std::make_unique<std::mutex>();  // Held over predict()
+};
+
+}
+#endif
@@ -0,0 +1,110 @@
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#ifndef ROLLING_COVARIANCE_HPP
+#define ROLLING_COVARIANCE_HPP
+
+namespace quantamental {
+
+// Rolling covariance and correlation of a whole universe over several
+// windows at once, updated per date instead of recomputed. Input rows are
+// one date's values (e.g. daily returns) for every ticker, NaN where it has
+// no bar; each pair of tickers uses the dates both have (pairwise complete,
+// as DataFrame.rolling(w).cov() / .corr()), tracked through per-pair counts.
+//
+// Each pair keeps six running sums per window (count, sum x, sum y, sum x^2,
+// sum y^2, sum xy over the dates both are present). A new date is a rank-1
+// update to every window's sums and the date leaving a window a rank-1
+// downdate, so a date costs O(N^2) whatever the window lengths. Pairs are
+// stored as kTile x kTile tiles of the upper triangle, each tile's sums
+// contiguous, and the tile kernels run in SIMD registers (AVX-512 / AVX2,
+// chosen at runtime). update() spreads tiles across threads and runs every
+// date of a batch over a tile while the tile is in cache.
+class RollingCovariance {
+
+public:
+    static constexpr size_t kTile = 8;
+
+    enum class Target : uint32_t {
+        Diagonal = 0,              // Off-diagonal shrunk toward zero
+        ConstantCorrelation = 1    // Toward the mean pairwise correlation
+    };
+
+    // windows are lengths in dates, e.g. {20, 60, 120}; a pair's entry is
+    // NaN until it has min_periods joint observations (at least 2). nullopt
+    // without tickers or windows, or with a window of 0 or below min_periods.
+    static std::optional<RollingCovariance> create(size_t num_tickers, std::vector<size_t> windows,
+                                                   size_t min_periods = 2);
+
+    // Appends num_dates rows of num_tickers values (row-major, dates x
+    // tickers) and slides every window past them. Non-finite values count
+    // as missing.
+    void update(const double* values, size_t num_dates = 1, size_t num_threads = 0);
+
+    // Forgets every date seen
+    void reset();
+
+    size_t num_tickers() const;
+    const std::vector<size_t>& windows() const;
+    size_t min_periods() const;
+    uint64_t num_dates() const;      // Dates seen since create() or reset()
+    size_t memory_bytes() const;
+
+    // Symmetric num_tickers x num_tickers matrices (row-major) for window
+    // windows()[window]. Covariances use ddof = 1; the diagonal holds each
+    // ticker's variance, and NaN marks pairs short of min_periods.
+    void covariance(size_t window, double* out, size_t num_threads = 0) const;
+    // Pairwise correlation, each pair's variances taken over its joint
+    // dates; NaN where either is constant (to within rounding: a centered
+    // sum of squares below 1e-12 * mean^2 * count counts as zero)
+    void correlation(size_t window, double* out, size_t num_threads = 0) const;
+    // (1 - intensity) * covariance + intensity * target (intensity clamped
+    // to [0, 1]). The target keeps the variances; a pair short of
+    // min_periods whose variances are known takes the target's value.
+    void shrunk_covariance(size_t window, double intensity, Target target, double* out,
+                           size_t num_threads = 0) const;
+    // Joint observations of every pair in the window
+    void counts(size_t window, int64_t* out, size_t num_threads = 0) const;
+
+    // Tile kernel chosen for this CPU: "avx512", "avx2" or "scalar"
+    static const char* backend();
+
+private:
+    RollingCovariance(size_t num_tickers, std::vector<size_t> windows, size_t min_periods);
+
+    // Writes fn(pair sums, i == j) for every pair of the upper triangle,
+    // and its mirror, to out
+    template <typename T, typename Fn>
+    void for_each_pair(size_t window, T* out, size_t num_threads, Fn&& fn) const;
+
+    // Moves every shift to the ticker's latest value and rebuilds the sums
+    void recenter(size_t num_threads);
+
+    size_t num_tickers_;
+    size_t padded_tickers_;          // Rounded up to whole tiles
+    std::vector<size_t> windows_;
+    size_t min_periods_;
+    uint64_t num_dates_ = 0;
+
+    // Tiles (row block, column block) of the upper triangle; tile t's sums
+    // for window w are kSums x kTile x kTile doubles at
+    // sums_[(t * windows_.size() + w) * kTileSums]
+    std::vector<uint32_t> tile_rows_;
+    std::vector<uint32_t> tile_cols_;
+    std::vector<double> sums_;
+
+    // The last max window dates, as masked rows (present, x, x^2) of
+    // padded_tickers_ each; x is shifted by a recent value of the ticker so
+    // the sums stay small next to the spread they measure. Every max window
+    // dates the shifts move to last_ and the sums are rebuilt.
+    std::vector<double> history_;
+    std::vector<double> shift_;
+    std::vector<double> last_;       // Latest finite value per ticker
+    uint64_t next_recenter_ = 0;
+    std::vector<double> staging_;    // Masked rows of the batch being added
+};
+
+}
+#endif
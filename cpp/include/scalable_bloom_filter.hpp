@@ -0,0 +1,92 @@
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bloom_filter.hpp"
+
+#ifndef SCALABLE_BLOOM_FILTER_HPP
+#define SCALABLE_BLOOM_FILTER_HPP
+
+namespace quantamental {
+
+// Bloom filter that grows instead of degrading once it outgrows its initial
+// size (Almeida et al., 2007). It is a stack of BloomFilter layers: layer i
+// holds initial_capacity * growth_factor^i keys at a target FPR of
+//   p_i = false_positive_rate * (1 - tightening_ratio) * tightening_ratio^i
+// so the compound FPR stays below false_positive_rate however many layers
+// are added. Keys go into the newest layer, which is sealed and replaced
+// once its estimated fill ratio reaches fill_threshold. Queries probe the
+// newest layer first and stop at the first hit.
+class ScalableBloomFilter {
+
+public:
+    using Layout = BloomFilter::Layout;
+    using BloomFilterStats = BloomFilter::BloomFilterStats;
+
+    // false_positive_rate, tightening_ratio and fill_threshold in (0, 1) and
+    // a finite growth_factor > 1, or std::invalid_argument is thrown. An
+    // initial_capacity of 0 is raised to 1.
+    ScalableBloomFilter(size_t initial_capacity, double false_positive_rate = 0.01,
+                        Layout layout = Layout::Standard, double growth_factor = 2.0,
+                        double tightening_ratio = 0.5, double fill_threshold = 0.5);
+
+    // Core operations. Keys already (possibly) present are not re-inserted,
+    // so duplicates never push the filter into a new layer.
+    void insert(std::string_view key);
+    bool possibly_contains(std::string_view key) const;
+    bool insert_and_check(std::string_view key);  // Insert and return if was new
+
+    // Batch operations. Queries run on every layer's batch pipeline; inserts
+    // go into the newest layer one key at a time so growth happens on time.
+    void insert_batch(const std::vector<std::string>& keys);
+    std::vector<size_t> filter_new(const std::vector<std::string>& keys) const;
+    void insert_batch(const KeyBuffer& keys, size_t num_threads = 0);
+    void filter_new_mask(const KeyBuffer& keys, bool* is_new, size_t num_threads = 0) const;
+
+    // Statistics (summed over layers; num_hash_functions is the newest layer's)
+    BloomFilterStats get_stats() const;
+    double fill_ratio() const;
+    double estimated_false_positive_rate() const;  // Compound, from insertions
+    double false_positive_bound() const;           // Compound, from layer targets
+    size_t size_bits() const;
+    size_t size_bytes() const;
+    uint64_t num_insertions() const;
+    size_t num_layers() const;
+    uint64_t capacity() const;                     // Keys before the next layer
+    Layout layout() const;
+    const BloomFilter& layer(size_t i) const;      // 0 is the oldest
+
+    // Persistence. The parameters and every layer go into a single file.
+    bool save_to_file(const std::string& filepath) const;
+    static std::optional<ScalableBloomFilter> load_from_file(const std::string& filepath);
+    void clear();  // Back to a single empty layer
+
+private:
+    struct Params {
+        uint64_t initial_capacity;
+        double false_positive_rate;
+        double growth_factor;
+        double tightening_ratio;
+        double fill_threshold;
+        Layout layout;
+    };
+
+    explicit ScalableBloomFilter(const Params& params);  // No layers yet
+
+    Params params_;
+    std::vector<BloomFilter> layers_;
+    std::vector<uint64_t> layer_limits_;   // Insertions at which each layer is full
+
+    // Private methods
+    size_t layer_capacity(size_t i) const;
+    double layer_false_positive_rate(size_t i) const;
+    void add_layer();
+    uint64_t layer_limit(size_t i) const;
+    bool insert_new(std::string_view key);  // Key is known to be absent
+};
+
+}
+#endif
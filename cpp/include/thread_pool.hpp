@@ -0,0 +1,52 @@
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+namespace quantamental {
+
+// Fixed set of worker threads for splitting batch work. parallel_for blocks
+// until every chunk is done; the calling thread runs chunks too and drains
+// queued work while it waits, so nested calls from a worker cannot deadlock.
+class ThreadPool {
+
+public:
+    explicit ThreadPool(size_t num_threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Runs fn(begin, end) over [0, count) split into num_chunks contiguous
+    // ranges (at least one item each)
+    void parallel_for(size_t count, size_t num_chunks,
+                      const std::function<void(size_t, size_t)>& fn);
+
+    size_t size() const;  // Worker threads, excluding callers
+
+    // Process-wide pool sized to the hardware
+    static ThreadPool& shared();
+
+    // Threads worth using for count items when each thread should get at
+    // least min_per_thread of them; requested == 0 means "all available"
+    static size_t resolve_threads(size_t requested, size_t count, size_t min_per_thread);
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_;
+
+    void worker_loop();
+    bool run_one_task(std::unique_lock<std::mutex>& lock);
+};
+
+}
+#endif
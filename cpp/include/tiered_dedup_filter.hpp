@@ -0,0 +1,60 @@
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "binary_fuse_filter.hpp"
+#include "bloom_filter.hpp"
+
+#ifndef TIERED_DEDUP_FILTER_HPP
+#define TIERED_DEDUP_FILTER_HPP
+
+namespace quantamental {
+
+// Dedup over a frozen history plus live ingest: a shared, immutable
+// BinaryFuseFilter for the historical keys and a mutable BloomFilter for
+// keys seen since it was built. Queries ask the history first (three fixed
+// accesses), then the live filter; inserts only touch the live filter.
+// Rebuilding the history from the full key set and swapping it in with
+// set_history() lets the live filter be cleared.
+class TieredDedupFilter {
+
+public:
+    using Layout = BloomFilter::Layout;
+
+    TieredDedupFilter(std::shared_ptr<const BinaryFuseFilter> history, BloomFilter live);
+    TieredDedupFilter(std::shared_ptr<const BinaryFuseFilter> history, size_t live_expected_elements,
+                      double live_false_positive_rate = 0.01, Layout layout = Layout::Standard);
+
+    // Core operations
+    void insert(std::string_view key);
+    bool possibly_contains(std::string_view key) const;
+    bool insert_and_check(std::string_view key);  // False if in history or live
+
+    // Batch operations
+    void insert_batch(const std::vector<std::string>& keys);
+    std::vector<size_t> filter_new(const std::vector<std::string>& keys) const;
+    void insert_batch(const KeyBuffer& keys, size_t num_threads = 0);
+    void filter_new_mask(const KeyBuffer& keys, bool* is_new, size_t num_threads = 0) const;
+
+    // Statistics
+    double estimated_false_positive_rate() const;  // Either tier: 1 - (1 - p_h)(1 - p_l)
+    size_t size_bytes() const;
+    uint64_t num_insertions() const;               // History keys plus live insertions
+
+    // Tiers
+    const BinaryFuseFilter& history() const;
+    std::shared_ptr<const BinaryFuseFilter> shared_history() const;
+    const BloomFilter& live() const;
+    BloomFilter& live();
+    void set_history(std::shared_ptr<const BinaryFuseFilter> history);
+
+private:
+    std::shared_ptr<const BinaryFuseFilter> history_;
+    BloomFilter live_;
+};
+
+}
+#endif
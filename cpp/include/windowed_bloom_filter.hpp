@@ -0,0 +1,107 @@
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bloom_filter.hpp"
+
+#ifndef WINDOWED_BLOOM_FILTER_HPP
+#define WINDOWED_BLOOM_FILTER_HPP
+
+namespace quantamental {
+
+// Bloom filter that remembers only the last num_buckets time buckets, e.g.
+// the last N trading days of bar keys.
+//
+// It is a ring of num_buckets + 1 sub-filters stored bit-sliced: cell c of
+// the array holds bit c of every sub-filter side by side, so a key's k
+// probes read k cells of one array whatever the window length, and a query
+// ANDs the cells with the mask of live buckets. Moving to a new bucket
+// drops the oldest one from that mask in O(1); its bits are then cleared a
+// few words per insert, and the cleared spare becomes the next bucket.
+// Cells are num_buckets + 1 bits rounded up to a power of two so they never
+// straddle words. Probes use the Standard layout.
+class WindowedBloomFilter {
+
+public:
+    using BloomFilterStats = BloomFilter::BloomFilterStats;
+
+    static constexpr uint32_t kMaxBuckets = 63;
+
+    // Each bucket is sized for expected_per_bucket keys at
+    // false_positive_rate / num_buckets, so a full window stays near
+    // false_positive_rate. Timestamps passed to advance_to() fall into
+    // bucket floor(time / bucket_width) (e.g. epoch days with width 1).
+    WindowedBloomFilter(size_t expected_per_bucket, double false_positive_rate = 0.01,
+                        uint32_t num_buckets = 5, int64_t bucket_width = 1);
+
+    // Core operations. Inserting a key refreshes it into the current bucket.
+    void insert(std::string_view key);
+    bool possibly_contains(std::string_view key) const;   // In any live bucket
+    bool insert_and_check(std::string_view key);          // True if not in the window before
+
+    // Batch operations
+    void insert_batch(const std::vector<std::string>& keys);
+    std::vector<size_t> filter_new(const std::vector<std::string>& keys) const;
+    void insert_batch(const KeyBuffer& keys, size_t num_threads = 0);
+    void filter_new_mask(const KeyBuffer& keys, bool* is_new, size_t num_threads = 0) const;
+
+    // Window control. advance_to() starts as many buckets as time has moved
+    // on (the first call only sets the clock; earlier times are ignored) and
+    // returns how many it started. rotate() starts the next bucket now.
+    size_t advance_to(int64_t time);
+    void rotate();
+    // Clears up to max_words of the expired bucket, e.g. while idle; returns
+    // the words still pending. Inserts do this on their own.
+    size_t expire_step(size_t max_words);
+
+    // Statistics (over the live buckets)
+    BloomFilterStats get_stats() const;
+    double fill_ratio() const;
+    double estimated_false_positive_rate() const;
+    size_t size_bits() const;
+    size_t size_bytes() const;
+    uint64_t num_insertions() const;
+    uint32_t num_buckets() const;
+    int64_t bucket_width() const;
+    std::optional<int64_t> current_bucket() const;   // Unset until advance_to()
+    size_t pending_expire_words() const;
+
+    void clear();
+
+private:
+    std::unique_ptr<uint64_t[]> words_;   // num_cells_ cells of cell_bits_ bits each
+    size_t num_cells_;                    // Bits per bucket (m)
+    size_t num_words_;
+    uint32_t num_hashes_;                 // Hash functions (k)
+    uint32_t num_buckets_;
+    uint32_t num_slots_;                  // num_buckets_ + 1 sub-filters
+    uint32_t cell_shift_;                 // log2(cell_bits_)
+    uint32_t cell_bits_;                  // Power of two >= num_slots_
+    uint32_t lane_shift_;                 // log2(cells per word)
+    uint64_t lane_ones_;                  // Bit 0 of every cell in a word
+    uint64_t live_mask_;                  // Slots of the live buckets
+    uint32_t current_slot_;
+    uint32_t spare_slot_;                 // Expired, being cleared
+    size_t expire_pos_;                   // Next word of spare_slot_ to clear
+    size_t expire_stride_;                // Words cleared per insert
+    int64_t bucket_width_;
+    std::optional<int64_t> current_bucket_;
+    std::vector<uint64_t> slot_insertions_;
+    mutable uint64_t num_queries_;
+
+    // Private methods
+    uint64_t probe_cells(detail::ProbeSequence probes) const;   // AND of the k cells
+    bool set_cells(detail::ProbeSequence probes);               // Returns true if any bit was new
+    template <bool Shared, typename KeyAt>
+    size_t insert_range(size_t begin, size_t end, KeyAt&& key_at);
+    template <typename KeyAt>
+    size_t filter_range(size_t begin, size_t end, KeyAt&& key_at, bool* is_new) const;
+    void finish_expire();
+};
+
+}
+#endif
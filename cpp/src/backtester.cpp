@@ -0,0 +1,494 @@
+#include "backtester.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace quantamental {
+    namespace {
+        constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+        // Dates per unit of work when preparing
+        constexpr size_t kMinDatesPerThread = 16;
+
+        // Pearson correlation of n pairs; NaN below 3 pairs or without variance
+        double pearson(const double* x, const double* y, size_t n) {
+            if (n < 3) {
+                return kNaN;
+            }
+            double mean_x = 0.0;
+            double mean_y = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                mean_x += x[i];
+                mean_y += y[i];
+            }
+            mean_x /= static_cast<double>(n);
+            mean_y /= static_cast<double>(n);
+            double sxy = 0.0;
+            double sxx = 0.0;
+            double syy = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                const double dx = x[i] - mean_x;
+                const double dy = y[i] - mean_y;
+                sxy += dx * dy;
+                sxx += dx * dx;
+                syy += dy * dy;
+            }
+            if (sxx <= 0.0 || syy <= 0.0) {
+                return kNaN;
+            }
+            return sxy / std::sqrt(sxx * syy);
+        }
+
+        // Tie-averaged ranks (1 = smallest) of n values already sorted best
+        // first, where value_at(p) is the p-th best
+        template <typename ValueAt>
+        void descending_ranks(size_t n, ValueAt&& value_at, double* ranks) {
+            for (size_t first = 0; first < n;) {
+                size_t last = first + 1;
+                while (last < n && value_at(last) == value_at(first)) {
+                    ++last;
+                }
+                // Positions [first, last) hold ranks n - last + 1 .. n - first
+                const double rank = static_cast<double>(n) - 0.5 * static_cast<double>(first + last - 1);
+                std::fill(ranks + first, ranks + last, rank);
+                first = last;
+            }
+        }
+
+        // Tie-averaged ranks (1 = smallest) of values[0, n) into ranks,
+        // using index as scratch
+        void average_ranks(const double* values, size_t n, std::vector<uint32_t>& index, double* ranks) {
+            index.resize(n);
+            for (size_t i = 0; i < n; ++i) {
+                index[i] = static_cast<uint32_t>(i);
+            }
+            std::sort(index.begin(), index.end(),
+                      [values](uint32_t a, uint32_t b) { return values[a] < values[b]; });
+            for (size_t first = 0; first < n;) {
+                size_t last = first + 1;
+                while (last < n && values[index[last]] == values[index[first]]) {
+                    ++last;
+                }
+                const double rank = 0.5 * static_cast<double>(first + last + 1);
+                for (size_t i = first; i < last; ++i) {
+                    ranks[index[i]] = rank;
+                }
+                first = last;
+            }
+        }
+
+        // Mean and mean / std of a daily series, skipping NaN dates
+        void mean_and_ir(const std::vector<double>& series, double& mean, double& ir) {
+            double sum = 0.0;
+            size_t n = 0;
+            for (double v : series) {
+                if (v == v) {
+                    sum += v;
+                    ++n;
+                }
+            }
+            mean = n > 0 ? sum / static_cast<double>(n) : kNaN;
+            if (n < 2) {
+                ir = kNaN;
+                return;
+            }
+            double ss = 0.0;
+            for (double v : series) {
+                if (v == v) {
+                    ss += (v - mean) * (v - mean);
+                }
+            }
+            const double sd = std::sqrt(ss / static_cast<double>(n - 1));
+            ir = sd > 0.0 ? mean / sd : kNaN;
+        }
+    }
+
+    // ============================================================================
+    // Construction
+    // ============================================================================
+
+    std::optional<Backtester> Backtester::create(const double* scores, const double* returns,
+                                                 const double* volatility, const double* ic_target,
+                                                 size_t num_dates, size_t num_tickers,
+                                                 size_t num_threads) {
+        if (scores == nullptr || returns == nullptr || num_dates == 0 || num_tickers == 0 ||
+            num_tickers > std::numeric_limits<uint32_t>::max()) {
+            return std::nullopt;
+        }
+        Backtester backtester(num_dates, num_tickers, num_threads);
+        const size_t cells = num_dates * num_tickers;
+
+        // NaN returns become 0 once here, so the per-date loops stay branch-free
+        backtester.returns_.resize(cells);
+        for (size_t i = 0; i < cells; ++i) {
+            backtester.returns_[i] = returns[i] == returns[i] ? returns[i] : 0.0;
+        }
+        if (volatility != nullptr) {
+            backtester.volatility_.assign(volatility, volatility + cells);
+        }
+        backtester.prepare(scores, ic_target != nullptr ? ic_target : returns);
+        return backtester;
+    }
+
+    Backtester::Backtester(size_t num_dates, size_t num_tickers, size_t num_threads)
+        : num_dates_(num_dates),
+          num_tickers_(num_tickers),
+          num_threads_(num_threads == 0 ? ThreadPool::shared().size() + 1 : num_threads),
+          workspaces_(num_threads_) {
+        for (Workspace& workspace : workspaces_) {
+            workspace.weights.resize(num_tickers);
+            workspace.target.resize(num_tickers);
+            workspace.picked.reserve(num_tickers);
+        }
+    }
+
+    void Backtester::prepare(const double* scores, const double* ic_target) {
+        const size_t n = num_tickers_;
+        order_.resize(num_dates_ * n);
+        ranks_.resize(num_dates_ * n);
+        num_scored_.resize(num_dates_);
+        ic_.resize(num_dates_);
+        rank_ic_.resize(num_dates_);
+
+        auto prepare_dates = [&](size_t begin, size_t end) {
+            std::vector<double> pair_scores;
+            std::vector<double> pair_targets;
+            std::vector<double> score_ranks(n);
+            std::vector<double> target_ranks(n);
+            std::vector<uint32_t> index;
+            pair_scores.reserve(n);
+            pair_targets.reserve(n);
+
+            for (size_t d = begin; d < end; ++d) {
+                const double* s = scores + d * n;
+                const double* y = ic_target + d * n;
+
+                // Scored tickers, best first; ties by ticker for determinism
+                uint32_t* order = order_.data() + d * n;
+                size_t scored = 0;
+                for (size_t j = 0; j < n; ++j) {
+                    if (s[j] == s[j]) {
+                        order[scored++] = static_cast<uint32_t>(j);
+                    }
+                }
+                std::sort(order, order + scored, [s](uint32_t a, uint32_t b) {
+                    return s[a] > s[b] || (s[a] == s[b] && a < b);
+                });
+                num_scored_[d] = static_cast<uint32_t>(scored);
+                descending_ranks(scored, [s, order](size_t p) { return s[order[p]]; },
+                                 ranks_.data() + d * n);
+
+                // IC pairs in score order, so only the targets need a sort to rank
+                pair_scores.clear();
+                pair_targets.clear();
+                for (size_t p = 0; p < scored; ++p) {
+                    const uint32_t j = order[p];
+                    if (y[j] == y[j]) {
+                        pair_scores.push_back(s[j]);
+                        pair_targets.push_back(y[j]);
+                    }
+                }
+                const size_t pairs = pair_scores.size();
+                ic_[d] = pearson(pair_scores.data(), pair_targets.data(), pairs);
+                if (pairs >= 3) {
+                    descending_ranks(pairs, [&pair_scores](size_t p) { return pair_scores[p]; },
+                                     score_ranks.data());
+                    average_ranks(pair_targets.data(), pairs, index, target_ranks.data());
+                    rank_ic_[d] = pearson(score_ranks.data(), target_ranks.data(), pairs);
+                } else {
+                    rank_ic_[d] = kNaN;
+                }
+            }
+        };
+
+        const size_t threads = ThreadPool::resolve_threads(num_threads_, num_dates_, kMinDatesPerThread);
+        if (threads <= 1) {
+            prepare_dates(0, num_dates_);
+        } else {
+            ThreadPool::shared().parallel_for(num_dates_, threads, prepare_dates);
+        }
+
+        mean_and_ir(ic_, mean_ic_, ic_ir_);
+        mean_and_ir(rank_ic_, mean_rank_ic_, rank_ic_ir_);
+    }
+
+    // ============================================================================
+    // Runs
+    // ============================================================================
+
+    bool Backtester::accepts(const BacktestConfig& config) const {
+        switch (config.weighting) {
+            case Weighting::TopBottom:
+                break;
+            case Weighting::Rank:
+                break;
+            case Weighting::VolScaled:
+                if (volatility_.empty()) {
+                    return false;
+                }
+                break;
+            default:
+                return false;
+        }
+        if (config.weighting != Weighting::Rank && config.top_k == 0) {
+            return false;
+        }
+        // Negated comparisons also reject NaN
+        return config.gross_exposure > 0.0 && !(config.cost_bps < 0.0) && config.cost_bps == config.cost_bps &&
+               !(config.max_turnover < 0.0) && config.max_turnover == config.max_turnover;
+    }
+
+    void Backtester::fill_target(Workspace& workspace, const BacktestConfig& config, size_t date) const {
+        for (uint32_t j : workspace.picked) {
+            workspace.target[j] = 0.0;
+        }
+        workspace.picked.clear();
+
+        const size_t scored = num_scored_[date];
+        const uint32_t* order = order_.data() + date * num_tickers_;
+        double* target = workspace.target.data();
+        const double side_gross = config.long_only ? config.gross_exposure : 0.5 * config.gross_exposure;
+
+        switch (config.weighting) {
+            case Weighting::TopBottom: {
+                const size_t k = std::min(config.top_k, config.long_only ? scored : scored / 2);
+                if (k == 0) {
+                    return;
+                }
+                const double w = side_gross / static_cast<double>(k);
+                for (size_t p = 0; p < k; ++p) {
+                    target[order[p]] = w;
+                    workspace.picked.push_back(order[p]);
+                }
+                if (!config.long_only) {
+                    for (size_t p = scored - k; p < scored; ++p) {
+                        target[order[p]] = -w;
+                        workspace.picked.push_back(order[p]);
+                    }
+                }
+                return;
+            }
+            case Weighting::Rank: {
+                // Rank minus the middle rank: positive for the better half
+                const double* ranks = ranks_.data() + date * num_tickers_;
+                const double middle = 0.5 * static_cast<double>(scored + 1);
+                double total = 0.0;
+                for (size_t p = 0; p < scored; ++p) {
+                    const double w = config.long_only ? std::max(ranks[p] - middle, 0.0) : ranks[p] - middle;
+                    if (w != 0.0) {
+                        target[order[p]] = w;
+                        workspace.picked.push_back(order[p]);
+                        total += std::abs(w);
+                    }
+                }
+                if (total > 0.0) {
+                    const double scale = config.gross_exposure / total;
+                    for (uint32_t j : workspace.picked) {
+                        target[j] *= scale;
+                    }
+                }
+                return;
+            }
+            case Weighting::VolScaled: {
+                // Only names with a usable volatility compete for the k slots
+                const double* vol = volatility_.data() + date * num_tickers_;
+                auto usable = [vol](uint32_t j) { return vol[j] > 0.0 && std::isfinite(vol[j]); };
+                size_t eligible = 0;
+                for (size_t p = 0; p < scored; ++p) {
+                    eligible += usable(order[p]);
+                }
+                const size_t k = std::min(config.top_k, config.long_only ? eligible : eligible / 2);
+                if (k == 0) {
+                    return;
+                }
+                auto fill_side = [&](bool best, double sign) {
+                    const size_t side_begin = workspace.picked.size();
+                    double total = 0.0;
+                    for (size_t i = 0, taken = 0; taken < k; ++i) {
+                        const uint32_t j = order[best ? i : scored - 1 - i];
+                        if (usable(j)) {
+                            target[j] = 1.0 / vol[j];
+                            total += target[j];
+                            workspace.picked.push_back(j);
+                            ++taken;
+                        }
+                    }
+                    const double scale = sign * side_gross / total;
+                    for (size_t i = side_begin; i < workspace.picked.size(); ++i) {
+                        target[workspace.picked[i]] *= scale;
+                    }
+                };
+                fill_side(true, 1.0);
+                if (!config.long_only) {
+                    fill_side(false, -1.0);
+                }
+                return;
+            }
+        }
+    }
+
+    void Backtester::run_one(Workspace& workspace, const BacktestConfig& config, BacktestSummary& summary,
+                             double* series) const {
+        const size_t n = num_tickers_;
+        double* weights = workspace.weights.data();
+        const double* target = workspace.target.data();
+        std::fill_n(workspace.weights.data(), n, 0.0);
+        std::fill_n(workspace.target.data(), n, 0.0);
+        workspace.picked.clear();
+
+        const double cost_rate = config.cost_bps * 1e-4;
+        double equity = 1.0;
+        double peak = 1.0;
+        double sum_net = 0.0;
+        double sum_net_sq = 0.0;
+        double sum_turnover = 0.0;
+        double total_cost = 0.0;
+        double max_drawdown = 0.0;
+        size_t invested = 0;
+        size_t wins = 0;
+
+        for (size_t d = 0; d < num_dates_; ++d) {
+            fill_target(workspace, config, d);
+
+            double turnover = 0.0;
+            for (size_t j = 0; j < n; ++j) {
+                turnover += std::abs(target[j] - weights[j]);
+            }
+            // Over the cap, trade the same fraction of every name's gap
+            const double step = config.max_turnover > 0.0 && turnover > config.max_turnover
+                ? config.max_turnover / turnover : 1.0;
+            turnover *= step;
+
+            const double* r = returns_.data() + d * n;
+            double gross_return = 0.0;
+            double exposure = 0.0;
+            for (size_t j = 0; j < n; ++j) {
+                const double w = step == 1.0 ? target[j] : weights[j] + step * (target[j] - weights[j]);
+                weights[j] = w;
+                gross_return += w * r[j];
+                exposure += std::abs(w);
+            }
+            const double cost = turnover * cost_rate;
+            const double net = gross_return - cost;
+
+            // Weights drift with their returns, as fractions of the new equity
+            const double growth = 1.0 + net;
+            if (growth > 0.0) {
+                const double inv_growth = 1.0 / growth;
+                for (size_t j = 0; j < n; ++j) {
+                    weights[j] *= (1.0 + r[j]) * inv_growth;
+                }
+            }
+
+            equity *= growth;
+            peak = std::max(peak, equity);
+            const double drawdown = equity / peak - 1.0;
+            max_drawdown = std::min(max_drawdown, drawdown);
+            sum_net += net;
+            sum_net_sq += net * net;
+            sum_turnover += turnover;
+            total_cost += cost;
+            if (exposure > 0.0) {
+                ++invested;
+                wins += net > 0.0;
+            }
+
+            if (series != nullptr) {
+                series[NetReturn * num_dates_ + d] = net;
+                series[GrossReturn * num_dates_ + d] = gross_return;
+                series[Turnover * num_dates_ + d] = turnover;
+                series[Drawdown * num_dates_ + d] = drawdown;
+            }
+        }
+
+        const double dates = static_cast<double>(num_dates_);
+        const double mean = sum_net / dates;
+        const double var = num_dates_ > 1
+            ? std::max(sum_net_sq - dates * mean * mean, 0.0) / (dates - 1.0) : kNaN;
+        const double sd = std::sqrt(var);
+
+        summary.total_return = equity - 1.0;
+        summary.annual_return = equity > 0.0 ? std::pow(equity, kPeriodsPerYear / dates) - 1.0 : -1.0;
+        summary.annual_volatility = sd * std::sqrt(kPeriodsPerYear);
+        summary.sharpe = sd > 0.0 ? mean / sd * std::sqrt(kPeriodsPerYear) : kNaN;
+        summary.max_drawdown = max_drawdown;
+        summary.hit_rate = invested > 0 ? static_cast<double>(wins) / static_cast<double>(invested) : kNaN;
+        summary.mean_turnover = sum_turnover / dates;
+        summary.total_cost = total_cost;
+        summary.mean_ic = mean_ic_;
+        summary.ic_ir = ic_ir_;
+        summary.mean_rank_ic = mean_rank_ic_;
+        summary.rank_ic_ir = rank_ic_ir_;
+    }
+
+    bool Backtester::run(const BacktestConfig& config, BacktestSummary& summary, double* series) {
+        if (!accepts(config)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(*run_mutex_);
+        run_one(workspaces_[0], config, summary, series);
+        return true;
+    }
+
+    bool Backtester::sweep(const BacktestConfig* configs, size_t num_configs, BacktestSummary* summaries,
+                           double* series) {
+        if (!std::all_of(configs, configs + num_configs, [this](const BacktestConfig& c) { return accepts(c); })) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(*run_mutex_);
+        const size_t series_values = kNumSeries * num_dates_;
+        auto run_configs = [&](size_t thread, size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                run_one(workspaces_[thread], configs[i], summaries[i],
+                        series != nullptr ? series + i * series_values : nullptr);
+            }
+        };
+
+        const size_t threads = std::min(num_threads_, ThreadPool::resolve_threads(num_threads_, num_configs, 1));
+        if (threads <= 1) {
+            run_configs(0, 0, num_configs);
+            return true;
+        }
+        // One chunk per thread, so chunk t owns workspace t
+        ThreadPool::shared().parallel_for(threads, threads, [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; ++t) {
+                run_configs(t, num_configs * t / threads, num_configs * (t + 1) / threads);
+            }
+        });
+        return true;
+    }
+
+    // ============================================================================
+    // Accessors
+    // ============================================================================
+
+    const std::vector<std::string>& Backtester::series_names() {
+        static const std::vector<std::string> names = {"net_return", "gross_return", "turnover", "drawdown"};
+        return names;
+    }
+
+    size_t Backtester::num_dates() const {
+        return num_dates_;
+    }
+
+    size_t Backtester::num_tickers() const {
+        return num_tickers_;
+    }
+
+    size_t Backtester::num_threads() const {
+        return num_threads_;
+    }
+
+    bool Backtester::has_volatility() const {
+        return !volatility_.empty();
+    }
+
+    const std::vector<double>& Backtester::ic() const {
+        return ic_;
+    }
+
+    const std::vector<double>& Backtester::rank_ic() const {
+        return rank_ic_;
+    }
+}
@@ -0,0 +1,122 @@
+#include "bar_dedup.hpp"
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace quantamental {
+    namespace {
+        constexpr size_t kBarKeyBytes = sizeof(uint32_t) + sizeof(int64_t);
+        constexpr size_t kRevisionKeyBytes = kBarKeyBytes + sizeof(int64_t);
+
+        // Rows classified per chunk; the packed keys live on the stack
+        constexpr size_t kChunkRows = 256;
+
+        // Fixed-width native-endian packing. The two key lengths differ, so a
+        // bar key never collides with a revision key by construction.
+        struct PackedKey {
+            char bytes[kRevisionKeyBytes];
+        };
+
+        std::string_view pack(PackedKey& key, uint32_t ticker_id, int64_t timestamp) {
+            std::memcpy(key.bytes, &ticker_id, sizeof ticker_id);
+            std::memcpy(key.bytes + sizeof ticker_id, &timestamp, sizeof timestamp);
+            return std::string_view(key.bytes, kBarKeyBytes);
+        }
+
+        std::string_view pack(PackedKey& key, uint32_t ticker_id, int64_t timestamp, int64_t revision) {
+            pack(key, ticker_id, timestamp);
+            std::memcpy(key.bytes + kBarKeyBytes, &revision, sizeof revision);
+            return std::string_view(key.bytes, kRevisionKeyBytes);
+        }
+    }
+
+    // ============================================================================
+    // Constructors
+    // ============================================================================
+
+    BarDeduplicator::BarDeduplicator(size_t expected_keys, double false_positive_rate,
+                                     BloomFilter::Layout layout)
+        : filter_(expected_keys, false_positive_rate, layout, BloomFilter::HashScheme::WyHash) {}
+
+    BarDeduplicator::BarDeduplicator(BloomFilter filter) : filter_(std::move(filter)) {}
+
+    // ============================================================================
+    // Ingest
+    // ============================================================================
+
+    // Each chunk goes through the filter's batch path, which prefetches the
+    // probes of several keys at once. With revisions, the revision keys go
+    // first: a seen revision is a duplicate, and of the rest, a bar whose
+    // (ticker, timestamp) key was already set is a correction. Both passes
+    // run in row order, so the result matches classifying row by row.
+    size_t BarDeduplicator::classify(const BarBatch& batch, Status* status) {
+        PackedKey bar_keys[kChunkRows];
+        PackedKey revision_keys[kChunkRows];
+        std::string_view keys[kChunkRows];
+        bool bar_new[kChunkRows];
+        bool revision_new[kChunkRows];
+
+        size_t kept = 0;
+        for (size_t base = 0; base < batch.size; base += kChunkRows) {
+            const size_t n = std::min(kChunkRows, batch.size - base);
+            const uint32_t* ticker_ids = batch.ticker_ids + base;
+            const int64_t* timestamps = batch.timestamps + base;
+
+            if (batch.revisions != nullptr) {
+                for (size_t i = 0; i < n; ++i) {
+                    keys[i] = pack(revision_keys[i], ticker_ids[i], timestamps[i], batch.revisions[base + i]);
+                }
+                filter_.insert_and_check_batch(keys, n, revision_new);
+            }
+            for (size_t i = 0; i < n; ++i) {
+                keys[i] = pack(bar_keys[i], ticker_ids[i], timestamps[i]);
+            }
+            filter_.insert_and_check_batch(keys, n, bar_new);
+
+            for (size_t i = 0; i < n; ++i) {
+                Status s;
+                if (bar_new[i]) {
+                    s = Status::New;
+                } else if (batch.revisions != nullptr && revision_new[i]) {
+                    s = Status::Revised;
+                } else {
+                    s = Status::Duplicate;
+                }
+                status[base + i] = s;
+                kept += s != Status::Duplicate;
+            }
+        }
+        return kept;
+    }
+
+    size_t BarDeduplicator::compact(const BarBatch& batch, const Status* status, const BarColumns& out) {
+        const size_t k = batch.num_values;
+        size_t n = 0;
+        for (size_t i = 0; i < batch.size; ++i) {
+            if (status[i] == Status::Duplicate) continue;
+            out.ticker_ids[n] = batch.ticker_ids[i];
+            out.timestamps[n] = batch.timestamps[i];
+            if (batch.revisions != nullptr) out.revisions[n] = batch.revisions[i];
+            std::copy_n(batch.values + i * k, k, out.values + n * k);
+            ++n;
+        }
+        return n;
+    }
+
+    size_t BarDeduplicator::ingest(const BarBatch& batch, Status* status, const BarColumns& out) {
+        classify(batch, status);
+        return compact(batch, status, out);
+    }
+
+    // ============================================================================
+    // Filter
+    // ============================================================================
+
+    const BloomFilter& BarDeduplicator::filter() const {
+        return filter_;
+    }
+
+    BloomFilter& BarDeduplicator::filter() {
+        return filter_;
+    }
+}
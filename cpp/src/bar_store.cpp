@@ -0,0 +1,500 @@
+#include "bar_store.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace quantamental {
+    namespace {
+        // File layout (native-endian, checked via endian_tag); every region
+        // starts on a page:
+        //   [0, 4096)                RawHeader
+        //   [dates_offset, ...)      date_capacity int64 timestamps
+        //   [directory_offset, ...)  ticker_capacity NUL-padded names
+        //   [data_offset, ...)       kNumFields x ticker_capacity columns of
+        //                            date_capacity doubles, field-major
+        // Only rows below num_dates and tickers below num_tickers hold data;
+        // the file is sized with ftruncate, so unused capacity stays sparse.
+        // A writer holds an flock on filepath + ".lock". When it replaces the
+        // file (create or grow), it stores the new file's generation into the
+        // old header, which tells readers still mapping it to remap.
+        constexpr uint32_t kStoreMagic = 0x52414251;  // "QBAR"
+        constexpr uint32_t kStoreVersion = 1;
+        constexpr uint32_t kEndianTag = 0x01020304;
+        constexpr uint64_t kPageBytes = 4096;
+        constexpr uint64_t kNameBytes = BarStore::kMaxTickerLength + 1;
+        constexpr uint64_t kTimezoneBytes = BarStore::kMaxTimezoneLength + 1;
+        constexpr uint64_t kMaxDateCapacity = uint64_t{1} << 32;
+        constexpr uint64_t kMaxTickerCapacity = uint64_t{1} << 20;
+        constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+        struct RawHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t endian_tag;
+            uint32_t header_bytes;
+            uint32_t num_fields;
+            uint32_t name_bytes;
+            uint64_t num_dates;         // Written last by append, read atomically
+            uint64_t num_tickers;
+            uint64_t date_capacity;
+            uint64_t ticker_capacity;
+            uint64_t dates_offset;
+            uint64_t directory_offset;
+            uint64_t data_offset;
+            uint64_t file_bytes;
+            uint64_t generation;        // Bumped in the old header on replacement
+            char timezone[kTimezoneBytes];  // NUL-padded; empty for naive dates
+        };
+        static_assert(sizeof(RawHeader) == 160, "RawHeader layout is part of the file format");
+
+        uint64_t page_align(uint64_t n) {
+            return (n + kPageBytes - 1) / kPageBytes * kPageBytes;
+        }
+
+        // Region offsets for the given capacities, in a header with only
+        // those filled in
+        RawHeader layout_for(uint64_t date_capacity, uint64_t ticker_capacity) {
+            RawHeader raw{};
+            raw.magic = kStoreMagic;
+            raw.version = kStoreVersion;
+            raw.endian_tag = kEndianTag;
+            raw.header_bytes = sizeof(RawHeader);
+            raw.num_fields = BarStore::kNumFields;
+            raw.name_bytes = kNameBytes;
+            raw.date_capacity = date_capacity;
+            raw.ticker_capacity = ticker_capacity;
+            raw.dates_offset = kPageBytes;
+            raw.directory_offset = page_align(raw.dates_offset + date_capacity * sizeof(int64_t));
+            raw.data_offset = page_align(raw.directory_offset + ticker_capacity * kNameBytes);
+            raw.file_bytes = raw.data_offset +
+                             BarStore::kNumFields * ticker_capacity * date_capacity * sizeof(double);
+            return raw;
+        }
+
+        bool valid_name(const std::string& ticker) {
+            return !ticker.empty() && ticker.size() <= BarStore::kMaxTickerLength &&
+                   ticker.find('\0') == std::string::npos;
+        }
+
+        bool valid_timezone(const std::string& timezone) {
+            return timezone.size() <= BarStore::kMaxTimezoneLength &&
+                   timezone.find('\0') == std::string::npos;
+        }
+    }
+
+    namespace detail {
+        // One mmap of a store file, shared by the store and any views of it
+        struct BarStoreMapping {
+            void* base = nullptr;
+            size_t size = 0;
+            RawHeader* header = nullptr;
+            int64_t* dates = nullptr;
+            char* directory = nullptr;
+            double* data = nullptr;
+
+            BarStoreMapping(void* mapped, size_t mapped_size) : base(mapped), size(mapped_size) {
+                char* bytes = static_cast<char*>(base);
+                header = reinterpret_cast<RawHeader*>(bytes);
+                dates = reinterpret_cast<int64_t*>(bytes + header->dates_offset);
+                directory = bytes + header->directory_offset;
+                data = reinterpret_cast<double*>(bytes + header->data_offset);
+            }
+
+            BarStoreMapping(const BarStoreMapping&) = delete;
+            BarStoreMapping& operator=(const BarStoreMapping&) = delete;
+            ~BarStoreMapping();
+
+            uint64_t num_dates() const {
+                return std::atomic_ref<uint64_t>(header->num_dates).load(std::memory_order_acquire);
+            }
+
+            uint64_t generation() const {
+                return std::atomic_ref<uint64_t>(header->generation).load(std::memory_order_acquire);
+            }
+
+            // Tells readers of this (writable) mapping that the file was replaced
+            void retire(uint64_t next_generation) {
+                std::atomic_ref<uint64_t>(header->generation).store(next_generation, std::memory_order_release);
+            }
+        };
+
+        // Exclusive writer lock, held for the store's lifetime
+        struct BarStoreLock {
+            int fd;
+
+            explicit BarStoreLock(int lock_fd) : fd(lock_fd) {}
+            BarStoreLock(const BarStoreLock&) = delete;
+            BarStoreLock& operator=(const BarStoreLock&) = delete;
+            ~BarStoreLock();
+        };
+    }
+
+    namespace {
+        // ============================================================================
+        // Memory Mapping
+        // ============================================================================
+#if !defined(_WIN32)
+        // Validates the header of a mapped file (before any region is used)
+        bool header_consistent(const void* base, size_t size) {
+            RawHeader raw{};
+            if (size < sizeof(raw)) return false;
+            std::memcpy(&raw, base, sizeof(raw));
+            if (raw.magic != kStoreMagic || raw.version != kStoreVersion ||
+                raw.endian_tag != kEndianTag || raw.header_bytes != sizeof(RawHeader) ||
+                raw.num_fields != BarStore::kNumFields || raw.name_bytes != kNameBytes ||
+                raw.date_capacity == 0 || raw.date_capacity > kMaxDateCapacity ||
+                raw.ticker_capacity == 0 || raw.ticker_capacity > kMaxTickerCapacity ||
+                raw.num_dates > raw.date_capacity || raw.num_tickers > raw.ticker_capacity ||
+                raw.timezone[kTimezoneBytes - 1] != '\0') {
+                return false;
+            }
+            RawHeader expected = layout_for(raw.date_capacity, raw.ticker_capacity);
+            return raw.dates_offset == expected.dates_offset &&
+                   raw.directory_offset == expected.directory_offset &&
+                   raw.data_offset == expected.data_offset &&
+                   raw.file_bytes == expected.file_bytes && raw.file_bytes <= size;
+        }
+
+        std::shared_ptr<detail::BarStoreMapping> map_store(const std::string& filepath, bool writable) {
+            int fd = ::open(filepath.c_str(), writable ? O_RDWR : O_RDONLY);
+            if (fd < 0) return nullptr;
+
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+                ::close(fd);
+                return nullptr;
+            }
+            size_t size = static_cast<size_t>(st.st_size);
+            int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+            void* base = ::mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+            ::close(fd);  // The mapping keeps the file alive
+            if (base == MAP_FAILED) return nullptr;
+
+            if (!header_consistent(base, size)) {
+                ::munmap(base, size);
+                return nullptr;
+            }
+            return std::make_shared<detail::BarStoreMapping>(base, size);
+        }
+
+        // New empty store file with the given capacities
+        std::shared_ptr<detail::BarStoreMapping> create_store(const std::string& filepath,
+                                                              uint64_t date_capacity,
+                                                              uint64_t ticker_capacity) {
+            if (date_capacity > kMaxDateCapacity || ticker_capacity > kMaxTickerCapacity) return nullptr;
+            RawHeader raw = layout_for(date_capacity, ticker_capacity);
+
+            int fd = ::open(filepath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) return nullptr;
+            if (::ftruncate(fd, static_cast<off_t>(raw.file_bytes)) != 0) {
+                ::close(fd);
+                return nullptr;
+            }
+            void* base = ::mmap(nullptr, raw.file_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (base == MAP_FAILED) return nullptr;
+
+            std::memcpy(base, &raw, sizeof(raw));
+            return std::make_shared<detail::BarStoreMapping>(base, raw.file_bytes);
+        }
+
+        bool sync_store(const detail::BarStoreMapping& mapping) {
+            return ::msync(mapping.base, mapping.size, MS_SYNC) == 0;
+        }
+
+        // nullptr while another process (or store) holds the writer lock
+        std::unique_ptr<detail::BarStoreLock> lock_store(const std::string& filepath) {
+            const std::string lock_path = filepath + ".lock";
+            int fd = ::open(lock_path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd < 0) return nullptr;
+            if (::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+                ::close(fd);
+                return nullptr;
+            }
+            return std::make_unique<detail::BarStoreLock>(fd);
+        }
+#else
+        std::shared_ptr<detail::BarStoreMapping> map_store(const std::string&, bool) {
+            return nullptr;
+        }
+
+        std::shared_ptr<detail::BarStoreMapping> create_store(const std::string&, uint64_t, uint64_t) {
+            return nullptr;
+        }
+
+        bool sync_store(const detail::BarStoreMapping&) {
+            return false;
+        }
+
+        std::unique_ptr<detail::BarStoreLock> lock_store(const std::string&) {
+            return nullptr;
+        }
+#endif
+    }
+
+    detail::BarStoreMapping::~BarStoreMapping() {
+#if !defined(_WIN32)
+        ::munmap(base, size);
+#endif
+    }
+
+    detail::BarStoreLock::~BarStoreLock() {
+#if !defined(_WIN32)
+        ::close(fd);  // Releases the flock
+#endif
+    }
+
+    // ============================================================================
+    // Construction
+    // ============================================================================
+
+    std::optional<BarStore> BarStore::create(const std::string& filepath,
+                                             const std::vector<std::string>& tickers,
+                                             size_t date_capacity, const std::string& timezone) {
+        std::unordered_map<std::string, size_t> seen;
+        for (const std::string& ticker : tickers) {
+            if (!valid_name(ticker) || !seen.emplace(ticker, seen.size()).second) return std::nullopt;
+        }
+        if (!valid_timezone(timezone)) return std::nullopt;
+        auto lock = lock_store(filepath);
+        if (!lock) return std::nullopt;
+
+        // Built aside and renamed into place, so a reader still mapping an
+        // older store at filepath keeps a complete file
+        auto replaced = map_store(filepath, true);
+        const std::string tmp_path = filepath + ".tmp";
+        uint64_t ticker_capacity = std::bit_ceil(std::max<uint64_t>(tickers.size(), 1));
+        auto mapping = create_store(tmp_path, std::max<uint64_t>(date_capacity, 1), ticker_capacity);
+        if (!mapping) return std::nullopt;
+
+        for (size_t j = 0; j < tickers.size(); ++j) {
+            std::memcpy(mapping->directory + j * kNameBytes, tickers[j].data(), tickers[j].size());
+        }
+        std::memcpy(mapping->header->timezone, timezone.data(), timezone.size());
+        mapping->header->num_tickers = tickers.size();
+        mapping->header->generation = replaced ? replaced->generation() + 1 : 0;
+        if (std::rename(tmp_path.c_str(), filepath.c_str()) != 0) {
+            std::remove(tmp_path.c_str());
+            return std::nullopt;
+        }
+        if (replaced) replaced->retire(mapping->header->generation);
+
+        BarStore store(filepath, std::move(mapping), std::move(lock));
+        store.read_directory();
+        return store;
+    }
+
+    std::optional<BarStore> BarStore::open(const std::string& filepath, bool writable) {
+        std::unique_ptr<detail::BarStoreLock> lock;
+        if (writable && !(lock = lock_store(filepath))) return std::nullopt;
+        auto mapping = map_store(filepath, writable);
+        if (!mapping) return std::nullopt;
+
+        BarStore store(filepath, std::move(mapping), std::move(lock));
+        if (!store.read_directory()) return std::nullopt;
+        return store;
+    }
+
+    BarStore::BarStore(std::string filepath, std::shared_ptr<detail::BarStoreMapping> mapping,
+                       std::unique_ptr<detail::BarStoreLock> lock)
+        : filepath_(std::move(filepath)), mapping_(std::move(mapping)), lock_(std::move(lock)),
+          writable_(lock_ != nullptr), generation_(mapping_->generation()),
+          timezone_(mapping_->header->timezone) {}
+
+    BarStore::BarStore(BarStore&& other) noexcept = default;
+    BarStore& BarStore::operator=(BarStore&& other) noexcept = default;
+    BarStore::~BarStore() = default;
+
+    bool BarStore::refresh() {
+        if (mapping_->generation() != generation_) {
+            auto mapping = map_store(filepath_, writable_);
+            if (!mapping) return false;
+            mapping_ = std::move(mapping);
+            generation_ = mapping_->generation();
+            timezone_ = mapping_->header->timezone;
+            return read_directory();
+        }
+        if (mapping_->header->num_tickers != tickers_.size()) return read_directory();
+        return true;
+    }
+
+    bool BarStore::read_directory() {
+        tickers_.clear();
+        ticker_index_.clear();
+        for (size_t j = 0; j < mapping_->header->num_tickers; ++j) {
+            const char* slot = mapping_->directory + j * kNameBytes;
+            std::string ticker(slot, strnlen(slot, kNameBytes));
+            if (!valid_name(ticker) || !ticker_index_.emplace(ticker, j).second) return false;
+            tickers_.push_back(std::move(ticker));
+        }
+        return true;
+    }
+
+    // ============================================================================
+    // Queries
+    // ============================================================================
+
+    size_t BarStore::num_dates() const {
+        return mapping_->num_dates();
+    }
+
+    const int64_t* BarStore::dates() const {
+        return mapping_->dates;
+    }
+
+    size_t BarStore::num_tickers() const {
+        return tickers_.size();
+    }
+
+    const std::vector<std::string>& BarStore::tickers() const {
+        return tickers_;
+    }
+
+    std::optional<size_t> BarStore::find_ticker(const std::string& ticker) const {
+        auto it = ticker_index_.find(ticker);
+        if (it == ticker_index_.end()) return std::nullopt;
+        return it->second;
+    }
+
+    std::pair<size_t, size_t> BarStore::date_rows(int64_t first, int64_t last) const {
+        const int64_t* begin = mapping_->dates;
+        const int64_t* end = begin + num_dates();
+        const int64_t* lo = std::lower_bound(begin, end, first);
+        const int64_t* hi = std::upper_bound(lo, end, last);
+        return {static_cast<size_t>(lo - begin), static_cast<size_t>(hi - begin)};
+    }
+
+    const double* BarStore::column(Field field, size_t ticker) const {
+        const RawHeader& header = *mapping_->header;
+        size_t index = static_cast<size_t>(field) * header.ticker_capacity + ticker;
+        return mapping_->data + index * header.date_capacity;
+    }
+
+    double* BarStore::mutable_column(Field field, size_t ticker) {
+        return const_cast<double*>(column(field, ticker));
+    }
+
+    size_t BarStore::column_stride() const {
+        return mapping_->header->date_capacity;
+    }
+
+    std::shared_ptr<const void> BarStore::mapping() const {
+        return mapping_;
+    }
+
+    bool BarStore::writable() const {
+        return writable_;
+    }
+
+    const std::string& BarStore::timezone() const {
+        return timezone_;
+    }
+
+    // ============================================================================
+    // Updates
+    // ============================================================================
+
+    // Rewrites the store into a fresh file with larger capacities and swaps
+    // it in by rename. The old mapping lives on while anything references it,
+    // and its readers see the bumped generation and remap on refresh().
+    bool BarStore::grow(size_t date_capacity, size_t ticker_capacity) {
+        const std::string tmp_path = filepath_ + ".tmp";
+        auto grown = create_store(tmp_path, date_capacity, ticker_capacity);
+        if (!grown) return false;
+
+        const size_t n = num_dates();
+        const size_t num_tickers = tickers_.size();
+        std::memcpy(grown->dates, mapping_->dates, n * sizeof(int64_t));
+        std::memcpy(grown->directory, mapping_->directory, num_tickers * kNameBytes);
+        for (size_t f = 0; f < kNumFields; ++f) {
+            for (size_t j = 0; j < num_tickers; ++j) {
+                const double* src = column(static_cast<Field>(f), j);
+                double* dst = grown->data + (f * ticker_capacity + j) * date_capacity;
+                std::memcpy(dst, src, n * sizeof(double));
+            }
+        }
+        std::memcpy(grown->header->timezone, mapping_->header->timezone, kTimezoneBytes);
+        grown->header->num_tickers = num_tickers;
+        grown->header->num_dates = n;
+        grown->header->generation = generation_ + 1;
+
+        if (!sync_store(*grown) || std::rename(tmp_path.c_str(), filepath_.c_str()) != 0) {
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+        mapping_->retire(grown->header->generation);
+        mapping_ = std::move(grown);
+        generation_ = mapping_->generation();
+        return true;
+    }
+
+    std::optional<size_t> BarStore::add_ticker(const std::string& ticker) {
+        if (!writable_ || !valid_name(ticker) || ticker_index_.count(ticker)) return std::nullopt;
+
+        const size_t j = tickers_.size();
+        const RawHeader& header = *mapping_->header;
+        if (j == header.ticker_capacity && !grow(header.date_capacity, 2 * header.ticker_capacity)) {
+            return std::nullopt;
+        }
+
+        char* slot = mapping_->directory + j * kNameBytes;
+        std::memset(slot, 0, kNameBytes);
+        std::memcpy(slot, ticker.data(), ticker.size());
+        const size_t n = num_dates();
+        for (size_t f = 0; f < kNumFields; ++f) {
+            std::fill_n(mutable_column(static_cast<Field>(f), j), n, kNaN);
+        }
+        mapping_->header->num_tickers = j + 1;
+        tickers_.push_back(ticker);
+        ticker_index_.emplace(ticker, j);
+        return j;
+    }
+
+    bool BarStore::append(const int64_t* dates, size_t n, const double* values) {
+        if (!writable_) return false;
+        const size_t num_existing = num_dates();
+        for (size_t r = 0; r < n; ++r) {
+            bool after_last = r > 0 ? dates[r] > dates[r - 1]
+                                    : num_existing == 0 || dates[0] > mapping_->dates[num_existing - 1];
+            if (!after_last) return false;
+        }
+        if (n == 0) return true;
+
+        const size_t needed = num_existing + n;
+        const RawHeader& header = *mapping_->header;
+        if (needed > header.date_capacity &&
+            !grow(std::max<size_t>(2 * header.date_capacity, std::bit_ceil(needed)), header.ticker_capacity)) {
+            return false;
+        }
+
+        const size_t num_tickers = tickers_.size();
+        for (size_t f = 0; f < kNumFields; ++f) {
+            for (size_t j = 0; j < num_tickers; ++j) {
+                double* col = mutable_column(static_cast<Field>(f), j) + num_existing;
+                for (size_t r = 0; r < n; ++r) {
+                    col[r] = values[(r * kNumFields + f) * num_tickers + j];
+                }
+            }
+        }
+        std::memcpy(mapping_->dates + num_existing, dates, n * sizeof(int64_t));
+        // Publish the rows only once they are written
+        std::atomic_ref<uint64_t>(mapping_->header->num_dates).store(needed, std::memory_order_release);
+        return true;
+    }
+
+    bool BarStore::flush() {
+        return writable_ && sync_store(*mapping_);
+    }
+}
@@ -0,0 +1,568 @@
+#include "binary_fuse_filter.hpp"
+#include "bloom_probe.hpp"
+#include "bloom_file.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace quantamental {
+    namespace {
+        constexpr size_t kMinKeysPerThread = 16384;   // Below this threads cost more than they save
+        constexpr uint32_t kArity = 3;
+        constexpr int kMaxAttempts = 100;
+
+        // File layout: RawFuseHeader at 0, slot array at data_offset (a
+        // multiple of 4096), mirroring the BloomFilter file layout
+        constexpr uint32_t kFuseMagic = 0x53554651;   // "QFUS"
+        constexpr uint32_t kFuseVersion = 1;
+        constexpr uint32_t kEndianTag = 0x01020304;
+
+        struct RawFuseHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t endian_tag;
+            uint32_t header_bytes;
+            uint32_t fingerprint_bits;
+            uint32_t segment_length;
+            uint32_t segment_count;
+            uint32_t array_length;
+            uint64_t seed;
+            uint64_t num_keys;
+            uint64_t num_words;
+            uint64_t data_offset;
+            uint64_t checksum;
+        };
+        static_assert(sizeof(RawFuseHeader) == 72, "RawFuseHeader layout is part of the file format");
+
+        // MurmurHash3 finalizer: a bijection, so distinct key hashes stay
+        // distinct under every seed
+        inline uint64_t mix64(uint64_t h) {
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+            return h;
+        }
+
+        inline uint64_t splitmix64(uint64_t& state) {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+        inline uint64_t mulhi(uint64_t a, uint64_t b) {
+#if defined(_MSC_VER)
+            return __umulh(a, b);
+#else
+            return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64);
+#endif
+        }
+
+        inline uint32_t mod3(uint32_t x) {
+            return x > 2 ? x - 3 : x;
+        }
+
+        // Slots are read and written through bytes so 16-bit fingerprints
+        // do not alias the uint64_t storage
+        template <typename F>
+        inline F load_slot(const unsigned char* slots, size_t i) {
+            F value;
+            std::memcpy(&value, slots + i * sizeof(F), sizeof(F));
+            return value;
+        }
+
+        template <typename F>
+        inline void store_slot(unsigned char* slots, size_t i, F value) {
+            std::memcpy(slots + i * sizeof(F), &value, sizeof(F));
+        }
+
+        template <typename F>
+        inline F fingerprint_of(uint64_t hash) {
+            return static_cast<F>(hash ^ (hash >> 32));
+        }
+
+        // Sorts chunks on the pool, then merges neighbours pairwise
+        void parallel_sort(std::vector<uint64_t>& values, size_t threads) {
+            if (threads <= 1) {
+                std::sort(values.begin(), values.end());
+                return;
+            }
+
+            std::vector<size_t> bounds(threads + 1);
+            for (size_t c = 0; c <= threads; ++c) {
+                bounds[c] = values.size() * c / threads;
+            }
+            auto at = [&](size_t c) { return values.begin() + bounds[c]; };
+
+            ThreadPool& pool = ThreadPool::shared();
+            pool.parallel_for(threads, threads, [&](size_t begin, size_t end) {
+                for (size_t c = begin; c < end; ++c) std::sort(at(c), at(c + 1));
+            });
+            for (size_t width = 1; width < threads; width *= 2) {
+                size_t pairs = (threads + 2 * width - 1) / (2 * width);
+                pool.parallel_for(pairs, pairs, [&](size_t begin, size_t end) {
+                    for (size_t p = begin; p < end; ++p) {
+                        size_t lo = p * 2 * width;
+                        size_t mid = std::min(lo + width, threads);
+                        size_t hi = std::min(lo + 2 * width, threads);
+                        if (mid < hi) std::inplace_merge(at(lo), at(mid), at(hi));
+                    }
+                });
+            }
+        }
+
+        // Distinct 64-bit key hashes, the input to construction
+        template <typename KeyAt>
+        std::vector<uint64_t> distinct_key_hashes(size_t count, KeyAt&& key_at, size_t num_threads) {
+            std::vector<uint64_t> hashes(count);
+            size_t threads = ThreadPool::resolve_threads(num_threads, count, kMinKeysPerThread);
+            auto hash_range = [&](size_t begin, size_t end) {
+                constexpr size_t kBlock = detail::kBatchBlock;
+                std::string_view keys[kBlock];
+                detail::KeyHash block[kBlock];
+                for (size_t base = begin; base < end; base += kBlock) {
+                    size_t n = std::min(kBlock, end - base);
+                    for (size_t i = 0; i < n; ++i) {
+                        keys[i] = key_at(base + i);
+                    }
+                    detail::Murmur3Hash::hash_block(keys, n, block);
+                    for (size_t i = 0; i < n; ++i) {
+                        hashes[base + i] = block[i].h1;
+                    }
+                }
+            };
+            if (threads <= 1) {
+                hash_range(0, count);
+            } else {
+                ThreadPool::shared().parallel_for(count, threads, hash_range);
+            }
+
+            parallel_sort(hashes, threads);
+            hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+            return hashes;
+        }
+    }
+
+    // ============================================================================
+    // Construction
+    // ============================================================================
+
+    void BinaryFuseFilter::SlotArrayDeleter::operator()(uint64_t* words) const {
+        if (mapping != nullptr) {
+            detail::unmap_bloom_file(mapping, mapping_size);
+        } else {
+            delete[] words;
+        }
+    }
+
+    // Segment sizing from the reference implementation (3-wise fuse)
+    BinaryFuseFilter::BinaryFuseFilter(Fingerprint fingerprint, uint64_t num_keys)
+        : fingerprint_(fingerprint), num_keys_(num_keys), seed_(0), stored_checksum_(0) {
+        const double n = static_cast<double>(num_keys);
+        segment_length_ = num_keys == 0
+            ? 4 : 1u << static_cast<int>(std::floor(std::log(n) / std::log(3.33) + 2.25));
+        segment_length_ = std::min<uint32_t>(segment_length_, 262144);
+        segment_length_mask_ = segment_length_ - 1;
+
+        double size_factor = num_keys <= 1
+            ? 0.0 : std::max(1.125, 0.875 + 0.25 * std::log(1000000.0) / std::log(n));
+        uint64_t capacity = static_cast<uint64_t>(std::round(n * size_factor));
+        int64_t segments = static_cast<int64_t>((capacity + segment_length_ - 1) / segment_length_) -
+                           static_cast<int64_t>(kArity - 1);
+        segment_count_ = static_cast<uint32_t>(std::max<int64_t>(segments, 1));
+        array_length_ = (segment_count_ + kArity - 1) * segment_length_;
+        segment_count_length_ = segment_count_ * segment_length_;
+
+        size_t slot_bytes = static_cast<size_t>(array_length_) * (static_cast<uint32_t>(fingerprint_) / 8);
+        num_words_ = (slot_bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    }
+
+    void BinaryFuseFilter::allocate_slots() {
+        slots_ = std::unique_ptr<uint64_t[], SlotArrayDeleter>(new uint64_t[num_words_]());
+    }
+
+    // Peeling construction (Graf & Lemire, Algorithm 3): count the keys on
+    // every slot, repeatedly remove a key that is alone on one of its slots,
+    // then assign fingerprints in reverse removal order. A seed that leaves
+    // a cycle is retried with the next one.
+    template <typename F>
+    bool BinaryFuseFilter::populate(std::vector<uint64_t>& hashes) {
+        const size_t size = hashes.size();
+        std::vector<uint64_t> reverse_order(size + 1, 0);
+        std::vector<uint8_t> reverse_h(size);
+        std::vector<uint8_t> t2count(array_length_, 0);
+        std::vector<uint64_t> t2hash(array_length_, 0);
+        std::vector<uint32_t> alone(array_length_);
+
+        // Keys are bucketed by segment first so the counting pass walks the
+        // slot array roughly in order
+        uint32_t block_bits = 1;
+        while ((1u << block_bits) < segment_count_) ++block_bits;
+        const size_t num_blocks = size_t(1) << block_bits;
+        const size_t block_mask = num_blocks - 1;
+        std::vector<size_t> start_pos(num_blocks);
+
+        auto positions = [this](uint64_t hash, uint32_t h012[5]) {
+            uint64_t hi = mulhi(hash, segment_count_length_);
+            h012[0] = static_cast<uint32_t>(hi);
+            h012[1] = h012[0] + segment_length_;
+            h012[2] = h012[1] + segment_length_;
+            h012[1] ^= static_cast<uint32_t>(hash >> 18) & segment_length_mask_;
+            h012[2] ^= static_cast<uint32_t>(hash) & segment_length_mask_;
+            h012[3] = h012[0];
+            h012[4] = h012[1];
+        };
+
+        uint64_t rng = 0x726b2b9d438b9d4dULL;
+        size_t stack_size = 0;
+        for (int attempt = 0; ; ++attempt) {
+            if (attempt == kMaxAttempts) return false;
+            seed_ = splitmix64(rng);
+
+            std::fill(reverse_order.begin(), reverse_order.end(), 0);
+            reverse_order[size] = 1;   // Sentinel stops the bucket scan
+            std::fill(t2count.begin(), t2count.end(), 0);
+            std::fill(t2hash.begin(), t2hash.end(), 0);
+
+            for (size_t b = 0; b < num_blocks; ++b) {
+                start_pos[b] = (b * size) >> block_bits;
+            }
+            for (uint64_t key : hashes) {
+                uint64_t hash = mix64(key + seed_);
+                size_t block = hash >> (64 - block_bits);
+                while (reverse_order[start_pos[block]] != 0) {
+                    block = (block + 1) & block_mask;
+                }
+                reverse_order[start_pos[block]] = hash;
+                ++start_pos[block];
+            }
+
+            bool overflow = false;
+            uint32_t h012[5];
+            for (size_t i = 0; i < size; ++i) {
+                uint64_t hash = reverse_order[i];
+                positions(hash, h012);
+                t2count[h012[0]] += 4;
+                t2hash[h012[0]] ^= hash;
+                t2count[h012[1]] += 4;
+                t2count[h012[1]] ^= 1;
+                t2hash[h012[1]] ^= hash;
+                t2count[h012[2]] += 4;
+                t2count[h012[2]] ^= 2;
+                t2hash[h012[2]] ^= hash;
+                overflow |= t2count[h012[0]] < 4 || t2count[h012[1]] < 4 || t2count[h012[2]] < 4;
+            }
+            if (overflow) continue;
+
+            // Each count holds 4 * keys on the slot plus the XOR of the slot
+            // indices (0-2) the keys reach it through
+            size_t queue_size = 0;
+            for (uint32_t i = 0; i < array_length_; ++i) {
+                alone[queue_size] = i;
+                queue_size += (t2count[i] >> 2) == 1;
+            }
+
+            stack_size = 0;
+            while (queue_size > 0) {
+                uint32_t index = alone[--queue_size];
+                if ((t2count[index] >> 2) != 1) continue;
+
+                uint64_t hash = t2hash[index];
+                positions(hash, h012);
+                uint8_t found = t2count[index] & 3;
+                reverse_h[stack_size] = found;
+                reverse_order[stack_size] = hash;
+                ++stack_size;
+
+                uint32_t other1 = h012[found + 1];
+                alone[queue_size] = other1;
+                queue_size += (t2count[other1] >> 2) == 2;
+                t2count[other1] -= 4;
+                t2count[other1] ^= mod3(found + 1);
+                t2hash[other1] ^= hash;
+
+                uint32_t other2 = h012[found + 2];
+                alone[queue_size] = other2;
+                queue_size += (t2count[other2] >> 2) == 2;
+                t2count[other2] -= 4;
+                t2count[other2] ^= mod3(found + 2);
+                t2hash[other2] ^= hash;
+            }
+            if (stack_size == size) break;
+        }
+
+        unsigned char* slots = reinterpret_cast<unsigned char*>(slots_.get());
+        uint32_t h012[5];
+        for (size_t i = stack_size; i-- > 0;) {
+            uint64_t hash = reverse_order[i];
+            positions(hash, h012);
+            uint8_t found = reverse_h[i];
+            F value = fingerprint_of<F>(hash) ^ load_slot<F>(slots, h012[found + 1]) ^
+                      load_slot<F>(slots, h012[found + 2]);
+            store_slot<F>(slots, h012[found], value);
+        }
+        return true;
+    }
+
+    std::optional<BinaryFuseFilter> BinaryFuseFilter::build_from_hashes(std::vector<uint64_t>& hashes,
+                                                                        Fingerprint fingerprint) {
+        // Slot indices are 32-bit
+        if (hashes.size() > 3500000000ULL) return std::nullopt;
+
+        BinaryFuseFilter filter(fingerprint, hashes.size());
+        filter.allocate_slots();
+        bool built = fingerprint == Fingerprint::Bits8
+            ? filter.populate<uint8_t>(hashes) : filter.populate<uint16_t>(hashes);
+        if (!built) return std::nullopt;
+        return filter;
+    }
+
+    std::optional<BinaryFuseFilter> BinaryFuseFilter::build(const KeyBuffer& keys, Fingerprint fingerprint,
+                                                            size_t num_threads) {
+        auto hashes = distinct_key_hashes(keys.size(), [&keys](size_t i) { return keys[i]; }, num_threads);
+        return build_from_hashes(hashes, fingerprint);
+    }
+
+    std::optional<BinaryFuseFilter> BinaryFuseFilter::build(const std::vector<std::string>& keys,
+                                                            Fingerprint fingerprint, size_t num_threads) {
+        auto hashes = distinct_key_hashes(keys.size(), [&keys](size_t i) {
+            return std::string_view(keys[i]);
+        }, num_threads);
+        return build_from_hashes(hashes, fingerprint);
+    }
+
+    // ============================================================================
+    // Queries
+    // ============================================================================
+    // A key is hashed as in construction; its fingerprint must equal the XOR
+    // of its three slots. Batches use the hash / prefetch / probe pipeline.
+
+    bool BinaryFuseFilter::possibly_contains(std::string_view key) const {
+        bool is_new;
+        auto key_at = [key](size_t) { return key; };
+        if (fingerprint_ == Fingerprint::Bits8) {
+            filter_range<uint8_t>(0, 1, key_at, &is_new);
+        } else {
+            filter_range<uint16_t>(0, 1, key_at, &is_new);
+        }
+        return !is_new;
+    }
+
+    template <typename F, typename KeyAt>
+    void BinaryFuseFilter::filter_range(size_t begin, size_t end, KeyAt&& key_at, bool* is_new) const {
+        if (num_keys_ == 0) {
+            std::fill(is_new + begin, is_new + end, true);
+            return;
+        }
+
+        const unsigned char* slots = reinterpret_cast<const unsigned char*>(slots_.get());
+        constexpr size_t kBlock = detail::kBatchBlock;
+        for (size_t base = begin; base < end; base += kBlock) {
+            size_t n = std::min(kBlock, end - base);
+
+            std::string_view keys[kBlock];
+            detail::KeyHash key_hashes[kBlock];
+            for (size_t i = 0; i < n; ++i) {
+                keys[i] = key_at(base + i);
+            }
+            detail::Murmur3Hash::hash_block(keys, n, key_hashes);
+
+            uint64_t hashes[kBlock];
+            uint32_t h0[kBlock], h1[kBlock], h2[kBlock];
+            for (size_t i = 0; i < n; ++i) {
+                uint64_t hash = mix64(key_hashes[i].h1 + seed_);
+                hashes[i] = hash;
+                h0[i] = static_cast<uint32_t>(mulhi(hash, segment_count_length_));
+                h1[i] = (h0[i] + segment_length_) ^ (static_cast<uint32_t>(hash >> 18) & segment_length_mask_);
+                h2[i] = (h0[i] + 2 * segment_length_) ^ (static_cast<uint32_t>(hash) & segment_length_mask_);
+            }
+            for (size_t i = 0; i < n; ++i) {
+                BLOOM_PREFETCH_READ(slots + h0[i] * sizeof(F));
+                BLOOM_PREFETCH_READ(slots + h1[i] * sizeof(F));
+                BLOOM_PREFETCH_READ(slots + h2[i] * sizeof(F));
+            }
+            for (size_t i = 0; i < n; ++i) {
+                F value = fingerprint_of<F>(hashes[i]) ^ load_slot<F>(slots, h0[i]) ^
+                          load_slot<F>(slots, h1[i]) ^ load_slot<F>(slots, h2[i]);
+                is_new[base + i] = value != 0;
+            }
+        }
+    }
+
+    std::vector<size_t> BinaryFuseFilter::filter_new(const std::vector<std::string>& keys) const {
+        auto is_new = std::make_unique<bool[]>(keys.size());
+        auto key_at = [&keys](size_t i) { return std::string_view(keys[i]); };
+        if (fingerprint_ == Fingerprint::Bits8) {
+            filter_range<uint8_t>(0, keys.size(), key_at, is_new.get());
+        } else {
+            filter_range<uint16_t>(0, keys.size(), key_at, is_new.get());
+        }
+
+        std::vector<size_t> new_indices;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (is_new[i]) {
+                new_indices.push_back(i);
+            }
+        }
+        return new_indices;
+    }
+
+    void BinaryFuseFilter::filter_new_mask(const KeyBuffer& keys, bool* is_new, size_t num_threads) const {
+        auto key_at = [&keys](size_t i) { return keys[i]; };
+        auto run = [&](size_t begin, size_t end) {
+            if (fingerprint_ == Fingerprint::Bits8) {
+                filter_range<uint8_t>(begin, end, key_at, is_new);
+            } else {
+                filter_range<uint16_t>(begin, end, key_at, is_new);
+            }
+        };
+
+        size_t threads = ThreadPool::resolve_threads(num_threads, keys.size(), kMinKeysPerThread);
+        if (threads <= 1) {
+            run(0, keys.size());
+        } else {
+            ThreadPool::shared().parallel_for(keys.size(), threads, run);
+        }
+    }
+
+    // ============================================================================
+    // Statistics
+    // ============================================================================
+
+    uint64_t BinaryFuseFilter::num_keys() const {
+        return num_keys_;
+    }
+
+    BinaryFuseFilter::Fingerprint BinaryFuseFilter::fingerprint() const {
+        return fingerprint_;
+    }
+
+    double BinaryFuseFilter::false_positive_rate() const {
+        return std::ldexp(1.0, -static_cast<int>(fingerprint_));
+    }
+
+    double BinaryFuseFilter::bits_per_key() const {
+        if (num_keys_ == 0) return 0.0;
+        return static_cast<double>(array_length_) * static_cast<uint32_t>(fingerprint_) / num_keys_;
+    }
+
+    size_t BinaryFuseFilter::size_bits() const {
+        return static_cast<size_t>(array_length_) * static_cast<uint32_t>(fingerprint_);
+    }
+
+    size_t BinaryFuseFilter::size_bytes() const {
+        return num_words_ * sizeof(uint64_t);
+    }
+
+    // ============================================================================
+    // Persistence
+    // ============================================================================
+
+    bool BinaryFuseFilter::save_to_file(const std::string& filepath) const {
+        std::ofstream file(filepath, std::ios::binary);
+        if (!file) return false;
+
+        RawFuseHeader raw{};
+        raw.magic = kFuseMagic;
+        raw.version = kFuseVersion;
+        raw.endian_tag = kEndianTag;
+        raw.header_bytes = sizeof(RawFuseHeader);
+        raw.fingerprint_bits = static_cast<uint32_t>(fingerprint_);
+        raw.segment_length = segment_length_;
+        raw.segment_count = segment_count_;
+        raw.array_length = array_length_;
+        raw.seed = seed_;
+        raw.num_keys = num_keys_;
+        raw.num_words = num_words_;
+        raw.data_offset = detail::kDataAlignment;
+        raw.checksum = detail::bloom_checksum(slots_.get(), num_words_, 0);
+
+        char page[detail::kDataAlignment] = {};
+        std::memcpy(page, &raw, sizeof(raw));
+        file.write(page, sizeof(page));
+        file.write(reinterpret_cast<const char*>(slots_.get()), num_words_ * sizeof(uint64_t));
+        return file.good();
+    }
+
+    std::optional<BinaryFuseFilter> BinaryFuseFilter::from_file(const std::string& filepath, bool mapped,
+                                                                bool verify) {
+        RawFuseHeader raw{};
+        std::optional<detail::FileMapping> mapping;
+        std::ifstream file;
+        if (mapped) {
+            mapping = detail::map_file(filepath, BloomFilter::MapMode::ReadOnly);
+            if (!mapping) return std::nullopt;
+            if (mapping->size >= sizeof(raw)) std::memcpy(&raw, mapping->base, sizeof(raw));
+        } else {
+            file.open(filepath, std::ios::binary);
+            if (!file) return std::nullopt;
+            file.read(reinterpret_cast<char*>(&raw), sizeof(raw));
+        }
+
+        // The stored sizing must be exactly what num_keys gives, so a
+        // corrupt header cannot send queries outside the slot array
+        bool valid = raw.magic == kFuseMagic && raw.version == kFuseVersion &&
+                     raw.endian_tag == kEndianTag && raw.header_bytes == sizeof(RawFuseHeader) &&
+                     (raw.fingerprint_bits == 8 || raw.fingerprint_bits == 16) &&
+                     raw.data_offset >= sizeof(RawFuseHeader) &&
+                     raw.data_offset % detail::kDataAlignment == 0;
+        std::optional<BinaryFuseFilter> filter;
+        if (valid) {
+            filter.emplace(BinaryFuseFilter(static_cast<Fingerprint>(raw.fingerprint_bits), raw.num_keys));
+            valid = filter->segment_length_ == raw.segment_length &&
+                    filter->segment_count_ == raw.segment_count &&
+                    filter->array_length_ == raw.array_length && filter->num_words_ == raw.num_words;
+        }
+        if (valid && mapped) {
+            valid = raw.data_offset + raw.num_words * sizeof(uint64_t) <= mapping->size;
+        }
+        if (!valid) {
+            if (mapping) detail::unmap_bloom_file(mapping->base, mapping->size);
+            return std::nullopt;
+        }
+
+        filter->seed_ = raw.seed;
+        filter->stored_checksum_ = raw.checksum;
+        if (mapped) {
+            uint64_t* words = reinterpret_cast<uint64_t*>(static_cast<char*>(mapping->base) + raw.data_offset);
+            filter->slots_ = std::unique_ptr<uint64_t[], SlotArrayDeleter>(
+                words, SlotArrayDeleter{mapping->base, mapping->size});
+            detail::advise_random(words, raw.num_words * sizeof(uint64_t));
+        } else {
+            filter->allocate_slots();
+            file.seekg(static_cast<std::streamoff>(raw.data_offset));
+            file.read(reinterpret_cast<char*>(filter->slots_.get()), raw.num_words * sizeof(uint64_t));
+            if (!file) return std::nullopt;
+            verify = true;
+        }
+
+        if (verify && !filter->verify_checksum()) return std::nullopt;
+        return filter;
+    }
+
+    std::optional<BinaryFuseFilter> BinaryFuseFilter::load_from_file(const std::string& filepath) {
+        return from_file(filepath, false, true);
+    }
+
+    std::optional<BinaryFuseFilter> BinaryFuseFilter::open_mapped(const std::string& filepath, bool verify) {
+        return from_file(filepath, true, verify);
+    }
+
+    bool BinaryFuseFilter::verify_checksum(size_t num_threads) const {
+        if (stored_checksum_ == 0) return true;
+        return detail::bloom_checksum(slots_.get(), num_words_, num_threads) == stored_checksum_;
+    }
+
+    bool BinaryFuseFilter::is_mapped() const {
+        return slots_.get_deleter().mapping != nullptr;
+    }
+}
@@ -2,13 +2,436 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>  // For std::vector, std::optional, std::string
 #include <pybind11/operators.h>
+#include <pybind11/numpy.h>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <type_traits>
+#include "backtester.hpp"
+#include "bar_dedup.hpp"
+#include "bar_store.hpp"
+#include "binary_fuse_filter.hpp"
 #include "bloom_filter.hpp"
+#include "concurrent_bloom_filter.hpp"
+#include "cross_section.hpp"
+#include "feature_cache.hpp"
+#include "filter_checkpointer.hpp"
+#include "indicator_engine.hpp"
+#include "indicator_state.hpp"
+#include "inference_server.hpp"
+#include "key_buffer.hpp"
+#include "label_builder.hpp"
+#include "mlp_inference.hpp"
+#include "rolling_covariance.hpp"
+#include "scalable_bloom_filter.hpp"
+#include "tiered_dedup_filter.hpp"
+#include "windowed_bloom_filter.hpp"
 
 namespace py = pybind11;
 
+namespace {
+
+// ============================================================================
+// Zero-copy key columns
+// ============================================================================
+// Batch entry points read keys in place from NumPy/Arrow memory, release the
+// GIL for the C++ work and hand back NumPy arrays.
+
+// NumPy fixed-width bytes array (dtype 'S<n>')
+quantamental::KeyBuffer fixed_width_keys(const py::array& keys) {
+    if (keys.dtype().kind() != 'S') {
+        throw py::type_error("keys must be a NumPy bytes array (dtype 'S<n>')");
+    }
+    if (keys.ndim() != 1 || !(keys.flags() & py::array::c_style)) {
+        throw py::value_error("keys must be a 1-D C-contiguous array");
+    }
+    return quantamental::KeyBuffer::fixed_width(
+        static_cast<const char*>(keys.data()), keys.size(), keys.itemsize());
+}
+
+// Arrow string layout: a data buffer plus count + 1 int32 or int64 offsets
+quantamental::KeyBuffer offset_keys(const py::buffer& data, const py::array& offsets) {
+    py::buffer_info info = data.request();
+    if (offsets.dtype().kind() != 'i' || (offsets.itemsize() != 4 && offsets.itemsize() != 8)) {
+        throw py::type_error("offsets must be an int32 or int64 array");
+    }
+    if (offsets.ndim() != 1 || offsets.size() == 0 || !(offsets.flags() & py::array::c_style)) {
+        throw py::value_error("offsets must be a non-empty 1-D C-contiguous array");
+    }
+
+    const char* bytes = static_cast<const char*>(info.ptr);
+    size_t count = offsets.size() - 1;
+    size_t data_size = static_cast<size_t>(info.size * info.itemsize);
+
+    auto check = [&](const auto* offs) {
+        for (size_t i = 0; i < count; ++i) {
+            if (offs[i] < 0 || offs[i] > offs[i + 1]) {
+                throw py::value_error("offsets must be non-negative and non-decreasing");
+            }
+        }
+        if (static_cast<size_t>(offs[count]) > data_size) {
+            throw py::value_error("offsets run past the end of the data buffer");
+        }
+        return quantamental::KeyBuffer::with_offsets(bytes, offs, count);
+    };
+    if (offsets.itemsize() == 4) {
+        return check(static_cast<const int32_t*>(offsets.data()));
+    }
+    return check(static_cast<const int64_t*>(offsets.data()));
+}
+
+// Sized constructors: probes reduce modulo num_bits, and Blocked needs a whole block
+void check_num_bits(size_t num_bits, quantamental::BloomFilter::Layout layout) {
+    if (num_bits == 0) {
+        throw py::value_error("num_bits must be positive");
+    }
+    if (layout == quantamental::BloomFilter::Layout::Blocked &&
+        num_bits < quantamental::BloomFilter::kBlockBits) {
+        throw py::value_error("a Blocked filter needs num_bits of at least one 512-bit block");
+    }
+}
+
+// A ReadOnly mapping faults on write; raise instead of crashing the interpreter
+void require_writable(const quantamental::BloomFilter& filter) {
+    if (!filter.writable()) {
+        throw std::runtime_error("BloomFilter is a read-only mapping");
+    }
+}
+
+void require_writable(const quantamental::ConcurrentBloomFilter&) {}
+void require_writable(const quantamental::ScalableBloomFilter&) {}
+void require_writable(const quantamental::WindowedBloomFilter&) {}
+
+void require_writable(const quantamental::TieredDedupFilter& filter) {
+    require_writable(filter.live());
+}
+
+// Filters that Python threads may call at once. The others update plain
+// counters and words, so their batch calls keep the GIL and stay serialized
+// per interpreter; each call still spreads its keys across the thread pool.
+template <typename Filter>
+constexpr bool kReleasesGil = std::is_same_v<Filter, quantamental::ConcurrentBloomFilter> ||
+                              std::is_same_v<Filter, quantamental::BinaryFuseFilter>;
+
+template <typename Filter>
+void insert_keys(Filter& filter, const quantamental::KeyBuffer& keys, size_t num_threads) {
+    require_writable(filter);
+    std::optional<py::gil_scoped_release> release;
+    if constexpr (kReleasesGil<Filter>) release.emplace();
+    filter.insert_batch(keys, num_threads);
+}
+
+// Boolean "is new" mask, or the int64 indices of new keys
+template <typename Filter>
+py::array filter_new_keys(const Filter& filter, const quantamental::KeyBuffer& keys,
+                          bool return_indices, size_t num_threads) {
+    py::array_t<bool> mask(static_cast<py::ssize_t>(keys.size()));
+    bool* is_new = mask.mutable_data();
+    {
+        std::optional<py::gil_scoped_release> release;
+        if constexpr (kReleasesGil<Filter>) release.emplace();
+        filter.filter_new_mask(keys, is_new, num_threads);
+    }
+    if (!return_indices) return mask;
+
+    size_t num_new = 0;
+    for (size_t i = 0; i < keys.size(); ++i) num_new += is_new[i];
+
+    py::array_t<int64_t> indices(static_cast<py::ssize_t>(num_new));
+    int64_t* out = indices.mutable_data();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (is_new[i]) *out++ = static_cast<int64_t>(i);
+    }
+    return indices;
+}
+
+// Adds the array/Arrow query methods shared by every filter class
+template <typename Filter, typename PyClass>
+void def_zero_copy_queries(PyClass& cls) {
+    cls
+        .def("filter_new_array", [](const Filter& f, const py::array& keys, bool return_indices,
+                                    size_t num_threads) {
+                 return filter_new_keys(f, fixed_width_keys(keys), return_indices, num_threads);
+             },
+             py::arg("keys"), py::arg("return_indices") = false, py::arg("num_threads") = 0,
+             "Return a boolean 'is new' mask (or indices of new keys) for a NumPy 'S' array")
+        .def("filter_new_arrow", [](const Filter& f, const py::buffer& data, const py::array& offsets,
+                                    bool return_indices, size_t num_threads) {
+                 return filter_new_keys(f, offset_keys(data, offsets), return_indices, num_threads);
+             },
+             py::arg("data"), py::arg("offsets"), py::arg("return_indices") = false,
+             py::arg("num_threads") = 0,
+             "Return a boolean 'is new' mask (or indices of new keys) for Arrow-style keys");
+}
+
+// Adds the array/Arrow batch methods shared by the mutable filter classes
+template <typename Filter, typename PyClass>
+void def_zero_copy_batch(PyClass& cls) {
+    cls
+        .def("insert_array", [](Filter& f, const py::array& keys, size_t num_threads) {
+                 insert_keys(f, fixed_width_keys(keys), num_threads);
+             },
+             py::arg("keys"), py::arg("num_threads") = 0,
+             kReleasesGil<Filter> ? "Insert keys from a NumPy 'S' array without copying (releases the GIL)"
+                                  : "Insert keys from a NumPy 'S' array without copying")
+        .def("insert_arrow", [](Filter& f, const py::buffer& data, const py::array& offsets,
+                                size_t num_threads) {
+                 insert_keys(f, offset_keys(data, offsets), num_threads);
+             },
+             py::arg("data"), py::arg("offsets"), py::arg("num_threads") = 0,
+             kReleasesGil<Filter>
+                 ? "Insert keys from an Arrow-style data buffer and int32/int64 offsets (releases the GIL)"
+                 : "Insert keys from an Arrow-style data buffer and int32/int64 offsets");
+    def_zero_copy_queries<Filter>(cls);
+}
+
+// Merges another filter in, keeping the GIL (see kReleasesGil); mismatched
+// filters are a caller error, so they raise instead of returning False
+void merge_filter(quantamental::BloomFilter& filter, const quantamental::BloomFilter& other,
+                  bool intersect, size_t num_threads) {
+    require_writable(filter);
+    if (!filter.compatible_with(other)) {
+        throw py::value_error("filters differ in size, hash count, layout or hash scheme");
+    }
+    if (intersect) {
+        filter.merge_intersection(other, num_threads);
+    } else {
+        filter.merge_union(other, num_threads);
+    }
+}
+
+quantamental::BloomFilter build_bloom(const quantamental::KeyBuffer& keys, size_t expected_elements,
+                                      double false_positive_rate,
+                                      quantamental::BloomFilter::Layout layout,
+                                      quantamental::BloomFilter::HashScheme hash_scheme,
+                                      size_t num_threads) {
+    py::gil_scoped_release release;
+    return quantamental::BloomFilter::build_parallel(keys, expected_elements, false_positive_rate,
+                                                     layout, hash_scheme, num_threads);
+}
+
+// Builds a static filter without the GIL; construction only fails in
+// pathological cases, which Python sees as an exception
+quantamental::BinaryFuseFilter build_fuse(const quantamental::KeyBuffer& keys,
+                                          quantamental::BinaryFuseFilter::Fingerprint fingerprint,
+                                          size_t num_threads) {
+    std::optional<quantamental::BinaryFuseFilter> filter;
+    {
+        py::gil_scoped_release release;
+        filter = quantamental::BinaryFuseFilter::build(keys, fingerprint, num_threads);
+    }
+    if (!filter) {
+        throw std::runtime_error("BinaryFuseFilter construction failed");
+    }
+    return std::move(*filter);
+}
+
+// Float64 series as a contiguous 1-D array; already-contiguous float64
+// input (e.g. Series.to_numpy()) is used in place
+using SeriesArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+const double* series_data(const SeriesArray& series, const char* name) {
+    if (series.ndim() != 1) {
+        throw py::value_error(std::string(name) + " must be a 1-D array");
+    }
+    return series.data();
+}
+
+using TimestampArray = py::array_t<int64_t, py::array::c_style | py::array::forcecast>;
+
+// Float64 dates x tickers matrix, row-major (DataFrame.to_numpy() of a wide
+// frame); contiguous input is used in place
+using PanelArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+void check_panel(const PanelArray& panel, const char* name) {
+    if (panel.ndim() != 2) {
+        throw py::value_error(std::string(name) + " must be a 2-D (dates, tickers) array");
+    }
+}
+
+// ============================================================================
+// Bar store views
+// ============================================================================
+// Queries hand out read-only NumPy views into the store's mapping. Each view
+// holds a reference to that mapping, so it stays valid after the store grows
+// into a new file or is closed.
+
+quantamental::BarStore::Field bar_field(const std::string& name) {
+    using Field = quantamental::BarStore::Field;
+    static const std::pair<const char*, Field> fields[] = {
+        {"open", Field::Open}, {"high", Field::High}, {"low", Field::Low},
+        {"close", Field::Close}, {"volume", Field::Volume}};
+    for (const auto& [field_name, field] : fields) {
+        if (name == field_name) return field;
+    }
+    throw py::value_error("field must be one of 'open', 'high', 'low', 'close', 'volume'");
+}
+
+template <typename T>
+py::array mapped_view(const quantamental::BarStore& store, const T* data,
+                      std::vector<py::ssize_t> shape, std::vector<py::ssize_t> strides) {
+    auto* mapping = new std::shared_ptr<const void>(store.mapping());
+    py::capsule base(mapping, [](void* p) { delete static_cast<std::shared_ptr<const void>*>(p); });
+    py::array view(py::dtype::of<T>(), std::move(shape), std::move(strides), data, base);
+    view.attr("flags").attr("writeable") = false;
+    return view;
+}
+
+// Rows of the dates in [start, end]; a missing bound is open
+std::pair<size_t, size_t> bar_rows(const quantamental::BarStore& store, std::optional<int64_t> start,
+                                   std::optional<int64_t> end) {
+    return store.date_rows(start.value_or(std::numeric_limits<int64_t>::min()),
+                           end.value_or(std::numeric_limits<int64_t>::max()));
+}
+
+// ============================================================================
+// Bar ingest columns
+// ============================================================================
+
+using TickerIdArray = py::array_t<uint32_t, py::array::c_style | py::array::forcecast>;
+using ValuesArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+// Checks that the key columns line up and points a BarBatch at them
+quantamental::BarBatch bar_batch(const TickerIdArray& ticker_ids, const TimestampArray& timestamps,
+                                 const std::optional<TimestampArray>& revisions) {
+    size_t n = static_cast<size_t>(ticker_ids.size());
+    if (ticker_ids.ndim() != 1 || timestamps.ndim() != 1 || static_cast<size_t>(timestamps.size()) != n) {
+        throw py::value_error("ticker_ids and timestamps must be 1-D arrays of the same length");
+    }
+    if (revisions && (revisions->ndim() != 1 || static_cast<size_t>(revisions->size()) != n)) {
+        throw py::value_error("revisions must be a 1-D array with one entry per bar");
+    }
+
+    quantamental::BarBatch batch;
+    batch.ticker_ids = ticker_ids.data();
+    batch.timestamps = timestamps.data();
+    batch.revisions = revisions ? revisions->data() : nullptr;
+    batch.size = n;
+    return batch;
+}
+
+quantamental::IndicatorConfig make_indicator_config(std::vector<int> horizons,
+                                                    std::vector<int> sma_windows, int rsi_period,
+                                                    int macd_fast, int macd_slow, int macd_signal) {
+    return quantamental::IndicatorConfig{std::move(horizons), std::move(sma_windows), rsi_period,
+                                         macd_fast, macd_slow, macd_signal};
+}
+
+// ============================================================================
+// Cross-sectional panels
+// ============================================================================
+// The last axis is tickers and every other axis counts rows, so both a
+// (dates, tickers) frame and compute_panel's (columns, dates, tickers) output
+// pass as they are. inplace=True transforms the array itself, which must be
+// writable C-contiguous float64; otherwise the result is a new array and
+// such input is read without a copy.
+
+template <typename Transform>
+py::array_t<double> transform_panel(const py::array& panel, bool inplace, Transform transform) {
+    if (panel.ndim() < 1) {
+        throw py::value_error("panel must have a tickers axis");
+    }
+    PanelArray in;
+    py::array_t<double> out;
+    if (inplace) {
+        if (!py::isinstance<PanelArray>(panel) || !panel.writeable()) {
+            throw py::value_error("inplace=True needs a writable C-contiguous float64 array");
+        }
+        in = py::reinterpret_borrow<PanelArray>(panel);
+        out = in;
+    } else {
+        in = PanelArray::ensure(panel);
+        if (!in) throw py::type_error("panel must be convertible to a float64 array");
+        out = py::array_t<double>(std::vector<py::ssize_t>(panel.shape(), panel.shape() + panel.ndim()));
+    }
+
+    size_t num_tickers = static_cast<size_t>(in.shape(in.ndim() - 1));
+    size_t num_rows = num_tickers == 0 ? 0 : static_cast<size_t>(in.size()) / num_tickers;
+    const double* in_data = in.data();
+    double* out_data = out.mutable_data();
+    {
+        py::gil_scoped_release release;
+        transform(in_data, out_data, num_rows, num_tickers);
+    }
+    return out;
+}
+
+// ============================================================================
+// Rolling covariance outputs
+// ============================================================================
+// out=None allocates the (tickers, tickers) result. Otherwise out must be a
+// writable C-contiguous array of the output's dtype and shape and is filled
+// in place, e.g. one slice of a preallocated (dates, tickers, tickers) stack.
+
+template <typename T, typename Fill>
+py::array_t<T> matrix_output(const quantamental::RollingCovariance& rolling, size_t window,
+                             const std::optional<py::array>& out, Fill fill) {
+    if (window >= rolling.windows().size()) {
+        throw py::index_error("window must index windows()");
+    }
+    const auto n = static_cast<py::ssize_t>(rolling.num_tickers());
+    py::array_t<T> result;
+    if (out) {
+        if (!out->dtype().is(py::dtype::of<T>()) || out->ndim() != 2 || out->shape(0) != n ||
+            out->shape(1) != n || !(out->flags() & py::array::c_style) || !out->writeable()) {
+            throw py::value_error("out must be a writable C-contiguous (tickers, tickers) array of "
+                                  "the output's dtype");
+        }
+        result = py::reinterpret_borrow<py::array_t<T>>(*out);
+    } else {
+        result = py::array_t<T>({n, n});
+    }
+    T* data = result.mutable_data();
+    {
+        py::gil_scoped_release release;
+        fill(data);
+    }
+    return result;
+}
+
+} // namespace
+
 PYBIND11_MODULE(quantamental, m) {
     m.doc() = "Quantamental C++ library - Bloom Filter implementation";
 
+    // ========================================================================
+    // Expose FilterMetrics snapshots
+    // ========================================================================
+    py::class_<quantamental::FilterMetrics::Counters>(m, "FilterCounters")
+        .def_readonly("inserts", &quantamental::FilterMetrics::Counters::inserts)
+        .def_readonly("new_keys", &quantamental::FilterMetrics::Counters::new_keys)
+        .def_readonly("queries", &quantamental::FilterMetrics::Counters::queries)
+        .def_readonly("positives", &quantamental::FilterMetrics::Counters::positives)
+        .def("__repr__", [](const quantamental::FilterMetrics::Counters& c) {
+            return "<FilterCounters: inserts=" + std::to_string(c.inserts) +
+                   ", new_keys=" + std::to_string(c.new_keys) +
+                   ", queries=" + std::to_string(c.queries) +
+                   ", positives=" + std::to_string(c.positives) + ">";
+        });
+
+    py::class_<quantamental::FilterMetrics::LatencyHistogram>(m, "LatencyHistogram")
+        .def_readonly("buckets", &quantamental::FilterMetrics::LatencyHistogram::buckets,
+                      "Sample counts; bucket i covers [2^i, 2^(i+1)) ns")
+        .def_readonly("samples", &quantamental::FilterMetrics::LatencyHistogram::samples)
+        .def_readonly("total_ns", &quantamental::FilterMetrics::LatencyHistogram::total_ns)
+        .def("mean_ns", &quantamental::FilterMetrics::LatencyHistogram::mean_ns,
+             "Mean sampled latency in nanoseconds")
+        .def("percentile_ns", &quantamental::FilterMetrics::LatencyHistogram::percentile_ns,
+             py::arg("q"),
+             "Upper bound in nanoseconds of the bucket holding quantile q (0-1)")
+        .def("__repr__", [](const quantamental::FilterMetrics::LatencyHistogram& h) {
+            return "<LatencyHistogram: samples=" + std::to_string(h.samples) +
+                   ", mean_ns=" + std::to_string(h.mean_ns()) +
+                   ", p99_ns<=" + std::to_string(h.percentile_ns(0.99)) + ">";
+        });
+
+    py::class_<quantamental::FilterMetrics::Snapshot>(m, "FilterMetrics")
+        .def_readonly("counters", &quantamental::FilterMetrics::Snapshot::counters)
+        .def_readonly("single", &quantamental::FilterMetrics::Snapshot::single,
+                      "Sampled latency of single-key calls")
+        .def_readonly("batch", &quantamental::FilterMetrics::Snapshot::batch,
+                      "Latency of batch calls (every call)");
+
     // ========================================================================
     // Expose BloomFilterStats struct
     // ========================================================================
@@ -20,6 +443,9 @@ PYBIND11_MODULE(quantamental, m) {
         .def_readonly("num_hash_functions", &quantamental::BloomFilter::BloomFilterStats::num_hash_functions)
         .def_readonly("fill_ratio", &quantamental::BloomFilter::BloomFilterStats::fill_ratio)
         .def_readonly("estimated_fpr", &quantamental::BloomFilter::BloomFilterStats::estimated_fpr)
+        .def_readonly("metrics", &quantamental::BloomFilter::BloomFilterStats::metrics)
+        .def_readonly("observed_positive_rate",
+                      &quantamental::BloomFilter::BloomFilterStats::observed_positive_rate)
         .def("__repr__", [](const quantamental::BloomFilter::BloomFilterStats& s) {
             return "<BloomFilterStats: insertions=" + std::to_string(s.num_insertions) +
                    ", fill_ratio=" + std::to_string(s.fill_ratio) +
@@ -29,32 +455,66 @@ PYBIND11_MODULE(quantamental, m) {
     // ========================================================================
     // Expose BloomFilter class
     // ========================================================================
-    py::class_<quantamental::BloomFilter>(m, "BloomFilter")
+    py::class_<quantamental::BloomFilter> bloom_filter(m, "BloomFilter");
+
+    py::enum_<quantamental::BloomFilter::Layout>(bloom_filter, "Layout")
+        .value("Standard", quantamental::BloomFilter::Layout::Standard)
+        .value("Blocked", quantamental::BloomFilter::Layout::Blocked);
+
+    py::enum_<quantamental::BloomFilter::HashScheme>(bloom_filter, "HashScheme")
+        .value("Seeded", quantamental::BloomFilter::HashScheme::Seeded)
+        .value("DoubleHashing", quantamental::BloomFilter::HashScheme::DoubleHashing)
+        .value("WyHash", quantamental::BloomFilter::HashScheme::WyHash);
+
+    py::enum_<quantamental::BloomFilter::MapMode>(bloom_filter, "MapMode")
+        .value("ReadOnly", quantamental::BloomFilter::MapMode::ReadOnly)
+        .value("CopyOnWrite", quantamental::BloomFilter::MapMode::CopyOnWrite)
+        .value("Shared", quantamental::BloomFilter::MapMode::Shared);
+
+    bloom_filter
         // Constructors
-        .def(py::init<size_t, double>(),
+        .def(py::init<size_t, double, quantamental::BloomFilter::Layout,
+                      quantamental::BloomFilter::HashScheme>(),
              py::arg("expected_elements"),
              py::arg("false_positive_rate") = 0.01,
+             py::arg("layout") = quantamental::BloomFilter::Layout::Standard,
+             py::arg("hash_scheme") = quantamental::BloomFilter::HashScheme::DoubleHashing,
              "Create a Bloom filter for expected number of elements and target FPR")
-        .def(py::init<size_t, uint32_t>(),
+        .def(py::init([](size_t num_bits, uint32_t num_hashes, quantamental::BloomFilter::Layout layout,
+                         quantamental::BloomFilter::HashScheme hash_scheme) {
+                 check_num_bits(num_bits, layout);
+                 return std::make_unique<quantamental::BloomFilter>(num_bits, num_hashes, layout, hash_scheme);
+             }),
              py::arg("num_bits"),
              py::arg("num_hashes"),
+             py::arg("layout") = quantamental::BloomFilter::Layout::Standard,
+             py::arg("hash_scheme") = quantamental::BloomFilter::HashScheme::DoubleHashing,
              "Create a Bloom filter with specific bit array size and hash count (for testing)")
 
         // Core operations
-        .def("insert", &quantamental::BloomFilter::insert,
+        .def("insert", [](quantamental::BloomFilter& bf, std::string_view key) {
+                 require_writable(bf);
+                 bf.insert(key);
+             },
              py::arg("key"),
              "Insert a key into the Bloom filter")
         .def("possibly_contains", &quantamental::BloomFilter::possibly_contains,
              py::arg("key"),
              "Check if key might be in the filter (may have false positives)")
-        .def("insert_and_check", &quantamental::BloomFilter::insert_and_check,
+        .def("insert_and_check", [](quantamental::BloomFilter& bf, std::string_view key) {
+                 require_writable(bf);
+                 return bf.insert_and_check(key);
+             },
              py::arg("key"),
              "Insert key and return True if it was new")
         .def("__contains__", &quantamental::BloomFilter::possibly_contains,
              "Support 'key in filter' syntax")
 
         // Batch operations
-        .def("insert_batch", &quantamental::BloomFilter::insert_batch,
+        .def("insert_batch", [](quantamental::BloomFilter& bf, const std::vector<std::string>& keys) {
+                 require_writable(bf);
+                 bf.insert_batch(keys);
+             },
              py::arg("keys"),
              "Insert multiple keys at once")
         .def("filter_new", &quantamental::BloomFilter::filter_new,
@@ -74,24 +534,106 @@ PYBIND11_MODULE(quantamental, m) {
              "Get size in bytes")
         .def("num_insertions", &quantamental::BloomFilter::num_insertions,
              "Get number of insertions performed")
+        .def("layout", &quantamental::BloomFilter::layout,
+             "Get the probe layout (Standard or Blocked)")
+        .def("hash_scheme", &quantamental::BloomFilter::hash_scheme,
+             "Get the hash function behind the probes")
+
+        // Instrumentation
+        .def("reset_metrics", &quantamental::BloomFilter::reset_metrics,
+             "Zero the operation counters and latency histograms")
+        .def("set_latency_sampling", &quantamental::BloomFilter::set_latency_sampling,
+             py::arg("sample_every"),
+             "Time one in sample_every single-key calls (0 disables)")
+
+        // Merging
+        .def("compatible_with", &quantamental::BloomFilter::compatible_with,
+             py::arg("other"),
+             "Whether other has the same size, hash count, layout and hash scheme")
+        .def("merge_union", [](quantamental::BloomFilter& bf, const quantamental::BloomFilter& other,
+                               size_t num_threads) {
+                 merge_filter(bf, other, false, num_threads);
+             },
+             py::arg("other"), py::arg("num_threads") = 0,
+             "OR another compatible filter into this one")
+        .def("merge_intersection", [](quantamental::BloomFilter& bf, const quantamental::BloomFilter& other,
+                                      size_t num_threads) {
+                 merge_filter(bf, other, true, num_threads);
+             },
+             py::arg("other"), py::arg("num_threads") = 0,
+             "AND another compatible filter into this one")
 
         // Persistence
         .def("save_to_file", &quantamental::BloomFilter::save_to_file,
              py::arg("filepath"),
              "Save the Bloom filter to a binary file")
-        .def("clear", &quantamental::BloomFilter::clear,
+        .def("clear", [](quantamental::BloomFilter& bf) {
+                 require_writable(bf);
+                 bf.clear();
+             },
              "Clear all bits and reset counters")
+        .def("flush", &quantamental::BloomFilter::flush,
+             "Write counters and checksum back to a Shared mapping's file")
+        .def("verify_checksum", &quantamental::BloomFilter::verify_checksum,
+             py::arg("num_threads") = 0,
+             "Check the bits against the checksum of the file they were loaded from")
+        .def("is_mapped", &quantamental::BloomFilter::is_mapped,
+             "Whether the bits live in a memory-mapped file")
+        .def("writable", &quantamental::BloomFilter::writable,
+             "Whether the filter may be modified (False for ReadOnly mappings)")
 
         // Static methods
         .def_static("load_from_file", &quantamental::BloomFilter::load_from_file,
                     py::arg("filepath"),
                     "Load a Bloom filter from a binary file")
+        .def_static("open_mapped", &quantamental::BloomFilter::open_mapped,
+                    py::arg("filepath"),
+                    py::arg("mode") = quantamental::BloomFilter::MapMode::ReadOnly,
+                    py::arg("verify") = false,
+                    "Memory-map a saved Bloom filter in place (ReadOnly, CopyOnWrite or Shared)")
         .def_static("optimal_num_bits", &quantamental::BloomFilter::optimal_num_bits,
                     py::arg("n"), py::arg("p"),
                     "Calculate optimal bit array size for n elements and p false positive rate")
         .def_static("optimal_num_hashes", &quantamental::BloomFilter::optimal_num_hashes,
                     py::arg("m"), py::arg("n"),
                     "Calculate optimal number of hash functions for m bits and n elements")
+        .def_static("blocked_false_positive_rate", &quantamental::BloomFilter::blocked_false_positive_rate,
+                    py::arg("m"), py::arg("n"), py::arg("k"),
+                    "Theoretical FPR of a cache-line-blocked filter")
+        .def_static("optimal_num_bits_blocked", &quantamental::BloomFilter::optimal_num_bits_blocked,
+                    py::arg("n"), py::arg("p"),
+                    "Calculate bit array size for a blocked filter to reach p false positive rate")
+        .def_static("estimate_insertions", &quantamental::BloomFilter::estimate_insertions,
+                    py::arg("m"), py::arg("bits_set"), py::arg("k"),
+                    "Estimate the number of distinct keys from m bits with bits_set set and k hashes")
+        .def_static("build_parallel_array", [](const py::array& keys, size_t expected_elements,
+                                               double false_positive_rate,
+                                               quantamental::BloomFilter::Layout layout,
+                                               quantamental::BloomFilter::HashScheme hash_scheme,
+                                               size_t num_threads) {
+                        return build_bloom(fixed_width_keys(keys), expected_elements, false_positive_rate,
+                                           layout, hash_scheme, num_threads);
+                    },
+                    py::arg("keys"), py::arg("expected_elements"),
+                    py::arg("false_positive_rate") = 0.01,
+                    py::arg("layout") = quantamental::BloomFilter::Layout::Standard,
+                    py::arg("hash_scheme") = quantamental::BloomFilter::HashScheme::DoubleHashing,
+                    py::arg("num_threads") = 0,
+                    "Build a filter from a NumPy 'S' array with one private filter per thread, then OR them")
+        .def_static("build_parallel_arrow", [](const py::buffer& data, const py::array& offsets,
+                                               size_t expected_elements, double false_positive_rate,
+                                               quantamental::BloomFilter::Layout layout,
+                                               quantamental::BloomFilter::HashScheme hash_scheme,
+                                               size_t num_threads) {
+                        return build_bloom(offset_keys(data, offsets), expected_elements, false_positive_rate,
+                                           layout, hash_scheme, num_threads);
+                    },
+                    py::arg("data"), py::arg("offsets"), py::arg("expected_elements"),
+                    py::arg("false_positive_rate") = 0.01,
+                    py::arg("layout") = quantamental::BloomFilter::Layout::Standard,
+                    py::arg("hash_scheme") = quantamental::BloomFilter::HashScheme::DoubleHashing,
+                    py::arg("num_threads") = 0,
+                    "Build a filter from Arrow-style keys with one private filter per thread, then OR them")
 
         // Python-friendly representation
         .def("__repr__", [](const quantamental::BloomFilter& bf) {
@@ -101,6 +643,1563 @@ PYBIND11_MODULE(quantamental, m) {
         .def("__len__", &quantamental::BloomFilter::num_insertions,
              "Return number of insertions (approximate set size)");
 
+    // The array methods run without the GIL: share a BloomFilter across Python
+    // threads only through ConcurrentBloomFilter
+    def_zero_copy_batch<quantamental::BloomFilter>(bloom_filter);
+
+    // ========================================================================
+    // Expose ConcurrentBloomFilter class
+    // ========================================================================
+    // Operations release the GIL so Python threads can insert in parallel
+    // Held by shared_ptr so a FilterCheckpointer can share it
+    py::class_<quantamental::ConcurrentBloomFilter, std::shared_ptr<quantamental::ConcurrentBloomFilter>>
+        concurrent_bloom_filter(m, "ConcurrentBloomFilter");
+
+    concurrent_bloom_filter
+        // Constructors
+        .def(py::init<size_t, double, quantamental::BloomFilter::Layout>(),
+             py::arg("expected_elements"),
+             py::arg("false_positive_rate") = 0.01,
+             py::arg("layout") = quantamental::BloomFilter::Layout::Standard,
+             "Create a thread-safe Bloom filter for expected number of elements and target FPR")
+        .def(py::init([](size_t num_bits, uint32_t num_hashes, quantamental::BloomFilter::Layout layout) {
+                 check_num_bits(num_bits, layout);
+                 return std::make_shared<quantamental::ConcurrentBloomFilter>(num_bits, num_hashes, layout);
+             }),
+             py::arg("num_bits"),
+             py::arg("num_hashes"),
+             py::arg("layout") = quantamental::BloomFilter::Layout::Standard,
+             "Create a thread-safe Bloom filter with specific bit array size and hash count (for testing)")
+
+        // Core operations
+        .def("insert", &quantamental::ConcurrentBloomFilter::insert,
+             py::arg("key"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Insert a key into the Bloom filter")
+        .def("possibly_contains", &quantamental::ConcurrentBloomFilter::possibly_contains,
+             py::arg("key"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Check if key might be in the filter (may have false positives)")
+        .def("insert_and_check", &quantamental::ConcurrentBloomFilter::insert_and_check,
+             py::arg("key"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Insert key and return True if it was new (exactly one racing caller sees True)")
+        .def("__contains__", &quantamental::ConcurrentBloomFilter::possibly_contains,
+             py::call_guard<py::gil_scoped_release>(),
+             "Support 'key in filter' syntax")
+
+        // Batch operations
+        .def("insert_batch", py::overload_cast<const std::vector<std::string>&>(&quantamental::ConcurrentBloomFilter::insert_batch),
+             py::arg("keys"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Insert multiple keys at once")
+        .def("filter_new", &quantamental::ConcurrentBloomFilter::filter_new,
+             py::arg("keys"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Return indices of keys not in the filter")
+
+        // Statistics
+        .def("get_stats", &quantamental::ConcurrentBloomFilter::get_stats,
+             "Get detailed statistics about the filter")
+        .def("fill_ratio", &quantamental::ConcurrentBloomFilter::fill_ratio,
+             "Get the ratio of set bits to total bits")
+        .def("estimated_false_positive_rate", &quantamental::ConcurrentBloomFilter::estimated_false_positive_rate,
+             "Estimate current false positive rate based on insertions")
+        .def("size_bits", &quantamental::ConcurrentBloomFilter::size_bits,
+             "Get size in bits")
+        .def("size_bytes", &quantamental::ConcurrentBloomFilter::size_bytes,
+             "Get size in bytes")
+        .def("num_insertions", &quantamental::ConcurrentBloomFilter::num_insertions,
+             "Get number of insertions performed")
+        .def("layout", &quantamental::ConcurrentBloomFilter::layout,
+             "Get the probe layout (Standard or Blocked)")
+
+        // Instrumentation
+        .def("reset_metrics", &quantamental::ConcurrentBloomFilter::reset_metrics,
+             "Zero the operation counters and latency histograms")
+        .def("set_latency_sampling", &quantamental::ConcurrentBloomFilter::set_latency_sampling,
+             py::arg("sample_every"),
+             "Time one in sample_every single-key calls (0 disables)")
+
+        // Persistence
+        .def("save_to_file", &quantamental::ConcurrentBloomFilter::save_to_file,
+             py::arg("filepath"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Save the Bloom filter to a binary file (same format as BloomFilter)")
+        .def("clear", &quantamental::ConcurrentBloomFilter::clear,
+             "Clear all bits and reset counters")
+        .def_static("load_from_file", [](const std::string& filepath) {
+                        return std::shared_ptr<quantamental::ConcurrentBloomFilter>(
+                            quantamental::ConcurrentBloomFilter::load_from_file(filepath));
+                    },
+                    py::arg("filepath"),
+                    "Load a Bloom filter file written by BloomFilter or ConcurrentBloomFilter")
+
+        // Python-friendly representation
+        .def("__repr__", [](const quantamental::ConcurrentBloomFilter& bf) {
+            return "<ConcurrentBloomFilter: " + std::to_string(bf.size_bits()) + " bits, " +
+                   std::to_string(bf.num_insertions()) + " insertions>";
+        })
+        .def("__len__", &quantamental::ConcurrentBloomFilter::num_insertions,
+             "Return number of insertions (approximate set size)");
+
+    def_zero_copy_batch<quantamental::ConcurrentBloomFilter>(concurrent_bloom_filter);
+
+    // ========================================================================
+    // Expose FilterCheckpointer class
+    // ========================================================================
+    using CheckpointStats = quantamental::FilterCheckpointer::Stats;
+    py::class_<quantamental::FilterCheckpointer> filter_checkpointer(m, "FilterCheckpointer");
+
+    py::class_<CheckpointStats>(filter_checkpointer, "Stats")
+        .def_readonly("checkpoints", &CheckpointStats::checkpoints, "Delta records appended")
+        .def_readonly("compactions", &CheckpointStats::compactions, "Bases written")
+        .def_readonly("failures", &CheckpointStats::failures)
+        .def_readonly("blocks_written", &CheckpointStats::blocks_written,
+                      "64-byte blocks across all delta records")
+        .def_readonly("bytes_written", &CheckpointStats::bytes_written)
+        .def_readonly("log_bytes", &CheckpointStats::log_bytes)
+        .def_readonly("last_blocks", &CheckpointStats::last_blocks)
+        .def_readonly("last_checkpoint_us", &CheckpointStats::last_checkpoint_us)
+        .def("__repr__", [](const CheckpointStats& s) {
+            return "<FilterCheckpointer.Stats: checkpoints=" + std::to_string(s.checkpoints) +
+                   ", compactions=" + std::to_string(s.compactions) +
+                   ", log_bytes=" + std::to_string(s.log_bytes) + ">";
+        });
+
+    filter_checkpointer
+        .def_static("start", [](std::shared_ptr<quantamental::ConcurrentBloomFilter> filter,
+                                const std::string& base_path, const std::string& log_path,
+                                uint32_t interval_ms, double compact_ratio, bool sync) {
+                        quantamental::CheckpointConfig config{base_path, log_path, interval_ms,
+                                                              compact_ratio, sync};
+                        py::gil_scoped_release release;
+                        return quantamental::FilterCheckpointer::start(std::move(filter), std::move(config));
+                    },
+                    py::arg("filter"), py::arg("base_path"), py::arg("log_path") = "",
+                    py::arg("interval_ms") = 1000, py::arg("compact_ratio") = 1.0, py::arg("sync") = true,
+                    "Write a base snapshot of the filter, then append its changed blocks to "
+                    "the delta log (base_path + '.log' by default) every interval_ms from a "
+                    "background thread while inserts continue. Returns None if the files "
+                    "cannot be written, which is always the case on Windows")
+        .def("checkpoint", &quantamental::FilterCheckpointer::checkpoint,
+             py::call_guard<py::gil_scoped_release>(),
+             "Append the blocks changed since the last checkpoint now")
+        .def("compact", &quantamental::FilterCheckpointer::compact,
+             py::call_guard<py::gil_scoped_release>(),
+             "Write a new base and start an empty log")
+        .def("stop", &quantamental::FilterCheckpointer::stop,
+             py::call_guard<py::gil_scoped_release>(),
+             "Take a last checkpoint and stop the background thread")
+        .def("stats", &quantamental::FilterCheckpointer::stats)
+        .def("filter", &quantamental::FilterCheckpointer::filter,
+             "The filter being checkpointed")
+        .def("base_path", [](const quantamental::FilterCheckpointer& checkpointer) {
+                 return checkpointer.config().base_path;
+             })
+        .def("log_path", [](const quantamental::FilterCheckpointer& checkpointer) {
+                 return checkpointer.config().log_path;
+             })
+        .def_static("recover", [](const std::string& base_path, const std::string& log_path) {
+                        py::gil_scoped_release release;
+                        return std::shared_ptr<quantamental::ConcurrentBloomFilter>(
+                            quantamental::FilterCheckpointer::recover(base_path, log_path));
+                    },
+                    py::arg("base_path"), py::arg("log_path") = "",
+                    "Load the base and replay every intact record of its delta log into a "
+                    "ConcurrentBloomFilter; None if the base cannot be loaded")
+        .def("__repr__", [](const quantamental::FilterCheckpointer& checkpointer) {
+            return "<FilterCheckpointer: " + checkpointer.config().base_path + ", interval_ms=" +
+                   std::to_string(checkpointer.config().interval_ms) + ">";
+        });
+
+    // ========================================================================
+    // Expose ScalableBloomFilter class
+    // ========================================================================
+    py::class_<quantamental::ScalableBloomFilter> scalable_bloom_filter(m, "ScalableBloomFilter");
+
+    scalable_bloom_filter
+        // Constructors
+        // The constructor's std::invalid_argument surfaces as ValueError
+        .def(py::init<size_t, double, quantamental::BloomFilter::Layout, double, double, double>(),
+             py::arg("initial_capacity"),
+             py::arg("false_positive_rate") = 0.01,
+             py::arg("layout") = quantamental::BloomFilter::Layout::Standard,
+             py::arg("growth_factor") = 2.0,
+             py::arg("tightening_ratio") = 0.5,
+             py::arg("fill_threshold") = 0.5,
+             "Create a Bloom filter that adds larger, tighter layers as it fills")
+
+        // Core operations
+        .def("insert", &quantamental::ScalableBloomFilter::insert,
+             py::arg("key"),
+             "Insert a key (keys already present are skipped)")
+        .def("possibly_contains", &quantamental::ScalableBloomFilter::possibly_contains,
+             py::arg("key"),
+             "Check if key might be in the filter (newest layer first)")
+        .def("insert_and_check", &quantamental::ScalableBloomFilter::insert_and_check,
+             py::arg("key"),
+             "Insert key and return True if it was new")
+        .def("__contains__", &quantamental::ScalableBloomFilter::possibly_contains,
+             "Support 'key in filter' syntax")
+
+        // Batch operations
+        .def("insert_batch", py::overload_cast<const std::vector<std::string>&>(&quantamental::ScalableBloomFilter::insert_batch),
+             py::arg("keys"),
+             "Insert multiple keys at once")
+        .def("filter_new", &quantamental::ScalableBloomFilter::filter_new,
+             py::arg("keys"),
+             "Return indices of keys not in the filter")
+
+        // Statistics
+        .def("get_stats", &quantamental::ScalableBloomFilter::get_stats,
+             "Get statistics summed over all layers")
+        .def("fill_ratio", &quantamental::ScalableBloomFilter::fill_ratio,
+             "Get the ratio of set bits to total bits over all layers")
+        .def("estimated_false_positive_rate", &quantamental::ScalableBloomFilter::estimated_false_positive_rate,
+             "Estimate the compound false positive rate from per-layer insertions")
+        .def("false_positive_bound", &quantamental::ScalableBloomFilter::false_positive_bound,
+             "Compound false positive rate of the layers at their target fill")
+        .def("size_bits", &quantamental::ScalableBloomFilter::size_bits,
+             "Get size in bits over all layers")
+        .def("size_bytes", &quantamental::ScalableBloomFilter::size_bytes,
+             "Get size in bytes over all layers")
+        .def("num_insertions", &quantamental::ScalableBloomFilter::num_insertions,
+             "Get number of distinct keys inserted")
+        .def("num_layers", &quantamental::ScalableBloomFilter::num_layers,
+             "Get the number of layers")
+        .def("capacity", &quantamental::ScalableBloomFilter::capacity,
+             "Get the number of keys the current layers hold before growing")
+        .def("layout", &quantamental::ScalableBloomFilter::layout,
+             "Get the probe layout (Standard or Blocked)")
+
+        // Persistence
+        .def("save_to_file", &quantamental::ScalableBloomFilter::save_to_file,
+             py::arg("filepath"),
+             "Save all layers to a single binary file")
+        .def("clear", &quantamental::ScalableBloomFilter::clear,
+             "Drop all layers and start over with one empty layer")
+        .def_static("load_from_file", &quantamental::ScalableBloomFilter::load_from_file,
+                    py::arg("filepath"),
+                    "Load a scalable Bloom filter from a binary file")
+
+        // Python-friendly representation
+        .def("__repr__", [](const quantamental::ScalableBloomFilter& bf) {
+            return "<ScalableBloomFilter: " + std::to_string(bf.num_layers()) + " layers, " +
+                   std::to_string(bf.size_bits()) + " bits, " +
+                   std::to_string(bf.num_insertions()) + " insertions>";
+        })
+        .def("__len__", &quantamental::ScalableBloomFilter::num_insertions,
+             "Return number of distinct keys inserted (approximate set size)");
+
+    def_zero_copy_batch<quantamental::ScalableBloomFilter>(scalable_bloom_filter);
+
+    // ========================================================================
+    // Expose WindowedBloomFilter class
+    // ========================================================================
+    py::class_<quantamental::WindowedBloomFilter> windowed_bloom_filter(m, "WindowedBloomFilter");
+
+    windowed_bloom_filter
+        // Constructors
+        .def(py::init([](size_t expected_per_bucket, double false_positive_rate,
+                         uint32_t num_buckets, int64_t bucket_width) {
+                 if (!(false_positive_rate > 0.0 && false_positive_rate < 1.0)) {
+                     throw py::value_error("false_positive_rate must be in (0, 1)");
+                 }
+                 if (num_buckets == 0 || num_buckets > quantamental::WindowedBloomFilter::kMaxBuckets) {
+                     throw py::value_error("num_buckets must be between 1 and " +
+                                           std::to_string(quantamental::WindowedBloomFilter::kMaxBuckets));
+                 }
+                 if (bucket_width <= 0) {
+                     throw py::value_error("bucket_width must be positive");
+                 }
+                 return quantamental::WindowedBloomFilter(expected_per_bucket, false_positive_rate,
+                                                          num_buckets, bucket_width);
+             }),
+             py::arg("expected_per_bucket"),
+             py::arg("false_positive_rate") = 0.01,
+             py::arg("num_buckets") = 5,
+             py::arg("bucket_width") = 1,
+             "Create a Bloom filter that remembers only the last num_buckets time buckets")
+
+        // Core operations
+        .def("insert", &quantamental::WindowedBloomFilter::insert,
+             py::arg("key"),
+             "Insert a key into the current bucket")
+        .def("possibly_contains", &quantamental::WindowedBloomFilter::possibly_contains,
+             py::arg("key"),
+             "Check if key might be in any live bucket")
+        .def("insert_and_check", &quantamental::WindowedBloomFilter::insert_and_check,
+             py::arg("key"),
+             "Insert key and return True if it was not in the window")
+        .def("__contains__", &quantamental::WindowedBloomFilter::possibly_contains,
+             "Support 'key in filter' syntax")
+
+        // Batch operations
+        .def("insert_batch", py::overload_cast<const std::vector<std::string>&>(&quantamental::WindowedBloomFilter::insert_batch),
+             py::arg("keys"),
+             "Insert multiple keys at once")
+        .def("filter_new", &quantamental::WindowedBloomFilter::filter_new,
+             py::arg("keys"),
+             "Return indices of keys not in the window")
+
+        // Window control
+        .def("advance_to", &quantamental::WindowedBloomFilter::advance_to,
+             py::arg("time"),
+             "Move the window to the bucket holding time; returns the number of buckets started")
+        .def("rotate", &quantamental::WindowedBloomFilter::rotate,
+             "Start the next bucket now, expiring the oldest")
+        .def("expire_step", &quantamental::WindowedBloomFilter::expire_step,
+             py::arg("max_words"),
+             "Clear part of the expired bucket (e.g. while idle); returns the words still pending")
+
+        // Statistics
+        .def("get_stats", &quantamental::WindowedBloomFilter::get_stats,
+             "Get statistics over the live buckets")
+        .def("fill_ratio", &quantamental::WindowedBloomFilter::fill_ratio,
+             "Get the ratio of set bits to total bits over the live buckets")
+        .def("estimated_false_positive_rate", &quantamental::WindowedBloomFilter::estimated_false_positive_rate,
+             "Estimate the false positive rate of the window from per-bucket insertions")
+        .def("size_bits", &quantamental::WindowedBloomFilter::size_bits,
+             "Get size in bits")
+        .def("size_bytes", &quantamental::WindowedBloomFilter::size_bytes,
+             "Get size in bytes")
+        .def("num_insertions", &quantamental::WindowedBloomFilter::num_insertions,
+             "Get number of keys inserted into the live buckets")
+        .def("num_buckets", &quantamental::WindowedBloomFilter::num_buckets,
+             "Get the window length in buckets")
+        .def("bucket_width", &quantamental::WindowedBloomFilter::bucket_width,
+             "Get the width of a bucket in advance_to() time units")
+        .def("current_bucket", &quantamental::WindowedBloomFilter::current_bucket,
+             "Get the current bucket number (None before the first advance_to)")
+        .def("clear", &quantamental::WindowedBloomFilter::clear,
+             "Clear all buckets, counters and the clock")
+
+        // Python-friendly representation
+        .def("__repr__", [](const quantamental::WindowedBloomFilter& bf) {
+            return "<WindowedBloomFilter: " + std::to_string(bf.num_buckets()) + " buckets, " +
+                   std::to_string(bf.size_bits()) + " bits, " +
+                   std::to_string(bf.num_insertions()) + " insertions>";
+        })
+        .def("__len__", &quantamental::WindowedBloomFilter::num_insertions,
+             "Return number of keys in the live buckets (approximate set size)");
+
+    def_zero_copy_batch<quantamental::WindowedBloomFilter>(windowed_bloom_filter);
+
+    // ========================================================================
+    // Expose BinaryFuseFilter class
+    // ========================================================================
+    // Held by shared_ptr so a TieredDedupFilter can share the history
+    py::class_<quantamental::BinaryFuseFilter, std::shared_ptr<quantamental::BinaryFuseFilter>>
+        binary_fuse_filter(m, "BinaryFuseFilter");
+
+    py::enum_<quantamental::BinaryFuseFilter::Fingerprint>(binary_fuse_filter, "Fingerprint")
+        .value("Bits8", quantamental::BinaryFuseFilter::Fingerprint::Bits8)
+        .value("Bits16", quantamental::BinaryFuseFilter::Fingerprint::Bits16);
+
+    binary_fuse_filter
+        // Construction
+        .def_static("build", [](const std::vector<std::string>& keys,
+                                quantamental::BinaryFuseFilter::Fingerprint fingerprint,
+                                size_t num_threads) {
+                        std::optional<quantamental::BinaryFuseFilter> filter;
+                        {
+                            py::gil_scoped_release release;
+                            filter = quantamental::BinaryFuseFilter::build(keys, fingerprint, num_threads);
+                        }
+                        if (!filter) {
+                            throw std::runtime_error("BinaryFuseFilter construction failed");
+                        }
+                        return std::move(*filter);
+                    },
+                    py::arg("keys"),
+                    py::arg("fingerprint") = quantamental::BinaryFuseFilter::Fingerprint::Bits8,
+                    py::arg("num_threads") = 0,
+                    "Build a static filter from a list of keys")
+        .def_static("build_array", [](const py::array& keys,
+                                      quantamental::BinaryFuseFilter::Fingerprint fingerprint,
+                                      size_t num_threads) {
+                        return build_fuse(fixed_width_keys(keys), fingerprint, num_threads);
+                    },
+                    py::arg("keys"),
+                    py::arg("fingerprint") = quantamental::BinaryFuseFilter::Fingerprint::Bits8,
+                    py::arg("num_threads") = 0,
+                    "Build a static filter from a NumPy 'S' array (releases the GIL)")
+        .def_static("build_arrow", [](const py::buffer& data, const py::array& offsets,
+                                      quantamental::BinaryFuseFilter::Fingerprint fingerprint,
+                                      size_t num_threads) {
+                        return build_fuse(offset_keys(data, offsets), fingerprint, num_threads);
+                    },
+                    py::arg("data"), py::arg("offsets"),
+                    py::arg("fingerprint") = quantamental::BinaryFuseFilter::Fingerprint::Bits8,
+                    py::arg("num_threads") = 0,
+                    "Build a static filter from Arrow-style keys (releases the GIL)")
+
+        // Queries
+        .def("possibly_contains", &quantamental::BinaryFuseFilter::possibly_contains,
+             py::arg("key"),
+             "Check if key might be in the filter (may have false positives)")
+        .def("__contains__", &quantamental::BinaryFuseFilter::possibly_contains,
+             "Support 'key in filter' syntax")
+        .def("filter_new", &quantamental::BinaryFuseFilter::filter_new,
+             py::arg("keys"),
+             "Return indices of keys not in the filter")
+
+        // Statistics
+        .def("num_keys", &quantamental::BinaryFuseFilter::num_keys,
+             "Get the number of distinct keys the filter was built from")
+        .def("fingerprint", &quantamental::BinaryFuseFilter::fingerprint,
+             "Get the fingerprint width")
+        .def("false_positive_rate", &quantamental::BinaryFuseFilter::false_positive_rate,
+             "Get the false positive rate (2^-fingerprint bits)")
+        .def("bits_per_key", &quantamental::BinaryFuseFilter::bits_per_key,
+             "Get the storage cost per key in bits")
+        .def("size_bits", &quantamental::BinaryFuseFilter::size_bits,
+             "Get size in bits")
+        .def("size_bytes", &quantamental::BinaryFuseFilter::size_bytes,
+             "Get size in bytes")
+
+        // Persistence
+        .def("save_to_file", &quantamental::BinaryFuseFilter::save_to_file,
+             py::arg("filepath"),
+             "Save the filter to a binary file")
+        .def("verify_checksum", &quantamental::BinaryFuseFilter::verify_checksum,
+             py::arg("num_threads") = 0,
+             py::call_guard<py::gil_scoped_release>(),
+             "Check the slots against the checksum of the file they were loaded from")
+        .def("is_mapped", &quantamental::BinaryFuseFilter::is_mapped,
+             "Whether the slots live in a memory-mapped file")
+        .def_static("load_from_file", &quantamental::BinaryFuseFilter::load_from_file,
+                    py::arg("filepath"),
+                    "Load a static filter from a binary file")
+        .def_static("open_mapped", &quantamental::BinaryFuseFilter::open_mapped,
+                    py::arg("filepath"),
+                    py::arg("verify") = false,
+                    "Memory-map a saved static filter read-only")
+
+        // Python-friendly representation
+        .def("__repr__", [](const quantamental::BinaryFuseFilter& f) {
+            return "<BinaryFuseFilter: " + std::to_string(f.num_keys()) + " keys, " +
+                   std::to_string(f.bits_per_key()) + " bits/key>";
+        })
+        .def("__len__", &quantamental::BinaryFuseFilter::num_keys,
+             "Return number of distinct keys");
+
+    def_zero_copy_queries<quantamental::BinaryFuseFilter>(binary_fuse_filter);
+
+    // ========================================================================
+    // Expose TieredDedupFilter class
+    // ========================================================================
+    py::class_<quantamental::TieredDedupFilter> tiered_dedup_filter(m, "TieredDedupFilter");
+
+    tiered_dedup_filter
+        // Constructors
+        .def(py::init([](std::shared_ptr<quantamental::BinaryFuseFilter> history,
+                         size_t live_expected_elements, double live_false_positive_rate,
+                         quantamental::BloomFilter::Layout layout) {
+                 return quantamental::TieredDedupFilter(std::move(history), live_expected_elements,
+                                                        live_false_positive_rate, layout);
+             }),
+             py::arg("history"),
+             py::arg("live_expected_elements"),
+             py::arg("live_false_positive_rate") = 0.01,
+             py::arg("layout") = quantamental::BloomFilter::Layout::Standard,
+             "Combine a static history filter with a new live Bloom filter")
+        .def_static("with_live_file", [](std::shared_ptr<quantamental::BinaryFuseFilter> history,
+                                         const std::string& live_filepath)
+                        -> std::optional<quantamental::TieredDedupFilter> {
+                        auto live = quantamental::BloomFilter::load_from_file(live_filepath);
+                        if (!live) return std::nullopt;
+                        return quantamental::TieredDedupFilter(std::move(history), std::move(*live));
+                    },
+                    py::arg("history"), py::arg("live_filepath"),
+                    "Combine a static history filter with a saved live Bloom filter")
+
+        // Core operations
+        .def("insert", [](quantamental::TieredDedupFilter& f, std::string_view key) {
+                 require_writable(f);
+                 f.insert(key);
+             },
+             py::arg("key"),
+             "Insert a key into the live filter")
+        .def("possibly_contains", &quantamental::TieredDedupFilter::possibly_contains,
+             py::arg("key"),
+             "Check if key might be in the history or the live filter")
+        .def("insert_and_check", [](quantamental::TieredDedupFilter& f, std::string_view key) {
+                 require_writable(f);
+                 return f.insert_and_check(key);
+             },
+             py::arg("key"),
+             "Insert key and return True if it was in neither tier")
+        .def("__contains__", &quantamental::TieredDedupFilter::possibly_contains,
+             "Support 'key in filter' syntax")
+
+        // Batch operations
+        .def("insert_batch", [](quantamental::TieredDedupFilter& f, const std::vector<std::string>& keys) {
+                 require_writable(f);
+                 f.insert_batch(keys);
+             },
+             py::arg("keys"),
+             "Insert multiple keys into the live filter")
+        .def("filter_new", &quantamental::TieredDedupFilter::filter_new,
+             py::arg("keys"),
+             "Return indices of keys in neither tier")
+
+        // Statistics
+        .def("estimated_false_positive_rate", &quantamental::TieredDedupFilter::estimated_false_positive_rate,
+             "Estimate the false positive rate over both tiers")
+        .def("size_bytes", &quantamental::TieredDedupFilter::size_bytes,
+             "Get size in bytes of both tiers")
+        .def("num_insertions", &quantamental::TieredDedupFilter::num_insertions,
+             "Get history keys plus live insertions")
+
+        // Tiers
+        .def("history", [](const quantamental::TieredDedupFilter& f) {
+                 return std::const_pointer_cast<quantamental::BinaryFuseFilter>(f.shared_history());
+             },
+             "Get the static history filter")
+        .def("live", py::overload_cast<>(&quantamental::TieredDedupFilter::live),
+             py::return_value_policy::reference_internal,
+             "Get the live Bloom filter (e.g. to save or clear it)")
+        .def("set_history", [](quantamental::TieredDedupFilter& f,
+                               std::shared_ptr<quantamental::BinaryFuseFilter> history) {
+                 f.set_history(std::move(history));
+             },
+             py::arg("history"),
+             "Swap in a rebuilt history filter")
+
+        .def("__repr__", [](const quantamental::TieredDedupFilter& f) {
+            return "<TieredDedupFilter: " + std::to_string(f.history().num_keys()) + " history keys, " +
+                   std::to_string(f.live().num_insertions()) + " live insertions>";
+        })
+        .def("__len__", &quantamental::TieredDedupFilter::num_insertions,
+             "Return history keys plus live insertions (approximate set size)");
+
+    def_zero_copy_batch<quantamental::TieredDedupFilter>(tiered_dedup_filter);
+
+    // ========================================================================
+    // Expose BarDeduplicator class
+    // ========================================================================
+    using BarStatus = quantamental::BarDeduplicator::Status;
+    py::class_<quantamental::BarDeduplicator> bar_deduplicator(m, "BarDeduplicator");
+
+    py::enum_<BarStatus>(bar_deduplicator, "Status")
+        .value("Duplicate", BarStatus::Duplicate)
+        .value("New", BarStatus::New)
+        .value("Revised", BarStatus::Revised);
+
+    bar_deduplicator
+        // Constructors
+        .def(py::init<size_t, double, quantamental::BloomFilter::Layout>(),
+             py::arg("expected_keys"),
+             py::arg("false_positive_rate") = 0.01,
+             py::arg("layout") = quantamental::BloomFilter::Layout::Blocked,
+             "Create a bar deduplicator over a new wyhash Bloom filter "
+             "(one key per bar, plus one per revised bar)")
+        .def_static("with_filter_file", [](const std::string& filepath)
+                        -> std::optional<quantamental::BarDeduplicator> {
+                        auto filter = quantamental::BloomFilter::load_from_file(filepath);
+                        if (!filter) return std::nullopt;
+                        return quantamental::BarDeduplicator(std::move(*filter));
+                    },
+                    py::arg("filepath"),
+                    "Resume from a filter saved with filter().save_to_file()")
+
+        // Ingest
+        .def("classify", [](quantamental::BarDeduplicator& dedup, const TickerIdArray& ticker_ids,
+                            const TimestampArray& timestamps, std::optional<TimestampArray> revisions) {
+                 require_writable(dedup.filter());
+                 quantamental::BarBatch batch = bar_batch(ticker_ids, timestamps, revisions);
+                 py::array_t<uint8_t> status(static_cast<py::ssize_t>(batch.size));
+                 auto* status_data = reinterpret_cast<BarStatus*>(status.mutable_data());
+                 // Keeps the GIL: classify inserts into a BloomFilter, which is not thread-safe
+                 dedup.classify(batch, status_data);
+                 return status;
+             },
+             py::arg("ticker_ids"), py::arg("timestamps"), py::arg("revisions") = py::none(),
+             "Record a batch of bar keys and return their uint8 status codes "
+             "(Status.Duplicate = 0, New = 1, Revised = 2)")
+        .def("ingest", [](quantamental::BarDeduplicator& dedup, const TickerIdArray& ticker_ids,
+                          const TimestampArray& timestamps, const ValuesArray& values,
+                          std::optional<TimestampArray> revisions) {
+                 require_writable(dedup.filter());
+                 quantamental::BarBatch batch = bar_batch(ticker_ids, timestamps, revisions);
+                 if (values.ndim() != 2 || static_cast<size_t>(values.shape(0)) != batch.size) {
+                     throw py::value_error("values must be a 2-D (rows, fields) array with one row per bar");
+                 }
+                 batch.values = values.data();
+                 batch.num_values = static_cast<size_t>(values.shape(1));
+                 py::array_t<uint8_t> status(static_cast<py::ssize_t>(batch.size));
+                 auto* status_data = reinterpret_cast<BarStatus*>(status.mutable_data());
+                 size_t kept = dedup.classify(batch, status_data);
+
+                 const auto rows = static_cast<py::ssize_t>(kept);
+                 py::array_t<uint32_t> out_ticker_ids(rows);
+                 py::array_t<int64_t> out_timestamps(rows);
+                 py::array_t<int64_t> out_revisions(revisions ? rows : 0);
+                 py::array_t<double> out_values(std::vector<py::ssize_t>{
+                     rows, static_cast<py::ssize_t>(batch.num_values)});
+                 quantamental::BarColumns out{out_ticker_ids.mutable_data(), out_timestamps.mutable_data(),
+                                              out_revisions.mutable_data(), out_values.mutable_data()};
+                 {
+                     py::gil_scoped_release release;   // Only reads the batch and fills new arrays
+                     quantamental::BarDeduplicator::compact(batch, status_data, out);
+                 }
+
+                 py::dict result;
+                 result["status"] = status;
+                 result["ticker_ids"] = out_ticker_ids;
+                 result["timestamps"] = out_timestamps;
+                 result["values"] = out_values;
+                 if (revisions) result["revisions"] = out_revisions;
+                 return result;
+             },
+             py::arg("ticker_ids"), py::arg("timestamps"), py::arg("values"),
+             py::arg("revisions") = py::none(),
+             "Dedup a batch of bars in one call: returns {'status': uint8 codes per "
+             "input row, 'ticker_ids', 'timestamps', 'values' (and 'revisions')} "
+             "holding only the New and Revised rows, in input order")
+
+        // Filter
+        .def("filter", py::overload_cast<>(&quantamental::BarDeduplicator::filter),
+             py::return_value_policy::reference_internal,
+             "Get the underlying Bloom filter (e.g. to save it or read its stats)")
+
+        .def("__repr__", [](const quantamental::BarDeduplicator& dedup) {
+            return "<BarDeduplicator: " + std::to_string(dedup.filter().num_insertions()) + " keys>";
+        });
+
+    // ========================================================================
+    // Expose IndicatorEngine class
+    // ========================================================================
+    py::class_<quantamental::IndicatorEngine>(m, "IndicatorEngine")
+        .def(py::init([](std::vector<int> horizons, std::vector<int> sma_windows, int rsi_period,
+                         int macd_fast, int macd_slow, int macd_signal) {
+                 auto engine = quantamental::IndicatorEngine::create(make_indicator_config(
+                     std::move(horizons), std::move(sma_windows), rsi_period,
+                     macd_fast, macd_slow, macd_signal));
+                 if (!engine) {
+                     throw py::value_error("indicator windows and periods must be positive");
+                 }
+                 return std::move(*engine);
+             }),
+             py::arg("horizons") = std::vector<int>{1, 5, 10, 20},
+             py::arg("sma_windows") = std::vector<int>{10, 20, 50, 200},
+             py::arg("rsi_period") = 14,
+             py::arg("macd_fast") = 12,
+             py::arg("macd_slow") = 26,
+             py::arg("macd_signal") = 9,
+             "Create an engine for the TechnicalFeatures windows")
+        .def("columns", &quantamental::IndicatorEngine::columns,
+             "Feature names in compute_all order")
+        .def("compute", [](const quantamental::IndicatorEngine& engine,
+                           const SeriesArray& close, const SeriesArray& volume) {
+                 const double* close_data = series_data(close, "close");
+                 const double* volume_data = series_data(volume, "volume");
+                 if (close.size() != volume.size()) {
+                     throw py::value_error("close and volume must have the same length");
+                 }
+
+                 size_t n = static_cast<size_t>(close.size());
+                 py::array_t<double> features({static_cast<py::ssize_t>(engine.num_columns()),
+                                               static_cast<py::ssize_t>(n)});
+                 double* out = features.mutable_data();
+                 {
+                     py::gil_scoped_release release;
+                     engine.compute(close_data, volume_data, n, out);
+                 }
+                 return features;
+             },
+             py::arg("close"), py::arg("volume"),
+             "Compute every feature in one pass (releases the GIL). Returns a "
+             "(num_columns, n) float64 array; its transpose is the feature "
+             "DataFrame's values without a copy")
+        .def("compute_panel", [](const quantamental::IndicatorEngine& engine,
+                                 const PanelArray& close, const PanelArray& volume,
+                                 size_t num_threads) {
+                 check_panel(close, "close");
+                 check_panel(volume, "volume");
+                 if (close.shape(0) != volume.shape(0) || close.shape(1) != volume.shape(1)) {
+                     throw py::value_error("close and volume must have the same shape");
+                 }
+
+                 size_t num_dates = static_cast<size_t>(close.shape(0));
+                 size_t num_tickers = static_cast<size_t>(close.shape(1));
+                 py::array_t<double> features({static_cast<py::ssize_t>(engine.num_columns()),
+                                               static_cast<py::ssize_t>(num_dates),
+                                               static_cast<py::ssize_t>(num_tickers)});
+                 const double* close_data = close.data();
+                 const double* volume_data = volume.data();
+                 double* out = features.mutable_data();
+                 {
+                     py::gil_scoped_release release;
+                     engine.compute_panel(close_data, volume_data, num_dates, num_tickers,
+                                          out, num_threads);
+                 }
+                 return features;
+             },
+             py::arg("close"), py::arg("volume"), py::arg("num_threads") = 0,
+             "Compute every feature for a (dates, tickers) panel, tickers side "
+             "by side in SIMD lanes and across threads (releases the GIL). A NaN "
+             "close marks a date the ticker has no bar: its features are NaN "
+             "and its windows skip the date. Returns a (num_columns, dates, "
+             "tickers) float64 array; num_threads=0 uses all cores")
+        .def_static("panel_backend", &quantamental::IndicatorEngine::panel_backend,
+                    "SIMD kernel compute_panel uses: 'avx512', 'avx2' or 'scalar'")
+        .def("__repr__", [](const quantamental::IndicatorEngine& engine) {
+            return "<IndicatorEngine: " + std::to_string(engine.num_columns()) + " columns>";
+        });
+
+    // ========================================================================
+    // Expose IndicatorState class
+    // ========================================================================
+    py::class_<quantamental::IndicatorState>(m, "IndicatorState")
+        .def(py::init([](std::vector<int> horizons, std::vector<int> sma_windows, int rsi_period,
+                         int macd_fast, int macd_slow, int macd_signal) {
+                 auto state = quantamental::IndicatorState::create(make_indicator_config(
+                     std::move(horizons), std::move(sma_windows), rsi_period,
+                     macd_fast, macd_slow, macd_signal));
+                 if (!state) {
+                     throw py::value_error("indicator windows and periods must be positive");
+                 }
+                 return std::move(*state);
+             }),
+             py::arg("horizons") = std::vector<int>{1, 5, 10, 20},
+             py::arg("sma_windows") = std::vector<int>{10, 20, 50, 200},
+             py::arg("rsi_period") = 14,
+             py::arg("macd_fast") = 12,
+             py::arg("macd_slow") = 26,
+             py::arg("macd_signal") = 9,
+             "Create empty per-ticker state for the TechnicalFeatures windows")
+        .def("columns", &quantamental::IndicatorState::columns,
+             "Feature names in compute_all order")
+        .def("num_bars", &quantamental::IndicatorState::num_bars,
+             "Number of bars appended so far")
+        .def("last_timestamp", &quantamental::IndicatorState::last_timestamp,
+             "Timestamp of the last bar appended, or None")
+        .def("append", [](quantamental::IndicatorState& state, int64_t timestamp,
+                          double close, double volume) {
+                 py::array_t<double> row(static_cast<py::ssize_t>(state.num_columns()));
+                 if (!state.append(timestamp, close, volume, row.mutable_data())) {
+                     throw py::value_error("timestamp must be after last_timestamp()");
+                 }
+                 return row;
+             },
+             py::arg("timestamp"), py::arg("close"), py::arg("volume"),
+             "Append one bar and return its feature row")
+        .def("append_batch", [](quantamental::IndicatorState& state, const TimestampArray& timestamps,
+                                const SeriesArray& close, const SeriesArray& volume) {
+                 const double* close_data = series_data(close, "close");
+                 const double* volume_data = series_data(volume, "volume");
+                 if (timestamps.ndim() != 1 || close.size() != timestamps.size() ||
+                     volume.size() != timestamps.size()) {
+                     throw py::value_error("timestamps, close and volume must be 1-D with the same length");
+                 }
+
+                 size_t n = static_cast<size_t>(close.size());
+                 py::array_t<double> features({static_cast<py::ssize_t>(state.num_columns()),
+                                               static_cast<py::ssize_t>(n)});
+                 // Keeps the GIL: the state is not safe to append to from two threads
+                 if (!state.append_batch(timestamps.data(), close_data, volume_data, n,
+                                         features.mutable_data())) {
+                     throw py::value_error("timestamps must increase strictly past last_timestamp()");
+                 }
+                 return features;
+             },
+             py::arg("timestamps"), py::arg("close"), py::arg("volume"),
+             "Append bars and return their (num_columns, n) "
+             "features, laid out as IndicatorEngine.compute. Nothing is appended "
+             "if any timestamp is out of order")
+        .def("save_to_file", &quantamental::IndicatorState::save_to_file,
+             py::arg("filepath"),
+             "Save state to file")
+        .def_static("load_from_file", &quantamental::IndicatorState::load_from_file,
+                    py::arg("filepath"),
+                    "Load state from file (None if missing, corrupt or another version)")
+        .def(py::pickle(
+            [](const quantamental::IndicatorState& state) {
+                std::ostringstream out;
+                state.save_to_stream(out);
+                return py::bytes(out.str());
+            },
+            [](const py::bytes& data) {
+                std::istringstream in(static_cast<std::string>(data));
+                auto state = quantamental::IndicatorState::load_from_stream(in);
+                if (!state) {
+                    throw py::value_error("invalid IndicatorState pickle");
+                }
+                return std::move(*state);
+            }))
+        .def("__repr__", [](const quantamental::IndicatorState& state) {
+            return "<IndicatorState: " + std::to_string(state.num_bars()) + " bars, " +
+                   std::to_string(state.num_columns()) + " columns>";
+        });
+
+    // ========================================================================
+    // Expose BarStore class
+    // ========================================================================
+    py::class_<quantamental::BarStore>(m, "BarStore")
+        .def_static("create", [](const std::string& filepath, const std::vector<std::string>& tickers,
+                                 size_t date_capacity, const std::string& timezone) {
+                        if (timezone.size() > quantamental::BarStore::kMaxTimezoneLength) {
+                            throw py::value_error("timezone name is too long");
+                        }
+                        return quantamental::BarStore::create(filepath, tickers, date_capacity, timezone);
+                    },
+                    py::arg("filepath"), py::arg("tickers"), py::arg("date_capacity") = 4096,
+                    py::arg("timezone") = "",
+                    "Create (or replace) an empty store for these tickers, recording the "
+                    "timezone of its dates ('' for naive). Returns None on an I/O error, "
+                    "an invalid/repeated ticker, or while another writer has the store open")
+        .def_static("open", &quantamental::BarStore::open,
+                    py::arg("filepath"), py::arg("writable") = false,
+                    "Map an existing store; writable=True allows append/add_ticker and "
+                    "takes the single-writer lock. Returns None if the file is not a "
+                    "valid store or the lock is held")
+        .def("num_dates", &quantamental::BarStore::num_dates,
+             "Dates stored so far (appends by another process show up live)")
+        .def("num_tickers", &quantamental::BarStore::num_tickers)
+        .def("tickers", &quantamental::BarStore::tickers,
+             "Ticker directory, in column order")
+        .def("writable", &quantamental::BarStore::writable)
+        .def("timezone", &quantamental::BarStore::timezone,
+             "Timezone recorded at create() ('' for naive dates)")
+        .def("refresh", &quantamental::BarStore::refresh,
+             "Remap if the writer replaced the file and pick up added tickers; "
+             "False if the file can no longer be mapped")
+        .def("dates", [](const quantamental::BarStore& store) {
+                 return mapped_view(store, store.dates(),
+                                    {static_cast<py::ssize_t>(store.num_dates())},
+                                    {static_cast<py::ssize_t>(sizeof(int64_t))});
+             },
+             "Read-only int64 view of the date index (ns timestamps)")
+        .def("date_rows", [](const quantamental::BarStore& store, std::optional<int64_t> start,
+                             std::optional<int64_t> end) {
+                 return bar_rows(store, start, end);
+             },
+             py::arg("start") = py::none(), py::arg("end") = py::none(),
+             "Row range [begin, end) of the dates in [start, end]")
+        .def("panel", [](const quantamental::BarStore& store, const std::string& field,
+                         std::optional<int64_t> start, std::optional<int64_t> end) {
+                 auto [begin, stop] = bar_rows(store, start, end);
+                 if (store.num_tickers() == 0) {
+                     return py::array(py::dtype::of<double>(),
+                                      std::vector<py::ssize_t>{0, static_cast<py::ssize_t>(stop - begin)},
+                                      std::vector<py::ssize_t>{});
+                 }
+                 const double* first = store.column(bar_field(field), 0) + begin;
+                 return mapped_view(store, first,
+                                    {static_cast<py::ssize_t>(store.num_tickers()),
+                                     static_cast<py::ssize_t>(stop - begin)},
+                                    {static_cast<py::ssize_t>(store.column_stride() * sizeof(double)),
+                                     static_cast<py::ssize_t>(sizeof(double))});
+             },
+             py::arg("field"), py::arg("start") = py::none(), py::arg("end") = py::none(),
+             "Zero-copy (tickers, dates) view of one field for every ticker over "
+             "the dates in [start, end]; its .T is the dates x tickers frame")
+        .def("query", [](const quantamental::BarStore& store, const std::string& field,
+                         const std::vector<std::string>& tickers, std::optional<int64_t> start,
+                         std::optional<int64_t> end) {
+                 quantamental::BarStore::Field f = bar_field(field);
+                 auto [begin, stop] = bar_rows(store, start, end);
+                 py::dict columns;
+                 for (const std::string& ticker : tickers) {
+                     auto j = store.find_ticker(ticker);
+                     if (!j) throw py::key_error(ticker);
+                     columns[py::str(ticker)] = mapped_view(
+                         store, store.column(f, *j) + begin,
+                         {static_cast<py::ssize_t>(stop - begin)},
+                         {static_cast<py::ssize_t>(sizeof(double))});
+                 }
+                 return columns;
+             },
+             py::arg("field"), py::arg("tickers"), py::arg("start") = py::none(),
+             py::arg("end") = py::none(),
+             "Zero-copy 1-D views of one field for a set of tickers over the "
+             "dates in [start, end], as {ticker: array}")
+        .def("add_ticker", [](quantamental::BarStore& store, const std::string& ticker) {
+                 auto j = store.add_ticker(ticker);
+                 if (!j) {
+                     throw py::value_error("cannot add ticker '" + ticker + "' (read-only store, "
+                                           "invalid name or already present)");
+                 }
+                 return *j;
+             },
+             py::arg("ticker"),
+             "Add a ticker (NaN for every existing date); returns its column index")
+        .def("append", [](quantamental::BarStore& store, const TimestampArray& dates,
+                          const py::array_t<double, py::array::c_style | py::array::forcecast>& values) {
+                 size_t n = static_cast<size_t>(dates.size());
+                 if (dates.ndim() != 1 || values.ndim() != 3 ||
+                     static_cast<size_t>(values.shape(0)) != n ||
+                     static_cast<size_t>(values.shape(1)) != quantamental::BarStore::kNumFields ||
+                     static_cast<size_t>(values.shape(2)) != store.num_tickers()) {
+                     throw py::value_error("values must have shape (len(dates), 5, num_tickers) "
+                                           "with fields open, high, low, close, volume");
+                 }
+                 // Keeps the GIL: a store is not safe to append to from two threads
+                 if (!store.append(dates.data(), n, values.data())) {
+                     throw py::value_error("append failed: dates must increase past the last "
+                                           "stored date and the store must be writable");
+                 }
+             },
+             py::arg("dates"), py::arg("values"),
+             "Append dates (int64 ns, increasing) with a (n, 5, num_tickers) "
+             "OHLCV array, NaN where a ticker has no bar. Writes in place unless "
+             "the date capacity runs out, which doubles it with one rewrite")
+        .def("flush", &quantamental::BarStore::flush,
+             "Sync the mapping to disk (writable stores)")
+        .def("__repr__", [](const quantamental::BarStore& store) {
+            return "<BarStore: " + std::to_string(store.num_tickers()) + " tickers, " +
+                   std::to_string(store.num_dates()) + " dates>";
+        });
+
+    // ========================================================================
+    // Expose MlpModel and MlpEngine classes
+    // ========================================================================
+    using Activation = quantamental::MlpModel::Activation;
+    using FloatMatrix = py::array_t<float, py::array::c_style | py::array::forcecast>;
+    py::class_<quantamental::MlpModel> mlp_model(m, "MlpModel");
+
+    py::enum_<Activation>(mlp_model, "Activation")
+        .value("Identity", Activation::Identity)
+        .value("ReLU", Activation::ReLU)
+        .value("Tanh", Activation::Tanh)
+        .value("Sigmoid", Activation::Sigmoid);
+
+    mlp_model
+        .def(py::init([](std::vector<int> horizons, const std::vector<FloatMatrix>& weights,
+                         const std::vector<FloatMatrix>& biases, const std::vector<Activation>& activations) {
+                 if (biases.size() != weights.size() || activations.size() != weights.size()) {
+                     throw py::value_error("weights, biases and activations need one entry per layer");
+                 }
+                 std::vector<quantamental::MlpModel::Layer> layers;
+                 std::vector<std::vector<float>> weight_data, bias_data;
+                 for (size_t l = 0; l < weights.size(); ++l) {
+                     if (weights[l].ndim() != 2 || biases[l].ndim() != 1) {
+                         throw py::value_error("weights must be 2-D (out, in) and biases 1-D");
+                     }
+                     layers.push_back({static_cast<size_t>(weights[l].shape(1)),
+                                       static_cast<size_t>(weights[l].shape(0)), activations[l]});
+                     weight_data.emplace_back(weights[l].data(), weights[l].data() + weights[l].size());
+                     bias_data.emplace_back(biases[l].data(), biases[l].data() + biases[l].size());
+                 }
+                 auto model = quantamental::MlpModel::create(std::move(horizons), layers, weight_data, bias_data);
+                 if (!model) {
+                     throw py::value_error("layers must chain (each in = previous out), biases must match "
+                                           "their layer, and the last layer needs one output per horizon");
+                 }
+                 return std::move(*model);
+             }),
+             py::arg("horizons"), py::arg("weights"), py::arg("biases"), py::arg("activations"),
+             "Build a model from nn.Linear-layout float32 weights (out, in) and "
+             "biases, one activation per layer")
+        .def("save_to_file", &quantamental::MlpModel::save_to_file,
+             py::arg("filepath"),
+             "Save to the versioned binary weight format")
+        .def_static("load_from_file", &quantamental::MlpModel::load_from_file,
+                    py::arg("filepath"),
+                    "Load a saved model; None if the file is missing, corrupt or another version")
+        .def("horizons", &quantamental::MlpModel::horizons,
+             "Forecast horizon of each output")
+        .def("input_dim", &quantamental::MlpModel::input_dim,
+             "Features per row")
+        .def("output_dim", &quantamental::MlpModel::output_dim,
+             "Outputs per row (one per horizon)")
+        .def("num_layers", [](const quantamental::MlpModel& model) { return model.layers().size(); },
+             "Number of dense layers")
+        .def("activation", [](const quantamental::MlpModel& model, size_t layer) {
+                 if (layer >= model.layers().size()) throw py::index_error("layer out of range");
+                 return model.layers()[layer].activation;
+             },
+             py::arg("layer"),
+             "Activation of one layer")
+        .def("weights", [](const quantamental::MlpModel& model, size_t layer) {
+                 if (layer >= model.layers().size()) throw py::index_error("layer out of range");
+                 const auto& shape = model.layers()[layer];
+                 FloatMatrix out({static_cast<py::ssize_t>(shape.out), static_cast<py::ssize_t>(shape.in)});
+                 std::vector<float> values = model.weights(layer);
+                 std::copy(values.begin(), values.end(), out.mutable_data());
+                 return out;
+             },
+             py::arg("layer"),
+             "One layer's weights as an (out, in) float32 array")
+        .def("bias", [](const quantamental::MlpModel& model, size_t layer) {
+                 if (layer >= model.layers().size()) throw py::index_error("layer out of range");
+                 std::vector<float> values = model.bias(layer);
+                 FloatMatrix out(static_cast<py::ssize_t>(values.size()));
+                 std::copy(values.begin(), values.end(), out.mutable_data());
+                 return out;
+             },
+             py::arg("layer"),
+             "One layer's bias as a float32 array")
+        .def_static("backend", &quantamental::MlpModel::backend,
+                    "GEMM kernel used on this CPU: 'avx512', 'avx2' or 'scalar'")
+        .def("__repr__", [](const quantamental::MlpModel& model) {
+            std::string dims = std::to_string(model.input_dim());
+            for (const auto& layer : model.layers()) dims += "->" + std::to_string(layer.out);
+            return "<MlpModel: " + dims + ">";
+        });
+
+    py::class_<quantamental::MlpEngine>(m, "MlpEngine")
+        .def(py::init<quantamental::MlpModel, size_t>(),
+             py::arg("model"), py::arg("num_threads") = 0,
+             "Preallocate one activation arena per thread for batched inference")
+        .def("predict", [](quantamental::MlpEngine& engine, const FloatMatrix& x,
+                           std::optional<py::array> out) {
+                 const quantamental::MlpModel& model = engine.model();
+                 if (x.ndim() != 2 || static_cast<size_t>(x.shape(1)) != model.input_dim()) {
+                     throw py::value_error("x must have shape (rows, input_dim)");
+                 }
+                 const auto rows = x.shape(0);
+                 const auto outputs = static_cast<py::ssize_t>(model.output_dim());
+                 py::array_t<float> result;
+                 if (out) {
+                     if (!out->dtype().is(py::dtype::of<float>()) || out->ndim() != 2 ||
+                         out->shape(0) != rows || out->shape(1) != outputs ||
+                         !(out->flags() & py::array::c_style) || !out->writeable()) {
+                         throw py::value_error("out must be a writable C-contiguous float32 array "
+                                               "of shape (rows, output_dim)");
+                     }
+                     result = py::reinterpret_borrow<py::array_t<float>>(*out);
+                 } else {
+                     result = py::array_t<float>({rows, outputs});
+                 }
+                 const float* x_data = x.data();
+                 float* out_data = result.mutable_data();
+                 {
+                     py::gil_scoped_release release;
+                     engine.predict(x_data, static_cast<size_t>(rows), out_data);
+                 }
+                 return result;
+             },
+             py::arg("x"), py::arg("out") = py::none(),
+             "Forecasts for a (rows, input_dim) float32 batch as (rows, output_dim), "
+             "split across threads (releases the GIL). Pass out= to reuse a buffer")
+        .def("model", &quantamental::MlpEngine::model,
+             py::return_value_policy::reference_internal,
+             "The model being served")
+        .def("num_threads", &quantamental::MlpEngine::num_threads,
+             "Threads the arena is sized for")
+        .def("arena_bytes", &quantamental::MlpEngine::arena_bytes,
+             "Bytes of preallocated activation memory")
+        .def("__repr__", [](const quantamental::MlpEngine& engine) {
+            return "<MlpEngine: " + std::to_string(engine.num_threads()) + " threads, " +
+                   std::to_string(engine.arena_bytes()) + " arena bytes>";
+        });
+
+    // ========================================================================
+    // Expose FeatureCache class
+    // ========================================================================
+    py::class_<quantamental::FeatureCache>(m, "FeatureCache")
+        .def_static("create", &quantamental::FeatureCache::create,
+                    py::arg("filepath"), py::arg("num_rows"), py::arg("dim"),
+                    "Create (or replace) a cache of num_rows feature vectors of dim "
+                    "floats, e.g. under /dev/shm. Returns None on an I/O error")
+        .def_static("open", &quantamental::FeatureCache::open,
+                    py::arg("filepath"), py::arg("writable") = false,
+                    "Map an existing cache; None if the file is not a valid cache")
+        .def("num_rows", &quantamental::FeatureCache::num_rows)
+        .def("dim", &quantamental::FeatureCache::dim)
+        .def("writable", &quantamental::FeatureCache::writable)
+        .def("write", [](quantamental::FeatureCache& cache, const TickerIdArray& rows,
+                         const FloatMatrix& features, const TimestampArray& as_of) {
+                 if (!cache.writable()) throw std::runtime_error("FeatureCache is a read-only mapping");
+                 const size_t n = static_cast<size_t>(rows.size());
+                 if (rows.ndim() != 1 || features.ndim() != 2 || static_cast<size_t>(features.shape(0)) != n ||
+                     static_cast<size_t>(features.shape(1)) != cache.dim() ||
+                     (as_of.size() != 1 && static_cast<size_t>(as_of.size()) != n)) {
+                     throw py::value_error("features must have shape (len(rows), dim) and as_of be "
+                                           "a scalar or one timestamp per row");
+                 }
+                 const uint32_t* row_data = rows.data();
+                 for (size_t i = 0; i < n; ++i) {
+                     if (row_data[i] >= cache.num_rows()) throw py::index_error("row out of range");
+                 }
+                 const float* feature_data = features.data();
+                 const int64_t* as_of_data = as_of.data();
+                 const size_t as_of_step = as_of.size() == 1 ? 0 : 1;
+                 py::gil_scoped_release release;
+                 for (size_t i = 0; i < n; ++i) {
+                     cache.write(row_data[i], feature_data + i * cache.dim(), as_of_data[i * as_of_step]);
+                 }
+             },
+             py::arg("rows"), py::arg("features"), py::arg("as_of"),
+             "Store features[i] (float32) as row rows[i]'s latest vector, as of "
+             "as_of (ns timestamps, one per row or one for all)")
+        .def("read", [](const quantamental::FeatureCache& cache, size_t row) -> py::object {
+                 if (row >= cache.num_rows()) throw py::index_error("row out of range");
+                 FloatMatrix features(static_cast<py::ssize_t>(cache.dim()));
+                 int64_t as_of = 0;
+                 if (!cache.read(row, features.mutable_data(), &as_of)) return py::none();
+                 return py::make_tuple(features, as_of);
+             },
+             py::arg("row"),
+             "(features, as_of) of one row, or None if it has never been written")
+        .def("flush", &quantamental::FeatureCache::flush,
+             "Sync the mapping to its file")
+        .def("__repr__", [](const quantamental::FeatureCache& cache) {
+            return "<FeatureCache: " + std::to_string(cache.num_rows()) + " rows x " +
+                   std::to_string(cache.dim()) + " features>";
+        });
+
+    // ========================================================================
+    // Expose InferenceServer class
+    // ========================================================================
+    using ServerStats = quantamental::InferenceServer::Stats;
+    using LatencySummary = quantamental::InferenceServer::LatencySummary;
+    py::class_<quantamental::InferenceServer> inference_server(m, "InferenceServer");
+
+    py::class_<LatencySummary>(inference_server, "LatencySummary")
+        .def_readonly("samples", &LatencySummary::samples)
+        .def_readonly("mean_us", &LatencySummary::mean_us)
+        .def_readonly("p50_us", &LatencySummary::p50_us,
+                      "Median in microseconds (bucket upper edge, within 1/8)")
+        .def_readonly("p99_us", &LatencySummary::p99_us,
+                      "99th percentile in microseconds (bucket upper edge, within 1/8)")
+        .def_readonly("max_us", &LatencySummary::max_us)
+        .def("__repr__", [](const LatencySummary& s) {
+            return "<LatencySummary: samples=" + std::to_string(s.samples) +
+                   ", p50_us<=" + std::to_string(s.p50_us) + ", p99_us<=" + std::to_string(s.p99_us) + ">";
+        });
+
+    py::class_<ServerStats>(inference_server, "Stats")
+        .def_readonly("requests", &ServerStats::requests, "Requests scored")
+        .def_readonly("batches", &ServerStats::batches)
+        .def_readonly("rejected", &ServerStats::rejected, "Requests answered Busy")
+        .def_readonly("bad_requests", &ServerStats::bad_requests)
+        .def_readonly("connections", &ServerStats::connections)
+        .def_readonly("mean_batch_size", &ServerStats::mean_batch_size)
+        .def_readonly("queue", &ServerStats::queue, "Arrival to start of batch")
+        .def_readonly("compute", &ServerStats::compute, "Feature gather and forward pass of the batch")
+        .def("__repr__", [](const ServerStats& s) {
+            return "<InferenceServer.Stats: requests=" + std::to_string(s.requests) +
+                   ", batches=" + std::to_string(s.batches) +
+                   ", rejected=" + std::to_string(s.rejected) + ">";
+        });
+
+    inference_server
+        .def_static("start", [](quantamental::MlpModel model, const std::string& socket_path,
+                                size_t max_batch, uint32_t max_wait_us, size_t num_workers,
+                                bool pin_workers, size_t queue_capacity, const std::string& feature_cache_path) {
+                        quantamental::InferenceServerConfig config{socket_path, max_batch, max_wait_us, num_workers,
+                                                                   pin_workers, queue_capacity, feature_cache_path};
+                        py::gil_scoped_release release;
+                        return quantamental::InferenceServer::start(std::move(model), std::move(config));
+                    },
+                    py::arg("model"), py::arg("socket_path"), py::arg("max_batch") = 64,
+                    py::arg("max_wait_us") = 200, py::arg("num_workers") = 1, py::arg("pin_workers") = true,
+                    py::arg("queue_capacity") = 4096, py::arg("feature_cache_path") = "",
+                    "Serve the model on a Unix domain socket from background threads. "
+                    "Returns None if the socket cannot be bound or the feature cache "
+                    "cannot be opened or does not match the model's input_dim")
+        .def("stop", &quantamental::InferenceServer::stop,
+             py::call_guard<py::gil_scoped_release>(),
+             "Answer what is queued, close connections and remove the socket")
+        .def("stats", &quantamental::InferenceServer::stats,
+             "Request, batch and latency counters since start or reset_stats()")
+        .def("reset_stats", &quantamental::InferenceServer::reset_stats)
+        .def("socket_path", [](const quantamental::InferenceServer& server) {
+                 return server.config().socket_path;
+             })
+        .def("__repr__", [](const quantamental::InferenceServer& server) {
+            const auto& config = server.config();
+            return "<InferenceServer: " + config.socket_path + ", max_batch=" +
+                   std::to_string(config.max_batch) + ", max_wait_us=" +
+                   std::to_string(config.max_wait_us) + ">";
+        });
+
+    // ========================================================================
+    // Expose LabelBuilder class
+    // ========================================================================
+    py::class_<quantamental::LabelBuilder>(m, "LabelBuilder")
+        .def(py::init([](std::vector<int> horizons, int vol_window) {
+                 auto builder = quantamental::LabelBuilder::create(
+                     quantamental::LabelConfig{std::move(horizons), vol_window});
+                 if (!builder) {
+                     throw py::value_error("horizons must be positive and vol_window at least 2");
+                 }
+                 return std::move(*builder);
+             }),
+             py::arg("horizons") = std::vector<int>{1, 5, 10, 20},
+             py::arg("vol_window") = 20,
+             "Create a forward-return label builder for the given horizons")
+        .def("columns", &quantamental::LabelBuilder::columns,
+             "Label names: fwd_return / fwd_log_return / fwd_vol_scaled / "
+             "fwd_excess per horizon")
+        .def("build", [](const quantamental::LabelBuilder& builder, const PanelArray& close,
+                         std::optional<SeriesArray> benchmark, std::optional<size_t> num_known_dates,
+                         size_t num_threads) {
+                 check_panel(close, "close");
+                 size_t num_dates = static_cast<size_t>(close.shape(0));
+                 size_t num_tickers = static_cast<size_t>(close.shape(1));
+                 const double* benchmark_data = nullptr;
+                 if (benchmark) {
+                     benchmark_data = series_data(*benchmark, "benchmark");
+                     if (static_cast<size_t>(benchmark->size()) != num_dates) {
+                         throw py::value_error("benchmark must hold one close per date");
+                     }
+                 }
+
+                 py::array_t<double> labels({static_cast<py::ssize_t>(builder.num_columns()),
+                                             static_cast<py::ssize_t>(num_dates),
+                                             static_cast<py::ssize_t>(num_tickers)});
+                 const double* close_data = close.data();
+                 double* out = labels.mutable_data();
+                 {
+                     py::gil_scoped_release release;
+                     builder.build(close_data, benchmark_data, num_dates, num_tickers,
+                                   num_known_dates.value_or(num_dates), out, num_threads);
+                 }
+                 return labels;
+             },
+             py::arg("close"), py::arg("benchmark") = py::none(),
+             py::arg("num_known_dates") = py::none(), py::arg("num_threads") = 0,
+             "Build every label from a (dates, tickers) close panel (NaN = no "
+             "bar) in one pass across threads (releases the GIL). Returns a "
+             "(num_columns, dates, tickers) float64 array. Labels whose exit "
+             "date is at or past num_known_dates are NaN, masking look-ahead "
+             "past the sample boundary")
+        .def("__repr__", [](const quantamental::LabelBuilder& builder) {
+            return "<LabelBuilder: " + std::to_string(builder.num_columns()) + " labels>";
+        });
+
+    // ========================================================================
+    // Expose RollingCovariance class
+    // ========================================================================
+    using RollingCovariance = quantamental::RollingCovariance;
+    py::class_<RollingCovariance> rolling_covariance(m, "RollingCovariance");
+
+    py::enum_<RollingCovariance::Target>(rolling_covariance, "Target")
+        .value("Diagonal", RollingCovariance::Target::Diagonal)
+        .value("ConstantCorrelation", RollingCovariance::Target::ConstantCorrelation);
+
+    rolling_covariance
+        .def(py::init([](size_t num_tickers, std::vector<size_t> windows, size_t min_periods) {
+                 auto rolling = RollingCovariance::create(num_tickers, std::move(windows), min_periods);
+                 if (!rolling) {
+                     throw py::value_error("need tickers, windows of at least min_periods dates, "
+                                           "and min_periods >= 2");
+                 }
+                 return std::move(*rolling);
+             }),
+             py::arg("num_tickers"), py::arg("windows") = std::vector<size_t>{20, 60, 120},
+             py::arg("min_periods") = 2,
+             "Create a rolling covariance engine over num_tickers for every window at once")
+        .def("update", [](RollingCovariance& rolling, const PanelArray& values, size_t num_threads) {
+                 const size_t n = rolling.num_tickers();
+                 if ((values.ndim() != 1 && values.ndim() != 2) ||
+                     static_cast<size_t>(values.shape(values.ndim() - 1)) != n) {
+                     throw py::value_error("values must be one (tickers,) row or a (dates, tickers) array");
+                 }
+                 const size_t num_dates = values.ndim() == 1 ? 1 : static_cast<size_t>(values.shape(0));
+                 // Keeps the GIL: the sums are not safe to update from two threads
+                 rolling.update(values.data(), num_dates, num_threads);
+             },
+             py::arg("values"), py::arg("num_threads") = 0,
+             "Append one date's values (e.g. returns; NaN = no bar) or a (dates, "
+             "tickers) block and slide every window forward")
+        .def("reset", &RollingCovariance::reset,
+             "Forget every date seen")
+        .def("num_tickers", &RollingCovariance::num_tickers)
+        .def("windows", &RollingCovariance::windows)
+        .def("min_periods", &RollingCovariance::min_periods)
+        .def("num_dates", &RollingCovariance::num_dates,
+             "Dates seen since creation or reset()")
+        .def("memory_bytes", &RollingCovariance::memory_bytes)
+        .def("covariance", [](const RollingCovariance& rolling, size_t window,
+                              std::optional<py::array> out, size_t num_threads) {
+                 return matrix_output<double>(rolling, window, out, [&](double* data) {
+                     rolling.covariance(window, data, num_threads);
+                 });
+             },
+             py::arg("window"), py::arg("out") = py::none(), py::arg("num_threads") = 0,
+             "Covariance matrix (ddof=1) of windows()[window] over each pair's "
+             "joint dates; NaN where a pair has fewer than min_periods")
+        .def("correlation", [](const RollingCovariance& rolling, size_t window,
+                               std::optional<py::array> out, size_t num_threads) {
+                 return matrix_output<double>(rolling, window, out, [&](double* data) {
+                     rolling.correlation(window, data, num_threads);
+                 });
+             },
+             py::arg("window"), py::arg("out") = py::none(), py::arg("num_threads") = 0,
+             "Pairwise correlation matrix of windows()[window]")
+        .def("shrunk_covariance", [](const RollingCovariance& rolling, size_t window, double intensity,
+                                     RollingCovariance::Target target, std::optional<py::array> out,
+                                     size_t num_threads) {
+                 return matrix_output<double>(rolling, window, out, [&](double* data) {
+                     rolling.shrunk_covariance(window, intensity, target, data, num_threads);
+                 });
+             },
+             py::arg("window"), py::arg("intensity"),
+             py::arg("target") = RollingCovariance::Target::ConstantCorrelation,
+             py::arg("out") = py::none(), py::arg("num_threads") = 0,
+             "(1 - intensity) * covariance + intensity * target, keeping the variances")
+        .def("counts", [](const RollingCovariance& rolling, size_t window,
+                          std::optional<py::array> out, size_t num_threads) {
+                 return matrix_output<int64_t>(rolling, window, out, [&](int64_t* data) {
+                     rolling.counts(window, data, num_threads);
+                 });
+             },
+             py::arg("window"), py::arg("out") = py::none(), py::arg("num_threads") = 0,
+             "Joint observations (int64) of every pair in windows()[window]")
+        .def_static("backend", &RollingCovariance::backend,
+                    "Tile kernel in use: 'avx512', 'avx2' or 'scalar'")
+        .def("__repr__", [](const RollingCovariance& rolling) {
+            std::ostringstream oss;
+            oss << "<RollingCovariance: " << rolling.num_tickers() << " tickers, windows=[";
+            for (size_t i = 0; i < rolling.windows().size(); ++i) {
+                oss << (i ? ", " : "") << rolling.windows()[i];
+            }
+            oss << "], " << rolling.num_dates() << " dates>";
+            return oss.str();
+        });
+
+    // ========================================================================
+    // Expose Backtester class
+    // ========================================================================
+    py::enum_<quantamental::Weighting>(m, "Weighting")
+        .value("TopBottom", quantamental::Weighting::TopBottom)
+        .value("Rank", quantamental::Weighting::Rank)
+        .value("VolScaled", quantamental::Weighting::VolScaled);
+
+    using BacktestConfig = quantamental::BacktestConfig;
+    py::class_<BacktestConfig>(m, "BacktestConfig")
+        .def(py::init([](quantamental::Weighting weighting, size_t top_k, bool long_only,
+                         double gross_exposure, double cost_bps, double max_turnover) {
+                 return BacktestConfig{weighting, top_k, long_only, gross_exposure, cost_bps, max_turnover};
+             }),
+             py::arg("weighting") = quantamental::Weighting::TopBottom, py::arg("top_k") = 50,
+             py::arg("long_only") = false, py::arg("gross_exposure") = 1.0,
+             py::arg("cost_bps") = 5.0, py::arg("max_turnover") = 0.0)
+        .def_readwrite("weighting", &BacktestConfig::weighting)
+        .def_readwrite("top_k", &BacktestConfig::top_k, "Names per side (TopBottom, VolScaled)")
+        .def_readwrite("long_only", &BacktestConfig::long_only)
+        .def_readwrite("gross_exposure", &BacktestConfig::gross_exposure, "Sum of |weights| of the target")
+        .def_readwrite("cost_bps", &BacktestConfig::cost_bps, "One-way cost on traded notional")
+        .def_readwrite("max_turnover", &BacktestConfig::max_turnover,
+                       "Cap on sum |trade| per rebalance; 0 = none")
+        .def("__repr__", [](const BacktestConfig& config) {
+            std::ostringstream oss;
+            oss << "<BacktestConfig: " << py::str(py::cast(config.weighting)).cast<std::string>()
+                << ", top_k=" << config.top_k << ", long_only=" << (config.long_only ? "True" : "False")
+                << ", gross_exposure=" << config.gross_exposure << ", cost_bps=" << config.cost_bps
+                << ", max_turnover=" << config.max_turnover << ">";
+            return oss.str();
+        });
+
+    using BacktestSummary = quantamental::BacktestSummary;
+    py::class_<BacktestSummary>(m, "BacktestSummary")
+        .def_readonly("total_return", &BacktestSummary::total_return)
+        .def_readonly("annual_return", &BacktestSummary::annual_return, "Geometric, 252 dates a year")
+        .def_readonly("annual_volatility", &BacktestSummary::annual_volatility)
+        .def_readonly("sharpe", &BacktestSummary::sharpe)
+        .def_readonly("max_drawdown", &BacktestSummary::max_drawdown, "Deepest drawdown, <= 0")
+        .def_readonly("hit_rate", &BacktestSummary::hit_rate,
+                      "Share of invested dates with a positive net return")
+        .def_readonly("mean_turnover", &BacktestSummary::mean_turnover)
+        .def_readonly("total_cost", &BacktestSummary::total_cost)
+        .def_readonly("mean_ic", &BacktestSummary::mean_ic)
+        .def_readonly("ic_ir", &BacktestSummary::ic_ir)
+        .def_readonly("mean_rank_ic", &BacktestSummary::mean_rank_ic)
+        .def_readonly("rank_ic_ir", &BacktestSummary::rank_ic_ir)
+        .def("to_dict", [](const BacktestSummary& s) {
+                 py::dict d;
+                 d["total_return"] = s.total_return;
+                 d["annual_return"] = s.annual_return;
+                 d["annual_volatility"] = s.annual_volatility;
+                 d["sharpe"] = s.sharpe;
+                 d["max_drawdown"] = s.max_drawdown;
+                 d["hit_rate"] = s.hit_rate;
+                 d["mean_turnover"] = s.mean_turnover;
+                 d["total_cost"] = s.total_cost;
+                 d["mean_ic"] = s.mean_ic;
+                 d["ic_ir"] = s.ic_ir;
+                 d["mean_rank_ic"] = s.mean_rank_ic;
+                 d["rank_ic_ir"] = s.rank_ic_ir;
+                 return d;
+             })
+        .def("__repr__", [](const BacktestSummary& s) {
+            std::ostringstream oss;
+            oss << "<BacktestSummary: sharpe=" << s.sharpe << ", annual_return=" << s.annual_return
+                << ", max_drawdown=" << s.max_drawdown << ", mean_ic=" << s.mean_ic << ">";
+            return oss.str();
+        });
+
+    using Backtester = quantamental::Backtester;
+    py::class_<Backtester>(m, "Backtester")
+        .def(py::init([](const PanelArray& scores, const PanelArray& returns,
+                         std::optional<PanelArray> volatility, std::optional<PanelArray> ic_target,
+                         size_t num_threads) {
+                 check_panel(scores, "scores");
+                 auto check_shape = [&scores](const PanelArray& panel, const char* name) {
+                     if (panel.ndim() != 2 || panel.shape(0) != scores.shape(0) ||
+                         panel.shape(1) != scores.shape(1)) {
+                         throw py::value_error(std::string(name) + " must have the shape of scores");
+                     }
+                 };
+                 check_shape(returns, "returns");
+                 if (volatility) check_shape(*volatility, "volatility");
+                 if (ic_target) check_shape(*ic_target, "ic_target");
+
+                 const double* score_data = scores.data();
+                 const double* return_data = returns.data();
+                 const double* vol_data = volatility ? volatility->data() : nullptr;
+                 const double* target_data = ic_target ? ic_target->data() : nullptr;
+                 std::optional<Backtester> backtester;
+                 {
+                     py::gil_scoped_release release;
+                     backtester = Backtester::create(score_data, return_data, vol_data, target_data,
+                                                     static_cast<size_t>(scores.shape(0)),
+                                                     static_cast<size_t>(scores.shape(1)), num_threads);
+                 }
+                 if (!backtester) {
+                     throw py::value_error("scores must hold at least one date and one ticker");
+                 }
+                 return std::move(*backtester);
+             }),
+             py::arg("scores"), py::arg("returns"), py::arg("volatility") = py::none(),
+             py::arg("ic_target") = py::none(), py::arg("num_threads") = 0,
+             "Copy (dates, tickers) panels of model scores and the returns each "
+             "date's book earns (NaN = no score / no return), sort every date's "
+             "scores and compute the daily IC once (releases the GIL). volatility "
+             "is needed for Weighting.VolScaled; ic_target defaults to returns")
+        .def("accepts", &Backtester::accepts, py::arg("config"),
+             "Whether run() / sweep() take the config")
+        .def("run", [](Backtester& backtester, const BacktestConfig& config) {
+                 if (!backtester.accepts(config)) {
+                     throw py::value_error("config not accepted: check top_k, gross_exposure, "
+                                           "cost_bps, max_turnover and volatility for VolScaled");
+                 }
+                 const auto num_dates = static_cast<py::ssize_t>(backtester.num_dates());
+                 py::array_t<double> series({static_cast<py::ssize_t>(Backtester::kNumSeries), num_dates});
+                 BacktestSummary summary;
+                 double* series_data_out = series.mutable_data();
+                 {
+                     py::gil_scoped_release release;
+                     backtester.run(config, summary, series_data_out);
+                 }
+                 py::dict named;
+                 const auto& names = Backtester::series_names();
+                 for (size_t i = 0; i < names.size(); ++i) {
+                     named[py::str(names[i])] = series[py::int_(i)];
+                 }
+                 return py::make_tuple(summary, named);
+             },
+             py::arg("config"),
+             "Backtest one config (releases the GIL). Returns (BacktestSummary, "
+             "dict of per-date float64 series: net_return, gross_return, "
+             "turnover, drawdown)")
+        .def("sweep", [](Backtester& backtester, const std::vector<BacktestConfig>& configs,
+                         bool series) {
+                 for (const BacktestConfig& config : configs) {
+                     if (!backtester.accepts(config)) {
+                         throw py::value_error("config not accepted: " +
+                                               py::repr(py::cast(config)).cast<std::string>());
+                     }
+                 }
+                 std::vector<BacktestSummary> summaries(configs.size());
+                 py::object all_series = py::none();
+                 double* series_out = nullptr;
+                 if (series) {
+                     py::array_t<double> values({static_cast<py::ssize_t>(configs.size()),
+                                                 static_cast<py::ssize_t>(Backtester::kNumSeries),
+                                                 static_cast<py::ssize_t>(backtester.num_dates())});
+                     series_out = values.mutable_data();
+                     all_series = values;
+                 }
+                 {
+                     py::gil_scoped_release release;
+                     backtester.sweep(configs.data(), configs.size(), summaries.data(), series_out);
+                 }
+                 return py::make_tuple(summaries, all_series);
+             },
+             py::arg("configs"), py::arg("series") = false,
+             "Backtest every config, split across threads in preallocated "
+             "buffers (releases the GIL). Returns (list of BacktestSummary, "
+             "(configs, 4, dates) series array or None)")
+        .def_static("series_names", &Backtester::series_names)
+        .def("ic", [](const Backtester& backtester) {
+                 return py::array_t<double>(static_cast<py::ssize_t>(backtester.num_dates()),
+                                            backtester.ic().data());
+             },
+             "Daily Pearson IC of scores against ic_target; NaN below 3 pairs")
+        .def("rank_ic", [](const Backtester& backtester) {
+                 return py::array_t<double>(static_cast<py::ssize_t>(backtester.num_dates()),
+                                            backtester.rank_ic().data());
+             },
+             "Daily Spearman rank IC")
+        .def("num_dates", &Backtester::num_dates)
+        .def("num_tickers", &Backtester::num_tickers)
+        .def("num_threads", &Backtester::num_threads,
+             "Threads the run buffers are sized for")
+        .def("has_volatility", &Backtester::has_volatility)
+        .def("__repr__", [](const Backtester& backtester) {
+            return "<Backtester: " + std::to_string(backtester.num_dates()) + " dates x " +
+                   std::to_string(backtester.num_tickers()) + " tickers, " +
+                   std::to_string(backtester.num_threads()) + " threads>";
+        });
+
+    // ========================================================================
+    // Expose cross-sectional transforms
+    // ========================================================================
+    m.def("cross_sectional_zscore", [](const py::array& panel, bool inplace, size_t num_threads) {
+              return transform_panel(panel, inplace, [num_threads](const double* in, double* out,
+                                                                   size_t rows, size_t tickers) {
+                  quantamental::cross_section::zscore(in, out, rows, tickers, num_threads);
+              });
+          },
+          py::arg("panel"), py::arg("inplace") = false, py::arg("num_threads") = 0,
+          "Z-score each row across tickers (std with ddof=1), skipping NaN. "
+          "The last axis is tickers; releases the GIL");
+
+    m.def("cross_sectional_rank", [](const py::array& panel, bool pct, bool inplace,
+                                     size_t num_threads) {
+              return transform_panel(panel, inplace, [pct, num_threads](const double* in, double* out,
+                                                                        size_t rows, size_t tickers) {
+                  quantamental::cross_section::rank(in, out, rows, tickers, pct, num_threads);
+              });
+          },
+          py::arg("panel"), py::arg("pct") = false, py::arg("inplace") = false,
+          py::arg("num_threads") = 0,
+          "Rank each row across tickers like DataFrame.rank(axis=1): ties "
+          "averaged, NaN kept; pct=True divides by the row's count");
+
+    m.def("cross_sectional_winsorize", [](const py::array& panel, double lower, double upper,
+                                          bool inplace, size_t num_threads) {
+              if (!(lower >= 0.0 && lower <= upper && upper <= 1.0)) {
+                  throw py::value_error("quantiles must satisfy 0 <= lower <= upper <= 1");
+              }
+              return transform_panel(panel, inplace, [=](const double* in, double* out,
+                                                         size_t rows, size_t tickers) {
+                  quantamental::cross_section::winsorize(in, out, rows, tickers, lower, upper,
+                                                         num_threads);
+              });
+          },
+          py::arg("panel"), py::arg("lower") = 0.01, py::arg("upper") = 0.99,
+          py::arg("inplace") = false, py::arg("num_threads") = 0,
+          "Clip each row to its lower/upper quantiles (linear interpolation, "
+          "as DataFrame.quantile), skipping NaN");
+
+    m.def("cross_sectional_demean", [](const py::array& panel,
+                                       const py::array_t<int32_t, py::array::c_style | py::array::forcecast>& groups,
+                                       bool inplace, size_t num_threads) {
+              if (groups.ndim() != 1 || panel.ndim() < 1 ||
+                  groups.shape(0) != panel.shape(panel.ndim() - 1)) {
+                  throw py::value_error("groups must hold one id per ticker (the panel's last axis)");
+              }
+              const int32_t* group_ids = groups.data();
+              return transform_panel(panel, inplace, [=](const double* in, double* out,
+                                                         size_t rows, size_t tickers) {
+                  quantamental::cross_section::demean_by_group(in, out, rows, tickers, group_ids,
+                                                               num_threads);
+              });
+          },
+          py::arg("panel"), py::arg("groups"), py::arg("inplace") = false,
+          py::arg("num_threads") = 0,
+          "Subtract each row's group mean (e.g. sector-neutral features). "
+          "groups[j] is ticker j's integer group id; negative ids give NaN");
+
     // ========================================================================
     // Module-level convenience functions
     // ========================================================================
@@ -0,0 +1,136 @@
+#include "bit_words.hpp"
+#include <bit>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#include <immintrin.h>
+#define BIT_WORDS_X86 1
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace quantamental::detail {
+    namespace {
+
+        // ============================================================================
+        // Scalar Kernels
+        // ============================================================================
+
+        template <WordOp Op>
+        uint64_t combine_scalar(uint64_t* dst, const uint64_t* src, size_t n) {
+            uint64_t count = 0;
+            for (size_t i = 0; i < n; ++i) {
+                dst[i] = Op == WordOp::Or ? dst[i] | src[i] : dst[i] & src[i];
+                count += std::popcount(dst[i]);
+            }
+            return count;
+        }
+
+        uint64_t popcount_scalar(const uint64_t* words, size_t n) {
+            uint64_t count = 0;
+            for (size_t i = 0; i < n; ++i) {
+                count += std::popcount(words[i]);
+            }
+            return count;
+        }
+
+        // ============================================================================
+        // AVX2 Kernels
+        // ============================================================================
+        // Bits are counted per nibble with a shuffle lookup and summed into
+        // 64-bit lanes with sad_epu8 (Mula et al., "Faster Population Counts
+        // Using AVX2 Instructions", 2016).
+#if defined(BIT_WORDS_X86)
+        TARGET_AVX2 inline __m256i popcount_lanes(__m256i v) {
+            const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+            const __m256i low_nibbles = _mm256_set1_epi8(0x0f);
+            __m256i lo = _mm256_and_si256(v, low_nibbles);
+            __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_nibbles);
+            __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                            _mm256_shuffle_epi8(lookup, hi));
+            return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+        }
+
+        TARGET_AVX2 inline uint64_t sum_lanes(__m256i v) {
+            return static_cast<uint64_t>(_mm256_extract_epi64(v, 0)) +
+                   static_cast<uint64_t>(_mm256_extract_epi64(v, 1)) +
+                   static_cast<uint64_t>(_mm256_extract_epi64(v, 2)) +
+                   static_cast<uint64_t>(_mm256_extract_epi64(v, 3));
+        }
+
+        template <WordOp Op>
+        TARGET_AVX2 uint64_t combine_avx2(uint64_t* dst, const uint64_t* src, size_t n) {
+            __m256i counts = _mm256_setzero_si256();
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m256i* d = reinterpret_cast<__m256i*>(dst + i);
+                const __m256i* s = reinterpret_cast<const __m256i*>(src + i);
+                __m256i a = _mm256_loadu_si256(d);
+                __m256i b = _mm256_loadu_si256(d + 1);
+                if constexpr (Op == WordOp::Or) {
+                    a = _mm256_or_si256(a, _mm256_loadu_si256(s));
+                    b = _mm256_or_si256(b, _mm256_loadu_si256(s + 1));
+                } else {
+                    a = _mm256_and_si256(a, _mm256_loadu_si256(s));
+                    b = _mm256_and_si256(b, _mm256_loadu_si256(s + 1));
+                }
+                _mm256_storeu_si256(d, a);
+                _mm256_storeu_si256(d + 1, b);
+                counts = _mm256_add_epi64(counts, _mm256_add_epi64(popcount_lanes(a), popcount_lanes(b)));
+            }
+            return sum_lanes(counts) + combine_scalar<Op>(dst + i, src + i, n - i);
+        }
+
+        TARGET_AVX2 uint64_t popcount_avx2(const uint64_t* words, size_t n) {
+            __m256i counts = _mm256_setzero_si256();
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                const __m256i* w = reinterpret_cast<const __m256i*>(words + i);
+                counts = _mm256_add_epi64(counts, _mm256_add_epi64(
+                    popcount_lanes(_mm256_loadu_si256(w)), popcount_lanes(_mm256_loadu_si256(w + 1))));
+            }
+            return sum_lanes(counts) + popcount_scalar(words + i, n - i);
+        }
+#endif
+
+        // ============================================================================
+        // Dispatch
+        // ============================================================================
+
+        struct Kernels {
+            uint64_t (*combine_or)(uint64_t*, const uint64_t*, size_t);
+            uint64_t (*combine_and)(uint64_t*, const uint64_t*, size_t);
+            uint64_t (*popcount)(const uint64_t*, size_t);
+            const char* name;
+        };
+
+        Kernels select_kernels() {
+#if defined(BIT_WORDS_X86)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return Kernels{combine_avx2<WordOp::Or>, combine_avx2<WordOp::And>,
+                               popcount_avx2, "avx2"};
+            }
+#endif
+            return Kernels{combine_scalar<WordOp::Or>, combine_scalar<WordOp::And>,
+                           popcount_scalar, "scalar"};
+        }
+
+        const Kernels& kernels() {
+            static const Kernels selected = select_kernels();
+            return selected;
+        }
+    }
+
+    uint64_t combine_words(uint64_t* dst, const uint64_t* src, size_t n, WordOp op) {
+        const Kernels& k = kernels();
+        return op == WordOp::Or ? k.combine_or(dst, src, n) : k.combine_and(dst, src, n);
+    }
+
+    uint64_t popcount_words(const uint64_t* words, size_t n) {
+        return kernels().popcount(words, n);
+    }
+
+    const char* bit_words_backend() {
+        return kernels().name;
+    }
+}
@@ -0,0 +1,31 @@
+// bit_words.hpp
+//
+// Whole-array kernels over 64-bit words for merging and counting filter
+// bit arrays. AVX2 is picked at runtime when the CPU has it; the results
+// match the scalar loop exactly.
+
+#ifndef BIT_WORDS_HPP
+#define BIT_WORDS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace quantamental::detail {
+
+enum class WordOp {
+    Or,
+    And
+};
+
+// dst[i] = dst[i] op src[i] for i < n; returns the set bits of the result
+uint64_t combine_words(uint64_t* dst, const uint64_t* src, size_t n, WordOp op);
+
+// Set bits in words[0, n)
+uint64_t popcount_words(const uint64_t* words, size_t n);
+
+// Kernel in use: "avx2" or "scalar"
+const char* bit_words_backend();
+
+} // namespace quantamental::detail
+
+#endif // BIT_WORDS_HPP
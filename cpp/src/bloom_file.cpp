@@ -0,0 +1,234 @@
+#include "bloom_file.hpp"
+#include "murmur_hash3.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace quantamental::detail {
+    namespace {
+        // File header: magic "QBLF" followed by a format version. Files without
+        // the magic are the original headerless format: Standard layout,
+        // Seeded probes, no checksum.
+        constexpr uint32_t kFileMagic = 0x464C4251;
+        constexpr uint32_t kFileVersion = 1;
+        constexpr uint32_t kEndianTag = 0x01020304;
+
+        struct RawHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t endian_tag;
+            uint32_t header_bytes;
+            uint32_t layout;
+            uint32_t hash_scheme;
+            uint32_t num_hashes;
+            uint32_t reserved;
+            uint64_t num_bits;
+            uint64_t num_words;
+            uint64_t num_insertions;
+            uint64_t num_queries;
+            uint64_t data_offset;
+            uint64_t checksum;
+        };
+        static_assert(sizeof(RawHeader) == 80, "RawHeader layout is part of the file format");
+
+        RawHeader to_raw(const BloomFileHeader& header) {
+            RawHeader raw{};
+            raw.magic = kFileMagic;
+            raw.version = kFileVersion;
+            raw.endian_tag = kEndianTag;
+            raw.header_bytes = sizeof(RawHeader);
+            raw.layout = static_cast<uint32_t>(header.layout);
+            raw.hash_scheme = static_cast<uint32_t>(header.hash_scheme);
+            raw.num_hashes = header.num_hashes;
+            raw.num_bits = header.num_bits;
+            raw.num_words = (header.num_bits + 63) / 64;
+            raw.num_insertions = header.num_insertions;
+            raw.num_queries = header.num_queries;
+            raw.data_offset = kDataAlignment;
+            raw.checksum = header.checksum;
+            return raw;
+        }
+
+        // Validates a header (magic and version already checked)
+        bool from_raw(const RawHeader& raw, BloomFileHeader& header) {
+            if (raw.endian_tag != kEndianTag || raw.header_bytes != sizeof(RawHeader) ||
+                raw.layout > static_cast<uint32_t>(BloomFilter::Layout::Blocked) ||
+                raw.hash_scheme > static_cast<uint32_t>(BloomFilter::HashScheme::WyHash) ||
+                raw.num_words != (raw.num_bits + 63) / 64 ||
+                raw.data_offset < sizeof(RawHeader) || raw.data_offset % kDataAlignment != 0) {
+                return false;
+            }
+            header.layout = static_cast<BloomFilter::Layout>(raw.layout);
+            header.hash_scheme = static_cast<BloomFilter::HashScheme>(raw.hash_scheme);
+            header.num_bits = raw.num_bits;
+            header.num_hashes = raw.num_hashes;
+            header.num_insertions = raw.num_insertions;
+            header.num_queries = raw.num_queries;
+            header.checksum = raw.checksum;
+            return true;
+        }
+
+        // A filter has bits, and a blocked one whole blocks
+        bool blocks_consistent(const BloomFileHeader& header) {
+            return header.num_bits > 0 && (header.layout != BloomFilter::Layout::Blocked ||
+                                           header.num_bits % BloomFilter::kBlockBits == 0);
+        }
+    }
+
+    // ============================================================================
+    // Stream Header
+    // ============================================================================
+    void write_bloom_header(std::ostream& out, const BloomFileHeader& header) {
+        char page[kDataAlignment] = {};
+        RawHeader raw = to_raw(header);
+        std::memcpy(page, &raw, sizeof(raw));
+        out.write(page, sizeof(page));
+    }
+
+    bool read_bloom_header(std::istream& in, BloomFileHeader& header) {
+        const std::streampos start = in.tellg();  // Offsets are relative to the header
+        RawHeader raw{};
+        in.read(reinterpret_cast<char*>(&raw.magic), sizeof(raw.magic));
+        if (!in) return false;
+
+        if (raw.magic == kFileMagic) {
+            in.read(reinterpret_cast<char*>(&raw) + sizeof(raw.magic), sizeof(raw) - sizeof(raw.magic));
+            if (!in || raw.version != kFileVersion || !from_raw(raw, header) || !blocks_consistent(header)) {
+                return false;
+            }
+            in.seekg(start + static_cast<std::streamoff>(raw.data_offset));
+            return static_cast<bool>(in);
+        }
+
+        // Headerless: the four counters, then the words
+        in.seekg(start);
+        in.read(reinterpret_cast<char*>(&header.num_bits), sizeof(header.num_bits));
+        in.read(reinterpret_cast<char*>(&header.num_hashes), sizeof(header.num_hashes));
+        in.read(reinterpret_cast<char*>(&header.num_insertions), sizeof(header.num_insertions));
+        in.read(reinterpret_cast<char*>(&header.num_queries), sizeof(header.num_queries));
+        if (!in) return false;
+
+        header.layout = BloomFilter::Layout::Standard;
+        header.hash_scheme = BloomFilter::HashScheme::Seeded;
+        header.checksum = 0;
+        return blocks_consistent(header);
+    }
+
+    // ============================================================================
+    // Checksum
+    // ============================================================================
+    uint64_t chunk_digest(const uint64_t* words, size_t num_words, size_t chunk_index) {
+        uint64_t hash[2];
+        MurmurHash3_x64_128(words, static_cast<int>(num_words * sizeof(uint64_t)),
+                            static_cast<uint32_t>(chunk_index), hash);
+        return hash[0];
+    }
+
+    uint64_t combine_digests(const uint64_t* digests, size_t num_digests) {
+        uint64_t hash[2];
+        MurmurHash3_x64_128(digests, static_cast<int>(num_digests * sizeof(uint64_t)), 0, hash);
+        // 0 is reserved for "no checksum recorded"
+        return hash[0] == 0 ? 1 : hash[0];
+    }
+
+    uint64_t bloom_checksum(const uint64_t* words, size_t num_words, size_t num_threads) {
+        size_t num_chunks = (num_words + kChecksumChunkWords - 1) / kChecksumChunkWords;
+        std::vector<uint64_t> digests(num_chunks);
+
+        size_t threads = ThreadPool::resolve_threads(num_threads, num_chunks, 1);
+        ThreadPool::shared().parallel_for(num_chunks, threads, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; ++c) {
+                size_t first = c * kChecksumChunkWords;
+                size_t n = std::min(kChecksumChunkWords, num_words - first);
+                digests[c] = chunk_digest(words + first, n, c);
+            }
+        });
+        return combine_digests(digests.data(), digests.size());
+    }
+
+    // ============================================================================
+    // Memory Mapping
+    // ============================================================================
+#if !defined(_WIN32)
+    std::optional<FileMapping> map_file(const std::string& filepath, BloomFilter::MapMode mode) {
+        bool shared = mode == BloomFilter::MapMode::Shared;
+        int fd = ::open(filepath.c_str(), shared ? O_RDWR : O_RDONLY);
+        if (fd < 0) return std::nullopt;
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return std::nullopt;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+
+        int prot = mode == BloomFilter::MapMode::ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+        int flags = mode == BloomFilter::MapMode::CopyOnWrite ? MAP_PRIVATE : MAP_SHARED;
+        void* base = ::mmap(nullptr, size, prot, flags, fd, 0);
+        ::close(fd);  // The mapping keeps the file alive
+        if (base == MAP_FAILED) return std::nullopt;
+        return FileMapping{base, size};
+    }
+
+    void advise_random(void* addr, size_t len) {
+        ::madvise(addr, len, MADV_RANDOM);
+    }
+
+    std::optional<MappedBloomFile> map_bloom_file(const std::string& filepath,
+                                                  BloomFilter::MapMode mode) {
+        auto mapping = map_file(filepath, mode);
+        if (!mapping) return std::nullopt;
+        void* base = mapping->base;
+        size_t size = mapping->size;
+
+        RawHeader raw{};
+        if (size >= sizeof(raw)) std::memcpy(&raw, base, sizeof(raw));
+        MappedBloomFile file{base, size, {}, nullptr};
+        if (raw.magic != kFileMagic || raw.version != kFileVersion ||
+            !from_raw(raw, file.header) || !blocks_consistent(file.header) ||
+            raw.data_offset + raw.num_words * sizeof(uint64_t) > size) {
+            ::munmap(base, size);
+            return std::nullopt;
+        }
+
+        file.words = reinterpret_cast<uint64_t*>(static_cast<char*>(base) + raw.data_offset);
+        // Probes are random; read-ahead would only pull in unrelated pages
+        advise_random(file.words, raw.num_words * sizeof(uint64_t));
+        return file;
+    }
+
+    void unmap_bloom_file(void* base, size_t size) {
+        ::munmap(base, size);
+    }
+
+    bool sync_bloom_file(void* base, size_t size, const BloomFileHeader& header) {
+        RawHeader raw = to_raw(header);
+        std::memcpy(base, &raw, sizeof(raw));
+        return ::msync(base, size, MS_SYNC) == 0;
+    }
+#else
+    std::optional<FileMapping> map_file(const std::string&, BloomFilter::MapMode) {
+        return std::nullopt;
+    }
+
+    void advise_random(void*, size_t) {}
+
+    std::optional<MappedBloomFile> map_bloom_file(const std::string&, BloomFilter::MapMode) {
+        return std::nullopt;
+    }
+
+    void unmap_bloom_file(void*, size_t) {}
+
+    bool sync_bloom_file(void*, size_t, const BloomFileHeader&) {
+        return false;
+    }
+#endif
+}
@@ -0,0 +1,85 @@
+// bloom_file.hpp
+//
+// On-disk format shared by the Bloom filter variants, so every variant
+// reads and writes the same files.
+//
+// Layout (all fields native-endian, checked via endian_tag):
+//   [0, 80)              RawHeader
+//   [80, data_offset)    zero padding; data_offset is a multiple of 4096
+//   [data_offset, ...)   bit array as num_words 64-bit words
+// The page-aligned bit array lets open_mapped() use the file in place.
+// Headerless files, which predate the header, are still read through the
+// stream path.
+
+#ifndef BLOOM_FILE_HPP
+#define BLOOM_FILE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+
+#include "bloom_filter.hpp"
+
+namespace quantamental::detail {
+
+constexpr size_t kDataAlignment = 4096;
+
+// Words per checksum chunk (1 MiB). Chunks are hashed independently so the
+// checksum can be computed in parallel or while streaming the words out.
+constexpr size_t kChecksumChunkWords = 131072;
+
+struct BloomFileHeader {
+    BloomFilter::Layout layout;
+    BloomFilter::HashScheme hash_scheme;
+    uint64_t num_bits;
+    uint32_t num_hashes;
+    uint64_t num_insertions;
+    uint64_t num_queries;
+    uint64_t checksum = 0;      // 0 when the file records none (headerless)
+};
+
+// Writes a current-version header and pads the stream to the bit array
+void write_bloom_header(std::ostream& out, const BloomFileHeader& header);
+
+// Accepts the current version and headerless files and leaves the stream at
+// the first word of the bit array. The header may start anywhere in the
+// stream (e.g. embedded in a larger file); offsets are taken from where it
+// starts. Returns false on a truncated or inconsistent header.
+bool read_bloom_header(std::istream& in, BloomFileHeader& header);
+
+// Checksum of a bit array; chunk digests are computed on num_threads threads
+uint64_t chunk_digest(const uint64_t* words, size_t num_words, size_t chunk_index);
+uint64_t combine_digests(const uint64_t* digests, size_t num_digests);
+uint64_t bloom_checksum(const uint64_t* words, size_t num_words, size_t num_threads);
+
+// Whole-file mapping of any saved filter; empty files are not mapped.
+// advise_random() tells the kernel not to read ahead around probes.
+struct FileMapping {
+    void* base;
+    size_t size;
+};
+
+std::optional<FileMapping> map_file(const std::string& filepath, BloomFilter::MapMode mode);
+void advise_random(void* addr, size_t len);
+
+// Whole-file mapping for BloomFilter::open_mapped. The file must have the
+// current header; words points at the page-aligned bit array inside the mapping.
+struct MappedBloomFile {
+    void* base;
+    size_t size;
+    BloomFileHeader header;
+    uint64_t* words;
+};
+
+std::optional<MappedBloomFile> map_bloom_file(const std::string& filepath, BloomFilter::MapMode mode);
+void unmap_bloom_file(void* base, size_t size);
+
+// Writes counters and checksum into a mapped header and syncs it to disk
+bool sync_bloom_file(void* base, size_t size, const BloomFileHeader& header);
+
+} // namespace quantamental::detail
+
+#endif // BLOOM_FILE_HPP
@@ -1,11 +1,33 @@
 #include "bloom_filter.hpp"
 #include "murmur_hash3.hpp"
+#include "bloom_probe.hpp"
+#include "bloom_file.hpp"
+#include "bit_words.hpp"
+#include "thread_pool.hpp"
 #include <cmath>
 #include <fstream>
 #include <algorithm>
 #include <bit>
+#include <new>
+#include <atomic>
 
 namespace quantamental {
+    namespace {
+        constexpr size_t kWordAlignment = 64;
+        constexpr size_t kMinKeysPerThread = 16384;   // Below this threads cost more than they save
+        constexpr size_t kMinWordsPerThread = 65536;  // 512 KiB of each array per merge thread
+
+        // Probe masks hold a few bits each, and without -mpopcnt std::popcount
+        // is a library call, so clear them one at a time
+        uint32_t count_sparse_bits(uint64_t mask) {
+            uint32_t count = 0;
+            for (; mask != 0; mask &= mask - 1) {
+                ++count;
+            }
+            return count;
+        }
+    }
+
     // ============================================================================
     // Static Utilities
     // ============================================================================
@@ -21,31 +43,128 @@ namespace quantamental {
         return static_cast<uint32_t>(std::round(static_cast<double>(m) / n * std::log(2.0)));
     }
 
+    double BloomFilter::false_positive_rate(size_t m, size_t n, uint32_t k, Layout layout) {
+        if (n == 0) return 0.0;
+
+        if (layout == Layout::Blocked) {
+            return blocked_false_positive_rate(m, n, k);
+        }
+
+        // Formula: (1 - e^(-k*n/m))^k
+        double exponent = -static_cast<double>(k) * static_cast<double>(n) / m;
+        return std::pow(1.0 - std::exp(exponent), k);
+    }
+
+    double BloomFilter::estimate_insertions(size_t m, uint64_t bits_set, uint32_t k) {
+        if (m == 0 || k == 0) return 0.0;
+
+        // Formula: n = -(m/k) * ln(1 - X/m) (Swamidass & Baldi, 2007); a full
+        // array is read as one bit short of full
+        double fill = std::min(static_cast<double>(bits_set), static_cast<double>(m) - 1.0) / m;
+        return -static_cast<double>(m) / k * std::log1p(-fill);
+    }
+
+    double BloomFilter::blocked_false_positive_rate(size_t m, size_t n, uint32_t k) {
+        if (n == 0) return 0.0;
+
+        // Keys per block are Poisson(lambda); a block holding i keys behaves like
+        // a standard 512-bit filter with i insertions (Putze et al., 2007).
+        const double num_blocks = static_cast<double>(std::max<size_t>(m / kBlockBits, 1));
+        const double lambda = static_cast<double>(n) / num_blocks;
+        const double bits = static_cast<double>(kBlockBits);
+        const size_t max_i = static_cast<size_t>(lambda + 10.0 * std::sqrt(lambda) + 10.0);
+
+        double fpr = 0.0;
+        for (size_t i = 0; i <= max_i; ++i) {
+            double log_pmf = -lambda + i * std::log(lambda) - std::lgamma(i + 1.0);
+            double inner = std::pow(1.0 - std::pow(1.0 - 1.0 / bits, static_cast<double>(i) * k), k);
+            fpr += std::exp(log_pmf) * inner;
+        }
+        return fpr;
+    }
+
+    size_t BloomFilter::optimal_num_bits_blocked(size_t n, double p) {
+        // Start from the standard size and search upward in whole blocks
+        auto fpr_for = [n](size_t blocks) {
+            size_t m = blocks * kBlockBits;
+            return blocked_false_positive_rate(m, n, optimal_num_hashes(m, n));
+        };
+
+        size_t lo = std::max<size_t>((optimal_num_bits(n, p) + kBlockBits - 1) / kBlockBits, 1);
+        if (fpr_for(lo) <= p) return lo * kBlockBits;
+
+        size_t hi = lo * 2;
+        while (fpr_for(hi) > p) {
+            lo = hi;
+            hi *= 2;
+        }
+        while (hi - lo > 1) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (fpr_for(mid) <= p) hi = mid;
+            else lo = mid;
+        }
+        return hi * kBlockBits;
+    }
+
     // ============================================================================
     // Constructors
     // ============================================================================
-    BloomFilter::BloomFilter(size_t expected_elements, double false_positive_rate) 
-        : num_insertions_(0), num_queries_(0) {
-        num_bits_ = optimal_num_bits(expected_elements, false_positive_rate);
+    BloomFilter::BloomFilter(size_t expected_elements, double false_positive_rate,
+                             Layout layout, HashScheme hash_scheme)
+        : layout_(layout), hash_scheme_(hash_scheme),
+          num_insertions_(0), num_queries_(0), bits_set_(0), bits_set_known_(true),
+          metrics_(std::make_unique<FilterMetrics>()), stored_checksum_(0) {
+        if (layout_ == Layout::Blocked) {
+            num_bits_ = optimal_num_bits_blocked(expected_elements, false_positive_rate);
+        } else {
+            num_bits_ = optimal_num_bits(expected_elements, false_positive_rate);
+        }
         num_hashes_ = optimal_num_hashes(num_bits_, expected_elements);
-        num_words_ = (num_bits_ + 63) / 64; // Ceiling division
-
-        bit_array_ = std::make_unique<uint64_t[]>(num_words_);
-        std::fill_n(bit_array_.get(), num_words_, 0);
+        allocate_bits();
     }
 
-    BloomFilter::BloomFilter(size_t num_bits, uint32_t num_hashes) 
-        : num_bits_(num_bits), num_hashes_(num_hashes),
-          num_insertions_(0), num_queries_(0) {
-        
-        num_words_ = (num_bits_ + 63) / 64;
-        bit_array_ = std::make_unique<uint64_t[]>(num_words_);
-        std::fill_n(bit_array_.get(), num_words_, 0);
+    BloomFilter::BloomFilter(size_t num_bits, uint32_t num_hashes, Layout layout,
+                             HashScheme hash_scheme)
+        : num_bits_(num_bits), num_hashes_(num_hashes), layout_(layout),
+          hash_scheme_(hash_scheme),
+          num_insertions_(0), num_queries_(0), bits_set_(0), bits_set_known_(true),
+          metrics_(std::make_unique<FilterMetrics>()), stored_checksum_(0) {
+        allocate_bits();
     }
 
+    BloomFilter::BloomFilter(const detail::BloomFileHeader& header)
+        : num_bits_(header.num_bits), num_words_((header.num_bits + 63) / 64),
+          num_hashes_(header.num_hashes), layout_(header.layout),
+          hash_scheme_(header.hash_scheme), num_insertions_(header.num_insertions),
+          num_queries_(header.num_queries), bits_set_(0), bits_set_known_(false),
+          metrics_(std::make_unique<FilterMetrics>()), stored_checksum_(header.checksum) {}
+
     // ============================================================================
     // Private Helpers
     // ============================================================================
+    void BloomFilter::WordArrayDeleter::operator()(uint64_t* words) const {
+        if (mapping != nullptr) {
+            detail::unmap_bloom_file(mapping, mapping_size);
+        } else {
+            ::operator delete[](words, std::align_val_t(kWordAlignment));
+        }
+    }
+
+    void BloomFilter::allocate_bits() {
+        if (layout_ == Layout::Blocked) {
+            // Whole blocks only, so every block is one aligned cache line
+            num_bits_ = std::max<size_t>((num_bits_ + kBlockBits - 1) / kBlockBits, 1) * kBlockBits;
+        } else {
+            num_bits_ = std::max<size_t>(num_bits_, 1);   // Probes reduce modulo num_bits
+        }
+        num_words_ = (num_bits_ + 63) / 64; // Ceiling division
+
+        // Over-aligned so a block never straddles two cache lines
+        void* raw = ::operator new[](num_words_ * sizeof(uint64_t), std::align_val_t(kWordAlignment));
+        bit_array_.reset(static_cast<uint64_t*>(raw));
+        std::fill_n(bit_array_.get(), num_words_, 0);
+    }
+
     void BloomFilter::set_bit(size_t index) {
         size_t word_index = index / 64;
         size_t bit_index = index % 64;
@@ -59,93 +178,459 @@ namespace quantamental {
     }
 
     uint64_t BloomFilter::count_set_bits() const {
-        uint64_t count = 0;
-        for (size_t i = 0; i < num_words_; ++i) {
-            count += std::popcount(bit_array_[i]);
+        return detail::popcount_words(bit_array_.get(), num_words_);
+    }
 
+    uint64_t BloomFilter::bits_set() const {
+        // Loaded arrays are counted once. ReadOnly and Shared mappings see
+        // other processes' writes, so they are counted on every call.
+        bool shared_file = map_mode_.has_value() && map_mode_ != MapMode::CopyOnWrite;
+        if (!bits_set_known_ || shared_file) {
+            bits_set_ = count_set_bits();
+            bits_set_known_ = true;
         }
-        return count;
+        return bits_set_;
+    }
+
+    void BloomFilter::add_inserted(const InsertCount& count) {
+        bits_set_ += count.new_bits;
+    }
+
+    size_t BloomFilter::seeded_index(std::string_view key, uint32_t i) const {
+        uint64_t hash[2];
+        MurmurHash3_x64_128(key.data(), static_cast<int>(key.size()), i, hash);
+        return hash[0] % num_bits_;
+    }
+
+    uint32_t BloomFilter::set_key(std::string_view key) {
+        if (hash_scheme_ == HashScheme::Seeded) {
+            uint32_t new_bits = 0;
+            for (uint32_t i = 0; i < num_hashes_; ++i) {
+                size_t index = seeded_index(key, i);
+                if (!test_bit(index)) {
+                    ++new_bits;
+                    set_bit(index);
+                }
+            }
+            return new_bits;
+        }
+
+        detail::KeyHash hash = detail::hash_key(hash_scheme_, key.data(), key.size());
+        if (layout_ == Layout::Blocked) {
+            return set_block(detail::block_probe(hash, num_bits_ / kBlockBits, num_hashes_));
+        }
+        return set_probes(detail::probe_sequence(hash, num_bits_));
+    }
+
+    bool BloomFilter::test_key(std::string_view key) const {
+        if (hash_scheme_ == HashScheme::Seeded) {
+            for (uint32_t i = 0; i < num_hashes_; ++i) {
+                if (!test_bit(seeded_index(key, i))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        detail::KeyHash hash = detail::hash_key(hash_scheme_, key.data(), key.size());
+        if (layout_ == Layout::Blocked) {
+            return test_block(detail::block_probe(hash, num_bits_ / kBlockBits, num_hashes_));
+        }
+        return test_probes(detail::probe_sequence(hash, num_bits_));
     }
 
-    std::vector<size_t> BloomFilter::compute_hashes(const void* data, size_t len) const {
-        std::vector<size_t> hashes;
-        hashes.reserve(num_hashes_);
+    uint32_t BloomFilter::set_probes(detail::ProbeSequence probes) {
+        uint32_t new_bits = 0;
+        for (uint32_t i = 0; i < num_hashes_; ++i) {
+            size_t index = probes.next();
+            uint64_t& word = bit_array_[index / 64];
+            uint64_t bit = 1ULL << (index % 64);
+            new_bits += (word & bit) == 0;
+            word |= bit;
+        }
+        return new_bits;
+    }
 
+    bool BloomFilter::test_probes(detail::ProbeSequence probes) const {
         for (uint32_t i = 0; i < num_hashes_; ++i) {
-            uint64_t hash[2];
-            MurmurHash3_x64_128(data, len, i, hash);
-            hashes.push_back(hash[0] % num_bits_);
+            if (!test_bit(probes.next())) {
+                return false;
+            }
         }
-        return hashes;
+        return true;
+    }
+
+    uint32_t BloomFilter::set_block(const detail::BlockProbe& probe) {
+        uint64_t* block = bit_array_.get() + probe.word;
+        uint32_t new_bits = 0;
+        for (size_t w = 0; w < kBlockWords; ++w) {
+            new_bits += count_sparse_bits(probe.masks[w] & ~block[w]);
+            block[w] |= probe.masks[w];
+        }
+        return new_bits;
+    }
+
+    bool BloomFilter::test_block(const detail::BlockProbe& probe) const {
+        const uint64_t* block = bit_array_.get() + probe.word;
+        uint64_t missing = 0;
+        for (size_t w = 0; w < kBlockWords; ++w) {
+            missing |= probe.masks[w] & ~block[w];
+        }
+        return missing == 0;
     }
 
-    
     // ============================================================================
     // Core Operations
     // ============================================================================
     void BloomFilter::insert(std::string_view key) {
-        auto hashes = compute_hashes(key.data(), key.size());
-        for (size_t hash : hashes) {
-            set_bit(hash);
-        }
+        FilterMetrics::ScopedTimer timer(*metrics_, FilterMetrics::Op::Single);
+        uint32_t new_bits = set_key(key);
+        bits_set_ += new_bits;
         ++num_insertions_;
+        metrics_->count_inserts(1, new_bits != 0);
     }
 
     bool BloomFilter::possibly_contains(std::string_view key) const {
-        auto hashes = compute_hashes(key.data(), key.size());
-        for (size_t hash : hashes) {
-            if (!test_bit(hash)) {
-                return false;
-            }
+        FilterMetrics::ScopedTimer timer(*metrics_, FilterMetrics::Op::Single);
+        bool found = test_key(key);
+        metrics_->count_queries(1, found);
+        if (!found) {
+            return false;
         }
         ++num_queries_;
         return true;
     }
 
     bool BloomFilter::insert_and_check(std::string_view key) {
-        auto hashes = compute_hashes(key.data(), key.size());
-        bool is_new = false;
-
-        for (size_t hash : hashes) {
-            if (!test_bit(hash)) {
-                is_new = true;
-                set_bit(hash);
-            }
-        }
-
+        FilterMetrics::ScopedTimer timer(*metrics_, FilterMetrics::Op::Single);
+        uint32_t new_bits = set_key(key);
+        bool is_new = new_bits != 0;
         if (is_new) {
+            bits_set_ += new_bits;
             ++num_insertions_;
         }
+        metrics_->count_inserts(1, is_new);
         return is_new;
     }
 
     // ============================================================================
     // Batch Operations
     // ============================================================================
-    void BloomFilter::insert_batch(const std::vector<std::string>& keys) {
-        for (const auto& key : keys) {
-            insert(key);
+    // Keys are processed kBatchBlock at a time in three stages: hash the whole
+    // block (several equal-length keys per SIMD call) and derive the probes,
+    // prefetch every target word, then probe. The
+    // misses of a whole block overlap instead of being paid one key at a time.
+    // Shared ranges run on several threads at once and set bits with atomic
+    // fetch-or; the filter itself is still single-owner between calls.
+
+    template <bool Shared, typename KeyAt>
+    BloomFilter::InsertCount BloomFilter::insert_range(size_t begin, size_t end, KeyAt&& key_at,
+                                                       bool* is_new) {
+        InsertCount count;
+        if (hash_scheme_ == HashScheme::Seeded) {
+            for (size_t i = begin; i < end; ++i) {
+                uint32_t new_bits = set_key(key_at(i));
+                count.new_bits += new_bits;
+                count.new_keys += new_bits != 0;
+                if (is_new) is_new[i] = new_bits != 0;
+            }
+            return count;
+        }
+
+        constexpr size_t kBlock = detail::kBatchBlock;
+        // Standard filters never reduce by blocks and may hold less than one
+        const detail::Modulus num_blocks(layout_ == Layout::Blocked ? num_bits_ / kBlockBits : 1);
+        const detail::ProbeReducer reducer(num_bits_);
+        for (size_t base = begin; base < end; base += kBlock) {
+            size_t n = std::min(kBlock, end - base);
+
+            std::string_view keys[kBlock];
+            detail::KeyHash hashes[kBlock];
+            for (size_t i = 0; i < n; ++i) {
+                keys[i] = key_at(base + i);
+            }
+            detail::hash_block(hash_scheme_, keys, n, hashes);
+
+            if (layout_ == Layout::Blocked) {
+                detail::BlockProbe probes[kBlock];
+                for (size_t i = 0; i < n; ++i) {
+                    probes[i] = detail::block_probe(hashes[i], num_blocks, num_hashes_);
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    BLOOM_PREFETCH_WRITE(bit_array_.get() + probes[i].word);
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    uint32_t new_bits = 0;
+                    if constexpr (Shared) {
+                        for (size_t w = 0; w < kBlockWords; ++w) {
+                            uint64_t mask = probes[i].masks[w];
+                            if (mask != 0) {
+                                uint64_t old = std::atomic_ref<uint64_t>(bit_array_[probes[i].word + w])
+                                    .fetch_or(mask, std::memory_order_relaxed);
+                                new_bits += count_sparse_bits(mask & ~old);
+                            }
+                        }
+                    } else {
+                        new_bits = set_block(probes[i]);
+                    }
+                    count.new_bits += new_bits;
+                    count.new_keys += new_bits != 0;
+                    if (is_new) is_new[base + i] = new_bits != 0;
+                }
+            } else {
+                detail::ProbeSequence probes[kBlock];
+                for (size_t i = 0; i < n; ++i) {
+                    probes[i] = detail::probe_sequence(hashes[i], reducer);
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    detail::ProbeSequence seq = probes[i];
+                    for (uint32_t j = 0; j < num_hashes_; ++j) {
+                        BLOOM_PREFETCH_WRITE(bit_array_.get() + seq.next() / 64);
+                    }
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    uint32_t new_bits = 0;
+                    if constexpr (Shared) {
+                        detail::ProbeSequence seq = probes[i];
+                        for (uint32_t j = 0; j < num_hashes_; ++j) {
+                            size_t index = seq.next();
+                            uint64_t bit = 1ULL << (index % 64);
+                            uint64_t old = std::atomic_ref<uint64_t>(bit_array_[index / 64])
+                                .fetch_or(bit, std::memory_order_relaxed);
+                            new_bits += (old & bit) == 0;
+                        }
+                    } else {
+                        new_bits = set_probes(probes[i]);
+                    }
+                    count.new_bits += new_bits;
+                    count.new_keys += new_bits != 0;
+                    if (is_new) is_new[base + i] = new_bits != 0;
+                }
+            }
+        }
+        return count;
+    }
+
+    template <typename KeyAt>
+    size_t BloomFilter::filter_range(size_t begin, size_t end, KeyAt&& key_at, bool* is_new) const {
+        size_t num_seen = 0;
+        if (hash_scheme_ == HashScheme::Seeded) {
+            for (size_t i = begin; i < end; ++i) {
+                is_new[i] = !test_key(key_at(i));
+                num_seen += !is_new[i];
+            }
+            return num_seen;
+        }
+
+        constexpr size_t kBlock = detail::kBatchBlock;
+        // Standard filters never reduce by blocks and may hold less than one
+        const detail::Modulus num_blocks(layout_ == Layout::Blocked ? num_bits_ / kBlockBits : 1);
+        const detail::ProbeReducer reducer(num_bits_);
+        for (size_t base = begin; base < end; base += kBlock) {
+            size_t n = std::min(kBlock, end - base);
+
+            std::string_view keys[kBlock];
+            detail::KeyHash hashes[kBlock];
+            for (size_t i = 0; i < n; ++i) {
+                keys[i] = key_at(base + i);
+            }
+            detail::hash_block(hash_scheme_, keys, n, hashes);
+
+            if (layout_ == Layout::Blocked) {
+                detail::BlockProbe probes[kBlock];
+                for (size_t i = 0; i < n; ++i) {
+                    probes[i] = detail::block_probe(hashes[i], num_blocks, num_hashes_);
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    BLOOM_PREFETCH_READ(bit_array_.get() + probes[i].word);
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    is_new[base + i] = !test_block(probes[i]);
+                }
+            } else {
+                detail::ProbeSequence probes[kBlock];
+                for (size_t i = 0; i < n; ++i) {
+                    probes[i] = detail::probe_sequence(hashes[i], reducer);
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    detail::ProbeSequence seq = probes[i];
+                    for (uint32_t j = 0; j < num_hashes_; ++j) {
+                        BLOOM_PREFETCH_READ(bit_array_.get() + seq.next() / 64);
+                    }
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    is_new[base + i] = !test_probes(probes[i]);
+                }
+            }
+
+            for (size_t i = 0; i < n; ++i) {
+                num_seen += !is_new[base + i];
+            }
         }
+        return num_seen;
+    }
+
+    void BloomFilter::insert_batch(const std::vector<std::string>& keys) {
+        FilterMetrics::ScopedTimer timer(*metrics_, FilterMetrics::Op::Batch);
+        InsertCount count = insert_range<false>(0, keys.size(), [&keys](size_t i) {
+            return std::string_view(keys[i]);
+        });
+        add_inserted(count);
+        num_insertions_ += keys.size();
+        metrics_->count_inserts(keys.size(), count.new_keys);
+    }
+
+    void BloomFilter::insert_and_check_batch(const std::string_view* keys, size_t count, bool* is_new) {
+        FilterMetrics::ScopedTimer timer(*metrics_, FilterMetrics::Op::Batch);
+        InsertCount inserted = insert_range<false>(0, count, [keys](size_t i) { return keys[i]; }, is_new);
+        add_inserted(inserted);
+        num_insertions_ += inserted.new_keys;
+        metrics_->count_inserts(count, inserted.new_keys);
     }
 
     std::vector<size_t> BloomFilter::filter_new(const std::vector<std::string>& keys) const {
+        FilterMetrics::ScopedTimer timer(*metrics_, FilterMetrics::Op::Batch);
+        auto is_new = std::make_unique<bool[]>(keys.size());
+        size_t num_seen = filter_range(0, keys.size(), [&keys](size_t i) {
+            return std::string_view(keys[i]);
+        }, is_new.get());
+        num_queries_ += num_seen;
+        metrics_->count_queries(keys.size(), num_seen);
+
         std::vector<size_t> new_indices;
         for (size_t i = 0; i < keys.size(); ++i) {
-            if (!possibly_contains(keys[i])) {
+            if (is_new[i]) {
                 new_indices.push_back(i);
             }
         }
         return new_indices;
     }
 
+    void BloomFilter::insert_batch(const KeyBuffer& keys, size_t num_threads) {
+        FilterMetrics::ScopedTimer timer(*metrics_, FilterMetrics::Op::Batch);
+        auto key_at = [&keys](size_t i) { return keys[i]; };
+        size_t threads = hash_scheme_ == HashScheme::Seeded
+            ? 1 : ThreadPool::resolve_threads(num_threads, keys.size(), kMinKeysPerThread);
+
+        InsertCount count;
+        if (threads <= 1) {
+            count = insert_range<false>(0, keys.size(), key_at);
+        } else {
+            std::atomic<uint64_t> new_bits(0), new_keys(0);
+            ThreadPool::shared().parallel_for(keys.size(), threads, [&](size_t begin, size_t end) {
+                InsertCount part = insert_range<true>(begin, end, key_at);
+                new_bits.fetch_add(part.new_bits, std::memory_order_relaxed);
+                new_keys.fetch_add(part.new_keys, std::memory_order_relaxed);
+            });
+            count = {new_bits.load(), new_keys.load()};
+        }
+        add_inserted(count);
+        num_insertions_ += keys.size();
+        metrics_->count_inserts(keys.size(), count.new_keys);
+    }
+
+    void BloomFilter::filter_new_mask(const KeyBuffer& keys, bool* is_new, size_t num_threads) const {
+        FilterMetrics::ScopedTimer timer(*metrics_, FilterMetrics::Op::Batch);
+        auto key_at = [&keys](size_t i) { return keys[i]; };
+        size_t threads = ThreadPool::resolve_threads(num_threads, keys.size(), kMinKeysPerThread);
+
+        uint64_t num_seen = 0;
+        if (threads <= 1) {
+            num_seen = filter_range(0, keys.size(), key_at, is_new);
+        } else {
+            std::atomic<uint64_t> seen(0);
+            ThreadPool::shared().parallel_for(keys.size(), threads, [&](size_t begin, size_t end) {
+                seen.fetch_add(filter_range(begin, end, key_at, is_new), std::memory_order_relaxed);
+            });
+            num_seen = seen.load();
+        }
+        num_queries_ += num_seen;
+        metrics_->count_queries(keys.size(), num_seen);
+    }
+
+    // ============================================================================
+    // Merging
+    // ============================================================================
+
+    bool BloomFilter::compatible_with(const BloomFilter& other) const {
+        return num_bits_ == other.num_bits_ && num_hashes_ == other.num_hashes_ &&
+               layout_ == other.layout_ && hash_scheme_ == other.hash_scheme_;
+    }
+
+    bool BloomFilter::merge(const BloomFilter& other, detail::WordOp op, size_t num_threads) {
+        if (!compatible_with(other) || !writable()) return false;
+
+        size_t threads = ThreadPool::resolve_threads(num_threads, num_words_, kMinWordsPerThread);
+        std::atomic<uint64_t> bits_set(0);
+        ThreadPool::shared().parallel_for(num_words_, threads, [&](size_t begin, size_t end) {
+            bits_set.fetch_add(detail::combine_words(bit_array_.get() + begin,
+                                                     other.bit_array_.get() + begin,
+                                                     end - begin, op),
+                               std::memory_order_relaxed);
+        });
+
+        bits_set_ = bits_set.load();
+        bits_set_known_ = true;
+        num_insertions_ = static_cast<uint64_t>(
+            std::llround(estimate_insertions(num_bits_, bits_set_, num_hashes_)));
+        return true;
+    }
+
+    bool BloomFilter::merge_union(const BloomFilter& other, size_t num_threads) {
+        if (!merge(other, detail::WordOp::Or, num_threads)) return false;
+        num_queries_ += other.num_queries_;
+        return true;
+    }
+
+    bool BloomFilter::merge_intersection(const BloomFilter& other, size_t num_threads) {
+        return merge(other, detail::WordOp::And, num_threads);
+    }
+
+    BloomFilter BloomFilter::build_parallel(const KeyBuffer& keys, size_t expected_elements,
+                                            double false_positive_rate, Layout layout,
+                                            HashScheme hash_scheme, size_t num_threads) {
+        BloomFilter filter(expected_elements, false_positive_rate, layout, hash_scheme);
+        size_t threads = ThreadPool::resolve_threads(num_threads, keys.size(), kMinKeysPerThread);
+        if (threads <= 1) {
+            filter.insert_batch(keys, 1);
+            return filter;
+        }
+
+        // Map: thread 0 fills the result, the others fill private copies
+        auto key_at = [&keys](size_t i) { return keys[i]; };
+        std::vector<std::optional<BloomFilter>> parts(threads);
+        std::atomic<uint64_t> new_keys(0);   // New to each thread's own copy
+        ThreadPool::shared().parallel_for(threads, threads, [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; ++t) {
+                BloomFilter& part = t == 0 ? filter : parts[t].emplace(
+                    filter.num_bits_, filter.num_hashes_, layout, hash_scheme);
+                InsertCount count = part.insert_range<false>(keys.size() * t / threads,
+                                                             keys.size() * (t + 1) / threads, key_at);
+                part.add_inserted(count);
+                new_keys.fetch_add(count.new_keys, std::memory_order_relaxed);
+            }
+        });
+
+        // Reduce, freeing each copy as soon as it is folded in
+        for (size_t t = 1; t < threads; ++t) {
+            filter.merge(*parts[t], detail::WordOp::Or, num_threads);
+            parts[t].reset();
+        }
+        filter.num_insertions_ = keys.size();
+        filter.metrics_->count_inserts(keys.size(), new_keys.load());
+        return filter;
+    }
+
     // ============================================================================
     // Statistics
     // ============================================================================
 
     BloomFilter::BloomFilterStats BloomFilter::get_stats() const {
-        uint64_t bits_set = count_set_bits();
+        uint64_t bits_set = this->bits_set();
         double fill = static_cast<double>(bits_set) / num_bits_;
-        
+        FilterMetrics::Snapshot metrics = metrics_->snapshot();
+        const FilterMetrics::Counters& counters = metrics.counters;
+
         return BloomFilterStats{
             num_insertions_,
             num_queries_,
@@ -153,20 +638,18 @@ namespace quantamental {
             bits_set,
             num_hashes_,
             fill,
-            estimated_false_positive_rate()
+            estimated_false_positive_rate(),
+            metrics,
+            counters.queries == 0 ? 0.0 : static_cast<double>(counters.positives) / counters.queries
         };
     }
 
     double BloomFilter::fill_ratio() const {
-        return static_cast<double>(count_set_bits()) / num_bits_;
+        return static_cast<double>(bits_set()) / num_bits_;
     }
 
     double BloomFilter::estimated_false_positive_rate() const {
-        if (num_insertions_ == 0) return 0.0;
-        
-        // Formula: (1 - e^(-k*n/m))^k
-        double exponent = -static_cast<double>(num_hashes_ * num_insertions_) / num_bits_;
-        return std::pow(1.0 - std::exp(exponent), num_hashes_);
+        return false_positive_rate(num_bits_, num_insertions_, num_hashes_, layout_);
     }
 
     size_t BloomFilter::size_bits() const {
@@ -181,6 +664,30 @@ namespace quantamental {
         return num_insertions_;
     }
 
+    uint32_t BloomFilter::num_hashes() const {
+        return num_hashes_;
+    }
+
+    BloomFilter::Layout BloomFilter::layout() const {
+        return layout_;
+    }
+
+    BloomFilter::HashScheme BloomFilter::hash_scheme() const {
+        return hash_scheme_;
+    }
+
+    // ============================================================================
+    // Instrumentation
+    // ============================================================================
+
+    void BloomFilter::reset_metrics() {
+        metrics_->reset();
+    }
+
+    void BloomFilter::set_latency_sampling(uint32_t sample_every) {
+        metrics_->set_sample_every(sample_every);
+    }
+
     // ============================================================================
     // Persistence
     // ============================================================================
@@ -188,53 +695,90 @@ namespace quantamental {
     bool BloomFilter::save_to_file(const std::string& filepath) const {
         std::ofstream file(filepath, std::ios::binary);
         if (!file) return false;
-        
-        // Write metadata
-        file.write(reinterpret_cast<const char*>(&num_bits_), sizeof(num_bits_));
-        file.write(reinterpret_cast<const char*>(&num_hashes_), sizeof(num_hashes_));
-        file.write(reinterpret_cast<const char*>(&num_insertions_), sizeof(num_insertions_));
-        file.write(reinterpret_cast<const char*>(&num_queries_), sizeof(num_queries_));
-        
-        // Write bit array
-        file.write(reinterpret_cast<const char*>(bit_array_.get()), 
-                num_words_ * sizeof(uint64_t));
-        
-        return file.good();
+        return save_to_stream(file);
     }
 
     std::optional<BloomFilter> BloomFilter::load_from_file(const std::string& filepath) {
         std::ifstream file(filepath, std::ios::binary);
         if (!file) return std::nullopt;
+        return load_from_stream(file);
+    }
+
+    bool BloomFilter::save_to_stream(std::ostream& out) const {
+        detail::BloomFileHeader header{layout_, hash_scheme_, num_bits_, num_hashes_,
+                                       num_insertions_, num_queries_};
+        header.checksum = detail::bloom_checksum(bit_array_.get(), num_words_, 0);
+        detail::write_bloom_header(out, header);
+
+        // Write bit array
+        out.write(reinterpret_cast<const char*>(bit_array_.get()), 
+                num_words_ * sizeof(uint64_t));
         
-        // Read metadata
-        size_t num_bits;
-        uint32_t num_hashes;
-        uint64_t num_insertions, num_queries;
-        
-        file.read(reinterpret_cast<char*>(&num_bits), sizeof(num_bits));
-        file.read(reinterpret_cast<char*>(&num_hashes), sizeof(num_hashes));
-        file.read(reinterpret_cast<char*>(&num_insertions), sizeof(num_insertions));
-        file.read(reinterpret_cast<char*>(&num_queries), sizeof(num_queries));
-        
-        if (!file) return std::nullopt;
-        
+        return out.good();
+    }
+
+    std::optional<BloomFilter> BloomFilter::load_from_stream(std::istream& in) {
+        detail::BloomFileHeader header;
+        if (!detail::read_bloom_header(in, header)) return std::nullopt;
+
         // Create filter
-        BloomFilter filter(num_bits, num_hashes);
-        filter.num_insertions_ = num_insertions;
-        filter.num_queries_ = num_queries;
+        BloomFilter filter(header);
+        filter.allocate_bits();
         
         // Read bit array
-        file.read(reinterpret_cast<char*>(filter.bit_array_.get()), 
+        in.read(reinterpret_cast<char*>(filter.bit_array_.get()), 
                 filter.num_words_ * sizeof(uint64_t));
         
-        if (!file) return std::nullopt;
+        if (!in) return std::nullopt;
+        if (!filter.verify_checksum()) return std::nullopt;
         
         return filter;
     }
 
+    std::optional<BloomFilter> BloomFilter::open_mapped(const std::string& filepath,
+                                                        MapMode mode, bool verify) {
+        auto mapped = detail::map_bloom_file(filepath, mode);
+        if (!mapped) return std::nullopt;
+
+        BloomFilter filter(mapped->header);
+        filter.map_mode_ = mode;
+        filter.bit_array_ = std::unique_ptr<uint64_t[], WordArrayDeleter>(
+            mapped->words, WordArrayDeleter{mapped->base, mapped->size});
+
+        if (verify && !filter.verify_checksum()) return std::nullopt;
+        return filter;
+    }
+
+    bool BloomFilter::flush() {
+        const WordArrayDeleter& mapping = bit_array_.get_deleter();
+        if (map_mode_ != MapMode::Shared) return false;
+
+        detail::BloomFileHeader header{layout_, hash_scheme_, num_bits_, num_hashes_,
+                                       num_insertions_, num_queries_};
+        header.checksum = detail::bloom_checksum(bit_array_.get(), num_words_, 0);
+        if (!detail::sync_bloom_file(mapping.mapping, mapping.mapping_size, header)) return false;
+        stored_checksum_ = header.checksum;
+        return true;
+    }
+
+    bool BloomFilter::verify_checksum(size_t num_threads) const {
+        if (stored_checksum_ == 0) return true;
+        return detail::bloom_checksum(bit_array_.get(), num_words_, num_threads) == stored_checksum_;
+    }
+
+    bool BloomFilter::is_mapped() const {
+        return map_mode_.has_value();
+    }
+
+    bool BloomFilter::writable() const {
+        return map_mode_ != MapMode::ReadOnly;
+    }
+
     void BloomFilter::clear() {
         std::fill_n(bit_array_.get(), num_words_, 0);
         num_insertions_ = 0;
         num_queries_ = 0;
+        bits_set_ = 0;
+        bits_set_known_ = true;
     }
 }
\ No newline at end of file
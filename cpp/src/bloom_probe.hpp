@@ -0,0 +1,251 @@
+// bloom_probe.hpp
+//
+// Probe derivation shared by the Bloom filter variants. Every key is hashed
+// once by a hash policy (MurmurHash3_x64_128 unless the filter's HashScheme
+// picks another); the two 64-bit halves then drive either the
+// Kirsch-Mitzenmacher sequence g_i = h1 + i * h2 (mod m) of the Standard
+// layout, or the block choice and in-block bits of the Blocked layout.
+// Nothing here allocates, so the per-key paths stay off the heap.
+
+#ifndef BLOOM_PROBE_HPP
+#define BLOOM_PROBE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <bit>
+#include <string_view>
+
+#include "bloom_filter.hpp"
+#include "murmur_hash3.hpp"
+#include "wyhash.hpp"
+
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#define BLOOM_PREFETCH_READ(addr) _mm_prefetch(reinterpret_cast<const char*>(addr), _MM_HINT_T0)
+#define BLOOM_PREFETCH_WRITE(addr) _mm_prefetch(reinterpret_cast<const char*>(addr), _MM_HINT_T0)
+#else
+#define BLOOM_PREFETCH_READ(addr) __builtin_prefetch((addr), 0, 3)
+#define BLOOM_PREFETCH_WRITE(addr) __builtin_prefetch((addr), 1, 3)
+#endif
+
+namespace quantamental::detail {
+
+// Keys hashed per pipeline stage; the per-block state lives on the stack
+constexpr size_t kBatchBlock = 32;
+
+struct KeyHash {
+    uint64_t h1;
+    uint64_t h2;
+};
+
+// Hash policies. hash() turns one key into the two halves the probes use;
+// hash_block() does the same for up to kBatchBlock keys of a batch stage.
+
+// MurmurHash3_x64_128 with seed 0 (HashScheme::DoubleHashing). Blocks are
+// grouped by key length so equal-length keys, such as ticker|date keys of
+// one ticker, are hashed several at a time by the SIMD kernel.
+struct Murmur3Hash {
+    static KeyHash hash(const void* data, size_t len) {
+        uint64_t hash[2];
+        MurmurHash3_x64_128(data, static_cast<int>(len), 0, hash);
+        return KeyHash{hash[0], hash[1]};
+    }
+
+    static void hash_block(const std::string_view* keys, size_t n, KeyHash* out) {
+        const void* group[kBatchBlock];
+        uint8_t group_index[kBatchBlock];
+        uint64_t group_hash[2 * kBatchBlock];
+        bool done[kBatchBlock] = {};
+
+        for (size_t i = 0; i < n; ++i) {
+            if (done[i]) continue;
+            const size_t len = keys[i].size();
+            size_t count = 0;
+            for (size_t j = i; j < n; ++j) {
+                if (!done[j] && keys[j].size() == len) {
+                    done[j] = true;
+                    group_index[count] = static_cast<uint8_t>(j);
+                    group[count++] = keys[j].data();
+                }
+            }
+            MurmurHash3_x64_128_multi(group, count, static_cast<int>(len), 0, group_hash);
+            for (size_t c = 0; c < count; ++c) {
+                out[group_index[c]] = KeyHash{group_hash[2 * c], group_hash[2 * c + 1]};
+            }
+        }
+    }
+};
+
+// wyhash (HashScheme::WyHash). The second half re-mixes the first, which
+// costs one more multiply instead of a second pass over the key.
+struct WyHash {
+    static KeyHash hash(const void* data, size_t len) {
+        uint64_t h1 = wy::hash(data, len, 0);
+        return KeyHash{h1, wy::mix(h1 ^ wy::kSecret[2], len ^ wy::kSecret[3])};
+    }
+
+    static void hash_block(const std::string_view* keys, size_t n, KeyHash* out) {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = hash(keys[i].data(), keys[i].size());
+        }
+    }
+};
+
+inline KeyHash hash_key(const void* data, size_t len) {
+    return Murmur3Hash::hash(data, len);
+}
+
+// Dispatch on a filter's scheme. Seeded filters never come through here;
+// they hash once per probe.
+inline KeyHash hash_key(BloomFilter::HashScheme scheme, const void* data, size_t len) {
+    if (scheme == BloomFilter::HashScheme::WyHash) {
+        return WyHash::hash(data, len);
+    }
+    return Murmur3Hash::hash(data, len);
+}
+
+inline void hash_block(BloomFilter::HashScheme scheme, const std::string_view* keys, size_t n,
+                       KeyHash* out) {
+    if (scheme == BloomFilter::HashScheme::WyHash) {
+        WyHash::hash_block(keys, n, out);
+    } else {
+        Murmur3Hash::hash_block(keys, n, out);
+    }
+}
+
+// Exact n % d for a divisor fixed across a batch, without a hardware divide:
+// the round-up reciprocal of libdivide's unsigned 64-bit division turns the
+// quotient into a multiply-high and shifts, and the remainder is n - q * d.
+// Results equal %, so probe positions do not change. Building one costs a
+// 128-bit division, so batch stages make one per call while the single-key
+// paths keep %.
+class Modulus {
+
+public:
+    explicit Modulus(uint64_t divisor) : divisor_(divisor), magic_(0), shift_(0), add_(false) {
+        const uint32_t log2 = 63 - static_cast<uint32_t>(std::countl_zero(divisor));
+        shift_ = log2;
+        if ((divisor & (divisor - 1)) == 0) return;   // Power of two: a plain shift
+#if defined(__SIZEOF_INT128__)
+        const unsigned __int128 numerator = static_cast<unsigned __int128>(1) << (64 + log2);
+        uint64_t magic = static_cast<uint64_t>(numerator / divisor);
+        const uint64_t rem = static_cast<uint64_t>(numerator % divisor);
+        if (divisor - rem >= (1ULL << log2)) {
+            // The reciprocal needs 65 bits; the extra bit is added back in divide()
+            magic += magic;
+            const uint64_t twice_rem = rem + rem;
+            if (twice_rem >= divisor || twice_rem < rem) magic += 1;
+            add_ = true;
+        }
+        magic_ = magic + 1;
+#else
+        shift_ = kHardwareDivide;
+#endif
+    }
+
+    uint64_t operator()(uint64_t n) const {
+        return n - divide(n) * divisor_;
+    }
+
+private:
+    static constexpr uint32_t kHardwareDivide = 64;
+
+    uint64_t divide(uint64_t n) const {
+#if defined(__SIZEOF_INT128__)
+        if (magic_ == 0) return n >> shift_;
+        const uint64_t q = static_cast<uint64_t>((static_cast<unsigned __int128>(magic_) * n) >> 64);
+        if (add_) return (((n - q) >> 1) + q) >> shift_;
+        return q >> shift_;
+#else
+        if (shift_ == kHardwareDivide) return n / divisor_;
+        return n >> shift_;
+#endif
+    }
+
+    uint64_t divisor_;
+    uint64_t magic_;    // 0 for powers of two
+    uint32_t shift_;
+    bool add_;
+};
+
+// Kirsch-Mitzenmacher probe positions over m bits. Both reductions happen
+// once per key, after which each probe is an add and a conditional subtract.
+struct ProbeSequence {
+    size_t index;
+    size_t step;
+    size_t num_bits;
+
+    size_t next() {
+        size_t current = index;
+        index += step;
+        if (index >= num_bits) index -= num_bits;
+        return current;
+    }
+};
+
+inline ProbeSequence probe_sequence(const KeyHash& hash, size_t num_bits) {
+    size_t step = num_bits > 1 ? hash.h2 % (num_bits - 1) + 1 : 0;
+    return ProbeSequence{hash.h1 % num_bits, step, num_bits};
+}
+
+// Both reductions of probe_sequence() precomputed for a batch
+struct ProbeReducer {
+    Modulus bits;
+    Modulus steps;
+    size_t num_bits;
+
+    explicit ProbeReducer(size_t num_bits)
+        : bits(num_bits), steps(num_bits > 1 ? num_bits - 1 : 1), num_bits(num_bits) {}
+};
+
+inline ProbeSequence probe_sequence(const KeyHash& hash, const ProbeReducer& reducer) {
+    size_t step = reducer.num_bits > 1 ? reducer.steps(hash.h2) + 1 : 0;
+    return ProbeSequence{reducer.bits(hash.h1), step, reducer.num_bits};
+}
+
+// Blocked layout: h1 picks the 512-bit block, h2 is consumed 9 bits per probe
+// and re-mixed once exhausted.
+constexpr size_t kBlockBits = 512;
+constexpr size_t kBlockWords = kBlockBits / 64;
+
+struct BlockProbe {
+    size_t word;                    // First word of the block
+    uint64_t masks[kBlockWords];    // Bits to test or set in each block word
+};
+
+inline BlockProbe block_probe_at(size_t block, const KeyHash& hash, uint32_t num_hashes) {
+    BlockProbe probe;
+    probe.word = block * kBlockWords;
+
+    uint64_t seed = hash.h2;
+    uint64_t bits = seed;
+    int remaining = 7;
+
+    std::fill_n(probe.masks, kBlockWords, 0);
+    for (uint32_t i = 0; i < num_hashes; ++i) {
+        if (remaining == 0) {
+            // Re-mix the full seed; the shifted-out bits have 1 bit left
+            seed = (seed ^ (seed >> 31)) * 0x9E3779B97F4A7C15ULL;
+            bits = seed;
+            remaining = 7;
+        }
+        uint32_t bit = static_cast<uint32_t>(bits & (kBlockBits - 1));
+        probe.masks[bit / 64] |= (1ULL << (bit % 64));
+        bits >>= 9;
+        --remaining;
+    }
+    return probe;
+}
+
+inline BlockProbe block_probe(const KeyHash& hash, size_t num_blocks, uint32_t num_hashes) {
+    return block_probe_at(hash.h1 % num_blocks, hash, num_hashes);
+}
+
+inline BlockProbe block_probe(const KeyHash& hash, const Modulus& num_blocks, uint32_t num_hashes) {
+    return block_probe_at(num_blocks(hash.h1), hash, num_hashes);
+}
+
+} // namespace quantamental::detail
+
+#endif // BLOOM_PROBE_HPP
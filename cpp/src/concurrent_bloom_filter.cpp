@@ -0,0 +1,519 @@
+#include "concurrent_bloom_filter.hpp"
+#include "murmur_hash3.hpp"
+#include "bloom_probe.hpp"
+#include "bloom_file.hpp"
+#include "thread_pool.hpp"
+#include <fstream>
+#include <algorithm>
+#include <bit>
+#include <new>
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#endif
+
+namespace quantamental {
+    namespace {
+        constexpr size_t kWordAlignment = 64;
+        constexpr size_t kBlockBits = BloomFilter::kBlockBits;
+        constexpr size_t kBlockWords = BloomFilter::kBlockWords;
+        constexpr size_t kMinKeysPerThread = 16384;
+        constexpr uint32_t kSpinsBeforeYield = 64;   // A key lock is held for one key's probes
+
+        std::atomic<size_t> next_counter_shard{0};
+
+        // Tells the core we are spinning, so a hyperthread sibling (maybe the
+        // lock holder) gets the pipeline
+        void spin_pause() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+    }
+
+    // ============================================================================
+    // Constructors
+    // ============================================================================
+    ConcurrentBloomFilter::ConcurrentBloomFilter(size_t expected_elements,
+                                                 double false_positive_rate, Layout layout)
+        : layout_(layout), hash_scheme_(BloomFilter::HashScheme::DoubleHashing) {
+        if (layout_ == Layout::Blocked) {
+            num_bits_ = BloomFilter::optimal_num_bits_blocked(expected_elements, false_positive_rate);
+        } else {
+            num_bits_ = BloomFilter::optimal_num_bits(expected_elements, false_positive_rate);
+        }
+        num_hashes_ = BloomFilter::optimal_num_hashes(num_bits_, expected_elements);
+        allocate_bits();
+    }
+
+    ConcurrentBloomFilter::ConcurrentBloomFilter(size_t num_bits, uint32_t num_hashes,
+                                                 Layout layout)
+        : num_bits_(num_bits), num_hashes_(num_hashes), layout_(layout),
+          hash_scheme_(BloomFilter::HashScheme::DoubleHashing) {
+        allocate_bits();
+    }
+
+    // ============================================================================
+    // Private Helpers
+    // ============================================================================
+    void ConcurrentBloomFilter::WordArrayDeleter::operator()(uint64_t* words) const {
+        ::operator delete[](words, std::align_val_t(kWordAlignment));
+    }
+
+    void ConcurrentBloomFilter::allocate_bits() {
+        if (layout_ == Layout::Blocked) {
+            num_bits_ = std::max<size_t>((num_bits_ + kBlockBits - 1) / kBlockBits, 1) * kBlockBits;
+        } else {
+            num_bits_ = std::max<size_t>(num_bits_, 1);   // Probes reduce modulo num_bits
+        }
+        num_words_ = (num_bits_ + 63) / 64;
+
+        void* raw = ::operator new[](num_words_ * sizeof(uint64_t), std::align_val_t(kWordAlignment));
+        bit_array_.reset(static_cast<uint64_t*>(raw));
+        std::fill_n(bit_array_.get(), num_words_, 0);
+
+        counters_ = std::make_unique<CounterShard[]>(kCounterShards);
+        key_locks_ = std::make_unique<KeyLock[]>(kKeyLockStripes);
+
+        num_dirty_blocks_ = (num_words_ + kDirtyBlockWords - 1) / kDirtyBlockWords;
+        dirty_blocks_ = std::make_unique<DirtyMarks[]>((num_dirty_blocks_ + 63) / 64);
+    }
+
+    ConcurrentBloomFilter::CounterShard& ConcurrentBloomFilter::local_counters() const {
+        // Threads are dealt shards round-robin on first use
+        thread_local size_t shard = next_counter_shard.fetch_add(1, std::memory_order_relaxed);
+        return counters_[shard % kCounterShards];
+    }
+
+    bool ConcurrentBloomFilter::fetch_or(size_t word, uint64_t mask) {
+        std::atomic_ref<uint64_t> ref(bit_array_[word]);
+        // Skip the locked RMW when every bit is already set (the common case
+        // once a key has been seen)
+        if ((ref.load(std::memory_order_relaxed) & mask) == mask) return false;
+        return (ref.fetch_or(mask, std::memory_order_seq_cst) & mask) != mask;
+    }
+
+    bool ConcurrentBloomFilter::set_word(size_t word, uint64_t mask) {
+        if (!fetch_or(word, mask)) return false;
+        mark_dirty(word);
+        return true;
+    }
+
+    // The new bit and the mark check are seq_cst, and take_dirty_blocks()
+    // clears marks with seq_cst exchanges and a fence before the blocks are
+    // read: either this sees the mark already cleared and sets it again, or
+    // the checkpointer's copy of the block has the bit. The locked RMW only
+    // runs the first time a block changes after a checkpoint; after that the
+    // mark's line is only read, so it stays shared in every core's cache.
+    void ConcurrentBloomFilter::mark_dirty(size_t word) {
+        size_t block = word / kDirtyBlockWords;
+        std::atomic<uint64_t>& marks = dirty_blocks_[block / 64].bits;
+        uint64_t bit = 1ULL << (block % 64);
+        if ((marks.load(std::memory_order_seq_cst) & bit) == 0) {
+            marks.fetch_or(bit, std::memory_order_seq_cst);
+        }
+    }
+
+    uint64_t ConcurrentBloomFilter::load_word(size_t word) const {
+        return std::atomic_ref<uint64_t>(bit_array_[word]).load(std::memory_order_relaxed);
+    }
+
+    bool ConcurrentBloomFilter::set_key(std::string_view key) {
+        bool is_new = false;
+
+        if (hash_scheme_ == BloomFilter::HashScheme::Seeded) {
+            for (uint32_t i = 0; i < num_hashes_; ++i) {
+                uint64_t hash[2];
+                MurmurHash3_x64_128(key.data(), static_cast<int>(key.size()), i, hash);
+                size_t index = hash[0] % num_bits_;
+                is_new |= set_word(index / 64, 1ULL << (index % 64));
+            }
+            return is_new;
+        }
+
+        return set_hash(detail::hash_key(hash_scheme_, key.data(), key.size()));
+    }
+
+    bool ConcurrentBloomFilter::set_hash(const detail::KeyHash& hash) {
+        bool is_new = false;
+        if (layout_ == Layout::Blocked) {
+            // The block is one dirty-tracking block, so it is marked once
+            detail::BlockProbe probe = detail::block_probe(hash, num_bits_ / kBlockBits, num_hashes_);
+            for (size_t w = 0; w < kBlockWords; ++w) {
+                if (probe.masks[w] != 0) {
+                    is_new |= fetch_or(probe.word + w, probe.masks[w]);
+                }
+            }
+            if (is_new) mark_dirty(probe.word);
+            return is_new;
+        }
+
+        detail::ProbeSequence probes = detail::probe_sequence(hash, num_bits_);
+        for (uint32_t i = 0; i < num_hashes_; ++i) {
+            size_t index = probes.next();
+            is_new |= set_word(index / 64, 1ULL << (index % 64));
+        }
+        return is_new;
+    }
+
+    bool ConcurrentBloomFilter::test_key(std::string_view key) const {
+        if (hash_scheme_ == BloomFilter::HashScheme::Seeded) {
+            for (uint32_t i = 0; i < num_hashes_; ++i) {
+                uint64_t hash[2];
+                MurmurHash3_x64_128(key.data(), static_cast<int>(key.size()), i, hash);
+                size_t index = hash[0] % num_bits_;
+                if ((load_word(index / 64) & (1ULL << (index % 64))) == 0) return false;
+            }
+            return true;
+        }
+
+        detail::KeyHash hash = detail::hash_key(hash_scheme_, key.data(), key.size());
+        if (layout_ == Layout::Blocked) {
+            detail::BlockProbe probe = detail::block_probe(hash, num_bits_ / kBlockBits, num_hashes_);
+            uint64_t missing = 0;
+            for (size_t w = 0; w < kBlockWords; ++w) {
+                missing |= probe.masks[w] & ~load_word(probe.word + w);
+            }
+            return missing == 0;
+        }
+
+        detail::ProbeSequence probes = detail::probe_sequence(hash, num_bits_);
+        for (uint32_t i = 0; i < num_hashes_; ++i) {
+            size_t index = probes.next();
+            if ((load_word(index / 64) & (1ULL << (index % 64))) == 0) return false;
+        }
+        return true;
+    }
+
+    uint64_t ConcurrentBloomFilter::count_set_bits() const {
+        uint64_t count = 0;
+        for (size_t i = 0; i < num_words_; ++i) {
+            count += std::popcount(load_word(i));
+        }
+        return count;
+    }
+
+    // ============================================================================
+    // Core Operations
+    // ============================================================================
+    void ConcurrentBloomFilter::insert(std::string_view key) {
+        FilterMetrics::ScopedTimer timer(metrics_, FilterMetrics::Op::Single);
+        bool is_new = set_key(key);
+        local_counters().insertions.fetch_add(1, std::memory_order_relaxed);
+        metrics_.count_inserts(1, is_new);
+    }
+
+    bool ConcurrentBloomFilter::possibly_contains(std::string_view key) const {
+        FilterMetrics::ScopedTimer timer(metrics_, FilterMetrics::Op::Single);
+        bool found = test_key(key);
+        metrics_.count_queries(1, found);
+        if (!found) {
+            return false;
+        }
+        local_counters().queries.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool ConcurrentBloomFilter::insert_and_check(std::string_view key) {
+        // Fetch-or alone lets two racing threads each flip some of the key's
+        // bits and both report it as new. Racers on one key hash to the same
+        // stripe, so holding it makes test-and-set atomic per key; inserts of
+        // other keys keep running lock-free.
+        FilterMetrics::ScopedTimer timer(metrics_, FilterMetrics::Op::Single);
+        uint64_t hash[2];
+        MurmurHash3_x64_128(key.data(), static_cast<int>(key.size()), 0x51ED270B, hash);
+        KeyLock& lock = key_locks_[hash[0] % kKeyLockStripes];
+
+        // Test before test-and-set, so waiters read a shared line instead of
+        // bouncing it with writes; yield in case the holder was descheduled
+        for (uint32_t spins = 0;; ++spins) {
+            if (!lock.locked.load(std::memory_order_relaxed) &&
+                !lock.locked.exchange(true, std::memory_order_acquire)) {
+                break;
+            }
+            if (spins < kSpinsBeforeYield) {
+                spin_pause();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        bool is_new = set_key(key);
+        lock.locked.store(false, std::memory_order_release);
+
+        if (is_new) {
+            local_counters().insertions.fetch_add(1, std::memory_order_relaxed);
+        }
+        metrics_.count_inserts(1, is_new);
+        return is_new;
+    }
+
+    // ============================================================================
+    // Batch Operations
+    // ============================================================================
+    template <typename KeyAt>
+    uint64_t ConcurrentBloomFilter::insert_range(size_t begin, size_t end, KeyAt&& key_at) {
+        uint64_t new_keys = 0;
+        if (hash_scheme_ == BloomFilter::HashScheme::Seeded) {
+            for (size_t i = begin; i < end; ++i) {
+                new_keys += set_key(key_at(i));
+            }
+            return new_keys;
+        }
+
+        // Same three stages as BloomFilter: hash, prefetch, then fetch-or
+        constexpr size_t kBlock = detail::kBatchBlock;
+        std::string_view keys[kBlock];
+        detail::KeyHash hashes[kBlock];
+        for (size_t base = begin; base < end; base += kBlock) {
+            size_t n = std::min(kBlock, end - base);
+            for (size_t i = 0; i < n; ++i) {
+                keys[i] = key_at(base + i);
+            }
+            detail::hash_block(hash_scheme_, keys, n, hashes);
+
+            for (size_t i = 0; i < n; ++i) {
+                if (layout_ == Layout::Blocked) {
+                    BLOOM_PREFETCH_WRITE(bit_array_.get() + (hashes[i].h1 % (num_bits_ / kBlockBits)) * kBlockWords);
+                } else {
+                    detail::ProbeSequence probes = detail::probe_sequence(hashes[i], num_bits_);
+                    for (uint32_t j = 0; j < num_hashes_; ++j) {
+                        BLOOM_PREFETCH_WRITE(bit_array_.get() + probes.next() / 64);
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < n; ++i) {
+                new_keys += set_hash(hashes[i]);
+            }
+        }
+        return new_keys;
+    }
+
+    void ConcurrentBloomFilter::insert_batch(const std::vector<std::string>& keys) {
+        FilterMetrics::ScopedTimer timer(metrics_, FilterMetrics::Op::Batch);
+        uint64_t new_keys = insert_range(0, keys.size(), [&keys](size_t i) {
+            return std::string_view(keys[i]);
+        });
+        local_counters().insertions.fetch_add(keys.size(), std::memory_order_relaxed);
+        metrics_.count_inserts(keys.size(), new_keys);
+    }
+
+    std::vector<size_t> ConcurrentBloomFilter::filter_new(const std::vector<std::string>& keys) const {
+        FilterMetrics::ScopedTimer timer(metrics_, FilterMetrics::Op::Batch);
+        std::vector<size_t> new_indices;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (!test_key(keys[i])) {
+                new_indices.push_back(i);
+            }
+        }
+        uint64_t num_seen = keys.size() - new_indices.size();
+        local_counters().queries.fetch_add(num_seen, std::memory_order_relaxed);
+        metrics_.count_queries(keys.size(), num_seen);
+        return new_indices;
+    }
+
+    void ConcurrentBloomFilter::insert_batch(const KeyBuffer& keys, size_t num_threads) {
+        FilterMetrics::ScopedTimer timer(metrics_, FilterMetrics::Op::Batch);
+        auto key_at = [&keys](size_t i) { return keys[i]; };
+        size_t threads = ThreadPool::resolve_threads(num_threads, keys.size(), kMinKeysPerThread);
+        ThreadPool::shared().parallel_for(keys.size(), threads, [&](size_t begin, size_t end) {
+            metrics_.count_inserts(end - begin, insert_range(begin, end, key_at));
+        });
+        local_counters().insertions.fetch_add(keys.size(), std::memory_order_relaxed);
+    }
+
+    void ConcurrentBloomFilter::filter_new_mask(const KeyBuffer& keys, bool* is_new,
+                                                size_t num_threads) const {
+        FilterMetrics::ScopedTimer timer(metrics_, FilterMetrics::Op::Batch);
+        size_t threads = ThreadPool::resolve_threads(num_threads, keys.size(), kMinKeysPerThread);
+        ThreadPool::shared().parallel_for(keys.size(), threads, [&](size_t begin, size_t end) {
+            uint64_t num_seen = 0;
+            for (size_t i = begin; i < end; ++i) {
+                is_new[i] = !test_key(keys[i]);
+                num_seen += !is_new[i];
+            }
+            local_counters().queries.fetch_add(num_seen, std::memory_order_relaxed);
+            metrics_.count_queries(end - begin, num_seen);
+        });
+    }
+
+    // ============================================================================
+    // Statistics
+    // ============================================================================
+    BloomFilter::BloomFilterStats ConcurrentBloomFilter::get_stats() const {
+        uint64_t bits_set = count_set_bits();
+        uint64_t queries = 0;
+        for (size_t i = 0; i < kCounterShards; ++i) {
+            queries += counters_[i].queries.load(std::memory_order_relaxed);
+        }
+
+        FilterMetrics::Snapshot metrics = metrics_.snapshot();
+        const FilterMetrics::Counters& counters = metrics.counters;
+
+        return BloomFilterStats{
+            num_insertions(),
+            queries,
+            num_bits_,
+            bits_set,
+            num_hashes_,
+            static_cast<double>(bits_set) / num_bits_,
+            estimated_false_positive_rate(),
+            metrics,
+            counters.queries == 0 ? 0.0 : static_cast<double>(counters.positives) / counters.queries
+        };
+    }
+
+    double ConcurrentBloomFilter::fill_ratio() const {
+        return static_cast<double>(count_set_bits()) / num_bits_;
+    }
+
+    double ConcurrentBloomFilter::estimated_false_positive_rate() const {
+        return BloomFilter::false_positive_rate(num_bits_, num_insertions(), num_hashes_, layout_);
+    }
+
+    size_t ConcurrentBloomFilter::size_bits() const {
+        return num_bits_;
+    }
+
+    size_t ConcurrentBloomFilter::size_bytes() const {
+        return num_words_ * sizeof(uint64_t);
+    }
+
+    uint64_t ConcurrentBloomFilter::num_insertions() const {
+        uint64_t total = 0;
+        for (size_t i = 0; i < kCounterShards; ++i) {
+            total += counters_[i].insertions.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    ConcurrentBloomFilter::Layout ConcurrentBloomFilter::layout() const {
+        return layout_;
+    }
+
+    // ============================================================================
+    // Instrumentation
+    // ============================================================================
+
+    void ConcurrentBloomFilter::reset_metrics() {
+        metrics_.reset();
+    }
+
+    void ConcurrentBloomFilter::set_latency_sampling(uint32_t sample_every) {
+        metrics_.set_sample_every(sample_every);
+    }
+
+    // ============================================================================
+    // Persistence
+    // ============================================================================
+    bool ConcurrentBloomFilter::save_to_file(const std::string& filepath) const {
+        std::ofstream file(filepath, std::ios::binary);
+        if (!file) return false;
+
+        BloomFilterStats stats = get_stats();
+        detail::BloomFileHeader header{layout_, hash_scheme_, num_bits_, num_hashes_,
+                                       stats.num_insertions, stats.num_queries};
+        detail::write_bloom_header(file, header);
+
+        // Words are copied out a checksum chunk at a time with atomic loads so
+        // concurrent inserts stay well-defined; the checksum covers exactly
+        // the words written and the header is patched once they are
+        std::vector<uint64_t> chunk(std::min(detail::kChecksumChunkWords, num_words_));
+        std::vector<uint64_t> digests;
+        for (size_t base = 0; base < num_words_; base += chunk.size()) {
+            size_t n = std::min(chunk.size(), num_words_ - base);
+            for (size_t i = 0; i < n; ++i) {
+                chunk[i] = load_word(base + i);
+            }
+            digests.push_back(detail::chunk_digest(chunk.data(), n, digests.size()));
+            file.write(reinterpret_cast<const char*>(chunk.data()), n * sizeof(uint64_t));
+        }
+
+        header.checksum = detail::combine_digests(digests.data(), digests.size());
+        file.seekp(0);
+        detail::write_bloom_header(file, header);
+
+        return file.good();
+    }
+
+    std::unique_ptr<ConcurrentBloomFilter> ConcurrentBloomFilter::load_from_file(const std::string& filepath) {
+        std::ifstream file(filepath, std::ios::binary);
+        if (!file) return nullptr;
+
+        detail::BloomFileHeader header;
+        if (!detail::read_bloom_header(file, header)) return nullptr;
+
+        auto filter = std::make_unique<ConcurrentBloomFilter>(
+            header.num_bits, header.num_hashes, header.layout);
+        filter->hash_scheme_ = header.hash_scheme;
+        filter->counters_[0].insertions.store(header.num_insertions, std::memory_order_relaxed);
+        filter->counters_[0].queries.store(header.num_queries, std::memory_order_relaxed);
+
+        file.read(reinterpret_cast<char*>(filter->bit_array_.get()),
+                  filter->num_words_ * sizeof(uint64_t));
+        if (!file) return nullptr;
+        if (header.checksum != 0 &&
+            detail::bloom_checksum(filter->bit_array_.get(), filter->num_words_, 0) != header.checksum) {
+            return nullptr;
+        }
+
+        return filter;
+    }
+
+    void ConcurrentBloomFilter::clear() {
+        for (size_t i = 0; i < num_words_; ++i) {
+            std::atomic_ref<uint64_t>(bit_array_[i]).store(0, std::memory_order_relaxed);
+        }
+        // Deltas only ever add bits, so a checkpointer must start over
+        clear_count_.fetch_add(1, std::memory_order_seq_cst);
+        for (size_t i = 0; i < kCounterShards; ++i) {
+            counters_[i].insertions.store(0, std::memory_order_relaxed);
+            counters_[i].queries.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // ============================================================================
+    // Checkpointing
+    // ============================================================================
+    void ConcurrentBloomFilter::take_dirty_blocks(std::vector<uint32_t>& blocks) {
+        size_t num_mark_words = (num_dirty_blocks_ + 63) / 64;
+        for (size_t i = 0; i < num_mark_words; ++i) {
+            if (dirty_blocks_[i].bits.load(std::memory_order_relaxed) == 0) continue;
+            uint64_t marks = dirty_blocks_[i].bits.exchange(0, std::memory_order_seq_cst);
+            while (marks != 0) {
+                blocks.push_back(static_cast<uint32_t>(i * 64 + std::countr_zero(marks)));
+                marks &= marks - 1;
+            }
+        }
+        // Pairs with mark_dirty(): reads of the blocks after this see every
+        // bit whose mark was taken
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    void ConcurrentBloomFilter::mark_blocks_dirty(const std::vector<uint32_t>& blocks) {
+        for (uint32_t block : blocks) {
+            dirty_blocks_[block / 64].bits.fetch_or(1ULL << (block % 64), std::memory_order_seq_cst);
+        }
+    }
+
+    size_t ConcurrentBloomFilter::copy_block(size_t block, uint64_t* out) const {
+        size_t first = block * kDirtyBlockWords;
+        size_t n = std::min(kDirtyBlockWords, num_words_ - first);
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = load_word(first + i);
+        }
+        return n;
+    }
+
+    // Leaves the blocks unmarked: used to rebuild a filter from its own files
+    void ConcurrentBloomFilter::or_words(size_t first_word, const uint64_t* words, size_t num_words) {
+        for (size_t i = 0; i < num_words; ++i) {
+            if (words[i] != 0) {
+                std::atomic_ref<uint64_t>(bit_array_[first_word + i]).fetch_or(words[i], std::memory_order_relaxed);
+            }
+        }
+    }
+}
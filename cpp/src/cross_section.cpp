@@ -0,0 +1,239 @@
+#include "cross_section.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Packs only pass between functions of this file, so the ABI note GCC
+// attaches to wide vector arguments does not apply
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace quantamental::cross_section {
+    namespace {
+        constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+        constexpr size_t kMinRowsPerThread = 16;   // A row of ~500 tickers is microseconds of work
+        constexpr size_t kLanes = 8;               // Doubles per Pack
+
+        // Runs fn(begin, end) over the rows, split across the shared pool;
+        // fn allocates its scratch once per range
+        template <typename Fn>
+        void for_rows(size_t num_dates, size_t num_tickers, size_t num_threads, const Fn& fn) {
+            if (num_dates == 0 || num_tickers == 0) return;
+            size_t threads = ThreadPool::resolve_threads(num_threads, num_dates, kMinRowsPerThread);
+            if (threads <= 1) {
+                fn(0, num_dates);
+            } else {
+                ThreadPool::shared().parallel_for(num_dates, threads, fn);
+            }
+        }
+
+        // ============================================================================
+        // Moments
+        // ============================================================================
+
+        // kLanes doubles side by side. GCC lowers the vector type to whatever
+        // the target has (four SSE2 registers at the x86-64 baseline);
+        // masks are applied bitwise, as vector ?: does not vectorize at -O2.
+        typedef double Pack __attribute__((vector_size(kLanes * sizeof(double))));
+        typedef int64_t PackMask __attribute__((vector_size(kLanes * sizeof(double))));
+
+        Pack load_pack(const double* x) {
+            Pack v;
+            std::memcpy(&v, x, sizeof(v));
+            return v;
+        }
+
+        struct RowSum {
+            double sum;
+            double count;
+        };
+
+        // Sum of term(x) over the row's non-NaN x, in kLanes partial sums
+        // (term takes a double or a Pack)
+        template <typename Term>
+        RowSum row_sum(const double* x, size_t n, Term term) {
+            const Pack ones = Pack{} + 1.0;
+            Pack sum{}, count{};
+            size_t j = 0;
+            for (; j + kLanes <= n; j += kLanes) {
+                const Pack v = load_pack(x + j);
+                const PackMask present = v == v;
+                sum += (Pack)((PackMask)term(v) & present);
+                count += (Pack)((PackMask)ones & present);
+            }
+
+            RowSum total{0.0, 0.0};
+            for (size_t l = 0; l < kLanes; ++l) {
+                total.sum += sum[l];
+                total.count += count[l];
+            }
+            for (; j < n; ++j) {
+                if (x[j] == x[j]) {
+                    total.sum += term(x[j]);
+                    total.count += 1.0;
+                }
+            }
+            return total;
+        }
+
+        void zscore_row(const double* x, double* y, size_t n) {
+            const RowSum first = row_sum(x, n, [](const auto& v) { return v; });
+            double mean = first.sum / first.count;
+            // One correction pass: a row of equal values gets its mean back
+            // exactly, so its deviations (and std) are exactly zero
+            mean += row_sum(x, n, [mean](const auto& v) { return v - mean; }).sum / first.count;
+            const double ssqdm = row_sum(x, n, [mean](const auto& v) { return (v - mean) * (v - mean); }).sum;
+            const double stddev = std::sqrt(ssqdm / (first.count - 1.0));
+
+            if (!(first.count >= 2.0) || !(stddev > 0.0)) {
+                std::fill(y, y + n, kNaN);
+                return;
+            }
+            size_t j = 0;
+            for (; j + kLanes <= n; j += kLanes) {
+                const Pack z = (load_pack(x + j) - mean) / stddev;
+                std::memcpy(y + j, &z, sizeof(z));
+            }
+            for (; j < n; ++j) {
+                y[j] = (x[j] - mean) / stddev;
+            }
+        }
+
+        // ============================================================================
+        // Order Statistics
+        // ============================================================================
+
+        // Reads the whole row into values before y is written, so y may be x
+        void rank_row(const double* x, double* y, size_t n, bool pct,
+                      std::vector<std::pair<double, uint32_t>>& values) {
+            values.clear();
+            for (size_t j = 0; j < n; ++j) {
+                if (x[j] == x[j]) values.emplace_back(x[j], static_cast<uint32_t>(j));
+            }
+            std::sort(values.begin(), values.end());
+            std::fill(y, y + n, kNaN);
+
+            const double scale = pct ? 1.0 / static_cast<double>(values.size()) : 1.0;
+            for (size_t i = 0; i < values.size();) {
+                size_t tie_end = i + 1;
+                while (tie_end < values.size() && values[tie_end].first == values[i].first) ++tie_end;
+                // Ranks i + 1 .. tie_end averaged
+                const double rank = 0.5 * static_cast<double>(i + 1 + tie_end);
+                for (; i < tie_end; ++i) y[values[i].second] = pct ? rank * scale : rank;
+            }
+        }
+
+        // numpy's "linear" quantile of values (reordered in the process),
+        // including its lerp, which is taken from the upper end past t = 0.5
+        double quantile(std::vector<double>& values, double q) {
+            const double index = q * static_cast<double>(values.size() - 1);
+            const size_t lo = static_cast<size_t>(index);
+            const double t = index - static_cast<double>(lo);
+
+            std::nth_element(values.begin(), values.begin() + lo, values.end());
+            const double a = values[lo];
+            if (t == 0.0 || lo + 1 >= values.size()) return a;
+
+            const double b = *std::min_element(values.begin() + lo + 1, values.end());
+            const double diff = b - a;
+            return t >= 0.5 ? b - diff * (1.0 - t) : a + diff * t;
+        }
+
+        void winsorize_row(const double* x, double* y, size_t n, double lower, double upper,
+                           std::vector<double>& values) {
+            values.clear();
+            for (size_t j = 0; j < n; ++j) {
+                if (x[j] == x[j]) values.push_back(x[j]);
+            }
+            if (values.empty()) {
+                std::fill(y, y + n, kNaN);
+                return;
+            }
+
+            const double lo = quantile(values, lower);
+            const double hi = quantile(values, upper);
+            for (size_t j = 0; j < n; ++j) {
+                const double v = x[j];
+                y[j] = v < lo ? lo : (v > hi ? hi : v);
+            }
+        }
+
+        // ============================================================================
+        // Groups
+        // ============================================================================
+
+        void demean_row(const double* x, double* y, size_t n, const int32_t* groups,
+                        std::vector<double>& sums, std::vector<double>& counts) {
+            std::fill(sums.begin(), sums.end(), 0.0);
+            std::fill(counts.begin(), counts.end(), 0.0);
+            for (size_t j = 0; j < n; ++j) {
+                if (groups[j] >= 0 && x[j] == x[j]) {
+                    sums[groups[j]] += x[j];
+                    counts[groups[j]] += 1.0;
+                }
+            }
+            for (size_t g = 0; g < sums.size(); ++g) {
+                sums[g] /= counts[g];  // Now the group mean
+            }
+            for (size_t j = 0; j < n; ++j) {
+                y[j] = groups[j] >= 0 ? x[j] - sums[groups[j]] : kNaN;
+            }
+        }
+    }
+
+    // ============================================================================
+    // Panel Transforms
+    // ============================================================================
+
+    void zscore(const double* in, double* out, size_t num_dates, size_t num_tickers,
+                size_t num_threads) {
+        for_rows(num_dates, num_tickers, num_threads, [&](size_t begin, size_t end) {
+            for (size_t d = begin; d < end; ++d) {
+                zscore_row(in + d * num_tickers, out + d * num_tickers, num_tickers);
+            }
+        });
+    }
+
+    void rank(const double* in, double* out, size_t num_dates, size_t num_tickers,
+              bool pct, size_t num_threads) {
+        for_rows(num_dates, num_tickers, num_threads, [&](size_t begin, size_t end) {
+            std::vector<std::pair<double, uint32_t>> values;
+            values.reserve(num_tickers);
+            for (size_t d = begin; d < end; ++d) {
+                rank_row(in + d * num_tickers, out + d * num_tickers, num_tickers, pct, values);
+            }
+        });
+    }
+
+    void winsorize(const double* in, double* out, size_t num_dates, size_t num_tickers,
+                   double lower, double upper, size_t num_threads) {
+        for_rows(num_dates, num_tickers, num_threads, [&](size_t begin, size_t end) {
+            std::vector<double> values;
+            values.reserve(num_tickers);
+            for (size_t d = begin; d < end; ++d) {
+                winsorize_row(in + d * num_tickers, out + d * num_tickers, num_tickers,
+                              lower, upper, values);
+            }
+        });
+    }
+
+    void demean_by_group(const double* in, double* out, size_t num_dates, size_t num_tickers,
+                         const int32_t* groups, size_t num_threads) {
+        int32_t max_group = -1;
+        for (size_t j = 0; j < num_tickers; ++j) max_group = std::max(max_group, groups[j]);
+        const size_t num_groups = static_cast<size_t>(max_group + 1);
+
+        for_rows(num_dates, num_tickers, num_threads, [&](size_t begin, size_t end) {
+            std::vector<double> sums(num_groups), counts(num_groups);
+            for (size_t d = begin; d < end; ++d) {
+                demean_row(in + d * num_tickers, out + d * num_tickers, num_tickers, groups,
+                           sums, counts);
+            }
+        });
+    }
+}
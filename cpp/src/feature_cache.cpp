@@ -0,0 +1,325 @@
+#include "feature_cache.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace quantamental {
+    namespace {
+        // File layout (native-endian, checked via endian_tag):
+        //   [0, 4096)             RawHeader
+        //   [data_offset, ...)    num_rows rows of row_bytes:
+        //                           uint64 sequence   0 = never written, odd = being
+        //                                             written (writer pid in the top half)
+        //                           int64  as_of
+        //                           float  features[dim]
+        //                         padded to a cache line, so rows written by
+        //                         different threads never share one
+        constexpr uint32_t kCacheMagic = 0x48434651;  // "QFCH"
+        constexpr uint32_t kCacheVersion = 1;
+        constexpr uint32_t kEndianTag = 0x01020304;
+        constexpr uint64_t kPageBytes = 4096;
+        constexpr uint64_t kLineBytes = 64;
+        constexpr uint64_t kRowHeaderBytes = 16;
+        constexpr uint64_t kMaxDim = uint64_t{1} << 20;
+        constexpr uint64_t kMaxRows = uint64_t{1} << 32;
+        constexpr uint64_t kCounterMask = 0xFFFFFFFF;
+        constexpr uint32_t kMaxReadSpins = 1 << 16;    // ~1 ms, far longer than any write
+        constexpr uint32_t kMaxWriteSpins = 1 << 20;
+
+        struct RawHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t endian_tag;
+            uint32_t header_bytes;
+            uint32_t dim;
+            uint32_t row_bytes;
+            uint64_t num_rows;
+            uint64_t data_offset;
+            uint64_t file_bytes;
+        };
+        static_assert(sizeof(RawHeader) == 48, "RawHeader layout is part of the file format");
+
+        RawHeader layout_for(uint64_t num_rows, uint64_t dim) {
+            RawHeader raw{};
+            raw.magic = kCacheMagic;
+            raw.version = kCacheVersion;
+            raw.endian_tag = kEndianTag;
+            raw.header_bytes = sizeof(RawHeader);
+            raw.dim = static_cast<uint32_t>(dim);
+            raw.row_bytes = static_cast<uint32_t>(
+                (kRowHeaderBytes + dim * sizeof(float) + kLineBytes - 1) / kLineBytes * kLineBytes);
+            raw.num_rows = num_rows;
+            raw.data_offset = kPageBytes;
+            raw.file_bytes = raw.data_offset + num_rows * raw.row_bytes;
+            return raw;
+        }
+
+        void spin_pause() {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#else
+            std::this_thread::yield();
+#endif
+        }
+    }
+
+    namespace detail {
+        // One mmap of a cache file, shared by every copy of the cache
+        struct FeatureCacheMapping {
+            void* base = nullptr;
+            size_t size = 0;
+            RawHeader header{};
+            char* rows = nullptr;
+
+            FeatureCacheMapping(void* mapped, size_t mapped_size) : base(mapped), size(mapped_size) {
+                std::memcpy(&header, base, sizeof(header));
+                rows = static_cast<char*>(base) + header.data_offset;
+            }
+
+            FeatureCacheMapping(const FeatureCacheMapping&) = delete;
+            FeatureCacheMapping& operator=(const FeatureCacheMapping&) = delete;
+            ~FeatureCacheMapping();
+
+            char* row(size_t r) const {
+                return rows + r * header.row_bytes;
+            }
+        };
+    }
+
+    namespace {
+        // ============================================================================
+        // Memory Mapping
+        // ============================================================================
+#if !defined(_WIN32)
+        bool header_consistent(const void* base, size_t size) {
+            RawHeader raw{};
+            if (size < sizeof(raw)) return false;
+            std::memcpy(&raw, base, sizeof(raw));
+            if (raw.magic != kCacheMagic || raw.version != kCacheVersion ||
+                raw.endian_tag != kEndianTag || raw.header_bytes != sizeof(RawHeader) ||
+                raw.dim == 0 || raw.dim > kMaxDim || raw.num_rows == 0 || raw.num_rows > kMaxRows) {
+                return false;
+            }
+            RawHeader expected = layout_for(raw.num_rows, raw.dim);
+            return raw.row_bytes == expected.row_bytes && raw.data_offset == expected.data_offset &&
+                   raw.file_bytes == expected.file_bytes && raw.file_bytes <= size;
+        }
+
+        std::shared_ptr<detail::FeatureCacheMapping> map_cache(const std::string& filepath, bool writable) {
+            int fd = ::open(filepath.c_str(), writable ? O_RDWR : O_RDONLY);
+            if (fd < 0) return nullptr;
+
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+                ::close(fd);
+                return nullptr;
+            }
+            size_t size = static_cast<size_t>(st.st_size);
+            int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+            void* base = ::mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (base == MAP_FAILED) return nullptr;
+
+            if (!header_consistent(base, size)) {
+                ::munmap(base, size);
+                return nullptr;
+            }
+            return std::make_shared<detail::FeatureCacheMapping>(base, size);
+        }
+
+        std::shared_ptr<detail::FeatureCacheMapping> create_cache(const std::string& filepath,
+                                                                  uint64_t num_rows, uint64_t dim) {
+            RawHeader raw = layout_for(num_rows, dim);
+
+            // Built aside and renamed into place, so a process still mapping an
+            // older cache keeps a complete file
+            const std::string tmp_path = filepath + ".tmp";
+            int fd = ::open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) return nullptr;
+            if (::ftruncate(fd, static_cast<off_t>(raw.file_bytes)) != 0) {
+                ::close(fd);
+                ::unlink(tmp_path.c_str());
+                return nullptr;
+            }
+            void* base = ::mmap(nullptr, raw.file_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (base == MAP_FAILED || ::rename(tmp_path.c_str(), filepath.c_str()) != 0) {
+                if (base != MAP_FAILED) ::munmap(base, raw.file_bytes);
+                ::unlink(tmp_path.c_str());
+                return nullptr;
+            }
+
+            std::memcpy(base, &raw, sizeof(raw));
+            return std::make_shared<detail::FeatureCacheMapping>(base, raw.file_bytes);
+        }
+
+        bool sync_cache(const detail::FeatureCacheMapping& mapping) {
+            return ::msync(mapping.base, mapping.size, MS_SYNC) == 0;
+        }
+
+        uint32_t current_pid() {
+            return static_cast<uint32_t>(::getpid());
+        }
+
+        // Pids are only comparable within one pid namespace
+        bool writer_alive(uint32_t pid) {
+            return ::kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH;
+        }
+#else
+        std::shared_ptr<detail::FeatureCacheMapping> map_cache(const std::string&, bool) {
+            return nullptr;
+        }
+
+        std::shared_ptr<detail::FeatureCacheMapping> create_cache(const std::string&, uint64_t, uint64_t) {
+            return nullptr;
+        }
+
+        bool sync_cache(const detail::FeatureCacheMapping&) {
+            return false;
+        }
+
+        uint32_t current_pid() {
+            return 0;
+        }
+
+        bool writer_alive(uint32_t) {
+            return true;
+        }
+#endif
+    }
+
+    detail::FeatureCacheMapping::~FeatureCacheMapping() {
+#if !defined(_WIN32)
+        ::munmap(base, size);
+#endif
+    }
+
+    // ============================================================================
+    // Construction
+    // ============================================================================
+
+    std::optional<FeatureCache> FeatureCache::create(const std::string& filepath, size_t num_rows, size_t dim) {
+        if (num_rows == 0 || num_rows > kMaxRows || dim == 0 || dim > kMaxDim) return std::nullopt;
+        auto mapping = create_cache(filepath, num_rows, dim);
+        if (!mapping) return std::nullopt;
+        return FeatureCache(std::move(mapping), true);
+    }
+
+    std::optional<FeatureCache> FeatureCache::open(const std::string& filepath, bool writable) {
+        auto mapping = map_cache(filepath, writable);
+        if (!mapping) return std::nullopt;
+        return FeatureCache(std::move(mapping), writable);
+    }
+
+    FeatureCache::FeatureCache(std::shared_ptr<detail::FeatureCacheMapping> mapping, bool writable)
+        : mapping_(std::move(mapping)), writable_(writable) {}
+
+    size_t FeatureCache::num_rows() const {
+        return mapping_->header.num_rows;
+    }
+
+    size_t FeatureCache::dim() const {
+        return mapping_->header.dim;
+    }
+
+    bool FeatureCache::writable() const {
+        return writable_;
+    }
+
+    // ============================================================================
+    // Sequence-Locked Rows
+    // ============================================================================
+    // A row's sequence counter (the low 32 bits) is odd while it is written
+    // and even otherwise, and each write raises it by two. A read that starts
+    // and ends on the same even sequence saw no write. The features are
+    // copied with relaxed atomics, which compile to plain moves but keep the
+    // overlapping copies of a torn read well-defined.
+    //
+    // A writer that dies mid-write would leave the row odd for good, so both
+    // sides bound their spinning: a read gives up and reports the row as not
+    // cached, and a write takes the row over if the pid that marked it has
+    // exited, or gives up if that process is still alive.
+
+    bool FeatureCache::write(size_t row, const float* features, int64_t as_of) {
+        if (!writable_ || row >= num_rows()) return false;
+
+        char* slot = mapping_->row(row);
+        std::atomic_ref<uint64_t> sequence(*reinterpret_cast<uint64_t*>(slot));
+        const uint64_t owner = uint64_t{current_pid()} << 32;
+        uint64_t seq = sequence.load(std::memory_order_relaxed);
+        uint64_t writing = 0;   // The odd counter this write holds
+        uint32_t spins = 0;
+        for (;;) {
+            if (seq & 1) {
+                if (++spins < kMaxWriteSpins) {
+                    spin_pause();
+                    seq = sequence.load(std::memory_order_relaxed);
+                    continue;
+                }
+                if (writer_alive(static_cast<uint32_t>(seq >> 32))) return false;
+                writing = (seq + 2) & kCounterMask;
+                spins = 0;
+            } else {
+                writing = (seq + 1) & kCounterMask;
+            }
+            if (sequence.compare_exchange_weak(seq, owner | writing, std::memory_order_acquire,
+                                               std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        // The odd sequence is visible before any of the new values
+        std::atomic_thread_fence(std::memory_order_release);
+
+        std::atomic_ref<int64_t>(*reinterpret_cast<int64_t*>(slot + 8)).store(as_of, std::memory_order_relaxed);
+        float* values = reinterpret_cast<float*>(slot + kRowHeaderBytes);
+        const size_t n = dim();
+        for (size_t i = 0; i < n; ++i) {
+            std::atomic_ref<float>(values[i]).store(features[i], std::memory_order_relaxed);
+        }
+        const uint64_t written = (writing + 1) & kCounterMask;
+        sequence.store(written == 0 ? 2 : written, std::memory_order_release);   // 0 means unwritten
+        return true;
+    }
+
+    bool FeatureCache::read(size_t row, float* out, int64_t* as_of) const {
+        if (row >= num_rows()) return false;
+
+        char* slot = mapping_->row(row);
+        std::atomic_ref<uint64_t> sequence(*reinterpret_cast<uint64_t*>(slot));
+        float* values = reinterpret_cast<float*>(slot + kRowHeaderBytes);
+        const size_t n = dim();
+        for (uint32_t spins = 0; spins < kMaxReadSpins; ++spins) {
+            uint64_t before = sequence.load(std::memory_order_acquire);
+            if (before == 0) return false;
+            if (before & 1) {
+                spin_pause();
+                continue;
+            }
+            int64_t stamp = std::atomic_ref<int64_t>(*reinterpret_cast<int64_t*>(slot + 8))
+                                .load(std::memory_order_relaxed);
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = std::atomic_ref<float>(values[i]).load(std::memory_order_relaxed);
+            }
+            // The copies complete before the sequence is read again
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                if (as_of != nullptr) *as_of = stamp;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool FeatureCache::flush() {
+        return writable_ && sync_cache(*mapping_);
+    }
+}
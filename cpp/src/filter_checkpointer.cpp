@@ -0,0 +1,455 @@
+#include "filter_checkpointer.hpp"
+#include "bloom_file.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace quantamental {
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        constexpr uint32_t kLogMagic = 0x4C4C4251;      // "QBLL"
+        constexpr uint32_t kRecordMagic = 0x444C4251;   // "QBLD"
+        constexpr uint32_t kLogVersion = 1;
+        constexpr uint32_t kEndianTag = 0x01020304;
+
+        struct LogHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t endian_tag;
+            uint32_t block_words;
+            uint64_t num_bits;
+            uint32_t num_hashes;
+            uint32_t layout;
+            uint32_t hash_scheme;
+            uint32_t reserved;
+            uint64_t base_checksum;     // Checksum field of the base it extends
+        };
+        static_assert(sizeof(LogHeader) == 48, "LogHeader layout is part of the file format");
+
+        struct RecordHeader {
+            uint32_t magic;
+            uint32_t num_blocks;
+            uint64_t sequence;          // 1, 2, ... since the log was started
+            uint64_t num_insertions;    // Filter counters when the blocks were taken
+            uint64_t num_queries;
+            uint64_t checksum;          // Of the fields above and the body
+        };
+        static_assert(sizeof(RecordHeader) == 40, "RecordHeader layout is part of the file format");
+
+        constexpr size_t kHeaderWords = sizeof(RecordHeader) / sizeof(uint64_t);
+
+        size_t index_words(size_t num_blocks) {
+            return (num_blocks + 1) / 2;
+        }
+
+        // Chunk digests of the body, then of the header with its checksum
+        // zeroed, combined like a filter file's checksum
+        uint64_t record_checksum(RecordHeader header, const uint64_t* body, size_t num_words) {
+            std::vector<uint64_t> digests;
+            for (size_t first = 0; first < num_words; first += detail::kChecksumChunkWords) {
+                size_t n = std::min(detail::kChecksumChunkWords, num_words - first);
+                digests.push_back(detail::chunk_digest(body + first, n, digests.size()));
+            }
+            header.checksum = 0;
+            uint64_t header_words[kHeaderWords];
+            std::memcpy(header_words, &header, sizeof(header));
+            digests.push_back(detail::chunk_digest(header_words, kHeaderWords, digests.size()));
+            return detail::combine_digests(digests.data(), digests.size());
+        }
+
+        // Checksum recorded in a filter file's header (0 when unreadable)
+        uint64_t base_checksum(const std::string& filepath) {
+            std::ifstream file(filepath, std::ios::binary);
+            detail::BloomFileHeader header{};
+            if (!file || !detail::read_bloom_header(file, header)) return 0;
+            return header.checksum;
+        }
+
+        // ============================================================================
+        // File I/O
+        // ============================================================================
+#if !defined(_WIN32)
+        int open_log(const std::string& filepath) {
+            return ::open(filepath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        }
+
+        void close_file(int fd) {
+            ::close(fd);
+        }
+
+        bool write_all(int fd, const void* data, size_t size, bool sync) {
+            const char* bytes = static_cast<const char*>(data);
+            while (size > 0) {
+                ssize_t written = ::write(fd, bytes, size);
+                if (written < 0) {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                bytes += written;
+                size -= static_cast<size_t>(written);
+            }
+            return !sync || ::fdatasync(fd) == 0;
+        }
+
+        bool truncate_file(int fd, uint64_t size) {
+            return ::ftruncate(fd, static_cast<off_t>(size)) == 0;
+        }
+
+        bool sync_path(const std::string& filepath) {
+            int fd = ::open(filepath.c_str(), O_RDONLY);
+            if (fd < 0) return false;
+            bool ok = ::fsync(fd) == 0;
+            ::close(fd);
+            return ok;
+        }
+#else
+        int open_log(const std::string&) {
+            return -1;
+        }
+
+        void close_file(int) {}
+
+        bool write_all(int, const void*, size_t, bool) {
+            return false;
+        }
+
+        bool truncate_file(int, uint64_t) {
+            return false;
+        }
+
+        bool sync_path(const std::string&) {
+            return false;
+        }
+#endif
+    }
+
+    namespace detail {
+        // ============================================================================
+        // Checkpointer State
+        // ============================================================================
+        struct FilterCheckpointerState {
+            std::shared_ptr<ConcurrentBloomFilter> filter;
+            CheckpointConfig config;
+
+            // One checkpoint or compaction at a time; guards everything below
+            // up to the thread
+            std::mutex io_mutex;
+            int log_fd = -1;
+            uint64_t sequence = 0;
+            uint64_t base_bytes = 0;
+            uint64_t log_bytes = 0;
+            uint64_t clear_count = 0;        // Filter's clear_count_ when the base was taken
+            std::vector<uint32_t> blocks;    // Reused between checkpoints
+            std::vector<uint64_t> record;
+
+            std::mutex wake_mutex;
+            std::condition_variable wake;
+            bool stopping = false;           // Guarded by wake_mutex
+            std::thread thread;
+
+            mutable std::mutex stats_mutex;
+            FilterCheckpointer::Stats stats;
+
+            void count_failure() {
+                std::lock_guard<std::mutex> lock(stats_mutex);
+                ++stats.failures;
+            }
+        };
+    }
+
+    // ============================================================================
+    // Lifecycle
+    // ============================================================================
+    FilterCheckpointer::FilterCheckpointer(std::unique_ptr<detail::FilterCheckpointerState> state)
+        : state_(std::move(state)) {}
+
+    FilterCheckpointer::~FilterCheckpointer() {
+        stop();
+    }
+
+    std::unique_ptr<FilterCheckpointer> FilterCheckpointer::start(std::shared_ptr<ConcurrentBloomFilter> filter,
+                                                                  CheckpointConfig config) {
+        if (!filter || config.base_path.empty() || config.compact_ratio < 0.0) return nullptr;
+        if (config.log_path.empty()) config.log_path = config.base_path + ".log";
+
+        auto state = std::make_unique<detail::FilterCheckpointerState>();
+        state->filter = std::move(filter);
+        state->config = std::move(config);
+        std::unique_ptr<FilterCheckpointer> checkpointer(new FilterCheckpointer(std::move(state)));
+        {
+            std::lock_guard<std::mutex> lock(checkpointer->state_->io_mutex);
+            if (!checkpointer->rewrite_base()) return nullptr;
+        }
+        if (checkpointer->state_->config.interval_ms > 0) {
+            checkpointer->state_->thread = std::thread([raw = checkpointer.get()] { raw->run(); });
+        }
+        return checkpointer;
+    }
+
+    void FilterCheckpointer::run() {
+        detail::FilterCheckpointerState& s = *state_;
+        const auto interval = std::chrono::milliseconds(s.config.interval_ms);
+        std::unique_lock<std::mutex> lock(s.wake_mutex);
+        while (!s.wake.wait_for(lock, interval, [&s] { return s.stopping; })) {
+            lock.unlock();
+            checkpoint();
+            lock.lock();
+        }
+    }
+
+    void FilterCheckpointer::stop() {
+        detail::FilterCheckpointerState& s = *state_;
+        {
+            std::lock_guard<std::mutex> lock(s.wake_mutex);
+            s.stopping = true;
+        }
+        s.wake.notify_all();
+        if (s.thread.joinable()) s.thread.join();
+
+        std::lock_guard<std::mutex> lock(s.io_mutex);
+        if (s.log_fd < 0) return;
+        append_record();
+        close_file(s.log_fd);
+        s.log_fd = -1;
+    }
+
+    // ============================================================================
+    // Checkpoints
+    // ============================================================================
+    bool FilterCheckpointer::checkpoint() {
+        std::lock_guard<std::mutex> lock(state_->io_mutex);
+        if (state_->log_fd < 0) return false;
+        return append_record();
+    }
+
+    bool FilterCheckpointer::compact() {
+        std::lock_guard<std::mutex> lock(state_->io_mutex);
+        if (state_->log_fd < 0) return false;
+        return rewrite_base();
+    }
+
+    bool FilterCheckpointer::append_record() {
+        detail::FilterCheckpointerState& s = *state_;
+        ConcurrentBloomFilter& filter = *s.filter;
+        const Clock::time_point started = Clock::now();
+
+        // A cleared filter cannot be reached by adding blocks to the old base
+        if (filter.clear_count_.load(std::memory_order_seq_cst) != s.clear_count) {
+            return rewrite_base();
+        }
+
+        s.blocks.clear();
+        filter.take_dirty_blocks(s.blocks);
+        const size_t num_blocks = s.blocks.size();
+        if (num_blocks == 0) return true;
+
+        size_t num_words = kHeaderWords + index_words(num_blocks);
+        for (uint32_t block : s.blocks) {
+            num_words += std::min(ConcurrentBloomFilter::kDirtyBlockWords,
+                                  filter.num_words_ - block * ConcurrentBloomFilter::kDirtyBlockWords);
+        }
+        s.record.resize(num_words);
+
+        uint64_t* body = s.record.data() + kHeaderWords;
+        body[index_words(num_blocks) - 1] = 0;   // Padding after an odd block count
+        std::memcpy(body, s.blocks.data(), num_blocks * sizeof(uint32_t));
+        uint64_t* words = body + index_words(num_blocks);
+        for (uint32_t block : s.blocks) {
+            words += filter.copy_block(block, words);
+        }
+
+        RecordHeader header{};
+        header.magic = kRecordMagic;
+        header.num_blocks = static_cast<uint32_t>(num_blocks);
+        header.sequence = s.sequence + 1;
+        header.num_insertions = filter.num_insertions();
+        for (size_t i = 0; i < ConcurrentBloomFilter::kCounterShards; ++i) {
+            header.num_queries += filter.counters_[i].queries.load(std::memory_order_relaxed);
+        }
+        header.checksum = record_checksum(header, body, num_words - kHeaderWords);
+        std::memcpy(s.record.data(), &header, sizeof(header));
+
+        const size_t bytes = num_words * sizeof(uint64_t);
+        if (!write_all(s.log_fd, s.record.data(), bytes, s.config.sync)) {
+            // Drops the torn record so the next one follows the last good
+            // one; if that fails too, recover() stops at the torn bytes
+            truncate_file(s.log_fd, s.log_bytes);
+            filter.mark_blocks_dirty(s.blocks);
+            s.count_failure();
+            return false;
+        }
+        s.sequence = header.sequence;
+        s.log_bytes += bytes;
+
+        {
+            std::lock_guard<std::mutex> lock(s.stats_mutex);
+            ++s.stats.checkpoints;
+            s.stats.blocks_written += num_blocks;
+            s.stats.bytes_written += bytes;
+            s.stats.log_bytes = s.log_bytes;
+            s.stats.last_blocks = num_blocks;
+            s.stats.last_checkpoint_us =
+                std::chrono::duration<double, std::micro>(Clock::now() - started).count();
+        }
+
+        if (s.config.compact_ratio > 0.0 &&
+            static_cast<double>(s.log_bytes) > s.config.compact_ratio * static_cast<double>(s.base_bytes)) {
+            rewrite_base();   // On failure the log just keeps growing until a retry works
+        }
+        return true;
+    }
+
+    // The dirty marks are taken before the filter is read: a bit set after
+    // its block was read marks the block again for the next record.
+    bool FilterCheckpointer::rewrite_base() {
+        detail::FilterCheckpointerState& s = *state_;
+        ConcurrentBloomFilter& filter = *s.filter;
+
+        const uint64_t clear_count = filter.clear_count_.load(std::memory_order_seq_cst);
+        s.blocks.clear();
+        filter.take_dirty_blocks(s.blocks);
+
+        const std::string base_tmp = s.config.base_path + ".tmp";
+        const std::string log_tmp = s.config.log_path + ".tmp";
+        uint64_t checksum = 0;
+        bool ok = filter.save_to_file(base_tmp) && (!s.config.sync || sync_path(base_tmp)) &&
+                  (checksum = base_checksum(base_tmp)) != 0 &&
+                  std::rename(base_tmp.c_str(), s.config.base_path.c_str()) == 0;
+
+        int log_fd = -1;
+        if (ok) {
+            LogHeader header{};
+            header.magic = kLogMagic;
+            header.version = kLogVersion;
+            header.endian_tag = kEndianTag;
+            header.block_words = static_cast<uint32_t>(ConcurrentBloomFilter::kDirtyBlockWords);
+            header.num_bits = filter.num_bits_;
+            header.num_hashes = filter.num_hashes_;
+            header.layout = static_cast<uint32_t>(filter.layout_);
+            header.hash_scheme = static_cast<uint32_t>(filter.hash_scheme_);
+            header.base_checksum = checksum;
+
+            log_fd = open_log(log_tmp);
+            ok = log_fd >= 0 && write_all(log_fd, &header, sizeof(header), s.config.sync) &&
+                 std::rename(log_tmp.c_str(), s.config.log_path.c_str()) == 0;
+        }
+        if (!ok) {
+            if (log_fd >= 0) close_file(log_fd);
+            std::remove(base_tmp.c_str());
+            std::remove(log_tmp.c_str());
+            filter.mark_blocks_dirty(s.blocks);
+            s.count_failure();
+            return false;
+        }
+
+        if (s.log_fd >= 0) close_file(s.log_fd);
+        s.log_fd = log_fd;
+        s.sequence = 0;
+        s.clear_count = clear_count;
+        s.base_bytes = detail::kDataAlignment + filter.num_words_ * sizeof(uint64_t);
+        s.log_bytes = sizeof(LogHeader);
+
+        std::lock_guard<std::mutex> lock(s.stats_mutex);
+        ++s.stats.compactions;
+        s.stats.bytes_written += s.base_bytes + s.log_bytes;
+        s.stats.log_bytes = s.log_bytes;
+        return true;
+    }
+
+    // ============================================================================
+    // Accessors
+    // ============================================================================
+    const CheckpointConfig& FilterCheckpointer::config() const {
+        return state_->config;
+    }
+
+    const std::shared_ptr<ConcurrentBloomFilter>& FilterCheckpointer::filter() const {
+        return state_->filter;
+    }
+
+    FilterCheckpointer::Stats FilterCheckpointer::stats() const {
+        std::lock_guard<std::mutex> lock(state_->stats_mutex);
+        return state_->stats;
+    }
+
+    // ============================================================================
+    // Recovery
+    // ============================================================================
+    std::unique_ptr<ConcurrentBloomFilter> FilterCheckpointer::recover(const std::string& base_path,
+                                                                       const std::string& log_path) {
+        auto filter = ConcurrentBloomFilter::load_from_file(base_path);
+        if (!filter) return nullptr;
+
+        std::ifstream log(log_path.empty() ? base_path + ".log" : log_path, std::ios::binary);
+        LogHeader header{};
+        if (!log || !log.read(reinterpret_cast<char*>(&header), sizeof(header))) return filter;
+        const uint64_t checksum = base_checksum(base_path);
+        if (header.magic != kLogMagic || header.version != kLogVersion || header.endian_tag != kEndianTag ||
+            header.block_words != ConcurrentBloomFilter::kDirtyBlockWords || header.num_bits != filter->num_bits_ ||
+            header.num_hashes != filter->num_hashes_ ||
+            header.layout != static_cast<uint32_t>(filter->layout_) ||
+            header.hash_scheme != static_cast<uint32_t>(filter->hash_scheme_) ||
+            checksum == 0 || header.base_checksum != checksum) {
+            return filter;
+        }
+
+        // Records are applied whole or not at all; the first one that is
+        // short, malformed or fails its checksum ends the log
+        std::vector<uint64_t> body;
+        std::vector<uint32_t> blocks;
+        RecordHeader record{};
+        while (log.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+            if (record.magic != kRecordMagic || record.num_blocks == 0 ||
+                record.num_blocks > filter->num_dirty_blocks_) {
+                break;
+            }
+            const size_t num_blocks = record.num_blocks;
+            body.resize(index_words(num_blocks));
+            if (!log.read(reinterpret_cast<char*>(body.data()), body.size() * sizeof(uint64_t))) break;
+            blocks.resize(num_blocks);
+            std::memcpy(blocks.data(), body.data(), num_blocks * sizeof(uint32_t));
+
+            size_t num_words = 0;
+            bool valid = true;
+            for (size_t i = 0; i < num_blocks && valid; ++i) {
+                valid = blocks[i] < filter->num_dirty_blocks_ && (i == 0 || blocks[i] > blocks[i - 1]);
+                if (valid) {
+                    num_words += std::min(ConcurrentBloomFilter::kDirtyBlockWords,
+                                          filter->num_words_ - blocks[i] * ConcurrentBloomFilter::kDirtyBlockWords);
+                }
+            }
+            if (!valid) break;
+
+            const size_t first_word = body.size();
+            body.resize(first_word + num_words);
+            if (!log.read(reinterpret_cast<char*>(body.data() + first_word), num_words * sizeof(uint64_t)) ||
+                record_checksum(record, body.data(), body.size()) != record.checksum) {
+                break;
+            }
+
+            const uint64_t* words = body.data() + first_word;
+            for (uint32_t block : blocks) {
+                size_t first = block * ConcurrentBloomFilter::kDirtyBlockWords;
+                size_t n = std::min(ConcurrentBloomFilter::kDirtyBlockWords, filter->num_words_ - first);
+                filter->or_words(first, words, n);
+                words += n;
+            }
+            filter->counters_[0].insertions.store(record.num_insertions, std::memory_order_relaxed);
+            filter->counters_[0].queries.store(record.num_queries, std::memory_order_relaxed);
+        }
+        return filter;
+    }
+}
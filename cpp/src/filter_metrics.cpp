@@ -0,0 +1,157 @@
+#include "filter_metrics.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace quantamental {
+    namespace {
+        std::atomic<size_t> next_counter_shard{0};
+
+        // Per-thread countdown to the next sampled single-key call, shared by
+        // every FilterMetrics instance
+        thread_local uint32_t sample_countdown = 1;
+
+        // Beyond kCounterShards threads two may share a shard, so counts are
+        // added atomically; the line stays in the owner's cache either way
+        void bump(std::atomic<uint64_t>& counter, uint64_t n) {
+            counter.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        size_t latency_bucket(uint64_t ns) {
+            size_t bucket = std::max<size_t>(std::bit_width(ns), 1) - 1;
+            return std::min(bucket, FilterMetrics::kLatencyBuckets - 1);
+        }
+    }
+
+    // ============================================================================
+    // Latency Histogram
+    // ============================================================================
+
+    double FilterMetrics::LatencyHistogram::mean_ns() const {
+        return samples == 0 ? 0.0 : static_cast<double>(total_ns) / samples;
+    }
+
+    double FilterMetrics::LatencyHistogram::percentile_ns(double q) const {
+        if (samples == 0) return 0.0;
+
+        uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * samples));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kLatencyBuckets; ++i) {
+            seen += buckets[i];
+            if (seen >= std::max<uint64_t>(rank, 1)) {
+                return std::ldexp(1.0, static_cast<int>(i) + 1);
+            }
+        }
+        return std::ldexp(1.0, static_cast<int>(kLatencyBuckets));
+    }
+
+    // ============================================================================
+    // Scoped Timer
+    // ============================================================================
+
+    FilterMetrics::ScopedTimer::ScopedTimer(FilterMetrics& metrics, Op op)
+        : metrics_(metrics.should_sample(op) ? &metrics : nullptr), op_(op) {
+        if (metrics_ != nullptr) {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    FilterMetrics::ScopedTimer::~ScopedTimer() {
+        if (metrics_ == nullptr) return;
+
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        metrics_->record_latency(op_, static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    // ============================================================================
+    // Recording
+    // ============================================================================
+
+    FilterMetrics::FilterMetrics(uint32_t sample_every) : sample_every_(sample_every) {}
+
+    FilterMetrics::CounterShard& FilterMetrics::local_counters() {
+        // Threads are dealt shards round-robin on first use
+        thread_local size_t shard = next_counter_shard.fetch_add(1, std::memory_order_relaxed);
+        return counters_[shard % kCounterShards];
+    }
+
+    bool FilterMetrics::should_sample(Op op) const {
+        if (op == Op::Batch) return true;
+
+        uint32_t every = sample_every_.load(std::memory_order_relaxed);
+        if (every == 0 || --sample_countdown != 0) return false;
+        sample_countdown = every;
+        return true;
+    }
+
+    void FilterMetrics::count_inserts(uint64_t keys, uint64_t new_keys) {
+        CounterShard& shard = local_counters();
+        bump(shard.inserts, keys);
+        bump(shard.new_keys, new_keys);
+    }
+
+    void FilterMetrics::count_queries(uint64_t keys, uint64_t positives) {
+        CounterShard& shard = local_counters();
+        bump(shard.queries, keys);
+        bump(shard.positives, positives);
+    }
+
+    void FilterMetrics::record_latency(Op op, uint64_t ns) {
+        Histogram& histogram = histograms_[static_cast<size_t>(op)];
+        histogram.buckets[latency_bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+        histogram.samples.fetch_add(1, std::memory_order_relaxed);
+        histogram.total_ns.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    // ============================================================================
+    // Snapshot / Reset
+    // ============================================================================
+
+    // Each value is read atomically, but calls racing with the snapshot may
+    // be half counted (e.g. in queries but not yet in positives).
+    FilterMetrics::Snapshot FilterMetrics::snapshot() const {
+        Snapshot snap;
+        for (const CounterShard& shard : counters_) {
+            snap.counters.inserts += shard.inserts.load(std::memory_order_relaxed);
+            snap.counters.new_keys += shard.new_keys.load(std::memory_order_relaxed);
+            snap.counters.queries += shard.queries.load(std::memory_order_relaxed);
+            snap.counters.positives += shard.positives.load(std::memory_order_relaxed);
+        }
+
+        LatencyHistogram* out[2] = {&snap.single, &snap.batch};
+        for (size_t op = 0; op < 2; ++op) {
+            const Histogram& histogram = histograms_[op];
+            for (size_t i = 0; i < kLatencyBuckets; ++i) {
+                out[op]->buckets[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+            }
+            out[op]->samples = histogram.samples.load(std::memory_order_relaxed);
+            out[op]->total_ns = histogram.total_ns.load(std::memory_order_relaxed);
+        }
+        return snap;
+    }
+
+    void FilterMetrics::reset() {
+        for (CounterShard& shard : counters_) {
+            shard.inserts.store(0, std::memory_order_relaxed);
+            shard.new_keys.store(0, std::memory_order_relaxed);
+            shard.queries.store(0, std::memory_order_relaxed);
+            shard.positives.store(0, std::memory_order_relaxed);
+        }
+        for (Histogram& histogram : histograms_) {
+            for (auto& bucket : histogram.buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            histogram.samples.store(0, std::memory_order_relaxed);
+            histogram.total_ns.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    uint32_t FilterMetrics::sample_every() const {
+        return sample_every_.load(std::memory_order_relaxed);
+    }
+
+    void FilterMetrics::set_sample_every(uint32_t every) {
+        sample_every_.store(every, std::memory_order_relaxed);
+    }
+}
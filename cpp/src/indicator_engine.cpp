@@ -0,0 +1,151 @@
+#include "indicator_engine.hpp"
+#include "indicator_kernels.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace quantamental {
+
+    // ============================================================================
+    // Construction
+    // ============================================================================
+
+    std::optional<IndicatorEngine> IndicatorEngine::create(IndicatorConfig config) {
+        auto positive = [](int w) { return w >= 1; };
+        if (!std::all_of(config.horizons.begin(), config.horizons.end(), positive) ||
+            !std::all_of(config.sma_windows.begin(), config.sma_windows.end(), positive) ||
+            !positive(config.rsi_period) || !positive(config.macd_fast) ||
+            !positive(config.macd_slow) || !positive(config.macd_signal)) {
+            return std::nullopt;
+        }
+        return IndicatorEngine(std::move(config));
+    }
+
+    IndicatorEngine::IndicatorEngine(IndicatorConfig config) : config_(std::move(config)) {
+        for (int h : config_.horizons) columns_.push_back("return_" + std::to_string(h) + "d");
+        for (int w : config_.sma_windows) columns_.push_back("sma_" + std::to_string(w));
+        for (int w : config_.sma_windows) columns_.push_back("ema_" + std::to_string(w));
+        columns_.push_back("rsi_" + std::to_string(config_.rsi_period));
+        columns_.push_back("macd");
+        columns_.push_back("macd_signal");
+        columns_.push_back("macd_hist");
+        for (int w : config_.sma_windows) columns_.push_back("volatility_" + std::to_string(w) + "d");
+        for (int w : config_.sma_windows) {
+            columns_.push_back("volume_sma_" + std::to_string(w));
+            columns_.push_back("volume_ratio_" + std::to_string(w));
+        }
+    }
+
+    const std::vector<std::string>& IndicatorEngine::columns() const {
+        return columns_;
+    }
+
+    size_t IndicatorEngine::num_columns() const {
+        return columns_.size();
+    }
+
+    const IndicatorConfig& IndicatorEngine::config() const {
+        return config_;
+    }
+
+    // ============================================================================
+    // Compute
+    // ============================================================================
+
+    void IndicatorEngine::compute(const double* close, const double* volume, size_t n,
+                                  double* out) const {
+        detail::IndicatorPass pass(config_);
+        for (size_t t = 0; t < n; ++t) {
+            pass.step(config_, close[t], volume[t], out + t, n);
+        }
+    }
+}
+
+namespace quantamental::detail {
+
+    // ============================================================================
+    // Indicator Pass
+    // ============================================================================
+    // Bar by bar, every accumulator takes its next value; rolling windows read
+    // the leaving value back from the history ring. 1-day returns are kept
+    // there too, as the same doubles pandas' pct_change() holds.
+
+    size_t history_capacity(const IndicatorConfig& config) {
+        int lookback = 1;
+        for (int h : config.horizons) lookback = std::max(lookback, h);
+        for (int w : config.sma_windows) lookback = std::max(lookback, w);
+        return std::bit_ceil(static_cast<size_t>(lookback) + 1);
+    }
+
+    IndicatorPass::IndicatorPass(const IndicatorConfig& config)
+        : close_means(config.sma_windows.size()), volume_means(config.sma_windows.size()),
+          return_vars(config.sma_windows.size()),
+          avg_gain(config.rsi_period), avg_loss(config.rsi_period),
+          ema_fast(config.macd_fast), ema_slow(config.macd_slow), signal(config.macd_signal) {
+        for (int w : config.sma_windows) emas.emplace_back(w);
+        size_t capacity = history_capacity(config);
+        close_history.assign(capacity, kNaN);
+        volume_history.assign(capacity, kNaN);
+        return_history.assign(capacity, kNaN);
+        history_mask = capacity - 1;
+    }
+
+    void IndicatorPass::step(const IndicatorConfig& config, double c, double v,
+                             double* out, size_t stride) {
+        const std::vector<int>& horizons = config.horizons;
+        const std::vector<int>& windows = config.sma_windows;
+        const size_t num_windows = windows.size();
+        const int64_t t = num_bars;
+
+        double* returns = out;
+        double* sma = returns + horizons.size() * stride;
+        double* ema = sma + num_windows * stride;
+        double* rsi = ema + num_windows * stride;
+        double* macd = rsi + stride;
+        double* macd_signal = macd + stride;
+        double* macd_hist = macd_signal + stride;
+        double* volatility = macd_hist + stride;
+        double* volume_features = volatility + num_windows * stride;
+
+        for (size_t i = 0; i < horizons.size(); ++i) {
+            int64_t h = horizons[i];
+            returns[i * stride] = t >= h ? c / close_history[slot(t - h)] - 1.0 : kNaN;
+        }
+
+        const double r = t >= 1 ? c / close_history[slot(t - 1)] - 1.0 : kNaN;
+        for (size_t i = 0; i < num_windows; ++i) {
+            const int64_t w = windows[i];
+            const bool full = t >= w;
+            const size_t leaving = slot(t - w);
+
+            slide_window(close_means[i], w, t, c, full ? close_history[leaving] : 0.0);
+            sma[i * stride] = close_means[i].value(w);
+            ema[i * stride] = emas[i].update(c);
+
+            slide_window(return_vars[i], w, t, r, full ? return_history[leaving] : 0.0);
+            volatility[i * stride] = return_vars[i].stddev(w);
+
+            slide_window(volume_means[i], w, t, v, full ? volume_history[leaving] : 0.0);
+            double volume_sma = volume_means[i].value(w);
+            volume_features[(2 * i) * stride] = volume_sma;
+            volume_features[(2 * i + 1) * stride] = v / volume_sma;
+        }
+
+        // RSI: the first diff is NaN, which where() turns into a 0 gain and loss
+        double delta = t >= 1 ? c - close_history[slot(t - 1)] : kNaN;
+        double gain = avg_gain.update(delta > 0 ? delta : 0.0);
+        double loss = avg_loss.update(-delta > 0 ? -delta : 0.0);
+        double rs = gain / loss;
+        *rsi = 100.0 - (100.0 / (1.0 + rs));
+
+        double line = ema_fast.update(c) - ema_slow.update(c);
+        double signal_line = signal.update(line);
+        *macd = line;
+        *macd_signal = signal_line;
+        *macd_hist = line - signal_line;
+
+        close_history[slot(t)] = c;
+        volume_history[slot(t)] = v;
+        return_history[slot(t)] = r;
+        ++num_bars;
+    }
+}
@@ -0,0 +1,226 @@
+// indicator_kernels.hpp
+//
+// Online accumulators behind IndicatorEngine. Each one reproduces the
+// pandas algorithm step for step, so results match pandas to the last bit
+// rather than to a tolerance:
+//   RollingMean  Series.rolling(w).mean()   (Kahan-compensated running sum)
+//   RollingVar   Series.rolling(w).var()    (Welford with Kahan compensation)
+//   Ewm          Series.ewm(span=s, adjust=False).mean()
+// NaN inputs are skipped the way pandas skips them: a rolling window holding
+// one is NaN, and the EWM decays across the gap (ignore_na=False).
+// IndicatorPass combines them into the per-ticker state of compute_all.
+
+#ifndef INDICATOR_KERNELS_HPP
+#define INDICATOR_KERNELS_HPP
+
+#include "indicator_engine.hpp"
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace quantamental::detail {
+
+inline constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// ============================================================================
+// Rolling mean
+// ============================================================================
+// pandas keeps separate compensation terms for values entering and leaving
+// the window, and returns the repeated value itself when the whole window
+// holds one value (GH#42064).
+struct RollingMean {
+    double sum = 0.0;
+    double add_compensation = 0.0;
+    double remove_compensation = 0.0;
+    double prev_value = kNaN;
+    int64_t nobs = 0;
+    int64_t neg_ct = 0;
+    int64_t same_run = 0;
+
+    void reset() { *this = RollingMean{}; }
+
+    void add(double val) {
+        if (val != val) return;
+        ++nobs;
+        double y = val - add_compensation;
+        double t = sum + y;
+        add_compensation = t - sum - y;
+        sum = t;
+        if (std::signbit(val)) ++neg_ct;
+        same_run = val == prev_value ? same_run + 1 : 1;
+        prev_value = val;
+    }
+
+    void remove(double val) {
+        if (val != val) return;
+        --nobs;
+        double y = -val - remove_compensation;
+        double t = sum + y;
+        remove_compensation = t - sum - y;
+        sum = t;
+        if (std::signbit(val)) --neg_ct;
+    }
+
+    double value(int64_t min_periods) const {
+        if (nobs < min_periods || nobs == 0) return kNaN;
+        double result = sum / static_cast<double>(nobs);
+        if (same_run >= nobs) return prev_value;
+        if (neg_ct == 0 && result < 0) return 0.0;       // All positive
+        if (neg_ct == nobs && result > 0) return 0.0;    // All negative
+        return result;
+    }
+};
+
+// ============================================================================
+// Rolling variance
+// ============================================================================
+struct RollingVar {
+    double mean = 0.0;
+    double ssqdm = 0.0;
+    double add_compensation = 0.0;
+    double remove_compensation = 0.0;
+    double prev_value = kNaN;
+    double nobs = 0.0;
+    int64_t same_run = 0;
+
+    void reset() { *this = RollingVar{}; }
+
+    void add(double val) {
+        if (val != val) return;
+        nobs += 1.0;
+        same_run = val == prev_value ? same_run + 1 : 1;
+        prev_value = val;
+
+        double prev_mean = mean - add_compensation;
+        double y = val - add_compensation;
+        double t = y - mean;
+        add_compensation = t + mean - y;
+        mean = mean + t / nobs;
+        ssqdm = ssqdm + (val - prev_mean) * (val - mean);
+    }
+
+    void remove(double val) {
+        if (val != val) return;
+        nobs -= 1.0;
+        if (nobs == 0.0) {
+            mean = 0.0;
+            ssqdm = 0.0;
+            return;
+        }
+        double prev_mean = mean - remove_compensation;
+        double y = val - remove_compensation;
+        double t = y - mean;
+        remove_compensation = t + mean - y;
+        mean = mean - t / nobs;
+        ssqdm = ssqdm - (val - prev_mean) * (val - mean);
+    }
+
+    double variance(int64_t min_periods, int ddof = 1) const {
+        if (nobs < static_cast<double>(min_periods) || nobs <= ddof) return kNaN;
+        if (nobs == 1.0 || static_cast<double>(same_run) >= nobs) return 0.0;
+        double result = ssqdm / (nobs - ddof);
+        return result < 0 ? 0.0 : result;
+    }
+
+    double stddev(int64_t min_periods, int ddof = 1) const {
+        double var = variance(min_periods, ddof);
+        return var < 0 ? 0.0 : std::sqrt(var);
+    }
+};
+
+// Slides a fixed window of w over a series: x_in enters, x_out (the value
+// w steps back) leaves. pandas restarts the sums whenever consecutive
+// windows do not overlap, which for w == 1 is every step.
+template <typename Accumulator>
+inline void slide_window(Accumulator& acc, int64_t w, int64_t t, double x_in, double x_out) {
+    if (t >= w) {
+        if (w == 1) {
+            acc.reset();
+        } else {
+            acc.remove(x_out);
+        }
+    }
+    acc.add(x_in);
+}
+
+// ============================================================================
+// Exponentially weighted mean (adjust=False, ignore_na=False)
+// ============================================================================
+struct Ewm {
+    double alpha = 1.0;
+    double old_wt_factor = 0.0;
+    double weighted = kNaN;
+    double old_wt = 1.0;
+    bool started = false;
+
+    Ewm() = default;
+    explicit Ewm(double span) {
+        double com = (span - 1.0) / 2.0;
+        alpha = 1.0 / (1.0 + com);
+        old_wt_factor = 1.0 - alpha;
+    }
+
+    double update(double cur) {
+        if (!started) {
+            started = true;
+            weighted = cur;
+            return weighted;
+        }
+        bool is_observation = cur == cur;
+        if (weighted == weighted) {
+            old_wt *= old_wt_factor;
+            if (is_observation) {
+                // Avoid numerical errors on constant series
+                if (weighted != cur) {
+                    weighted = old_wt * weighted + alpha * cur;
+                    weighted /= (old_wt + alpha);
+                }
+                old_wt = 1.0;
+            }
+        } else if (is_observation) {
+            weighted = cur;
+        }
+        return weighted;
+    }
+};
+
+// ============================================================================
+// Indicator pass
+// ============================================================================
+// Everything compute_all carries from one bar to the next: the accumulators
+// plus the last closes, volumes and 1-day returns the rolling windows and
+// horizons still have to look back at. The history is a ring sized to a
+// power of two, so a full run and any split into appends see the same
+// values in the same order and produce the same doubles.
+// Ring slots needed to look max(window, horizon) bars back: a power of two
+// above the lookback, so bar t - lookback never shares a slot with bar t
+size_t history_capacity(const IndicatorConfig& config);
+
+struct IndicatorPass {
+    std::vector<RollingMean> close_means;
+    std::vector<RollingMean> volume_means;
+    std::vector<RollingVar> return_vars;
+    std::vector<Ewm> emas;
+    Ewm avg_gain, avg_loss;
+    Ewm ema_fast, ema_slow, signal;
+
+    std::vector<double> close_history;
+    std::vector<double> volume_history;
+    std::vector<double> return_history;
+    uint64_t history_mask = 0;
+    int64_t num_bars = 0;
+
+    explicit IndicatorPass(const IndicatorConfig& config);
+
+    // Feeds bar num_bars and writes its column c to out[c * stride]
+    void step(const IndicatorConfig& config, double close, double volume,
+              double* out, size_t stride);
+
+private:
+    size_t slot(int64_t bar) const { return static_cast<size_t>(bar) & history_mask; }
+};
+
+} // namespace quantamental::detail
+
+#endif // INDICATOR_KERNELS_HPP
@@ -0,0 +1,598 @@
+#include "indicator_engine.hpp"
+#include "indicator_kernels.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#include <immintrin.h>
+#define INDICATOR_PANEL_X86 1
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512dq")))
+#define FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
+namespace quantamental {
+    namespace {
+
+        // Tickers per tile, the unit of work. A tile's tickers advance date by
+        // date together, so each date's row of every output column is written
+        // as whole cache lines rather than one ticker's (or pack's) fragment.
+        constexpr size_t kTileTickers = 64;
+
+        // One sweep over the panel; workers take ranges of tiles
+        struct PanelTask {
+            const IndicatorConfig* config;
+            const double* close;
+            const double* volume;
+            size_t num_dates;
+            size_t num_tickers;
+            size_t num_columns;
+            double* out;
+        };
+
+        // ============================================================================
+        // Scalar Sweep
+        // ============================================================================
+        // One IndicatorPass per ticker, fed only the dates it has a bar on.
+
+        void sweep_scalar(const PanelTask& task, size_t begin, size_t end) {
+            const size_t T = task.num_tickers;
+            const size_t plane = task.num_dates * T;
+            for (size_t tile = begin; tile < end; ++tile) {
+                const size_t first = tile * kTileTickers;
+                const size_t last = std::min(first + kTileTickers, T);
+
+                std::vector<detail::IndicatorPass> passes(last - first, detail::IndicatorPass(*task.config));
+                for (size_t d = 0; d < task.num_dates; ++d) {
+                    for (size_t j = first; j < last; ++j) {
+                        const double c = task.close[d * T + j];
+                        double* out = task.out + d * T + j;
+                        if (c == c) {
+                            passes[j - first].step(*task.config, c, task.volume[d * T + j], out, plane);
+                        } else {
+                            for (size_t col = 0; col < task.num_columns; ++col) {
+                                out[col * plane] = detail::kNaN;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+#if defined(INDICATOR_PANEL_X86)
+// Packs are only passed between force-inlined functions, so the ABI note
+// GCC attaches to vector arguments does not apply (and is reported at the
+// end of the file, outside any push/pop)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+        // ============================================================================
+        // Lane Packs
+        // ============================================================================
+        // A pack holds one double per ticker. The kernels below are written once
+        // over GCC vector types and force-inlined into a target("avx2") or
+        // target("avx512f") entry point, which compiles them to one register
+        // per pack; the packs of a tile are independent, which gives the long
+        // division chains room to overlap.
+        // Each lane runs the scalar accumulator arithmetic operation for
+        // operation, branches turned into blends, so lanes produce the same
+        // doubles IndicatorPass does (the library builds with -ffp-contract=off
+        // to keep FMA out of it). Alignment is spelled out because default-target
+        // code, where the state vectors are allocated, would assume only 16.
+
+        struct Avx2Lanes {
+            static constexpr size_t N = 4;
+            typedef double D __attribute__((vector_size(32), aligned(32)));
+            typedef int64_t M __attribute__((vector_size(32), aligned(32)));
+
+            TARGET_AVX2 static inline D sqrt(D x) {
+                return (D)_mm256_sqrt_pd((__m256d)x);
+            }
+
+            template <int Predicate>
+            TARGET_AVX2 static inline M compare(D a, D b) {
+                return (M)_mm256_cmp_pd((__m256d)a, (__m256d)b, Predicate);
+            }
+        };
+
+        struct Avx512Lanes {
+            static constexpr size_t N = 8;
+            typedef double D __attribute__((vector_size(64), aligned(64)));
+            typedef int64_t M __attribute__((vector_size(64), aligned(64)));
+
+            TARGET_AVX512 static inline D sqrt(D x) {
+                return (D)_mm512_sqrt_pd((__m512d)x);
+            }
+
+            template <int Predicate>
+            TARGET_AVX512 static inline M compare(D a, D b) {
+                return (M)_mm512_movm_epi64(_mm512_cmp_pd_mask((__m512d)a, (__m512d)b, Predicate));
+            }
+        };
+
+        template <typename L>
+        struct LaneState {
+            using D = typename L::D;
+            using M = typename L::M;
+
+            struct Mean {
+                D sum, add_compensation, remove_compensation, prev_value, nobs, neg_ct, same_run;
+            };
+            struct Var {
+                D mean, ssqdm, add_compensation, remove_compensation, prev_value, nobs, same_run;
+            };
+            struct Ewm {
+                D weighted, old_wt;
+                M started;
+                double alpha, old_wt_factor;
+            };
+        };
+
+        template <typename L>
+        FORCE_INLINE typename L::D splat(double x) {
+            return typename L::D{} + x;
+        }
+
+        // Lanes of a where m is set, else of b. Spelled as bit operations: GCC
+        // scalarizes vector ?: once masks are stored or combined.
+        template <typename L>
+        FORCE_INLINE typename L::D select(typename L::M m, typename L::D a, typename L::D b) {
+            using M = typename L::M;
+            return (typename L::D)(((M)a & m) | ((M)b & ~m));
+        }
+
+        // Comparisons with C++ semantics for NaN (only != holds). Spelled with
+        // the compare intrinsics, which GCC keeps in vector registers where the
+        // operators get scalarized once masks are combined.
+        template <typename L, int Predicate>
+        FORCE_INLINE typename L::M compare(typename L::D a, typename L::D b) {
+            return L::template compare<Predicate>(a, b);
+        }
+
+        template <typename L, int Predicate>
+        FORCE_INLINE typename L::M compare(typename L::D a, double b) {
+            return L::template compare<Predicate>(a, splat<L>(b));
+        }
+
+        template <typename L, typename B> FORCE_INLINE typename L::M eq(typename L::D a, B b) { return compare<L, _CMP_EQ_OQ>(a, b); }
+        template <typename L, typename B> FORCE_INLINE typename L::M ne(typename L::D a, B b) { return compare<L, _CMP_NEQ_UQ>(a, b); }
+        template <typename L, typename B> FORCE_INLINE typename L::M lt(typename L::D a, B b) { return compare<L, _CMP_LT_OQ>(a, b); }
+        template <typename L, typename B> FORCE_INLINE typename L::M le(typename L::D a, B b) { return compare<L, _CMP_LE_OQ>(a, b); }
+        template <typename L, typename B> FORCE_INLINE typename L::M gt(typename L::D a, B b) { return compare<L, _CMP_GT_OQ>(a, b); }
+        template <typename L, typename B> FORCE_INLINE typename L::M ge(typename L::D a, B b) { return compare<L, _CMP_GE_OQ>(a, b); }
+
+        template <typename L>
+        FORCE_INLINE typename L::M is_number(typename L::D x) {
+            return compare<L, _CMP_ORD_Q>(x, x);
+        }
+
+        template <typename L>
+        FORCE_INLINE typename L::D load_lanes(const double* src, size_t valid) {
+            typename L::D v = splat<L>(detail::kNaN);
+            if (valid == L::N) {
+                std::memcpy(&v, src, sizeof(v));  // Fixed size: one vector load
+            } else {
+                std::memcpy(&v, src, valid * sizeof(double));
+            }
+            return v;
+        }
+
+        template <typename L>
+        FORCE_INLINE void store_lanes(double* dst, typename L::D v, size_t valid) {
+            if (valid == L::N) {
+                std::memcpy(dst, &v, sizeof(v));
+            } else {
+                std::memcpy(dst, &v, valid * sizeof(double));
+            }
+        }
+
+        // Reads from a ring of N-lane rows, `back` bars before each lane's own
+        // count; while every lane has seen the same number of bars (the usual
+        // case on a shared calendar) that is one vector load
+        template <typename L>
+        struct LaneHistory {
+            typename L::D bars;
+            size_t mask;
+            bool uniform;
+
+            FORCE_INLINE typename L::D operator()(const std::vector<double>& ring, int64_t back) const {
+                typename L::D x;
+                if (uniform) {
+                    size_t slot = static_cast<size_t>(static_cast<int64_t>(bars[0]) - back) & mask;
+                    std::memcpy(&x, ring.data() + slot * L::N, sizeof(x));
+                } else {
+                    for (size_t l = 0; l < L::N; ++l) {
+                        size_t slot = static_cast<size_t>(static_cast<int64_t>(bars[l]) - back) & mask;
+                        x[l] = ring[slot * L::N + l];
+                    }
+                }
+                return x;
+            }
+        };
+
+        // Writes one date's lanes of a column; lanes without a bar get NaN
+        template <typename L>
+        struct LaneOutput {
+            double* out;
+            size_t plane;
+            typename L::M present;
+            size_t valid;
+
+            FORCE_INLINE void operator()(size_t column, typename L::D value) const {
+                store_lanes<L>(out + column * plane, select<L>(present, value, splat<L>(detail::kNaN)), valid);
+            }
+        };
+
+        // ============================================================================
+        // Lane Accumulators
+        // ============================================================================
+        // detail::RollingMean / RollingVar / Ewm with a lane mask: lanes outside
+        // `on` keep their state.
+
+        template <typename L>
+        FORCE_INLINE void mean_reset(typename LaneState<L>::Mean& s, typename L::M on) {
+            using D = typename L::D;
+            const D zero{};
+            s.sum = select<L>(on, zero, s.sum);
+            s.add_compensation = select<L>(on, zero, s.add_compensation);
+            s.remove_compensation = select<L>(on, zero, s.remove_compensation);
+            s.prev_value = select<L>(on, splat<L>(detail::kNaN), s.prev_value);
+            s.nobs = select<L>(on, zero, s.nobs);
+            s.neg_ct = select<L>(on, zero, s.neg_ct);
+            s.same_run = select<L>(on, zero, s.same_run);
+        }
+
+        template <typename L>
+        FORCE_INLINE void mean_add(typename LaneState<L>::Mean& s, typename L::D val, typename L::M on) {
+            using D = typename L::D;
+            using M = typename L::M;
+            on &= is_number<L>(val);
+            D y = val - s.add_compensation;
+            D t = s.sum + y;
+            s.add_compensation = select<L>(on, t - s.sum - y, s.add_compensation);
+            s.sum = select<L>(on, t, s.sum);
+            s.nobs = select<L>(on, s.nobs + 1.0, s.nobs);
+            s.neg_ct = select<L>(on & ((M)val < 0), s.neg_ct + 1.0, s.neg_ct);
+            s.same_run = select<L>(on, select<L>(eq<L>(val, s.prev_value), s.same_run + 1.0, splat<L>(1.0)), s.same_run);
+            s.prev_value = select<L>(on, val, s.prev_value);
+        }
+
+        template <typename L>
+        FORCE_INLINE void mean_remove(typename LaneState<L>::Mean& s, typename L::D val, typename L::M on) {
+            using D = typename L::D;
+            using M = typename L::M;
+            on &= is_number<L>(val);
+            D y = -val - s.remove_compensation;
+            D t = s.sum + y;
+            s.remove_compensation = select<L>(on, t - s.sum - y, s.remove_compensation);
+            s.sum = select<L>(on, t, s.sum);
+            s.nobs = select<L>(on, s.nobs - 1.0, s.nobs);
+            s.neg_ct = select<L>(on & ((M)val < 0), s.neg_ct - 1.0, s.neg_ct);
+        }
+
+        template <typename L>
+        FORCE_INLINE typename L::D mean_value(const typename LaneState<L>::Mean& s, double min_periods) {
+            using D = typename L::D;
+            const D zero{};
+            D result = s.sum / s.nobs;
+            D value = select<L>(eq<L>(s.neg_ct, s.nobs) & gt<L>(result, 0.0), zero, result);
+            value = select<L>(eq<L>(s.neg_ct, 0.0) & lt<L>(result, 0.0), zero, value);
+            value = select<L>(ge<L>(s.same_run, s.nobs), s.prev_value, value);
+            return select<L>(lt<L>(s.nobs, min_periods) | eq<L>(s.nobs, 0.0), splat<L>(detail::kNaN), value);
+        }
+
+        template <typename L>
+        FORCE_INLINE void var_reset(typename LaneState<L>::Var& s, typename L::M on) {
+            using D = typename L::D;
+            const D zero{};
+            s.mean = select<L>(on, zero, s.mean);
+            s.ssqdm = select<L>(on, zero, s.ssqdm);
+            s.add_compensation = select<L>(on, zero, s.add_compensation);
+            s.remove_compensation = select<L>(on, zero, s.remove_compensation);
+            s.prev_value = select<L>(on, splat<L>(detail::kNaN), s.prev_value);
+            s.nobs = select<L>(on, zero, s.nobs);
+            s.same_run = select<L>(on, zero, s.same_run);
+        }
+
+        template <typename L>
+        FORCE_INLINE void var_add(typename LaneState<L>::Var& s, typename L::D val, typename L::M on) {
+            using D = typename L::D;
+            on &= is_number<L>(val);
+            D nobs = s.nobs + 1.0;
+            D prev_mean = s.mean - s.add_compensation;
+            D y = val - s.add_compensation;
+            D t = y - s.mean;
+            D add_compensation = t + s.mean - y;
+            D mean = s.mean + t / nobs;
+            D ssqdm = s.ssqdm + (val - prev_mean) * (val - mean);
+
+            s.same_run = select<L>(on, select<L>(eq<L>(val, s.prev_value), s.same_run + 1.0, splat<L>(1.0)), s.same_run);
+            s.prev_value = select<L>(on, val, s.prev_value);
+            s.nobs = select<L>(on, nobs, s.nobs);
+            s.add_compensation = select<L>(on, add_compensation, s.add_compensation);
+            s.mean = select<L>(on, mean, s.mean);
+            s.ssqdm = select<L>(on, ssqdm, s.ssqdm);
+        }
+
+        template <typename L>
+        FORCE_INLINE void var_remove(typename LaneState<L>::Var& s, typename L::D val, typename L::M on) {
+            using D = typename L::D;
+            using M = typename L::M;
+            const D zero{};
+            on &= is_number<L>(val);
+            D nobs = s.nobs - 1.0;
+            M emptied = eq<L>(nobs, 0.0);
+            D prev_mean = s.mean - s.remove_compensation;
+            D y = val - s.remove_compensation;
+            D t = y - s.mean;
+            D remove_compensation = t + s.mean - y;
+            D mean = s.mean - t / nobs;
+            D ssqdm = s.ssqdm - (val - prev_mean) * (val - mean);
+
+            s.nobs = select<L>(on, nobs, s.nobs);
+            s.remove_compensation = select<L>(on & ~emptied, remove_compensation, s.remove_compensation);
+            s.mean = select<L>(on, select<L>(emptied, zero, mean), s.mean);
+            s.ssqdm = select<L>(on, select<L>(emptied, zero, ssqdm), s.ssqdm);
+        }
+
+        // ddof = 1
+        template <typename L>
+        FORCE_INLINE typename L::D var_stddev(const typename LaneState<L>::Var& s, double min_periods) {
+            using D = typename L::D;
+            const D zero{};
+            D result = s.ssqdm / (s.nobs - 1.0);
+            D var = select<L>(lt<L>(result, 0.0), zero, result);
+            var = select<L>(eq<L>(s.nobs, 1.0) | ge<L>(s.same_run, s.nobs), zero, var);
+            var = select<L>(lt<L>(s.nobs, min_periods) | le<L>(s.nobs, 1.0), splat<L>(detail::kNaN), var);
+            return L::sqrt(var);
+        }
+
+        template <typename L>
+        FORCE_INLINE typename LaneState<L>::Ewm make_ewm(double span) {
+            detail::Ewm scalar(span);
+            typename LaneState<L>::Ewm e;
+            e.weighted = splat<L>(detail::kNaN);
+            e.old_wt = splat<L>(1.0);
+            e.started = typename L::M{};
+            e.alpha = scalar.alpha;
+            e.old_wt_factor = scalar.old_wt_factor;
+            return e;
+        }
+
+        template <typename L>
+        FORCE_INLINE typename L::D ewm_update(typename LaneState<L>::Ewm& e, typename L::D cur, typename L::M on) {
+            using D = typename L::D;
+            using M = typename L::M;
+            M observation = is_number<L>(cur);
+            M decay = on & e.started & is_number<L>(e.weighted);
+            D old_wt = select<L>(decay, e.old_wt * e.old_wt_factor, e.old_wt);
+            D mixed = (old_wt * e.weighted + e.alpha * cur) / (old_wt + e.alpha);
+
+            D weighted = select<L>(decay & observation & ne<L>(e.weighted, cur), mixed, e.weighted);
+            M restart = on & (~e.started | (~decay & observation));
+            e.weighted = select<L>(restart, cur, weighted);
+            e.old_wt = select<L>(decay & observation, splat<L>(1.0), old_wt);
+            e.started |= on;
+            return e.weighted;
+        }
+
+        // ============================================================================
+        // Lane Sweep
+        // ============================================================================
+
+        // compute_all column order (see IndicatorEngine::columns)
+        struct ColumnLayout {
+            size_t sma, ema, rsi, volatility, volume;
+
+            explicit ColumnLayout(const IndicatorConfig& config) {
+                const size_t num_windows = config.sma_windows.size();
+                sma = config.horizons.size();
+                ema = sma + num_windows;
+                rsi = ema + num_windows;
+                volatility = rsi + 4;
+                volume = volatility + num_windows;
+            }
+        };
+
+        // IndicatorPass over the N tickers of one pack, each lane counting its
+        // own bars. The history ring holds one row of N lanes per slot.
+        template <typename L>
+        struct LanePass {
+            using S = LaneState<L>;
+            using D = typename L::D;
+            using M = typename L::M;
+            static constexpr size_t N = L::N;
+
+            std::vector<typename S::Mean> close_means, volume_means;
+            std::vector<typename S::Var> return_vars;
+            std::vector<typename S::Ewm> emas;
+            typename S::Ewm avg_gain, avg_loss, ema_fast, ema_slow, signal;
+            std::vector<double> close_history, volume_history, return_history;
+            size_t mask;
+            D bars;
+            size_t first, valid;   // Tickers [first, first + valid) of the panel
+
+            FORCE_INLINE LanePass(const IndicatorConfig& config, size_t first_ticker, size_t num_valid)
+                : close_means(config.sma_windows.size()), volume_means(config.sma_windows.size()),
+                  return_vars(config.sma_windows.size()),
+                  avg_gain(make_ewm<L>(config.rsi_period)), avg_loss(make_ewm<L>(config.rsi_period)),
+                  ema_fast(make_ewm<L>(config.macd_fast)), ema_slow(make_ewm<L>(config.macd_slow)),
+                  signal(make_ewm<L>(config.macd_signal)),
+                  close_history(detail::history_capacity(config) * N),
+                  volume_history(close_history.size()), return_history(close_history.size()),
+                  mask(detail::history_capacity(config) - 1), bars{},
+                  first(first_ticker), valid(num_valid) {
+                for (size_t i = 0; i < config.sma_windows.size(); ++i) {
+                    mean_reset<L>(close_means[i], ~M{});
+                    mean_reset<L>(volume_means[i], ~M{});
+                    var_reset<L>(return_vars[i], ~M{});
+                    emas.push_back(make_ewm<L>(config.sma_windows[i]));
+                }
+            }
+
+            FORCE_INLINE void step(const PanelTask& task, const ColumnLayout& columns, size_t d) {
+                const IndicatorConfig& config = *task.config;
+                const std::vector<int>& horizons = config.horizons;
+                const std::vector<int>& windows = config.sma_windows;
+                const size_t T = task.num_tickers;
+                const D nan = splat<L>(detail::kNaN);
+                const D zero{};
+
+                const D c = load_lanes<L>(task.close + d * T + first, valid);
+                const D v = load_lanes<L>(task.volume + d * T + first, valid);
+                const M present = is_number<L>(c);
+
+                bool uniform = true;
+                for (size_t l = 1; l < N; ++l) uniform &= bars[l] == bars[0];
+                const LaneHistory<L> history{bars, mask, uniform};
+                const LaneOutput<L> emit{task.out + d * T + first, task.num_dates * T, present, valid};
+
+                for (size_t i = 0; i < horizons.size(); ++i) {
+                    const int64_t h = horizons[i];
+                    emit(i, select<L>(ge<L>(bars, static_cast<double>(h)), c / history(close_history, h) - 1.0, nan));
+                }
+
+                const D prev_close = history(close_history, 1);
+                const M started = ge<L>(bars, 1.0);
+                const D r = select<L>(started, c / prev_close - 1.0, nan);
+
+                for (size_t i = 0; i < windows.size(); ++i) {
+                    const int64_t w = windows[i];
+                    const double min_periods = static_cast<double>(w);
+                    const M full = present & ge<L>(bars, min_periods);
+                    if (w == 1) {
+                        mean_reset<L>(close_means[i], full);
+                        var_reset<L>(return_vars[i], full);
+                        mean_reset<L>(volume_means[i], full);
+                    } else {
+                        mean_remove<L>(close_means[i], history(close_history, w), full);
+                        var_remove<L>(return_vars[i], history(return_history, w), full);
+                        mean_remove<L>(volume_means[i], history(volume_history, w), full);
+                    }
+                    mean_add<L>(close_means[i], c, present);
+                    var_add<L>(return_vars[i], r, present);
+                    mean_add<L>(volume_means[i], v, present);
+
+                    emit(columns.sma + i, mean_value<L>(close_means[i], min_periods));
+                    emit(columns.ema + i, ewm_update<L>(emas[i], c, present));
+                    emit(columns.volatility + i, var_stddev<L>(return_vars[i], min_periods));
+                    D volume_sma = mean_value<L>(volume_means[i], min_periods);
+                    emit(columns.volume + 2 * i, volume_sma);
+                    emit(columns.volume + 2 * i + 1, v / volume_sma);
+                }
+
+                // RSI: the first diff is NaN, which where() turns into a 0 gain and loss
+                const D delta = select<L>(started, c - prev_close, nan);
+                D gain = ewm_update<L>(avg_gain, select<L>(gt<L>(delta, 0.0), delta, zero), present);
+                D loss = ewm_update<L>(avg_loss, select<L>(gt<L>(-delta, 0.0), -delta, zero), present);
+                D rs = gain / loss;
+                emit(columns.rsi, 100.0 - (100.0 / (1.0 + rs)));
+
+                D line = ewm_update<L>(ema_fast, c, present) - ewm_update<L>(ema_slow, c, present);
+                D signal_line = ewm_update<L>(signal, line, present);
+                emit(columns.rsi + 1, line);
+                emit(columns.rsi + 2, signal_line);
+                emit(columns.rsi + 3, line - signal_line);
+
+                // A lane without a bar writes its next slot, which nothing reads
+                // before its next bar overwrites it
+                for (size_t l = 0; l < N; ++l) {
+                    size_t slot = (static_cast<size_t>(static_cast<int64_t>(bars[l])) & mask) * N + l;
+                    close_history[slot] = c[l];
+                    volume_history[slot] = v[l];
+                    return_history[slot] = r[l];
+                }
+                bars = select<L>(present, bars + 1.0, bars);
+            }
+        };
+
+        template <typename L>
+        FORCE_INLINE void sweep_tiles(const PanelTask& task, size_t begin, size_t end) {
+            const ColumnLayout columns(*task.config);
+            for (size_t tile = begin; tile < end; ++tile) {
+                const size_t first = tile * kTileTickers;
+                const size_t last = std::min(first + kTileTickers, task.num_tickers);
+
+                std::vector<LanePass<L>> packs;
+                for (size_t j = first; j < last; j += L::N) {
+                    packs.emplace_back(*task.config, j, std::min(L::N, last - j));
+                }
+                for (size_t d = 0; d < task.num_dates; ++d) {
+                    for (LanePass<L>& pack : packs) pack.step(task, columns, d);
+                }
+            }
+        }
+
+        TARGET_AVX2 void sweep_avx2(const PanelTask& task, size_t begin, size_t end) {
+            sweep_tiles<Avx2Lanes>(task, begin, end);
+        }
+
+        TARGET_AVX512 void sweep_avx512(const PanelTask& task, size_t begin, size_t end) {
+            sweep_tiles<Avx512Lanes>(task, begin, end);
+        }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+        // ============================================================================
+        // Dispatch
+        // ============================================================================
+
+        struct PanelKernel {
+            void (*sweep)(const PanelTask&, size_t, size_t);  // Over tiles [begin, end)
+            const char* name;
+        };
+
+        PanelKernel select_kernel() {
+#if defined(INDICATOR_PANEL_X86)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")) {
+                return PanelKernel{sweep_avx512, "avx512"};
+            }
+            if (__builtin_cpu_supports("avx2")) {
+                return PanelKernel{sweep_avx2, "avx2"};
+            }
+#endif
+            return PanelKernel{sweep_scalar, "scalar"};
+        }
+
+        const PanelKernel& panel_kernel() {
+            static const PanelKernel selected = select_kernel();
+            return selected;
+        }
+    }
+
+    // ============================================================================
+    // Compute Panel
+    // ============================================================================
+
+    void IndicatorEngine::compute_panel(const double* close, const double* volume, size_t num_dates,
+                                        size_t num_tickers, double* out, size_t num_threads) const {
+        if (num_dates == 0 || num_tickers == 0) return;
+        const PanelKernel& kernel = panel_kernel();
+        const PanelTask task{&config_, close, volume, num_dates, num_tickers, num_columns(), out};
+        const size_t num_tiles = (num_tickers + kTileTickers - 1) / kTileTickers;
+
+        size_t threads = ThreadPool::resolve_threads(num_threads, num_tiles, 1);
+        if (threads <= 1) {
+            kernel.sweep(task, 0, num_tiles);
+        } else {
+            ThreadPool::shared().parallel_for(num_tiles, threads, [&](size_t begin, size_t end) {
+                kernel.sweep(task, begin, end);
+            });
+        }
+    }
+
+    const char* IndicatorEngine::panel_backend() {
+        return panel_kernel().name;
+    }
+}
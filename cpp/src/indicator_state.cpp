@@ -0,0 +1,355 @@
+#include "indicator_state.hpp"
+#include "indicator_kernels.hpp"
+#include "murmur_hash3.hpp"
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace quantamental {
+    namespace {
+        // File layout: RawHeader, then body_bytes of body. The body is the
+        // config followed by the pass, field by field in native byte order;
+        // the checksum covers all of it. The pass has a fixed size for a
+        // given config, so body_bytes is checked before the pass is read.
+        constexpr uint32_t kStateMagic = 0x444E4951;  // "QIND"
+        constexpr uint32_t kStateVersion = 1;
+        constexpr uint32_t kEndianTag = 0x01020304;
+        constexpr uint32_t kMaxConfigInts = 4096;       // Per list in the config
+        constexpr size_t kMaxConfigBytes = 2 * (4 + 4 * kMaxConfigInts) + 4 * 4;
+        constexpr size_t kChecksumChunkBytes = size_t{1} << 30;
+
+        struct RawHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t endian_tag;
+            uint32_t reserved;
+            uint64_t body_bytes;
+            uint64_t checksum;
+        };
+        static_assert(sizeof(RawHeader) == 32, "RawHeader layout is part of the file format");
+
+        // MurmurHash3 takes an int length, so bodies past a chunk are hashed
+        // a chunk at a time and the chunk digests hashed together
+        uint64_t body_checksum(const std::string& body) {
+            uint64_t hash[2];
+            if (body.size() <= kChecksumChunkBytes) {
+                MurmurHash3_x64_128(body.data(), static_cast<int>(body.size()), 0, hash);
+                return hash[0];
+            }
+            std::vector<uint64_t> digests;
+            for (size_t first = 0; first < body.size(); first += kChecksumChunkBytes) {
+                size_t n = std::min(kChecksumChunkBytes, body.size() - first);
+                MurmurHash3_x64_128(body.data() + first, static_cast<int>(n),
+                                    static_cast<uint32_t>(digests.size()), hash);
+                digests.push_back(hash[0]);
+            }
+            MurmurHash3_x64_128(digests.data(), static_cast<int>(digests.size() * sizeof(uint64_t)), 0, hash);
+            return hash[0];
+        }
+
+        // ============================================================================
+        // Field I/O
+        // ============================================================================
+
+        template <typename T>
+        void put(std::ostream& out, const T& value) {
+            out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        bool get(std::istream& in, T& value) {
+            in.read(reinterpret_cast<char*>(&value), sizeof(T));
+            return static_cast<bool>(in);
+        }
+
+        void put_ints(std::ostream& out, const std::vector<int>& values) {
+            put(out, static_cast<uint32_t>(values.size()));
+            for (int v : values) put(out, static_cast<int32_t>(v));
+        }
+
+        bool get_ints(std::istream& in, std::vector<int>& values) {
+            uint32_t size = 0;
+            if (!get(in, size) || size > kMaxConfigInts) return false;
+            values.resize(size);
+            for (int& v : values) {
+                int32_t raw = 0;
+                if (!get(in, raw)) return false;
+                v = raw;
+            }
+            return true;
+        }
+
+        void put_doubles(std::ostream& out, const std::vector<double>& values) {
+            out.write(reinterpret_cast<const char*>(values.data()),
+                      static_cast<std::streamsize>(values.size() * sizeof(double)));
+        }
+
+        bool get_doubles(std::istream& in, std::vector<double>& values) {
+            in.read(reinterpret_cast<char*>(values.data()),
+                    static_cast<std::streamsize>(values.size() * sizeof(double)));
+            return static_cast<bool>(in);
+        }
+
+        void put_mean(std::ostream& out, const detail::RollingMean& m) {
+            put(out, m.sum);
+            put(out, m.add_compensation);
+            put(out, m.remove_compensation);
+            put(out, m.prev_value);
+            put(out, m.nobs);
+            put(out, m.neg_ct);
+            put(out, m.same_run);
+        }
+
+        bool get_mean(std::istream& in, detail::RollingMean& m) {
+            return get(in, m.sum) && get(in, m.add_compensation) &&
+                   get(in, m.remove_compensation) && get(in, m.prev_value) &&
+                   get(in, m.nobs) && get(in, m.neg_ct) && get(in, m.same_run);
+        }
+
+        void put_var(std::ostream& out, const detail::RollingVar& v) {
+            put(out, v.mean);
+            put(out, v.ssqdm);
+            put(out, v.add_compensation);
+            put(out, v.remove_compensation);
+            put(out, v.prev_value);
+            put(out, v.nobs);
+            put(out, v.same_run);
+        }
+
+        bool get_var(std::istream& in, detail::RollingVar& v) {
+            return get(in, v.mean) && get(in, v.ssqdm) && get(in, v.add_compensation) &&
+                   get(in, v.remove_compensation) && get(in, v.prev_value) &&
+                   get(in, v.nobs) && get(in, v.same_run);
+        }
+
+        // alpha comes from the span in the config; only the carry is saved
+        void put_ewm(std::ostream& out, const detail::Ewm& e) {
+            put(out, e.weighted);
+            put(out, e.old_wt);
+            put(out, static_cast<uint8_t>(e.started));
+        }
+
+        bool get_ewm(std::istream& in, detail::Ewm& e) {
+            uint8_t started = 0;
+            if (!get(in, e.weighted) || !get(in, e.old_wt) || !get(in, started) || started > 1) {
+                return false;
+            }
+            e.started = started != 0;
+            return true;
+        }
+
+        // Bytes left in a seekable stream; unbounded otherwise
+        uint64_t remaining_bytes(std::istream& in) {
+            const std::streampos here = in.tellg();
+            if (here == std::streampos(-1) || !in.seekg(0, std::ios::end)) {
+                in.clear();
+                return std::numeric_limits<uint64_t>::max();
+            }
+            const std::streampos end = in.tellg();
+            in.seekg(here);
+            return static_cast<uint64_t>(end - here);
+        }
+
+        void put_config(std::ostream& out, const IndicatorConfig& config) {
+            put_ints(out, config.horizons);
+            put_ints(out, config.sma_windows);
+            put(out, static_cast<int32_t>(config.rsi_period));
+            put(out, static_cast<int32_t>(config.macd_fast));
+            put(out, static_cast<int32_t>(config.macd_slow));
+            put(out, static_cast<int32_t>(config.macd_signal));
+        }
+
+        bool get_config(std::istream& in, IndicatorConfig& config) {
+            int32_t rsi_period = 0, macd_fast = 0, macd_slow = 0, macd_signal = 0;
+            if (!get_ints(in, config.horizons) || !get_ints(in, config.sma_windows) ||
+                !get(in, rsi_period) || !get(in, macd_fast) ||
+                !get(in, macd_slow) || !get(in, macd_signal)) {
+                return false;
+            }
+            config.rsi_period = rsi_period;
+            config.macd_fast = macd_fast;
+            config.macd_slow = macd_slow;
+            config.macd_signal = macd_signal;
+            return true;
+        }
+    }
+
+    // ============================================================================
+    // Construction
+    // ============================================================================
+
+    std::optional<IndicatorState> IndicatorState::create(IndicatorConfig config) {
+        auto engine = IndicatorEngine::create(std::move(config));
+        if (!engine) return std::nullopt;
+        return IndicatorState(std::move(*engine));
+    }
+
+    IndicatorState::IndicatorState(IndicatorEngine engine)
+        : engine_(std::move(engine)),
+          pass_(std::make_unique<detail::IndicatorPass>(engine_.config())),
+          last_timestamp_(std::numeric_limits<int64_t>::min()) {}
+
+    IndicatorState::IndicatorState(IndicatorState&& other) noexcept = default;
+    IndicatorState& IndicatorState::operator=(IndicatorState&& other) noexcept = default;
+    IndicatorState::~IndicatorState() = default;
+
+    const std::vector<std::string>& IndicatorState::columns() const {
+        return engine_.columns();
+    }
+
+    size_t IndicatorState::num_columns() const {
+        return engine_.num_columns();
+    }
+
+    const IndicatorConfig& IndicatorState::config() const {
+        return engine_.config();
+    }
+
+    uint64_t IndicatorState::num_bars() const {
+        return static_cast<uint64_t>(pass_->num_bars);
+    }
+
+    std::optional<int64_t> IndicatorState::last_timestamp() const {
+        if (pass_->num_bars == 0) return std::nullopt;
+        return last_timestamp_;
+    }
+
+    // ============================================================================
+    // Append
+    // ============================================================================
+
+    bool IndicatorState::append(int64_t timestamp, double close, double volume, double* row) {
+        if (pass_->num_bars > 0 && timestamp <= last_timestamp_) return false;
+        pass_->step(engine_.config(), close, volume, row, 1);
+        last_timestamp_ = timestamp;
+        return true;
+    }
+
+    bool IndicatorState::append_batch(const int64_t* timestamps, const double* close,
+                                      const double* volume, size_t n, double* out) {
+        for (size_t t = 0; t < n; ++t) {
+            bool after_last = t > 0 ? timestamps[t] > timestamps[t - 1]
+                                    : pass_->num_bars == 0 || timestamps[0] > last_timestamp_;
+            if (!after_last) return false;
+        }
+        for (size_t t = 0; t < n; ++t) {
+            pass_->step(engine_.config(), close[t], volume[t], out + t, n);
+        }
+        if (n > 0) last_timestamp_ = timestamps[n - 1];
+        return true;
+    }
+
+    // ============================================================================
+    // Persistence
+    // ============================================================================
+
+    bool IndicatorState::save_to_file(const std::string& filepath) const {
+        std::ofstream file(filepath, std::ios::binary);
+        if (!file) return false;
+        return save_to_stream(file) && static_cast<bool>(file.flush());
+    }
+
+    std::optional<IndicatorState> IndicatorState::load_from_file(const std::string& filepath) {
+        std::ifstream file(filepath, std::ios::binary);
+        if (!file) return std::nullopt;
+        return load_from_stream(file);
+    }
+
+    std::string IndicatorState::serialize_body() const {
+        const IndicatorConfig& config = engine_.config();
+        const detail::IndicatorPass& pass = *pass_;
+
+        std::ostringstream body;
+        put_config(body, config);
+        put(body, pass.num_bars);
+        put(body, last_timestamp_);
+        put(body, static_cast<uint64_t>(pass.close_history.size()));
+        put_doubles(body, pass.close_history);
+        put_doubles(body, pass.volume_history);
+        put_doubles(body, pass.return_history);
+        for (size_t i = 0; i < config.sma_windows.size(); ++i) {
+            put_mean(body, pass.close_means[i]);
+            put_mean(body, pass.volume_means[i]);
+            put_var(body, pass.return_vars[i]);
+            put_ewm(body, pass.emas[i]);
+        }
+        for (const detail::Ewm* e : {&pass.avg_gain, &pass.avg_loss, &pass.ema_fast,
+                                     &pass.ema_slow, &pass.signal}) {
+            put_ewm(body, *e);
+        }
+        return body.str();
+    }
+
+    bool IndicatorState::save_to_stream(std::ostream& out) const {
+        const std::string bytes = serialize_body();
+        RawHeader raw{};
+        raw.magic = kStateMagic;
+        raw.version = kStateVersion;
+        raw.endian_tag = kEndianTag;
+        raw.body_bytes = bytes.size();
+        raw.checksum = body_checksum(bytes);
+        put(out, raw);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        return static_cast<bool>(out);
+    }
+
+    std::optional<IndicatorState> IndicatorState::load_from_stream(std::istream& in) {
+        RawHeader raw{};
+        if (!get(in, raw) || raw.magic != kStateMagic || raw.version != kStateVersion ||
+            raw.endian_tag != kEndianTag) {
+            return std::nullopt;
+        }
+
+        // Read no more than the largest config, build an empty state from it
+        // and require body_bytes to be that state's size before reading on
+        std::string bytes(std::min<uint64_t>(raw.body_bytes, kMaxConfigBytes), '\0');
+        in.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!in) return std::nullopt;
+
+        std::istringstream body(bytes);
+        IndicatorConfig config;
+        if (!get_config(body, config)) return std::nullopt;
+        const std::streampos pass_start = body.tellg();
+
+        // The rings alone take 3 * capacity doubles, so a config can only
+        // allocate what body_bytes claims and a seekable stream holds
+        if (raw.body_bytes / (3 * sizeof(double)) < detail::history_capacity(config) ||
+            raw.body_bytes - bytes.size() > remaining_bytes(in)) {
+            return std::nullopt;
+        }
+
+        auto state = create(std::move(config));
+        if (!state || raw.body_bytes != state->serialize_body().size()) return std::nullopt;
+
+        size_t prefix = bytes.size();
+        bytes.resize(raw.body_bytes);
+        in.read(bytes.data() + prefix, static_cast<std::streamsize>(bytes.size() - prefix));
+        if (!in || body_checksum(bytes) != raw.checksum) return std::nullopt;
+        body.str(bytes);
+        body.clear();
+        body.seekg(pass_start);
+
+        // The ring size follows from the config; a mismatch means another layout
+        detail::IndicatorPass& pass = *state->pass_;
+        uint64_t capacity = 0;
+        if (!get(body, pass.num_bars) || !get(body, state->last_timestamp_) ||
+            !get(body, capacity) || pass.num_bars < 0 || capacity != pass.close_history.size() ||
+            !get_doubles(body, pass.close_history) || !get_doubles(body, pass.volume_history) ||
+            !get_doubles(body, pass.return_history)) {
+            return std::nullopt;
+        }
+        for (size_t i = 0; i < state->config().sma_windows.size(); ++i) {
+            if (!get_mean(body, pass.close_means[i]) || !get_mean(body, pass.volume_means[i]) ||
+                !get_var(body, pass.return_vars[i]) || !get_ewm(body, pass.emas[i])) {
+                return std::nullopt;
+            }
+        }
+        for (detail::Ewm* e : {&pass.avg_gain, &pass.avg_loss, &pass.ema_fast,
+                               &pass.ema_slow, &pass.signal}) {
+            if (!get_ewm(body, *e)) return std::nullopt;
+        }
+        if (body.peek() != std::char_traits<char>::eof()) return std::nullopt;
+        return state;
+    }
+}
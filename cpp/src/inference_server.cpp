@@ -0,0 +1,791 @@
+#include "inference_server.hpp"
+#include "feature_cache.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace quantamental {
+    namespace {
+        namespace protocol = inference_protocol;
+        using Clock = std::chrono::steady_clock;
+
+        constexpr size_t kInboxBytes = 64 * 1024;
+        constexpr uint32_t kMaxFrameFeatures = 1 << 16;   // Larger frames drop the connection
+        constexpr size_t kMaxOutboxBytes = 4 << 20;       // A client this far behind is dropped
+
+        // ============================================================================
+        // Log-Linear Latency Histogram
+        // ============================================================================
+        // Exact below 16 ns, then 8 buckets per power of two, so a bucket's
+        // upper edge overstates the samples in it by at most 1/8. Written by
+        // one thread (plain load and store, as in FilterMetrics) and read
+        // by stats().
+        constexpr size_t kExactBuckets = 16;
+        constexpr size_t kSubBuckets = 8;
+        constexpr size_t kMaxExponent = 47;   // ~39 hours
+        constexpr size_t kHistogramBuckets = kExactBuckets + (kMaxExponent - 3) * kSubBuckets;
+
+        size_t histogram_bucket(uint64_t ns) {
+            if (ns < kExactBuckets) return static_cast<size_t>(ns);
+            size_t exponent = std::bit_width(ns) - 1;
+            if (exponent > kMaxExponent) return kHistogramBuckets - 1;
+            size_t sub = (ns >> (exponent - 3)) & (kSubBuckets - 1);
+            return kExactBuckets + (exponent - 4) * kSubBuckets + sub;
+        }
+
+        // Exclusive upper edge of a bucket, in ns
+        double bucket_upper_ns(size_t bucket) {
+            if (bucket < kExactBuckets) return static_cast<double>(bucket + 1);
+            size_t exponent = 4 + (bucket - kExactBuckets) / kSubBuckets;
+            size_t sub = (bucket - kExactBuckets) % kSubBuckets;
+            return std::ldexp(static_cast<double>(kSubBuckets + sub + 1), static_cast<int>(exponent) - 3);
+        }
+
+        void bump(std::atomic<uint64_t>& counter, uint64_t n) {
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        struct LatencyHistogram {
+            std::array<std::atomic<uint64_t>, kHistogramBuckets> buckets{};
+            std::atomic<uint64_t> samples{0};
+            std::atomic<uint64_t> total_ns{0};
+            std::atomic<uint64_t> max_ns{0};
+
+            void record(uint64_t ns) {
+                bump(buckets[histogram_bucket(ns)], 1);
+                bump(samples, 1);
+                bump(total_ns, ns);
+                if (ns > max_ns.load(std::memory_order_relaxed)) max_ns.store(ns, std::memory_order_relaxed);
+            }
+
+            void reset() {
+                for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+                samples.store(0, std::memory_order_relaxed);
+                total_ns.store(0, std::memory_order_relaxed);
+                max_ns.store(0, std::memory_order_relaxed);
+            }
+        };
+
+        // Merges per-worker histograms into one summary, in microseconds
+        template <typename Histograms>
+        InferenceServer::LatencySummary summarize(const Histograms& histograms) {
+            std::array<uint64_t, kHistogramBuckets> merged{};
+            InferenceServer::LatencySummary summary;
+            uint64_t total_ns = 0;
+            uint64_t max_ns = 0;
+            for (const LatencyHistogram* histogram : histograms) {
+                for (size_t b = 0; b < kHistogramBuckets; ++b) {
+                    merged[b] += histogram->buckets[b].load(std::memory_order_relaxed);
+                }
+                summary.samples += histogram->samples.load(std::memory_order_relaxed);
+                total_ns += histogram->total_ns.load(std::memory_order_relaxed);
+                max_ns = std::max(max_ns, histogram->max_ns.load(std::memory_order_relaxed));
+            }
+            if (summary.samples == 0) return summary;
+
+            auto percentile_us = [&](double q) {
+                uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(q * summary.samples)), 1);
+                uint64_t seen = 0;
+                for (size_t b = 0; b < kHistogramBuckets; ++b) {
+                    seen += merged[b];
+                    if (seen >= rank) return bucket_upper_ns(b) / 1e3;
+                }
+                return bucket_upper_ns(kHistogramBuckets - 1) / 1e3;
+            };
+            summary.mean_us = static_cast<double>(total_ns) / summary.samples / 1e3;
+            summary.max_us = static_cast<double>(max_ns) / 1e3;
+            summary.p50_us = std::min(percentile_us(0.50), summary.max_us);
+            summary.p99_us = std::min(percentile_us(0.99), summary.max_us);
+            return summary;
+        }
+
+        uint64_t elapsed_ns(Clock::time_point from, Clock::time_point to) {
+            return static_cast<uint64_t>(std::max<int64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count(), 0));
+        }
+
+        uint32_t saturate_us(uint64_t ns) {
+            return static_cast<uint32_t>(std::min<uint64_t>(ns / 1000, UINT32_MAX));
+        }
+    }
+
+    namespace detail {
+        // ============================================================================
+        // Server State
+        // ============================================================================
+
+        // A client socket. Only the I/O thread reads it; responses are written
+        // from the I/O and worker threads under write_mutex, and what the
+        // socket does not take at once waits in the outbox for the I/O thread
+        // to drain. The descriptor is closed once neither the I/O thread nor a
+        // queued request holds it.
+        struct Connection {
+            int fd;
+            std::mutex write_mutex;
+            bool broken = false;                   // Guarded by write_mutex
+            std::vector<char> outbox;              // Guarded by write_mutex
+            std::vector<char> inbox = std::vector<char>(kInboxBytes);
+            size_t inbox_bytes = 0;
+
+            explicit Connection(int socket_fd) : fd(socket_fd) {}
+            ~Connection();
+        };
+
+        // A queued request; its features live in the state's slot_features
+        struct RequestSlot {
+            std::shared_ptr<Connection> connection;
+            uint64_t request_id = 0;
+            uint32_t ticker = 0;
+            protocol::RequestKind kind = protocol::RequestKind::Score;
+            Clock::time_point arrival;
+        };
+
+        struct alignas(64) Worker {
+            MlpEngine engine;
+            std::vector<float> inputs;            // max_batch x input_dim staging rows
+            std::vector<float> outputs;           // max_batch x output_dim
+            std::vector<uint32_t> batch;          // Slot indices being scored
+            std::vector<uint8_t> cached;          // Per batch row: features found
+            std::vector<char> response;
+            std::atomic<uint64_t> requests{0};
+            std::atomic<uint64_t> batches{0};
+            LatencyHistogram queue_latency;
+            LatencyHistogram compute_latency;
+
+            Worker(const MlpModel& model, size_t max_batch)
+                : engine(model, 1), inputs(max_batch * model.input_dim()),
+                  outputs(max_batch * model.output_dim()), cached(max_batch),
+                  response(sizeof(protocol::ResponseHeader) + model.output_dim() * sizeof(float)) {
+                batch.reserve(max_batch);
+            }
+        };
+
+        struct InferenceServerState {
+            MlpModel model;
+            InferenceServerConfig config;
+            std::optional<FeatureCache> cache;
+            size_t input_dim;
+            size_t output_dim;
+
+            int listen_fd = -1;
+            int wake_fds[2] = {-1, -1};   // Written by stop() to end the I/O loop
+            int flush_fds[2] = {-1, -1};  // Written when a worker leaves bytes in an outbox
+            std::vector<int> cpus;        // Pin targets; empty when not pinning
+            std::thread io_thread;
+            std::vector<std::thread> worker_threads;
+            std::vector<std::unique_ptr<Worker>> workers;
+
+            // Request slots, their features, and the queue and free list of
+            // slot indices; the queue is a ring in arrival order
+            std::vector<RequestSlot> slots;
+            std::vector<float> slot_features;
+            std::mutex mutex;
+            std::condition_variable ready;
+            std::vector<uint32_t> queue;
+            size_t queue_head = 0;
+            size_t queue_size = 0;
+            std::vector<uint32_t> free_slots;
+            bool stopping = false;        // Guarded by mutex
+            bool stopped = false;
+
+            // Written by the I/O thread only
+            std::atomic<uint64_t> rejected{0};
+            std::atomic<uint64_t> bad_requests{0};
+            std::atomic<uint64_t> connections{0};
+            std::vector<char> io_response = std::vector<char>(sizeof(protocol::ResponseHeader));
+
+            InferenceServerState(MlpModel server_model, InferenceServerConfig server_config)
+                : model(std::move(server_model)), config(std::move(server_config)),
+                  input_dim(model.input_dim()), output_dim(model.output_dim()) {}
+        };
+    }
+
+    namespace {
+        using detail::Connection;
+        using detail::InferenceServerState;
+        using detail::RequestSlot;
+        using detail::Worker;
+
+        // ============================================================================
+        // Sockets
+        // ============================================================================
+#if !defined(_WIN32)
+#if defined(MSG_NOSIGNAL)
+        constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+        constexpr int kSendFlags = 0;   // SO_NOSIGPIPE is set per socket instead
+#endif
+
+        // Listening socket at path, replacing a stale socket file (but no
+        // other kind of file); -1 on failure
+        int open_listener(const std::string& path) {
+            sockaddr_un address{};
+            if (path.empty() || path.size() >= sizeof(address.sun_path)) return -1;
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, path.data(), path.size());
+
+            struct stat st;
+            if (::lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) ::unlink(path.c_str());
+
+            int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0) return -1;
+            ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+            if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+                ::listen(fd, SOMAXCONN) != 0 || ::fcntl(fd, F_SETFL, O_NONBLOCK) != 0) {
+                ::close(fd);
+                return -1;
+            }
+            return fd;
+        }
+
+        // Client sockets are non-blocking: no thread ever waits on a slow reader
+        std::shared_ptr<Connection> accept_connection(int listen_fd) {
+            int fd = ::accept(listen_fd, nullptr, nullptr);
+            if (fd < 0) return nullptr;
+            ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+            if (::fcntl(fd, F_SETFL, O_NONBLOCK) != 0) {
+                ::close(fd);
+                return nullptr;
+            }
+#if defined(SO_NOSIGPIPE)
+            int on = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+            return std::make_shared<Connection>(fd);
+        }
+
+        // Marks the connection broken and shuts it down, which the I/O thread
+        // sees as a hangup. Caller holds write_mutex.
+        void break_connection(Connection& connection) {
+            connection.broken = true;
+            connection.outbox.clear();
+            ::shutdown(connection.fd, SHUT_RDWR);
+        }
+
+        // Sends what the socket takes without blocking; the number of bytes
+        // sent, or nothing once the connection is broken. Caller holds
+        // write_mutex.
+        std::optional<size_t> send_some(Connection& connection, const char* data, size_t bytes) {
+            size_t total = 0;
+            while (total < bytes) {
+                ssize_t sent = ::send(connection.fd, data + total, bytes - total, kSendFlags);
+                if (sent < 0 && errno == EINTR) continue;
+                if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                if (sent <= 0) {
+                    break_connection(connection);
+                    return std::nullopt;
+                }
+                total += static_cast<size_t>(sent);
+            }
+            return total;
+        }
+
+        // Sends the outbox's head; false once the connection is broken
+        bool flush_outbox(Connection& connection) {
+            std::lock_guard<std::mutex> lock(connection.write_mutex);
+            if (connection.broken) return false;
+            auto sent = send_some(connection, connection.outbox.data(), connection.outbox.size());
+            if (!sent) return false;
+            connection.outbox.erase(connection.outbox.begin(), connection.outbox.begin() + *sent);
+            return true;
+        }
+
+        bool has_output(Connection& connection) {
+            std::lock_guard<std::mutex> lock(connection.write_mutex);
+            return !connection.outbox.empty();
+        }
+
+        // Sends one response, or queues what the socket will not take yet
+        // behind what is already queued, and wakes the I/O thread to drain
+        // it. A client more than kMaxOutboxBytes behind is dropped.
+        void send_response(InferenceServerState& state, Connection& connection, const char* data,
+                           size_t bytes) {
+            {
+                std::lock_guard<std::mutex> lock(connection.write_mutex);
+                if (connection.broken) return;
+                if (connection.outbox.empty()) {
+                    auto sent = send_some(connection, data, bytes);
+                    if (!sent || *sent == bytes) return;
+                    data += *sent;
+                    bytes -= *sent;
+                }
+                if (connection.outbox.size() + bytes > kMaxOutboxBytes) {
+                    break_connection(connection);
+                    return;
+                }
+                connection.outbox.insert(connection.outbox.end(), data, data + bytes);
+            }
+            // A full pipe already has the I/O thread's attention
+            char byte = 1;
+            while (::write(state.flush_fds[1], &byte, 1) < 0 && errno == EINTR) {}
+        }
+
+        void close_fd(int& fd) {
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+#else
+        void send_response(InferenceServerState&, Connection&, const char*, size_t) {}
+
+        void close_fd(int& fd) {
+            fd = -1;
+        }
+#endif
+
+        // Response without outputs (any status but Ok), from the I/O thread
+        void reply_status(InferenceServerState& state, Connection& connection, uint64_t request_id,
+                          protocol::Status status) {
+            protocol::ResponseHeader header{};
+            header.magic = protocol::kResponseMagic;
+            header.status = static_cast<uint16_t>(status);
+            header.request_id = request_id;
+            std::memcpy(state.io_response.data(), &header, sizeof(header));
+            send_response(state, connection, state.io_response.data(), sizeof(header));
+        }
+
+        // ============================================================================
+        // CPU Pinning
+        // ============================================================================
+
+        std::vector<int> allowed_cpus() {
+            std::vector<int> cpus;
+#if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+                for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                    if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+                }
+            }
+#endif
+            return cpus;
+        }
+
+        // The I/O thread takes the first allowed CPU and workers the ones
+        // after it, wrapping when there are more threads than CPUs
+        void pin_thread(const std::vector<int>& cpus, size_t index) {
+#if defined(__linux__)
+            if (cpus.empty()) return;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpus[index % cpus.size()], &set);
+            ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+#else
+            (void)cpus;
+            (void)index;
+#endif
+        }
+
+        // ============================================================================
+        // Request Intake (I/O thread)
+        // ============================================================================
+
+        // Validates one frame and queues it, or answers it at once. The
+        // caller has checked the header's magic and version and that the
+        // whole payload is buffered.
+        void handle_frame(InferenceServerState& state, const std::shared_ptr<Connection>& connection,
+                          const protocol::RequestHeader& header, const char* payload) {
+            const auto kind = static_cast<protocol::RequestKind>(header.kind);
+            bool valid = false;
+            if (kind == protocol::RequestKind::Score) {
+                valid = header.num_features == state.input_dim;
+            } else if (kind == protocol::RequestKind::ScoreCached) {
+                valid = header.num_features == 0 && state.cache && header.ticker < state.cache->num_rows();
+            }
+            if (!valid) {
+                bump(state.bad_requests, 1);
+                reply_status(state, *connection, header.request_id, protocol::Status::BadRequest);
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(state.mutex);
+            if (state.free_slots.empty()) {
+                lock.unlock();
+                bump(state.rejected, 1);
+                reply_status(state, *connection, header.request_id, protocol::Status::Busy);
+                return;
+            }
+            uint32_t index = state.free_slots.back();
+            state.free_slots.pop_back();
+
+            RequestSlot& slot = state.slots[index];
+            slot.connection = connection;
+            slot.request_id = header.request_id;
+            slot.ticker = header.ticker;
+            slot.kind = kind;
+            slot.arrival = Clock::now();
+            if (kind == protocol::RequestKind::Score) {
+                std::memcpy(state.slot_features.data() + index * state.input_dim, payload,
+                            state.input_dim * sizeof(float));
+            }
+
+            const size_t capacity = state.queue.size();
+            state.queue[(state.queue_head + state.queue_size) % capacity] = index;
+            ++state.queue_size;
+            // A worker only needs waking to start a deadline or dispatch a
+            // full batch; in between it is already waiting on the deadline
+            bool wake = state.queue_size == 1 || state.queue_size % state.config.max_batch == 0;
+            lock.unlock();
+            if (wake) state.ready.notify_one();
+        }
+
+#if !defined(_WIN32)
+        // Reads what the socket has and handles every complete frame; false
+        // when the connection should be dropped (hangup, error, bad framing)
+        bool read_connection(InferenceServerState& state, const std::shared_ptr<Connection>& connection) {
+            Connection& conn = *connection;
+            for (;;) {
+                if (conn.inbox_bytes == conn.inbox.size()) conn.inbox.resize(2 * conn.inbox.size());
+                ssize_t received = ::recv(conn.fd, conn.inbox.data() + conn.inbox_bytes,
+                                          conn.inbox.size() - conn.inbox_bytes, MSG_DONTWAIT);
+                if (received == 0) return false;
+                if (received < 0) {
+                    if (errno == EINTR) continue;
+                    return errno == EAGAIN || errno == EWOULDBLOCK;
+                }
+                conn.inbox_bytes += static_cast<size_t>(received);
+
+                size_t offset = 0;
+                while (conn.inbox_bytes - offset >= sizeof(protocol::RequestHeader)) {
+                    protocol::RequestHeader header;
+                    std::memcpy(&header, conn.inbox.data() + offset, sizeof(header));
+                    if (header.magic != protocol::kRequestMagic || header.version != protocol::kVersion ||
+                        header.num_features > kMaxFrameFeatures) {
+                        bump(state.bad_requests, 1);
+                        return false;   // No way to find the next frame
+                    }
+                    size_t frame_bytes = sizeof(header) + header.num_features * sizeof(float);
+                    if (conn.inbox_bytes - offset < frame_bytes) break;
+                    handle_frame(state, connection, header, conn.inbox.data() + offset + sizeof(header));
+                    offset += frame_bytes;
+                }
+                std::memmove(conn.inbox.data(), conn.inbox.data() + offset, conn.inbox_bytes - offset);
+                conn.inbox_bytes -= offset;
+            }
+        }
+
+        // Polls the wake pipe, the listener, the flush pipe and every client
+        // until stop(); clients with queued output are polled for writing too
+        void io_loop(InferenceServerState& state) {
+            if (!state.cpus.empty()) pin_thread(state.cpus, 0);
+
+            constexpr size_t kFirstClient = 3;
+            std::vector<pollfd> fds{{state.wake_fds[0], POLLIN, 0}, {state.listen_fd, POLLIN, 0},
+                                    {state.flush_fds[0], POLLIN, 0}};
+            std::vector<std::shared_ptr<Connection>> clients;   // clients[i] polls at fds[i + kFirstClient]
+            char drain[256];
+            for (;;) {
+                for (size_t i = 0; i < clients.size(); ++i) {
+                    fds[i + kFirstClient].events = has_output(*clients[i]) ? POLLIN | POLLOUT : POLLIN;
+                }
+                if (::poll(fds.data(), fds.size(), -1) < 0) {
+                    if (errno == EINTR) continue;
+                    return;
+                }
+                if (fds[0].revents != 0) return;
+                // Emptied before the outboxes are looked at, so a later
+                // worker's byte is never lost
+                if (fds[2].revents != 0) {
+                    while (::read(state.flush_fds[0], drain, sizeof(drain)) > 0) {}
+                }
+
+                for (size_t i = clients.size(); i-- > 0;) {
+                    const short revents = fds[i + kFirstClient].revents;
+                    if (revents == 0) continue;
+                    bool keep = true;
+                    if (revents & POLLOUT) keep = flush_outbox(*clients[i]);
+                    if (keep && (revents & ~POLLOUT)) keep = read_connection(state, clients[i]);
+                    if (keep) continue;
+                    ::shutdown(clients[i]->fd, SHUT_RDWR);
+                    clients[i] = std::move(clients.back());
+                    clients.pop_back();
+                    fds[i + kFirstClient] = fds.back();
+                    fds.pop_back();
+                }
+
+                if (fds[1].revents != 0) {
+                    while (auto connection = accept_connection(state.listen_fd)) {
+                        fds.push_back({connection->fd, POLLIN, 0});
+                        clients.push_back(std::move(connection));
+                        bump(state.connections, 1);
+                    }
+                }
+            }
+        }
+#else
+        void io_loop(InferenceServerState&) {}
+#endif
+
+        // ============================================================================
+        // Batching and Scoring (worker threads)
+        // ============================================================================
+
+        // Gathers a batch's features, runs one forward pass and answers each
+        // request. queue_us runs from arrival to the start of the gather.
+        void score_batch(InferenceServerState& state, Worker& worker) {
+            const size_t rows = worker.batch.size();
+            const size_t dim = state.input_dim;
+            const Clock::time_point start = Clock::now();
+
+            for (size_t r = 0; r < rows; ++r) {
+                const uint32_t index = worker.batch[r];
+                const RequestSlot& slot = state.slots[index];
+                float* row = worker.inputs.data() + r * dim;
+                if (slot.kind == protocol::RequestKind::Score) {
+                    std::memcpy(row, state.slot_features.data() + index * dim, dim * sizeof(float));
+                    worker.cached[r] = 1;
+                } else {
+                    worker.cached[r] = state.cache->read(slot.ticker, row);
+                    if (!worker.cached[r]) std::fill_n(row, dim, 0.0f);
+                }
+            }
+            worker.engine.predict(worker.inputs.data(), rows, worker.outputs.data());
+            const uint64_t compute_ns = elapsed_ns(start, Clock::now());
+
+            protocol::ResponseHeader header{};
+            header.magic = protocol::kResponseMagic;
+            header.compute_us = saturate_us(compute_ns);
+            for (size_t r = 0; r < rows; ++r) {
+                const RequestSlot& slot = state.slots[worker.batch[r]];
+                const uint64_t queue_ns = elapsed_ns(slot.arrival, start);
+                worker.queue_latency.record(queue_ns);
+                worker.compute_latency.record(compute_ns);
+
+                const bool ok = worker.cached[r] != 0;
+                header.status = static_cast<uint16_t>(ok ? protocol::Status::Ok : protocol::Status::NotCached);
+                header.num_outputs = ok ? static_cast<uint16_t>(state.output_dim) : 0;
+                header.request_id = slot.request_id;
+                header.queue_us = saturate_us(queue_ns);
+                std::memcpy(worker.response.data(), &header, sizeof(header));
+                size_t bytes = sizeof(header);
+                if (ok) {
+                    std::memcpy(worker.response.data() + bytes, worker.outputs.data() + r * state.output_dim,
+                                state.output_dim * sizeof(float));
+                    bytes += state.output_dim * sizeof(float);
+                }
+                send_response(state, *slot.connection, worker.response.data(), bytes);
+            }
+            bump(worker.requests, rows);
+            bump(worker.batches, 1);
+        }
+
+        // Dispatches the queue head once max_batch requests wait or the
+        // oldest has waited max_wait_us since it arrived. The wait is counted
+        // from arrival, not from when a worker came free, so time a request
+        // spent queued behind a busy pool comes out of its wait budget.
+        // When stopping, whatever is queued goes at once.
+        void worker_loop(InferenceServerState& state, size_t worker_index) {
+            if (!state.cpus.empty()) pin_thread(state.cpus, worker_index + 1);
+
+            Worker& worker = *state.workers[worker_index];
+            const size_t capacity = state.queue.size();
+            const size_t max_batch = state.config.max_batch;
+            const auto max_wait = std::chrono::microseconds(state.config.max_wait_us);
+
+            std::unique_lock<std::mutex> lock(state.mutex);
+            for (;;) {
+                if (state.queue_size == 0) {
+                    if (state.stopping) return;
+                    state.ready.wait(lock);
+                    continue;
+                }
+                const Clock::time_point deadline = state.slots[state.queue[state.queue_head]].arrival + max_wait;
+                if (state.queue_size < max_batch && !state.stopping && Clock::now() < deadline) {
+                    state.ready.wait_until(lock, deadline);
+                    continue;
+                }
+
+                const size_t take = std::min(state.queue_size, max_batch);
+                worker.batch.clear();
+                for (size_t i = 0; i < take; ++i) {
+                    worker.batch.push_back(state.queue[(state.queue_head + i) % capacity]);
+                }
+                state.queue_head = (state.queue_head + take) % capacity;
+                state.queue_size -= take;
+                // What is left is another worker's to time
+                if (state.queue_size > 0) state.ready.notify_one();
+                lock.unlock();
+
+                score_batch(state, worker);
+                for (uint32_t index : worker.batch) state.slots[index].connection.reset();
+
+                lock.lock();
+                state.free_slots.insert(state.free_slots.end(), worker.batch.begin(), worker.batch.end());
+            }
+        }
+    }
+
+    detail::Connection::~Connection() {
+        close_fd(fd);
+    }
+
+    // ============================================================================
+    // Lifecycle
+    // ============================================================================
+
+    std::unique_ptr<InferenceServer> InferenceServer::start(MlpModel model, InferenceServerConfig config) {
+#if defined(_WIN32)
+        (void)model;
+        (void)config;
+        return nullptr;
+#else
+        if (config.max_batch == 0 || config.num_workers == 0 || config.queue_capacity == 0 ||
+            config.queue_capacity > UINT32_MAX || model.output_dim() > UINT16_MAX) {
+            return nullptr;
+        }
+
+        auto state = std::make_unique<InferenceServerState>(std::move(model), std::move(config));
+        InferenceServerState& s = *state;
+        if (!s.config.feature_cache_path.empty()) {
+            s.cache = FeatureCache::open(s.config.feature_cache_path);
+            if (!s.cache || s.cache->dim() != s.input_dim) return nullptr;
+        }
+
+        const size_t capacity = s.config.queue_capacity;
+        s.slots.resize(capacity);
+        s.slot_features.resize(capacity * s.input_dim);
+        s.queue.resize(capacity);
+        s.free_slots.reserve(capacity);
+        for (size_t i = capacity; i-- > 0;) s.free_slots.push_back(static_cast<uint32_t>(i));
+        for (size_t w = 0; w < s.config.num_workers; ++w) {
+            s.workers.push_back(std::make_unique<Worker>(s.model, s.config.max_batch));
+        }
+        if (s.config.pin_workers) s.cpus = allowed_cpus();
+
+        s.listen_fd = open_listener(s.config.socket_path);
+        if (s.listen_fd < 0) return nullptr;
+        if (::pipe(s.wake_fds) != 0) {
+            close_fd(s.listen_fd);
+            s.wake_fds[0] = s.wake_fds[1] = -1;
+            return nullptr;
+        }
+        if (::pipe(s.flush_fds) != 0) {
+            close_fd(s.listen_fd);
+            close_fd(s.wake_fds[0]);
+            close_fd(s.wake_fds[1]);
+            s.flush_fds[0] = s.flush_fds[1] = -1;
+            return nullptr;
+        }
+        for (int fd : {s.wake_fds[0], s.wake_fds[1], s.flush_fds[0], s.flush_fds[1]}) {
+            ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+        // Neither end of the flush pipe may block: a full pipe is already a wake-up
+        ::fcntl(s.flush_fds[0], F_SETFL, O_NONBLOCK);
+        ::fcntl(s.flush_fds[1], F_SETFL, O_NONBLOCK);
+
+        for (size_t w = 0; w < s.config.num_workers; ++w) {
+            s.worker_threads.emplace_back([&s, w] { worker_loop(s, w); });
+        }
+        s.io_thread = std::thread([&s] { io_loop(s); });
+        return std::unique_ptr<InferenceServer>(new InferenceServer(std::move(state)));
+#endif
+    }
+
+    InferenceServer::InferenceServer(std::unique_ptr<detail::InferenceServerState> state)
+        : state_(std::move(state)) {}
+
+    InferenceServer::~InferenceServer() {
+        stop();
+    }
+
+    // New requests stop first: the I/O thread exits, dropping its hold on the
+    // connections; workers then drain the queue and answer on the
+    // connections their requests still hold. With the I/O thread gone,
+    // those answers get only what each socket buffer takes.
+    void InferenceServer::stop() {
+        InferenceServerState& s = *state_;
+        if (s.stopped) return;
+        s.stopped = true;
+
+#if !defined(_WIN32)
+        char byte = 1;
+        while (::write(s.wake_fds[1], &byte, 1) < 0 && errno == EINTR) {}
+#endif
+        if (s.io_thread.joinable()) s.io_thread.join();
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            s.stopping = true;
+        }
+        s.ready.notify_all();
+        for (auto& thread : s.worker_threads) thread.join();
+
+        close_fd(s.listen_fd);
+        close_fd(s.wake_fds[0]);
+        close_fd(s.wake_fds[1]);
+        close_fd(s.flush_fds[0]);
+        close_fd(s.flush_fds[1]);
+#if !defined(_WIN32)
+        ::unlink(s.config.socket_path.c_str());
+#endif
+    }
+
+    const InferenceServerConfig& InferenceServer::config() const {
+        return state_->config;
+    }
+
+    const MlpModel& InferenceServer::model() const {
+        return state_->model;
+    }
+
+    // ============================================================================
+    // Statistics
+    // ============================================================================
+
+    InferenceServer::Stats InferenceServer::stats() const {
+        const InferenceServerState& s = *state_;
+        Stats stats;
+        std::vector<const LatencyHistogram*> queue_histograms;
+        std::vector<const LatencyHistogram*> compute_histograms;
+        for (const auto& worker : s.workers) {
+            stats.requests += worker->requests.load(std::memory_order_relaxed);
+            stats.batches += worker->batches.load(std::memory_order_relaxed);
+            queue_histograms.push_back(&worker->queue_latency);
+            compute_histograms.push_back(&worker->compute_latency);
+        }
+        stats.rejected = s.rejected.load(std::memory_order_relaxed);
+        stats.bad_requests = s.bad_requests.load(std::memory_order_relaxed);
+        stats.connections = s.connections.load(std::memory_order_relaxed);
+        stats.mean_batch_size = stats.batches == 0 ? 0.0 : static_cast<double>(stats.requests) / stats.batches;
+        stats.queue = summarize(queue_histograms);
+        stats.compute = summarize(compute_histograms);
+        return stats;
+    }
+
+    // Counters written while this runs may keep their old value
+    void InferenceServer::reset_stats() {
+        InferenceServerState& s = *state_;
+        for (auto& worker : s.workers) {
+            worker->requests.store(0, std::memory_order_relaxed);
+            worker->batches.store(0, std::memory_order_relaxed);
+            worker->queue_latency.reset();
+            worker->compute_latency.reset();
+        }
+        s.rejected.store(0, std::memory_order_relaxed);
+        s.bad_requests.store(0, std::memory_order_relaxed);
+        s.connections.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,158 @@
+#include "label_builder.hpp"
+#include "indicator_kernels.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace quantamental {
+    namespace {
+        constexpr size_t kLabelsPerHorizon = 4;
+
+        // Tickers per unit of work. A tile's tickers advance date by date
+        // together, so every label row is written as whole cache lines.
+        constexpr size_t kTileTickers = 64;
+
+        // Rolling std of one ticker's daily log returns, fed only the dates
+        // it has a bar on (a return spans a gap in its bars)
+        struct TrailingVol {
+            detail::RollingVar var;
+            std::vector<double> returns;   // Ring of the last vol_window returns
+            double prev_log_close = detail::kNaN;
+            int64_t num_returns = 0;
+
+            explicit TrailingVol(int vol_window) : returns(vol_window, detail::kNaN) {}
+
+            // sigma through this close; NaN until vol_window returns are in
+            double update(double log_close) {
+                const int64_t w = static_cast<int64_t>(returns.size());
+                if (prev_log_close == prev_log_close) {
+                    const double r = log_close - prev_log_close;
+                    double& slot = returns[num_returns % w];
+                    detail::slide_window(var, w, num_returns, r, slot);
+                    slot = r;
+                    ++num_returns;
+                }
+                prev_log_close = log_close;
+                return var.stddev(w);
+            }
+        };
+    }
+
+    // ============================================================================
+    // Construction
+    // ============================================================================
+
+    std::optional<LabelBuilder> LabelBuilder::create(LabelConfig config) {
+        if (config.vol_window < 2 ||
+            !std::all_of(config.horizons.begin(), config.horizons.end(), [](int h) { return h >= 1; })) {
+            return std::nullopt;
+        }
+        return LabelBuilder(std::move(config));
+    }
+
+    LabelBuilder::LabelBuilder(LabelConfig config) : config_(std::move(config)) {
+        for (int h : config_.horizons) {
+            const std::string suffix = std::to_string(h) + "d";
+            columns_.push_back("fwd_return_" + suffix);
+            columns_.push_back("fwd_log_return_" + suffix);
+            columns_.push_back("fwd_vol_scaled_" + suffix);
+            columns_.push_back("fwd_excess_" + suffix);
+        }
+    }
+
+    const std::vector<std::string>& LabelBuilder::columns() const {
+        return columns_;
+    }
+
+    size_t LabelBuilder::num_columns() const {
+        return columns_.size();
+    }
+
+    const LabelConfig& LabelBuilder::config() const {
+        return config_;
+    }
+
+    // ============================================================================
+    // Build
+    // ============================================================================
+
+    void LabelBuilder::build(const double* close, const double* benchmark, size_t num_dates,
+                             size_t num_tickers, size_t num_known_dates, double* out,
+                             size_t num_threads) const {
+        if (num_dates == 0 || num_tickers == 0) return;
+        const std::vector<int>& horizons = config_.horizons;
+        const size_t T = num_tickers;
+        const size_t plane = num_dates * T;
+        const size_t known = std::min(num_known_dates, num_dates);
+
+        // Benchmark returns per horizon and date, shared by every tile
+        std::vector<double> benchmark_returns(horizons.size() * num_dates, detail::kNaN);
+        std::vector<double> sqrt_horizons;
+        for (size_t i = 0; i < horizons.size(); ++i) {
+            const size_t h = static_cast<size_t>(horizons[i]);
+            sqrt_horizons.push_back(std::sqrt(static_cast<double>(h)));
+            for (size_t d = 0; benchmark && d + h < known; ++d) {
+                benchmark_returns[i * num_dates + d] = benchmark[d + h] / benchmark[d] - 1.0;
+            }
+        }
+
+        // Log closes are taken once per element: each tile keeps a ring of
+        // rows reaching max(horizon) dates ahead, and log returns are their
+        // differences
+        const size_t lookahead = horizons.empty() ? 0 : static_cast<size_t>(
+            *std::max_element(horizons.begin(), horizons.end()));
+        const size_t ring_rows = std::bit_ceil(lookahead + 1);
+
+        auto sweep = [&](size_t begin, size_t end) {
+            std::vector<double> log_closes(ring_rows * kTileTickers);
+            for (size_t tile = begin; tile < end; ++tile) {
+                const size_t first = tile * kTileTickers;
+                const size_t width = std::min(first + kTileTickers, T) - first;
+                auto log_row = [&](size_t d) { return log_closes.data() + (d & (ring_rows - 1)) * width; };
+                auto fill_row = [&](size_t d) {
+                    double* row = log_row(d);
+                    for (size_t k = 0; k < width; ++k) row[k] = std::log(close[d * T + first + k]);
+                };
+
+                std::vector<TrailingVol> vols(width, TrailingVol(config_.vol_window));
+                for (size_t d = 0; d < std::min(lookahead, num_dates); ++d) fill_row(d);
+                for (size_t d = 0; d < num_dates; ++d) {
+                    if (d + lookahead < num_dates) fill_row(d + lookahead);
+                    const double* log_entry = log_row(d);
+
+                    for (size_t k = 0; k < width; ++k) {
+                        const size_t j = first + k;
+                        const double entry = close[d * T + j];
+                        const double sigma = entry == entry ? vols[k].update(log_entry[k]) : detail::kNaN;
+
+                        for (size_t i = 0; i < horizons.size(); ++i) {
+                            const size_t h = static_cast<size_t>(horizons[i]);
+                            // Exits at or past the sample boundary give NaN. Their
+                            // closes are still logged into the ring, but no label
+                            // uses them
+                            const bool in_sample = d + h < known;
+                            const double exit = in_sample ? close[(d + h) * T + j] : detail::kNaN;
+                            const double simple = exit / entry - 1.0;
+                            const double log_return = in_sample ? log_row(d + h)[k] - log_entry[k] : detail::kNaN;
+
+                            double* o = out + i * kLabelsPerHorizon * plane + d * T + j;
+                            o[0] = simple;
+                            o[plane] = log_return;
+                            o[2 * plane] = sigma > 0.0 ? log_return / (sigma * sqrt_horizons[i]) : detail::kNaN;
+                            o[3 * plane] = simple - benchmark_returns[i * num_dates + d];
+                        }
+                    }
+                }
+            }
+        };
+
+        const size_t num_tiles = (T + kTileTickers - 1) / kTileTickers;
+        size_t threads = ThreadPool::resolve_threads(num_threads, num_tiles, 1);
+        if (threads <= 1) {
+            sweep(0, num_tiles);
+        } else {
+            ThreadPool::shared().parallel_for(num_tiles, threads, sweep);
+        }
+    }
+}
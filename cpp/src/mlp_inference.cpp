@@ -0,0 +1,557 @@
+#include "mlp_inference.hpp"
+#include "murmur_hash3.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <new>
+#include <sstream>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define MLP_INFERENCE_X86 1
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+#define FORCE_INLINE inline __attribute__((always_inline))
+
+// Vectors are only passed between force-inlined functions, so the ABI note
+// GCC attaches to vector arguments does not apply
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace quantamental {
+
+    // ============================================================================
+    // Packed Weights
+    // ============================================================================
+    // Each layer's out x in weight matrix is stored transposed in panels of
+    // kPanelWidth output columns: panel p holds in rows of kPanelWidth floats,
+    // so the kernel streams one contiguous panel per tile of outputs. The last
+    // panel and the bias are zero-padded to a whole panel.
+
+    namespace detail {
+        struct MlpWeights {
+            struct Panels {
+                size_t weights;     // Offsets into data, in floats
+                size_t bias;
+                size_t num_panels;
+            };
+
+            struct Deleter {
+                void operator()(float* data) const {
+                    ::operator delete[](data, std::align_val_t(64));
+                }
+            };
+
+            std::unique_ptr<float[], Deleter> data;
+            std::vector<Panels> layers;
+        };
+    }
+
+    namespace {
+        constexpr size_t kPanelWidth = 16;
+        constexpr size_t kAlignment = 64;   // Bytes; one panel row is one cache line
+
+        // Inner-dimension block: one panel's slice (kKBlock x 16 floats, 16 KiB)
+        // stays in L1 while every row tile of the block runs over it
+        constexpr size_t kKBlock = 256;
+
+        size_t round_up(size_t n, size_t multiple) {
+            return (n + multiple - 1) / multiple * multiple;
+        }
+
+        float* allocate_floats(size_t count) {
+            return static_cast<float*>(::operator new[](std::max<size_t>(count, 1) * sizeof(float),
+                                                        std::align_val_t(kAlignment)));
+        }
+
+        // ============================================================================
+        // File Format
+        // ============================================================================
+        // RawHeader, then body_bytes of body: horizons (count, int32 each), the
+        // layer count, per layer (in, out, activation) as uint32, then per layer
+        // its nn.Linear weight (out x in float32, row-major) and bias. Native
+        // byte order; the checksum covers the body.
+        constexpr uint32_t kModelMagic = 0x504C4D51;  // "QMLP"
+        constexpr uint32_t kModelVersion = 1;
+        constexpr uint32_t kEndianTag = 0x01020304;
+        constexpr uint64_t kMaxBodyBytes = uint64_t{1} << 31;
+        constexpr uint32_t kMaxLayers = 256;
+
+        struct RawHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t endian_tag;
+            uint32_t reserved;
+            uint64_t body_bytes;
+            uint64_t checksum;
+        };
+        static_assert(sizeof(RawHeader) == 32, "RawHeader layout is part of the file format");
+
+        uint64_t body_checksum(const std::string& body) {
+            uint64_t hash[2];
+            MurmurHash3_x64_128(body.data(), static_cast<int>(body.size()), 0, hash);
+            return hash[0];
+        }
+
+        template <typename T>
+        void put(std::ostream& out, const T& value) {
+            out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        bool get(std::istream& in, T& value) {
+            in.read(reinterpret_cast<char*>(&value), sizeof(T));
+            return static_cast<bool>(in);
+        }
+
+        bool get_floats(std::istream& in, std::vector<float>& values, size_t count) {
+            values.resize(count);
+            in.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(count * sizeof(float)));
+            return static_cast<bool>(in);
+        }
+
+        // ============================================================================
+        // Kernels
+        // ============================================================================
+        // One forward pass over a block of rows, layer by layer between two
+        // arena buffers. Each layer is a GEMM tiled as kernel rows x one
+        // panel: the tile's accumulators start from the bias and run over a
+        // kKBlock slice of the inner dimension; on the last slice ReLU is
+        // applied to them before the single store (tanh and sigmoid, which
+        // have no vector form here, go over the stored block while it is
+        // still in cache). The kernel is written once over GCC vector
+        // types of the target's width and force-inlined into target entry
+        // points, so a tile row is one zmm (AVX-512), two ymm (AVX2) or four
+        // xmm (baseline SSE). This
+        // file builds with FP contraction on, so the multiply-adds become
+        // FMAs there.
+
+        struct ForwardTask {
+            const detail::MlpWeights* weights;
+            const MlpModel::Layer* layers;
+            size_t num_layers;
+            const float* input;     // rows x lda
+            size_t lda;
+            size_t rows;            // A multiple of the kernel's tile rows
+            float* buffers[2];      // rows x stride each
+            size_t stride;
+        };
+
+        // Native vector widths: a panel row is kPanelWidth / N vectors
+        struct SseLanes {
+            static constexpr size_t N = 4;
+            typedef float V __attribute__((vector_size(16), aligned(16)));
+        };
+
+        struct Avx2Lanes {
+            static constexpr size_t N = 8;
+            typedef float V __attribute__((vector_size(32), aligned(32)));
+        };
+
+        struct Avx512Lanes {
+            static constexpr size_t N = 16;
+            typedef float V __attribute__((vector_size(64), aligned(64)));
+        };
+
+        template <typename L, size_t Rows>
+        FORCE_INLINE void gemm_tile(const float* a, size_t lda, const float* b, size_t kc,
+                                    const float* bias, float* c, size_t ldc,
+                                    MlpModel::Activation activation) {
+            using V = typename L::V;
+            constexpr size_t kVectors = kPanelWidth / L::N;
+            V acc[Rows][kVectors];
+#pragma GCC unroll 16
+            for (size_t i = 0; i < Rows; ++i) {
+#pragma GCC unroll 4
+                for (size_t v = 0; v < kVectors; ++v) {
+                    acc[i][v] = bias != nullptr ? reinterpret_cast<const V*>(bias)[v]
+                                                : reinterpret_cast<const V*>(c + i * ldc)[v];
+                }
+            }
+            for (size_t k = 0; k < kc; ++k) {
+                V bk[kVectors];
+#pragma GCC unroll 4
+                for (size_t v = 0; v < kVectors; ++v) {
+                    bk[v] = reinterpret_cast<const V*>(b + k * kPanelWidth)[v];
+                }
+#pragma GCC unroll 16
+                for (size_t i = 0; i < Rows; ++i) {
+                    const V ai = V{} + a[i * lda + k];
+#pragma GCC unroll 4
+                    for (size_t v = 0; v < kVectors; ++v) {
+                        acc[i][v] += ai * bk[v];
+                    }
+                }
+            }
+#pragma GCC unroll 16
+            for (size_t i = 0; i < Rows; ++i) {
+#pragma GCC unroll 4
+                for (size_t v = 0; v < kVectors; ++v) {
+                    if (activation == MlpModel::Activation::ReLU) {
+                        acc[i][v] = acc[i][v] < 0.0f ? V{} : acc[i][v];   // NaN passes, as torch.relu
+                    }
+                    reinterpret_cast<V*>(c + i * ldc)[v] = acc[i][v];
+                }
+            }
+        }
+
+        template <typename L, size_t Rows>
+        FORCE_INLINE void gemm_layer(const detail::MlpWeights::Panels& panels, const float* data,
+                                     const MlpModel::Layer& layer, const float* a, size_t lda,
+                                     size_t rows, float* c, size_t ldc) {
+            const size_t K = layer.in;
+            for (size_t k0 = 0; k0 < K; k0 += kKBlock) {
+                const size_t kc = std::min(kKBlock, K - k0);
+                const bool last = k0 + kc == K;
+                const MlpModel::Activation fused = last ? layer.activation : MlpModel::Activation::Identity;
+                for (size_t p = 0; p < panels.num_panels; ++p) {
+                    const float* b = data + panels.weights + (p * K + k0) * kPanelWidth;
+                    const float* bias = k0 == 0 ? data + panels.bias + p * kPanelWidth : nullptr;
+                    for (size_t r = 0; r < rows; r += Rows) {
+                        gemm_tile<L, Rows>(a + r * lda + k0, lda, b, kc, bias,
+                                        c + r * ldc + p * kPanelWidth, ldc, fused);
+                    }
+                }
+            }
+        }
+
+        // Activations without a vector form run over the stored layer output
+        void finish_activation(MlpModel::Activation activation, float* c, size_t rows, size_t cols,
+                               size_t ldc) {
+            if (activation != MlpModel::Activation::Tanh && activation != MlpModel::Activation::Sigmoid) {
+                return;
+            }
+            for (size_t r = 0; r < rows; ++r) {
+                float* row = c + r * ldc;
+                for (size_t j = 0; j < cols; ++j) {
+                    row[j] = activation == MlpModel::Activation::Tanh
+                        ? std::tanh(row[j]) : 1.0f / (1.0f + std::exp(-row[j]));
+                }
+            }
+        }
+
+        // Returns the buffer holding the last layer's output
+        template <typename L, size_t Rows>
+        FORCE_INLINE float* forward(const ForwardTask& task) {
+            const float* a = task.input;
+            size_t lda = task.lda;
+            float* c = nullptr;
+            for (size_t l = 0; l < task.num_layers; ++l) {
+                const MlpModel::Layer& layer = task.layers[l];
+                c = task.buffers[(l + 1) % 2];
+                gemm_layer<L, Rows>(task.weights->layers[l], task.weights->data.get(), layer, a, lda,
+                                 task.rows, c, task.stride);
+                finish_activation(layer.activation, c, task.rows, layer.out, task.stride);
+                a = c;
+                lda = task.stride;
+            }
+            return c;
+        }
+
+        float* forward_scalar(const ForwardTask& task) {
+            return forward<SseLanes, 3>(task);
+        }
+
+#if defined(MLP_INFERENCE_X86)
+        TARGET_AVX2 float* forward_avx2(const ForwardTask& task) {
+            return forward<Avx2Lanes, 6>(task);
+        }
+
+        TARGET_AVX512 float* forward_avx512(const ForwardTask& task) {
+            return forward<Avx512Lanes, 12>(task);
+        }
+#endif
+
+        // ============================================================================
+        // Dispatch
+        // ============================================================================
+
+        struct MlpKernel {
+            float* (*forward)(const ForwardTask&);
+            size_t tile_rows;
+            const char* name;
+        };
+
+        MlpKernel select_kernel() {
+#if defined(MLP_INFERENCE_X86)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f")) {
+                return MlpKernel{forward_avx512, 12, "avx512"};
+            }
+            if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+                return MlpKernel{forward_avx2, 6, "avx2"};
+            }
+#endif
+            return MlpKernel{forward_scalar, 3, "scalar"};
+        }
+
+        const MlpKernel& mlp_kernel() {
+            static const MlpKernel selected = select_kernel();
+            return selected;
+        }
+    }
+
+    // ============================================================================
+    // Model
+    // ============================================================================
+
+    MlpModel::MlpModel(std::vector<int> horizons, std::vector<Layer> layers,
+                       std::shared_ptr<const detail::MlpWeights> weights)
+        : horizons_(std::move(horizons)), layers_(std::move(layers)), weights_(std::move(weights)) {}
+
+    std::optional<MlpModel> MlpModel::create(std::vector<int> horizons, const std::vector<Layer>& layers,
+                                             const std::vector<std::vector<float>>& weights,
+                                             const std::vector<std::vector<float>>& biases) {
+        if (layers.empty() || weights.size() != layers.size() || biases.size() != layers.size() ||
+            layers.back().out != horizons.size()) {
+            return std::nullopt;
+        }
+        size_t total = 0;
+        for (size_t l = 0; l < layers.size(); ++l) {
+            const Layer& layer = layers[l];
+            if (layer.in == 0 || layer.out == 0 || (l > 0 && layer.in != layers[l - 1].out) ||
+                layer.activation > Activation::Sigmoid ||
+                weights[l].size() != layer.in * layer.out || biases[l].size() != layer.out) {
+                return std::nullopt;
+            }
+            const size_t num_panels = (layer.out + kPanelWidth - 1) / kPanelWidth;
+            total += num_panels * kPanelWidth * (layer.in + 1);
+        }
+
+        auto packed = std::make_shared<detail::MlpWeights>();
+        packed->data.reset(allocate_floats(total));
+        float* data = packed->data.get();
+        std::fill_n(data, total, 0.0f);
+
+        size_t offset = 0;
+        for (size_t l = 0; l < layers.size(); ++l) {
+            const Layer& layer = layers[l];
+            detail::MlpWeights::Panels panels{offset, 0, (layer.out + kPanelWidth - 1) / kPanelWidth};
+            for (size_t j = 0; j < layer.out; ++j) {
+                float* column = data + offset + (j / kPanelWidth) * layer.in * kPanelWidth + j % kPanelWidth;
+                for (size_t k = 0; k < layer.in; ++k) {
+                    column[k * kPanelWidth] = weights[l][j * layer.in + k];
+                }
+            }
+            offset += panels.num_panels * kPanelWidth * layer.in;
+            panels.bias = offset;
+            std::copy(biases[l].begin(), biases[l].end(), data + offset);
+            offset += panels.num_panels * kPanelWidth;
+            packed->layers.push_back(panels);
+        }
+        return MlpModel(std::move(horizons), layers, std::move(packed));
+    }
+
+    const std::vector<int>& MlpModel::horizons() const {
+        return horizons_;
+    }
+
+    const std::vector<MlpModel::Layer>& MlpModel::layers() const {
+        return layers_;
+    }
+
+    size_t MlpModel::input_dim() const {
+        return layers_.front().in;
+    }
+
+    size_t MlpModel::output_dim() const {
+        return layers_.back().out;
+    }
+
+    std::vector<float> MlpModel::weights(size_t layer) const {
+        const Layer& shape = layers_[layer];
+        const float* panels = weights_->data.get() + weights_->layers[layer].weights;
+        std::vector<float> unpacked(shape.out * shape.in);
+        for (size_t j = 0; j < shape.out; ++j) {
+            const float* column = panels + (j / kPanelWidth) * shape.in * kPanelWidth + j % kPanelWidth;
+            for (size_t k = 0; k < shape.in; ++k) {
+                unpacked[j * shape.in + k] = column[k * kPanelWidth];
+            }
+        }
+        return unpacked;
+    }
+
+    std::vector<float> MlpModel::bias(size_t layer) const {
+        const float* bias = weights_->data.get() + weights_->layers[layer].bias;
+        return std::vector<float>(bias, bias + layers_[layer].out);
+    }
+
+    const char* MlpModel::backend() {
+        return mlp_kernel().name;
+    }
+
+    // ============================================================================
+    // Persistence
+    // ============================================================================
+
+    bool MlpModel::save_to_file(const std::string& filepath) const {
+        std::ofstream out(filepath, std::ios::binary);
+        return out && save_to_stream(out);
+    }
+
+    std::optional<MlpModel> MlpModel::load_from_file(const std::string& filepath) {
+        std::ifstream in(filepath, std::ios::binary);
+        if (!in) return std::nullopt;
+        return load_from_stream(in);
+    }
+
+    bool MlpModel::save_to_stream(std::ostream& out) const {
+        std::ostringstream body;
+        put(body, static_cast<uint32_t>(horizons_.size()));
+        for (int h : horizons_) put(body, static_cast<int32_t>(h));
+        put(body, static_cast<uint32_t>(layers_.size()));
+        for (const Layer& layer : layers_) {
+            put(body, static_cast<uint32_t>(layer.in));
+            put(body, static_cast<uint32_t>(layer.out));
+            put(body, static_cast<uint32_t>(layer.activation));
+        }
+        for (size_t l = 0; l < layers_.size(); ++l) {
+            for (const std::vector<float>& values : {weights(l), bias(l)}) {
+                body.write(reinterpret_cast<const char*>(values.data()),
+                           static_cast<std::streamsize>(values.size() * sizeof(float)));
+            }
+        }
+
+        const std::string bytes = body.str();
+        RawHeader raw{};
+        raw.magic = kModelMagic;
+        raw.version = kModelVersion;
+        raw.endian_tag = kEndianTag;
+        raw.body_bytes = bytes.size();
+        raw.checksum = body_checksum(bytes);
+        put(out, raw);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        return static_cast<bool>(out);
+    }
+
+    std::optional<MlpModel> MlpModel::load_from_stream(std::istream& in) {
+        RawHeader raw{};
+        if (!get(in, raw) || raw.magic != kModelMagic || raw.version != kModelVersion ||
+            raw.endian_tag != kEndianTag || raw.body_bytes > kMaxBodyBytes) {
+            return std::nullopt;
+        }
+        std::string bytes(raw.body_bytes, '\0');
+        in.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!in || body_checksum(bytes) != raw.checksum) return std::nullopt;
+
+        std::istringstream body(bytes);
+        uint32_t num_horizons = 0, num_layers = 0;
+        if (!get(body, num_horizons) || num_horizons > 4096) return std::nullopt;
+        std::vector<int> horizons(num_horizons);
+        for (int& h : horizons) {
+            int32_t raw_h = 0;
+            if (!get(body, raw_h)) return std::nullopt;
+            h = raw_h;
+        }
+        if (!get(body, num_layers) || num_layers == 0 || num_layers > kMaxLayers) return std::nullopt;
+
+        std::vector<Layer> layers(num_layers);
+        uint64_t num_floats = 0;
+        for (Layer& layer : layers) {
+            uint32_t in_dim = 0, out_dim = 0, activation = 0;
+            if (!get(body, in_dim) || !get(body, out_dim) || !get(body, activation)) return std::nullopt;
+            layer = Layer{in_dim, out_dim, static_cast<Activation>(activation)};
+            num_floats += (uint64_t{in_dim} + 1) * out_dim;
+        }
+        // The shapes must account for the rest of the body exactly
+        if (num_floats * sizeof(float) != bytes.size() - static_cast<size_t>(body.tellg())) {
+            return std::nullopt;
+        }
+
+        std::vector<std::vector<float>> weights(num_layers), biases(num_layers);
+        for (size_t l = 0; l < num_layers; ++l) {
+            if (!get_floats(body, weights[l], layers[l].in * layers[l].out) ||
+                !get_floats(body, biases[l], layers[l].out)) {
+                return std::nullopt;
+            }
+        }
+        return create(std::move(horizons), layers, weights, biases);
+    }
+
+    // ============================================================================
+    // Engine
+    // ============================================================================
+
+    void MlpEngine::ArenaDeleter::operator()(float* arena) const {
+        ::operator delete[](arena, std::align_val_t(kAlignment));
+    }
+
+    MlpEngine::MlpEngine(MlpModel model, size_t num_threads)
+        : model_(std::move(model)),
+          num_threads_(num_threads == 0 ? ThreadPool::shared().size() + 1 : num_threads) {
+        size_t width = model_.input_dim();
+        for (const MlpModel::Layer& layer : model_.layers()) {
+            width = std::max(width, layer.out);
+        }
+        stride_ = round_up(width, kPanelWidth);
+        slice_floats_ = 2 * kBlockRows * stride_;
+        arena_.reset(allocate_floats(num_threads_ * slice_floats_));
+        std::fill_n(arena_.get(), num_threads_ * slice_floats_, 0.0f);
+    }
+
+    void MlpEngine::run_blocks(size_t thread, const float* x, size_t begin_row, size_t end_row, float* out) {
+        const MlpKernel& kernel = mlp_kernel();
+        const size_t input_dim = model_.input_dim();
+        const size_t output_dim = model_.output_dim();
+        float* slice = arena_.get() + thread * slice_floats_;
+
+        ForwardTask task{model_.weights_.get(), model_.layers().data(), model_.layers().size(),
+                         nullptr, 0, 0, {slice, slice + kBlockRows * stride_}, stride_};
+        for (size_t r = begin_row; r < end_row; r += kBlockRows) {
+            const size_t rows = std::min(kBlockRows, end_row - r);
+            task.rows = round_up(rows, kernel.tile_rows);
+            if (task.rows == rows) {
+                task.input = x + r * input_dim;
+                task.lda = input_dim;
+            } else {
+                // Tail block: pad to whole tiles in the first buffer, which
+                // the first layer only reads
+                float* padded = task.buffers[0];
+                std::copy_n(x + r * input_dim, rows * input_dim, padded);
+                std::fill_n(padded + rows * input_dim, (task.rows - rows) * input_dim, 0.0f);
+                task.input = padded;
+                task.lda = input_dim;
+            }
+
+            const float* result = kernel.forward(task);
+            for (size_t i = 0; i < rows; ++i) {
+                std::copy_n(result + i * stride_, output_dim, out + (r + i) * output_dim);
+            }
+        }
+    }
+
+    void MlpEngine::predict(const float* x, size_t rows, float* out) {
+        std::lock_guard<std::mutex> lock(*predict_mutex_);
+        const size_t num_blocks = (rows + kBlockRows - 1) / kBlockRows;
+        const size_t threads = std::min(num_threads_, ThreadPool::resolve_threads(num_threads_, num_blocks, 1));
+        if (threads <= 1) {
+            run_blocks(0, x, 0, rows, out);
+            return;
+        }
+        // One chunk per thread, so chunk t owns arena slice t
+        ThreadPool::shared().parallel_for(threads, threads, [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; ++t) {
+                const size_t first = num_blocks * t / threads * kBlockRows;
+                const size_t last = std::min(rows, num_blocks * (t + 1) / threads * kBlockRows);
+                run_blocks(t, x, first, last, out);
+            }
+        });
+    }
+
+    const MlpModel& MlpEngine::model() const {
+        return model_;
+    }
+
+    size_t MlpEngine::num_threads() const {
+        return num_threads_;
+    }
+
+    size_t MlpEngine::arena_bytes() const {
+        return num_threads_ * slice_floats_ * sizeof(float);
+    }
+}
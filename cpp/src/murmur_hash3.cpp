@@ -13,9 +13,21 @@
 // - Wrapped in quantamental namespace
 // - Removed unused x86 variants
 // - Added [[fallthrough]] attributes to silence compiler warnings
+// - Added MurmurHash3_x64_128_multi, which runs the same steps over
+//   several equal-length keys in AVX2/AVX-512 lanes
 
 #include "murmur_hash3.hpp"
 
+#include <climits>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#include <immintrin.h>
+#define MURMUR_MULTI_X86 1
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512dq")))
+#endif
+
 namespace quantamental {
 
 //-----------------------------------------------------------------------------
@@ -156,4 +168,300 @@ void MurmurHash3_x64_128(const void* key, int len, uint32_t seed, void* out) {
     static_cast<uint64_t*>(out)[1] = h2;
 }
 
-} // namespace quantamental
\ No newline at end of file
+//-----------------------------------------------------------------------------
+// MurmurHash3_x64_128_multi
+//
+// Each vector lane carries one key through exactly the scalar steps above.
+// The keys all have the same length, so every lane runs the same number of
+// blocks and the same tail; the block words are gathered from the key
+// pointers and the tail bytes are packed lane by lane.
+
+namespace {
+
+using MultiKernel = void (*)(const uint8_t* const* keys, int len, uint32_t seed, uint64_t* out);
+
+// Packs the tail bytes of each key into its k1/k2 words byte by byte, as
+// the scalar switch does
+void load_tail(const uint8_t* const* keys, size_t lanes, int len, uint64_t* k1, uint64_t* k2) {
+    const size_t offset = static_cast<size_t>(len / 16) * 16;
+    const size_t tail = static_cast<size_t>(len & 15);
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        k1[lane] = 0;
+        k2[lane] = 0;
+        std::memcpy(&k1[lane], keys[lane] + offset, tail < 8 ? tail : 8);
+        if (tail > 8) {
+            std::memcpy(&k2[lane], keys[lane] + offset + 8, tail - 8);
+        }
+    }
+}
+
+void multi_scalar(const uint8_t* const* keys, size_t count, int len, uint32_t seed, uint64_t* out) {
+    for (size_t i = 0; i < count; ++i) {
+        MurmurHash3_x64_128(keys[i], len, seed, out + 2 * i);
+    }
+}
+
+#if defined(MURMUR_MULTI_X86)
+
+// GCC 12's AVX-512 headers build "undefined" vectors as __Y = __Y, which
+// -Wuninitialized reports at every inlined intrinsic
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// AVX2 has no 64-bit multiply, so it is built from three 32x32->64 products
+TARGET_AVX2 inline __m256i mul64_avx2(__m256i a, __m256i b) {
+    __m256i lo = _mm256_mul_epu32(a, b);
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                     _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+TARGET_AVX2 inline __m256i times5_avx2(__m256i x) {
+    return _mm256_add_epi64(_mm256_slli_epi64(x, 2), x);
+}
+
+TARGET_AVX2 inline __m256i rotl_avx2(__m256i x, int r) {
+    return _mm256_or_si256(_mm256_slli_epi64(x, r), _mm256_srli_epi64(x, 64 - r));
+}
+
+TARGET_AVX2 inline __m256i fmix_avx2(__m256i k) {
+    k = _mm256_xor_si256(k, _mm256_srli_epi64(k, 33));
+    k = mul64_avx2(k, _mm256_set1_epi64x(static_cast<long long>(BIG_CONSTANT(0xff51afd7ed558ccd))));
+    k = _mm256_xor_si256(k, _mm256_srli_epi64(k, 33));
+    k = mul64_avx2(k, _mm256_set1_epi64x(static_cast<long long>(BIG_CONSTANT(0xc4ceb9fe1a85ec53))));
+    return _mm256_xor_si256(k, _mm256_srli_epi64(k, 33));
+}
+
+// Tail words of keys of at least 8 bytes come from whole-word loads inside
+// the key: k1 is the word at the tail when 8+ bytes remain, otherwise the
+// last word of the key shifted down; k2 is always the last word shifted.
+// Shorter keys are packed byte by byte.
+TARGET_AVX2 inline void tail_avx2(const long long* base, __m256i offsets, const uint8_t* const* keys,
+                                  int len, __m256i& k1, __m256i& k2) {
+    const int tail = len & 15;
+    if (len < 8) {
+        alignas(32) uint64_t t1[4], t2[4];
+        load_tail(keys, 4, len, t1, t2);
+        k1 = _mm256_load_si256(reinterpret_cast<const __m256i*>(t1));
+        k2 = _mm256_setzero_si256();
+        return;
+    }
+    __m256i last = _mm256_i64gather_epi64(base, _mm256_add_epi64(offsets, _mm256_set1_epi64x(len - 8)), 1);
+    if (tail >= 8) {
+        k1 = _mm256_i64gather_epi64(base, _mm256_add_epi64(offsets, _mm256_set1_epi64x(len - tail)), 1);
+        k2 = _mm256_srl_epi64(last, _mm_cvtsi32_si128(8 * (16 - tail)));
+    } else {
+        k1 = _mm256_srl_epi64(last, _mm_cvtsi32_si128(8 * (8 - tail)));
+        k2 = _mm256_setzero_si256();
+    }
+}
+
+TARGET_AVX2 void multi_avx2(const uint8_t* const* keys, int len, uint32_t seed, uint64_t* out) {
+    const __m256i c1 = _mm256_set1_epi64x(static_cast<long long>(BIG_CONSTANT(0x87c37b91114253d5)));
+    const __m256i c2 = _mm256_set1_epi64x(static_cast<long long>(BIG_CONSTANT(0x4cf5ad432745937f)));
+
+    // Gather offsets relative to the first key, so no pointer is formed
+    // outside the keys themselves
+    const long long* base = reinterpret_cast<const long long*>(keys[0]);
+    const __m256i offsets = _mm256_setr_epi64x(
+        0,
+        reinterpret_cast<intptr_t>(keys[1]) - reinterpret_cast<intptr_t>(keys[0]),
+        reinterpret_cast<intptr_t>(keys[2]) - reinterpret_cast<intptr_t>(keys[0]),
+        reinterpret_cast<intptr_t>(keys[3]) - reinterpret_cast<intptr_t>(keys[0]));
+
+    __m256i h1 = _mm256_set1_epi64x(seed);
+    __m256i h2 = h1;
+
+    const int nblocks = len / 16;
+    for (int i = 0; i < nblocks; i++) {
+        __m256i index = _mm256_add_epi64(offsets, _mm256_set1_epi64x(i * 16));
+        __m256i k1 = _mm256_i64gather_epi64(base, index, 1);
+        __m256i k2 = _mm256_i64gather_epi64(base, _mm256_add_epi64(index, _mm256_set1_epi64x(8)), 1);
+
+        k1 = mul64_avx2(rotl_avx2(mul64_avx2(k1, c1), 31), c2);
+        h1 = _mm256_xor_si256(h1, k1);
+        h1 = _mm256_add_epi64(rotl_avx2(h1, 27), h2);
+        h1 = _mm256_add_epi64(times5_avx2(h1), _mm256_set1_epi64x(0x52dce729));
+
+        k2 = mul64_avx2(rotl_avx2(mul64_avx2(k2, c2), 33), c1);
+        h2 = _mm256_xor_si256(h2, k2);
+        h2 = _mm256_add_epi64(rotl_avx2(h2, 31), h1);
+        h2 = _mm256_add_epi64(times5_avx2(h2), _mm256_set1_epi64x(0x38495ab5));
+    }
+
+    const int tail = len & 15;
+    if (tail != 0) {
+        __m256i k1, k2;
+        tail_avx2(base, offsets, keys, len, k1, k2);
+        if (tail > 8) {
+            h2 = _mm256_xor_si256(h2, mul64_avx2(rotl_avx2(mul64_avx2(k2, c2), 33), c1));
+        }
+        h1 = _mm256_xor_si256(h1, mul64_avx2(rotl_avx2(mul64_avx2(k1, c1), 31), c2));
+    }
+
+    const __m256i length = _mm256_set1_epi64x(len);
+    h1 = _mm256_xor_si256(h1, length);
+    h2 = _mm256_xor_si256(h2, length);
+    h1 = _mm256_add_epi64(h1, h2);
+    h2 = _mm256_add_epi64(h2, h1);
+    h1 = fmix_avx2(h1);
+    h2 = fmix_avx2(h2);
+    h1 = _mm256_add_epi64(h1, h2);
+    h2 = _mm256_add_epi64(h2, h1);
+
+    // Interleave to [h1, h2] pairs
+    __m256i lo = _mm256_unpacklo_epi64(h1, h2);   // lanes 0, 2
+    __m256i hi = _mm256_unpackhi_epi64(h1, h2);   // lanes 1, 3
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+TARGET_AVX512 inline __m512i rotl_avx512(__m512i x, int r) {
+    return _mm512_rolv_epi64(x, _mm512_set1_epi64(r));
+}
+
+TARGET_AVX512 inline __m512i fmix_avx512(__m512i k) {
+    k = _mm512_xor_si512(k, _mm512_srli_epi64(k, 33));
+    k = _mm512_mullo_epi64(k, _mm512_set1_epi64(static_cast<long long>(BIG_CONSTANT(0xff51afd7ed558ccd))));
+    k = _mm512_xor_si512(k, _mm512_srli_epi64(k, 33));
+    k = _mm512_mullo_epi64(k, _mm512_set1_epi64(static_cast<long long>(BIG_CONSTANT(0xc4ceb9fe1a85ec53))));
+    return _mm512_xor_si512(k, _mm512_srli_epi64(k, 33));
+}
+
+TARGET_AVX512 inline void tail_avx512(const void* base, __m512i offsets, const uint8_t* const* keys,
+                                      int len, __m512i& k1, __m512i& k2) {
+    const int tail = len & 15;
+    if (len < 8) {
+        alignas(64) uint64_t t1[8], t2[8];
+        load_tail(keys, 8, len, t1, t2);
+        k1 = _mm512_load_si512(t1);
+        k2 = _mm512_setzero_si512();
+        return;
+    }
+    __m512i last = _mm512_i64gather_epi64(_mm512_add_epi64(offsets, _mm512_set1_epi64(len - 8)), base, 1);
+    if (tail >= 8) {
+        k1 = _mm512_i64gather_epi64(_mm512_add_epi64(offsets, _mm512_set1_epi64(len - tail)), base, 1);
+        k2 = _mm512_srl_epi64(last, _mm_cvtsi32_si128(8 * (16 - tail)));
+    } else {
+        k1 = _mm512_srl_epi64(last, _mm_cvtsi32_si128(8 * (8 - tail)));
+        k2 = _mm512_setzero_si512();
+    }
+}
+
+TARGET_AVX512 void multi_avx512(const uint8_t* const* keys, int len, uint32_t seed, uint64_t* out) {
+    constexpr size_t kLanes = 8;
+    const __m512i c1 = _mm512_set1_epi64(static_cast<long long>(BIG_CONSTANT(0x87c37b91114253d5)));
+    const __m512i c2 = _mm512_set1_epi64(static_cast<long long>(BIG_CONSTANT(0x4cf5ad432745937f)));
+    const __m512i m5 = _mm512_set1_epi64(5);
+
+    alignas(64) long long delta[kLanes];
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+        delta[lane] = reinterpret_cast<intptr_t>(keys[lane]) - reinterpret_cast<intptr_t>(keys[0]);
+    }
+    const void* base = keys[0];
+    const __m512i offsets = _mm512_load_si512(delta);
+
+    __m512i h1 = _mm512_set1_epi64(seed);
+    __m512i h2 = h1;
+
+    const int nblocks = len / 16;
+    for (int i = 0; i < nblocks; i++) {
+        __m512i index = _mm512_add_epi64(offsets, _mm512_set1_epi64(i * 16));
+        __m512i k1 = _mm512_i64gather_epi64(index, base, 1);
+        __m512i k2 = _mm512_i64gather_epi64(_mm512_add_epi64(index, _mm512_set1_epi64(8)), base, 1);
+
+        k1 = _mm512_mullo_epi64(rotl_avx512(_mm512_mullo_epi64(k1, c1), 31), c2);
+        h1 = _mm512_xor_si512(h1, k1);
+        h1 = _mm512_add_epi64(rotl_avx512(h1, 27), h2);
+        h1 = _mm512_add_epi64(_mm512_mullo_epi64(h1, m5), _mm512_set1_epi64(0x52dce729));
+
+        k2 = _mm512_mullo_epi64(rotl_avx512(_mm512_mullo_epi64(k2, c2), 33), c1);
+        h2 = _mm512_xor_si512(h2, k2);
+        h2 = _mm512_add_epi64(rotl_avx512(h2, 31), h1);
+        h2 = _mm512_add_epi64(_mm512_mullo_epi64(h2, m5), _mm512_set1_epi64(0x38495ab5));
+    }
+
+    const int tail = len & 15;
+    if (tail != 0) {
+        __m512i k1, k2;
+        tail_avx512(base, offsets, keys, len, k1, k2);
+        if (tail > 8) {
+            h2 = _mm512_xor_si512(h2, _mm512_mullo_epi64(rotl_avx512(_mm512_mullo_epi64(k2, c2), 33), c1));
+        }
+        h1 = _mm512_xor_si512(h1, _mm512_mullo_epi64(rotl_avx512(_mm512_mullo_epi64(k1, c1), 31), c2));
+    }
+
+    const __m512i length = _mm512_set1_epi64(len);
+    h1 = _mm512_xor_si512(h1, length);
+    h2 = _mm512_xor_si512(h2, length);
+    h1 = _mm512_add_epi64(h1, h2);
+    h2 = _mm512_add_epi64(h2, h1);
+    h1 = fmix_avx512(h1);
+    h2 = fmix_avx512(h2);
+    h1 = _mm512_add_epi64(h1, h2);
+    h2 = _mm512_add_epi64(h2, h1);
+
+    // Interleave to [h1, h2] pairs
+    const __m512i first = _mm512_setr_epi64(0, 8, 1, 9, 2, 10, 3, 11);
+    const __m512i second = _mm512_setr_epi64(4, 12, 5, 13, 6, 14, 7, 15);
+    _mm512_storeu_si512(out, _mm512_permutex2var_epi64(h1, first, h2));
+    _mm512_storeu_si512(out + 8, _mm512_permutex2var_epi64(h1, second, h2));
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+// AVX2 emulates each 64-bit multiply with three 32-bit ones, which only
+// pays off while there are no 16-byte blocks; longer keys stay scalar.
+struct MultiDispatch {
+    MultiKernel kernel;
+    size_t lanes;
+    int max_len;
+    const char* name;
+};
+
+MultiDispatch select_multi_kernel() {
+#if defined(MURMUR_MULTI_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")) {
+        return MultiDispatch{multi_avx512, 8, INT_MAX, "avx512"};
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return MultiDispatch{multi_avx2, 4, 15, "avx2"};
+    }
+#endif
+    return MultiDispatch{nullptr, 1, 0, "scalar"};
+}
+
+const MultiDispatch& multi_dispatch() {
+    static const MultiDispatch dispatch = select_multi_kernel();
+    return dispatch;
+}
+
+} // namespace
+
+void MurmurHash3_x64_128_multi(const void* const* keys, size_t count, int len,
+                               uint32_t seed, uint64_t* out) {
+    const auto* bytes = reinterpret_cast<const uint8_t* const*>(keys);
+    const MultiDispatch& dispatch = multi_dispatch();
+
+    size_t i = 0;
+    if (dispatch.kernel != nullptr && len <= dispatch.max_len) {
+        for (; i + dispatch.lanes <= count; i += dispatch.lanes) {
+            dispatch.kernel(bytes + i, len, seed, out + 2 * i);
+        }
+    }
+    multi_scalar(bytes + i, count - i, len, seed, out + 2 * i);
+}
+
+const char* MurmurHash3_multi_backend() {
+    return multi_dispatch().name;
+}
+
+} // namespace quantamental
@@ -28,6 +28,26 @@ namespace quantamental {
  */
 void MurmurHash3_x64_128(const void* key, int len, uint32_t seed, void* out);
 
+/**
+ * MurmurHash3_x64_128_multi
+ *
+ * Hashes count keys of the same length, each bit for bit as
+ * MurmurHash3_x64_128 would. Lanes of 8 (AVX-512) or 4 (AVX2) keys are
+ * hashed side by side when the CPU supports it; the rest go through the
+ * scalar code.
+ *
+ * @param keys   Pointers to the count keys
+ * @param count  Number of keys
+ * @param len    Length of every key in bytes
+ * @param seed   Hash seed
+ * @param out    Output array of 2 * count uint64_t values [h1, h2, h1, h2, ...]
+ */
+void MurmurHash3_x64_128_multi(const void* const* keys, size_t count, int len,
+                               uint32_t seed, uint64_t* out);
+
+// Kernel MurmurHash3_x64_128_multi picked at startup: "avx512", "avx2" or "scalar"
+const char* MurmurHash3_multi_backend();
+
 } // namespace quantamental
 
 #endif // MURMUR_HASH3_HPP
\ No newline at end of file
@@ -0,0 +1,499 @@
+#include "rolling_covariance.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define ROLLING_COVARIANCE_X86 1
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+#define FORCE_INLINE inline __attribute__((always_inline))
+
+// Packs only pass between force-inlined functions of this file, so the ABI
+// note GCC attaches to wide vector arguments does not apply
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace quantamental {
+    namespace {
+        constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+        constexpr size_t kTile = RollingCovariance::kTile;
+        constexpr size_t kTilePairs = kTile * kTile;
+        constexpr size_t kDateChunk = 64;         // Batch dates staged per tile pass
+        constexpr size_t kMinTilesPerThread = 16;
+        constexpr size_t kMinRowsPerThread = 64;
+        // A centered sum of squares this small next to the squared sum's
+        // share (mean^2 * count) is rounding left by add/remove, not spread
+        constexpr double kFlatTolerance = 1e-12;
+
+        // A tile's sums for one window: kSums blocks of kTile x kTile
+        // doubles, pair (r, c) of the tile at [sum * kTilePairs + r * kTile + c]
+        enum Sum : size_t { kCount = 0, kSumX, kSumY, kSumXX, kSumYY, kSumXY, kSums };
+        constexpr size_t kTileSums = kSums * kTilePairs;
+
+        // One row of a tile's column block side by side. GCC lowers the
+        // vector type to the target's registers: one with AVX-512, two with
+        // AVX2, four SSE2 registers at the x86-64 baseline.
+        typedef double Pack __attribute__((vector_size(kTile * sizeof(double))));
+
+        FORCE_INLINE Pack load_pack(const double* x) {
+            Pack v;
+            std::memcpy(&v, x, sizeof(v));
+            return v;
+        }
+
+        FORCE_INLINE void store_pack(double* x, const Pack& v) {
+            std::memcpy(x, &v, sizeof(v));
+        }
+
+        // ============================================================================
+        // Rank-1 Tile Updates
+        // ============================================================================
+        // A date enters the sums as a masked row of three planes, padded
+        // tickers long: present (1 or 0), x and x^2 (0 where missing). For
+        // tile rows with ticker i present, every sum of pair (i, j) then
+        // moves by a multiple of j's planes, with no branch on j.
+
+        struct UpdateTask {
+            double* sums;
+            const uint32_t* tile_rows;
+            const uint32_t* tile_cols;
+            const size_t* windows;
+            size_t num_windows;
+            size_t padded;
+            const double* staging;     // Rows of dates [first_date, first_date + num_dates)
+            const double* history;     // Rows of the history_rows dates before, by date % history_rows
+            size_t history_rows;
+            uint64_t first_date;
+            size_t num_dates;
+
+            const double* row(uint64_t date) const {
+                if (date >= first_date) return staging + (date - first_date) * 3 * padded;
+                return history + (date % history_rows) * 3 * padded;
+            }
+        };
+
+        template <bool Add>
+        FORCE_INLINE void rank1_tile(double* sums, const double* row, size_t padded, size_t first_i,
+                                     size_t first_j) {
+            const Pack present_j = load_pack(row + first_j);
+            const Pack x_j = load_pack(row + padded + first_j);
+            const Pack xx_j = load_pack(row + 2 * padded + first_j);
+            for (size_t r = 0; r < kTile; ++r) {
+                if (row[first_i + r] == 0.0) continue;
+                const double x_i = row[padded + first_i + r];
+                const double xx_i = row[2 * padded + first_i + r];
+                const Pack terms[kSums] = {present_j, x_i * present_j, x_j, xx_i * present_j, xx_j, x_i * x_j};
+                for (size_t s = 0; s < kSums; ++s) {
+                    double* at = sums + s * kTilePairs + r * kTile;
+                    store_pack(at, Add ? load_pack(at) + terms[s] : load_pack(at) - terms[s]);
+                }
+            }
+        }
+
+        // Every date of the batch over each tile in [begin, end), so a tile's
+        // sums stay in cache for the whole batch
+        FORCE_INLINE void sweep_tiles(const UpdateTask& task, size_t begin, size_t end) {
+            for (size_t t = begin; t < end; ++t) {
+                const size_t first_i = task.tile_rows[t] * kTile;
+                const size_t first_j = task.tile_cols[t] * kTile;
+                double* tile = task.sums + t * task.num_windows * kTileSums;
+                for (size_t k = 0; k < task.num_dates; ++k) {
+                    const uint64_t date = task.first_date + k;
+                    const double* added = task.row(date);
+                    for (size_t w = 0; w < task.num_windows; ++w) {
+                        double* sums = tile + w * kTileSums;
+                        rank1_tile<true>(sums, added, task.padded, first_i, first_j);
+                        if (date >= task.windows[w]) {
+                            rank1_tile<false>(sums, task.row(date - task.windows[w]), task.padded, first_i,
+                                              first_j);
+                        }
+                    }
+                }
+            }
+        }
+
+        // Sums of each tile in [begin, end) rebuilt from the history alone
+        // (no staging): window w gets the last windows[w] of the dates
+        // [first_date, first_date + num_dates)
+        FORCE_INLINE void rebuild_tiles(const UpdateTask& task, size_t begin, size_t end) {
+            const uint64_t last = task.first_date + task.num_dates;
+            for (size_t t = begin; t < end; ++t) {
+                const size_t first_i = task.tile_rows[t] * kTile;
+                const size_t first_j = task.tile_cols[t] * kTile;
+                double* tile = task.sums + t * task.num_windows * kTileSums;
+                std::fill_n(tile, task.num_windows * kTileSums, 0.0);
+                for (uint64_t date = task.first_date; date < last; ++date) {
+                    const double* row = task.history + (date % task.history_rows) * 3 * task.padded;
+                    for (size_t w = 0; w < task.num_windows; ++w) {
+                        if (last - date > task.windows[w]) continue;
+                        rank1_tile<true>(tile + w * kTileSums, row, task.padded, first_i, first_j);
+                    }
+                }
+            }
+        }
+
+        void sweep_scalar(const UpdateTask& task, size_t begin, size_t end) {
+            sweep_tiles(task, begin, end);
+        }
+
+        void rebuild_scalar(const UpdateTask& task, size_t begin, size_t end) {
+            rebuild_tiles(task, begin, end);
+        }
+
+#if defined(ROLLING_COVARIANCE_X86)
+        TARGET_AVX2 void sweep_avx2(const UpdateTask& task, size_t begin, size_t end) {
+            sweep_tiles(task, begin, end);
+        }
+
+        TARGET_AVX2 void rebuild_avx2(const UpdateTask& task, size_t begin, size_t end) {
+            rebuild_tiles(task, begin, end);
+        }
+
+        TARGET_AVX512 void sweep_avx512(const UpdateTask& task, size_t begin, size_t end) {
+            sweep_tiles(task, begin, end);
+        }
+
+        TARGET_AVX512 void rebuild_avx512(const UpdateTask& task, size_t begin, size_t end) {
+            rebuild_tiles(task, begin, end);
+        }
+#endif
+
+        // ============================================================================
+        // Dispatch
+        // ============================================================================
+
+        struct UpdateKernel {
+            void (*sweep)(const UpdateTask&, size_t, size_t);     // Over tiles [begin, end)
+            void (*rebuild)(const UpdateTask&, size_t, size_t);
+            const char* name;
+        };
+
+        UpdateKernel select_kernel() {
+#if defined(ROLLING_COVARIANCE_X86)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f")) {
+                return UpdateKernel{sweep_avx512, rebuild_avx512, "avx512"};
+            }
+            if (__builtin_cpu_supports("avx2")) {
+                return UpdateKernel{sweep_avx2, rebuild_avx2, "avx2"};
+            }
+#endif
+            return UpdateKernel{sweep_scalar, rebuild_scalar, "scalar"};
+        }
+
+        const UpdateKernel& update_kernel() {
+            static const UpdateKernel selected = select_kernel();
+            return selected;
+        }
+
+        // ============================================================================
+        // Pair Statistics
+        // ============================================================================
+
+        struct PairSums {
+            double count, sum_x, sum_y, sum_xx, sum_yy, sum_xy;
+        };
+
+        PairSums pair_sums(const double* sums, size_t pair) {
+            return PairSums{sums[kCount * kTilePairs + pair], sums[kSumX * kTilePairs + pair],
+                            sums[kSumY * kTilePairs + pair], sums[kSumXX * kTilePairs + pair],
+                            sums[kSumYY * kTilePairs + pair], sums[kSumXY * kTilePairs + pair]};
+        }
+
+        // Centered sum of squares, 0 for a series flat up to rounding
+        double centered_squares(double sum_sq, double sum, double count) {
+            const double mean_share = sum * sum / count;
+            const double centered = sum_sq - mean_share;
+            return centered <= kFlatTolerance * mean_share ? 0.0 : centered;
+        }
+
+        // ddof = 1, as DataFrame.cov()
+        double pair_covariance(const PairSums& p, double min_count) {
+            if (p.count < min_count) return kNaN;
+            return (p.sum_xy - p.sum_x * p.sum_y / p.count) / (p.count - 1.0);
+        }
+
+        double pair_variance(const PairSums& p, double min_count) {
+            if (p.count < min_count) return kNaN;
+            return centered_squares(p.sum_xx, p.sum_x, p.count) / (p.count - 1.0);
+        }
+
+        // Both variances over the pair's joint dates; NaN if either series
+        // is flat
+        double pair_correlation(const PairSums& p, double min_count) {
+            if (p.count < min_count) return kNaN;
+            double var_x = centered_squares(p.sum_xx, p.sum_x, p.count);
+            double var_y = centered_squares(p.sum_yy, p.sum_y, p.count);
+            if (!(var_x > 0.0) || !(var_y > 0.0)) return kNaN;
+            double corr = (p.sum_xy - p.sum_x * p.sum_y / p.count) / std::sqrt(var_x * var_y);
+            return std::clamp(corr, -1.0, 1.0);
+        }
+
+        // Runs fn(begin, end) over [0, count) split across the shared pool
+        template <typename Fn>
+        void for_ranges(size_t count, size_t min_per_thread, size_t num_threads, const Fn& fn) {
+            if (count == 0) return;
+            size_t threads = ThreadPool::resolve_threads(num_threads, count, min_per_thread);
+            if (threads <= 1) {
+                fn(0, count);
+            } else {
+                ThreadPool::shared().parallel_for(count, threads, fn);
+            }
+        }
+    }
+
+    // ============================================================================
+    // Construction
+    // ============================================================================
+
+    std::optional<RollingCovariance> RollingCovariance::create(size_t num_tickers, std::vector<size_t> windows,
+                                                               size_t min_periods) {
+        min_periods = std::max<size_t>(min_periods, 2);
+        if (num_tickers == 0 || num_tickers > UINT32_MAX || windows.empty()) return std::nullopt;
+        for (size_t window : windows) {
+            if (window == 0 || window < min_periods) return std::nullopt;
+        }
+        return RollingCovariance(num_tickers, std::move(windows), min_periods);
+    }
+
+    RollingCovariance::RollingCovariance(size_t num_tickers, std::vector<size_t> windows, size_t min_periods)
+        : num_tickers_(num_tickers),
+          padded_tickers_((num_tickers + kTile - 1) / kTile * kTile),
+          windows_(std::move(windows)),
+          min_periods_(min_periods) {
+        const size_t num_blocks = padded_tickers_ / kTile;
+        for (size_t i = 0; i < num_blocks; ++i) {
+            for (size_t j = i; j < num_blocks; ++j) {
+                tile_rows_.push_back(static_cast<uint32_t>(i));
+                tile_cols_.push_back(static_cast<uint32_t>(j));
+            }
+        }
+        const size_t max_window = *std::max_element(windows_.begin(), windows_.end());
+        sums_.assign(tile_rows_.size() * windows_.size() * kTileSums, 0.0);
+        history_.assign(max_window * 3 * padded_tickers_, 0.0);
+        shift_.assign(num_tickers_, kNaN);
+        last_.assign(num_tickers_, kNaN);
+        next_recenter_ = max_window;
+    }
+
+    void RollingCovariance::reset() {
+        std::fill(sums_.begin(), sums_.end(), 0.0);
+        std::fill(history_.begin(), history_.end(), 0.0);
+        std::fill(shift_.begin(), shift_.end(), kNaN);
+        std::fill(last_.begin(), last_.end(), kNaN);
+        num_dates_ = 0;
+        next_recenter_ = history_.size() / (3 * padded_tickers_);
+    }
+
+    size_t RollingCovariance::num_tickers() const {
+        return num_tickers_;
+    }
+
+    const std::vector<size_t>& RollingCovariance::windows() const {
+        return windows_;
+    }
+
+    size_t RollingCovariance::min_periods() const {
+        return min_periods_;
+    }
+
+    uint64_t RollingCovariance::num_dates() const {
+        return num_dates_;
+    }
+
+    size_t RollingCovariance::memory_bytes() const {
+        return (sums_.size() + history_.size() + shift_.size() + last_.size() + staging_.size()) * sizeof(double);
+    }
+
+    const char* RollingCovariance::backend() {
+        return update_kernel().name;
+    }
+
+    // ============================================================================
+    // Update
+    // ============================================================================
+
+    void RollingCovariance::update(const double* values, size_t num_dates, size_t num_threads) {
+        const size_t padded = padded_tickers_;
+        const size_t row_doubles = 3 * padded;
+        const size_t history_rows = history_.size() / row_doubles;
+        staging_.resize(std::min(num_dates, kDateChunk) * row_doubles);
+
+        for (size_t first = 0; first < num_dates; first += kDateChunk) {
+            const size_t count = std::min(kDateChunk, num_dates - first);
+
+            // Masked rows, shifting each ticker by its first finite value
+            std::fill_n(staging_.data(), count * row_doubles, 0.0);
+            for (size_t k = 0; k < count; ++k) {
+                const double* in = values + (first + k) * num_tickers_;
+                double* row = staging_.data() + k * row_doubles;
+                for (size_t j = 0; j < num_tickers_; ++j) {
+                    if (!std::isfinite(in[j])) continue;
+                    if (std::isnan(shift_[j])) shift_[j] = in[j];
+                    last_[j] = in[j];
+                    const double x = in[j] - shift_[j];
+                    row[j] = 1.0;
+                    row[padded + j] = x;
+                    row[2 * padded + j] = x * x;
+                }
+            }
+
+            const UpdateTask task{sums_.data(), tile_rows_.data(), tile_cols_.data(), windows_.data(),
+                                  windows_.size(), padded, staging_.data(), history_.data(), history_rows,
+                                  num_dates_, count};
+            const UpdateKernel& kernel = update_kernel();
+            for_ranges(tile_rows_.size(), kMinTilesPerThread, num_threads, [&](size_t begin, size_t end) {
+                kernel.sweep(task, begin, end);
+            });
+
+            // Only now, with every tile past them, can the rows that left
+            // the windows be overwritten
+            for (size_t k = 0; k < count; ++k) {
+                std::memcpy(history_.data() + ((num_dates_ + k) % history_rows) * row_doubles,
+                            staging_.data() + k * row_doubles, row_doubles * sizeof(double));
+            }
+            num_dates_ += count;
+            if (num_dates_ >= next_recenter_) {
+                recenter(num_threads);
+                next_recenter_ = num_dates_ + history_rows;
+            }
+        }
+    }
+
+    // Shifts each ticker by its latest value instead, so a series that has
+    // wandered from its old shift is small again (and one that has gone flat
+    // is exactly 0), then rebuilds every window's sums from the history.
+    // Once per max window dates, so the rebuild costs at most one more
+    // add per window and date, and the rounding that add/remove leaves in
+    // the sums never outlives it.
+    void RollingCovariance::recenter(size_t num_threads) {
+        const size_t padded = padded_tickers_;
+        const size_t row_doubles = 3 * padded;
+        const size_t history_rows = history_.size() / row_doubles;
+        const uint64_t kept = std::min<uint64_t>(num_dates_, history_rows);
+
+        for (size_t j = 0; j < num_tickers_; ++j) {
+            if (std::isnan(last_[j])) continue;
+            const double delta = last_[j] - shift_[j];
+            shift_[j] = last_[j];
+            for (uint64_t date = num_dates_ - kept; date < num_dates_; ++date) {
+                double* row = history_.data() + (date % history_rows) * row_doubles;
+                if (row[j] == 0.0) continue;
+                const double x = row[padded + j] - delta;
+                row[padded + j] = x;
+                row[2 * padded + j] = x * x;
+            }
+        }
+
+        const UpdateTask task{sums_.data(), tile_rows_.data(), tile_cols_.data(), windows_.data(),
+                              windows_.size(), padded, nullptr, history_.data(), history_rows,
+                              num_dates_ - kept, static_cast<size_t>(kept)};
+        const UpdateKernel& kernel = update_kernel();
+        for_ranges(tile_rows_.size(), kMinTilesPerThread, num_threads, [&](size_t begin, size_t end) {
+            kernel.rebuild(task, begin, end);
+        });
+    }
+
+    // ============================================================================
+    // Matrices
+    // ============================================================================
+
+    template <typename T, typename Fn>
+    void RollingCovariance::for_each_pair(size_t window, T* out, size_t num_threads, Fn&& fn) const {
+        const size_t n = num_tickers_;
+        const size_t num_windows = windows_.size();
+        for_ranges(tile_rows_.size(), kMinTilesPerThread, num_threads, [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; ++t) {
+                const double* sums = sums_.data() + (t * num_windows + window) * kTileSums;
+                const size_t first_i = tile_rows_[t] * kTile;
+                const size_t first_j = tile_cols_[t] * kTile;
+                // A diagonal tile holds both halves of its pairs
+                const bool diagonal = first_i == first_j;
+                for (size_t r = 0; r < kTile && first_i + r < n; ++r) {
+                    const size_t i = first_i + r;
+                    for (size_t c = 0; c < kTile && first_j + c < n; ++c) {
+                        const size_t j = first_j + c;
+                        const T value = fn(pair_sums(sums, r * kTile + c), i == j);
+                        out[i * n + j] = value;
+                        if (!diagonal) out[j * n + i] = value;
+                    }
+                }
+            }
+        });
+    }
+
+    void RollingCovariance::covariance(size_t window, double* out, size_t num_threads) const {
+        const double min_count = static_cast<double>(min_periods_);
+        for_each_pair(window, out, num_threads, [min_count](const PairSums& p, bool same) {
+            return same ? pair_variance(p, min_count) : pair_covariance(p, min_count);
+        });
+    }
+
+    void RollingCovariance::correlation(size_t window, double* out, size_t num_threads) const {
+        const double min_count = static_cast<double>(min_periods_);
+        for_each_pair(window, out, num_threads, [min_count](const PairSums& p, bool same) {
+            double corr = pair_correlation(p, min_count);
+            return same && !std::isnan(corr) ? 1.0 : corr;
+        });
+    }
+
+    void RollingCovariance::counts(size_t window, int64_t* out, size_t num_threads) const {
+        for_each_pair(window, out, num_threads, [](const PairSums& p, bool) {
+            return static_cast<int64_t>(p.count);
+        });
+    }
+
+    void RollingCovariance::shrunk_covariance(size_t window, double intensity, Target target, double* out,
+                                              size_t num_threads) const {
+        const size_t n = num_tickers_;
+        intensity = std::clamp(intensity, 0.0, 1.0);
+        covariance(window, out, num_threads);
+
+        // Mean correlation over the pairs that have one
+        double mean_corr = 0.0;
+        if (target == Target::ConstantCorrelation) {
+            const double min_count = static_cast<double>(min_periods_);
+            const size_t num_windows = windows_.size();
+            double total = 0.0;
+            size_t pairs = 0;
+            for (size_t t = 0; t < tile_rows_.size(); ++t) {
+                const double* sums = sums_.data() + (t * num_windows + window) * kTileSums;
+                const size_t first_i = tile_rows_[t] * kTile;
+                const size_t first_j = tile_cols_[t] * kTile;
+                for (size_t r = 0; r < kTile && first_i + r < n; ++r) {
+                    for (size_t c = 0; c < kTile && first_j + c < n; ++c) {
+                        if (first_j + c <= first_i + r) continue;
+                        double corr = pair_correlation(pair_sums(sums, r * kTile + c), min_count);
+                        if (std::isnan(corr)) continue;
+                        total += corr;
+                        ++pairs;
+                    }
+                }
+            }
+            mean_corr = pairs > 0 ? total / static_cast<double>(pairs) : 0.0;
+        }
+
+        for_ranges(n, kMinRowsPerThread, num_threads, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const double var_i = out[i * n + i];
+                for (size_t j = 0; j < n; ++j) {
+                    if (j == i) continue;
+                    const double var_j = out[j * n + j];
+                    double& value = out[i * n + j];
+                    if (std::isnan(var_i) || std::isnan(var_j)) {
+                        value = kNaN;
+                        continue;
+                    }
+                    const double prior = mean_corr * std::sqrt(var_i * var_j);
+                    value = std::isnan(value) ? prior : (1.0 - intensity) * value + intensity * prior;
+                }
+            }
+        });
+    }
+}
@@ -0,0 +1,307 @@
+#include "scalable_bloom_filter.hpp"
+#include <cmath>
+#include <fstream>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+namespace quantamental {
+    namespace {
+        // File layout: RawScalableHeader, then each layer in the BloomFilter
+        // file format, oldest first
+        constexpr uint32_t kScalableMagic = 0x46425351;   // "QSBF"
+        constexpr uint32_t kScalableVersion = 1;
+
+        struct RawScalableHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t layout;
+            uint32_t num_layers;
+            uint64_t initial_capacity;
+            double false_positive_rate;
+            double growth_factor;
+            double tightening_ratio;
+            double fill_threshold;
+        };
+        static_assert(sizeof(RawScalableHeader) == 56, "RawScalableHeader layout is part of the file format");
+
+        bool in_unit_interval(double x) {
+            return x > 0.0 && x < 1.0;  // False for NaN
+        }
+
+        // Each layer's FPR and capacity derive from these, so a value out of
+        // range would give a layer with no probes or no size
+        void check_params(double false_positive_rate, double growth_factor,
+                          double tightening_ratio, double fill_threshold) {
+            if (!in_unit_interval(false_positive_rate)) {
+                throw std::invalid_argument("false_positive_rate must be in (0, 1)");
+            }
+            if (!(growth_factor > 1.0 && std::isfinite(growth_factor))) {
+                throw std::invalid_argument("growth_factor must be a finite value greater than 1");
+            }
+            if (!in_unit_interval(tightening_ratio)) {
+                throw std::invalid_argument("tightening_ratio must be in (0, 1)");
+            }
+            if (!in_unit_interval(fill_threshold)) {
+                throw std::invalid_argument("fill_threshold must be in (0, 1)");
+            }
+        }
+    }
+
+    // ============================================================================
+    // Constructors
+    // ============================================================================
+
+    ScalableBloomFilter::ScalableBloomFilter(size_t initial_capacity, double false_positive_rate,
+                                             Layout layout, double growth_factor,
+                                             double tightening_ratio, double fill_threshold)
+        : ScalableBloomFilter(Params{std::max<uint64_t>(initial_capacity, 1), false_positive_rate,
+                                     growth_factor, tightening_ratio, fill_threshold, layout}) {
+        check_params(false_positive_rate, growth_factor, tightening_ratio, fill_threshold);
+        add_layer();
+    }
+
+    ScalableBloomFilter::ScalableBloomFilter(const Params& params)
+        : params_(params) {}
+
+    // ============================================================================
+    // Layers
+    // ============================================================================
+
+    size_t ScalableBloomFilter::layer_capacity(size_t i) const {
+        return static_cast<size_t>(std::ceil(params_.initial_capacity *
+                                             std::pow(params_.growth_factor, static_cast<double>(i))));
+    }
+
+    double ScalableBloomFilter::layer_false_positive_rate(size_t i) const {
+        return params_.false_positive_rate * (1.0 - params_.tightening_ratio) *
+               std::pow(params_.tightening_ratio, static_cast<double>(i));
+    }
+
+    void ScalableBloomFilter::add_layer() {
+        size_t i = layers_.size();
+        layers_.emplace_back(layer_capacity(i), layer_false_positive_rate(i), params_.layout);
+        layer_limits_.push_back(layer_limit(i));
+    }
+
+    // Insertions at which the expected fill 1 - e^(-k*n/m) reaches the
+    // threshold, or the layer reaches its target FPR if that comes first
+    // (blocked layers are sized past a fill of 1/2). Counting keys avoids a
+    // popcount of the layer per insert.
+    uint64_t ScalableBloomFilter::layer_limit(size_t i) const {
+        double m = static_cast<double>(layers_[i].size_bits());
+        double k = static_cast<double>(layers_[i].num_hashes());
+        double n = -m / k * std::log(1.0 - params_.fill_threshold);
+        return std::clamp<uint64_t>(static_cast<uint64_t>(n), 1, layer_capacity(i));
+    }
+
+    bool ScalableBloomFilter::insert_new(std::string_view key) {
+        // The newest layer lacks the key, so this always sets a bit unless
+        // the same key went into it earlier in the current batch
+        if (!layers_.back().insert_and_check(key)) return false;
+        if (layers_.back().num_insertions() >= layer_limits_.back()) {
+            add_layer();
+        }
+        return true;
+    }
+
+    // ============================================================================
+    // Core Operations
+    // ============================================================================
+
+    void ScalableBloomFilter::insert(std::string_view key) {
+        insert_and_check(key);
+    }
+
+    bool ScalableBloomFilter::possibly_contains(std::string_view key) const {
+        // Newest first: it is the largest layer and holds the recent keys
+        for (auto it = layers_.rbegin(); it != layers_.rend(); ++it) {
+            if (it->possibly_contains(key)) return true;
+        }
+        return false;
+    }
+
+    bool ScalableBloomFilter::insert_and_check(std::string_view key) {
+        if (possibly_contains(key)) return false;
+        return insert_new(key);
+    }
+
+    // ============================================================================
+    // Batch Operations
+    // ============================================================================
+
+    void ScalableBloomFilter::insert_batch(const std::vector<std::string>& keys) {
+        for (const auto& key : keys) {
+            insert_and_check(key);
+        }
+    }
+
+    std::vector<size_t> ScalableBloomFilter::filter_new(const std::vector<std::string>& keys) const {
+        std::vector<size_t> new_indices;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (!possibly_contains(keys[i])) {
+                new_indices.push_back(i);
+            }
+        }
+        return new_indices;
+    }
+
+    void ScalableBloomFilter::insert_batch(const KeyBuffer& keys, size_t num_threads) {
+        auto is_new = std::make_unique<bool[]>(keys.size());
+        filter_new_mask(keys, is_new.get(), num_threads);
+
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (is_new[i]) {
+                insert_new(keys[i]);
+            }
+        }
+    }
+
+    void ScalableBloomFilter::filter_new_mask(const KeyBuffer& keys, bool* is_new,
+                                              size_t num_threads) const {
+        // Newest layer first over the whole batch, then each older layer
+        // clears the keys it holds; stop once no key is left new
+        layers_.back().filter_new_mask(keys, is_new, num_threads);
+
+        std::unique_ptr<bool[]> layer_new;
+        for (size_t l = layers_.size() - 1; l-- > 0;) {
+            if (std::none_of(is_new, is_new + keys.size(), [](bool b) { return b; })) return;
+
+            if (!layer_new) layer_new = std::make_unique<bool[]>(keys.size());
+            layers_[l].filter_new_mask(keys, layer_new.get(), num_threads);
+            for (size_t i = 0; i < keys.size(); ++i) {
+                is_new[i] = is_new[i] && layer_new[i];
+            }
+        }
+    }
+
+    // ============================================================================
+    // Statistics
+    // ============================================================================
+
+    ScalableBloomFilter::BloomFilterStats ScalableBloomFilter::get_stats() const {
+        BloomFilterStats stats{0, 0, 0, 0, layers_.back().num_hashes(), 0.0,
+                               estimated_false_positive_rate()};
+        for (const auto& layer : layers_) {
+            BloomFilterStats layer_stats = layer.get_stats();
+            stats.num_insertions += layer_stats.num_insertions;
+            stats.num_queries += layer_stats.num_queries;
+            stats.bit_array_size += layer_stats.bit_array_size;
+            stats.bits_set += layer_stats.bits_set;
+        }
+        stats.fill_ratio = static_cast<double>(stats.bits_set) / stats.bit_array_size;
+        return stats;
+    }
+
+    double ScalableBloomFilter::fill_ratio() const {
+        return get_stats().fill_ratio;
+    }
+
+    // A key is a false positive if any layer reports it: 1 - prod(1 - p_i)
+    double ScalableBloomFilter::estimated_false_positive_rate() const {
+        double pass = 1.0;
+        for (const auto& layer : layers_) {
+            pass *= 1.0 - layer.estimated_false_positive_rate();
+        }
+        return 1.0 - pass;
+    }
+
+    double ScalableBloomFilter::false_positive_bound() const {
+        double pass = 1.0;
+        for (size_t i = 0; i < layers_.size(); ++i) {
+            pass *= 1.0 - layer_false_positive_rate(i);
+        }
+        return 1.0 - pass;
+    }
+
+    size_t ScalableBloomFilter::size_bits() const {
+        size_t bits = 0;
+        for (const auto& layer : layers_) bits += layer.size_bits();
+        return bits;
+    }
+
+    size_t ScalableBloomFilter::size_bytes() const {
+        size_t bytes = 0;
+        for (const auto& layer : layers_) bytes += layer.size_bytes();
+        return bytes;
+    }
+
+    uint64_t ScalableBloomFilter::num_insertions() const {
+        uint64_t insertions = 0;
+        for (const auto& layer : layers_) insertions += layer.num_insertions();
+        return insertions;
+    }
+
+    size_t ScalableBloomFilter::num_layers() const {
+        return layers_.size();
+    }
+
+    uint64_t ScalableBloomFilter::capacity() const {
+        uint64_t keys = 0;
+        for (uint64_t limit : layer_limits_) keys += limit;
+        return keys;
+    }
+
+    ScalableBloomFilter::Layout ScalableBloomFilter::layout() const {
+        return params_.layout;
+    }
+
+    const BloomFilter& ScalableBloomFilter::layer(size_t i) const {
+        return layers_[i];
+    }
+
+    // ============================================================================
+    // Persistence
+    // ============================================================================
+
+    bool ScalableBloomFilter::save_to_file(const std::string& filepath) const {
+        std::ofstream file(filepath, std::ios::binary);
+        if (!file) return false;
+
+        RawScalableHeader raw{kScalableMagic, kScalableVersion,
+                              static_cast<uint32_t>(params_.layout),
+                              static_cast<uint32_t>(layers_.size()),
+                              params_.initial_capacity, params_.false_positive_rate,
+                              params_.growth_factor, params_.tightening_ratio,
+                              params_.fill_threshold};
+        file.write(reinterpret_cast<const char*>(&raw), sizeof(raw));
+
+        for (const auto& layer : layers_) {
+            if (!layer.save_to_stream(file)) return false;
+        }
+        return file.good();
+    }
+
+    std::optional<ScalableBloomFilter> ScalableBloomFilter::load_from_file(const std::string& filepath) {
+        std::ifstream file(filepath, std::ios::binary);
+        if (!file) return std::nullopt;
+
+        RawScalableHeader raw;
+        file.read(reinterpret_cast<char*>(&raw), sizeof(raw));
+        if (!file || raw.magic != kScalableMagic || raw.version != kScalableVersion ||
+            raw.layout > static_cast<uint32_t>(Layout::Blocked) || raw.num_layers == 0 ||
+            raw.initial_capacity == 0 || !in_unit_interval(raw.false_positive_rate) ||
+            !(raw.growth_factor > 1.0 && std::isfinite(raw.growth_factor)) ||
+            !in_unit_interval(raw.tightening_ratio) || !in_unit_interval(raw.fill_threshold)) {
+            return std::nullopt;
+        }
+
+        ScalableBloomFilter filter(Params{raw.initial_capacity, raw.false_positive_rate,
+                                          raw.growth_factor, raw.tightening_ratio,
+                                          raw.fill_threshold, static_cast<Layout>(raw.layout)});
+        filter.layers_.reserve(raw.num_layers);
+        for (uint32_t i = 0; i < raw.num_layers; ++i) {
+            auto layer = BloomFilter::load_from_stream(file);
+            if (!layer || layer->layout() != filter.params_.layout) return std::nullopt;
+            filter.layers_.push_back(std::move(*layer));
+            filter.layer_limits_.push_back(filter.layer_limit(i));
+        }
+        return filter;
+    }
+
+    void ScalableBloomFilter::clear() {
+        layers_.clear();
+        layer_limits_.clear();
+        add_layer();
+    }
+}
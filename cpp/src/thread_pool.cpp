@@ -0,0 +1,106 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+
+namespace quantamental {
+
+    ThreadPool::ThreadPool(size_t num_threads) : stopping_(false) {
+        num_threads = std::max<size_t>(num_threads, 1);
+        workers_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::worker_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) return;  // Stopping and drained
+            run_one_task(lock);
+        }
+    }
+
+    bool ThreadPool::run_one_task(std::unique_lock<std::mutex>& lock) {
+        if (tasks_.empty()) return false;
+        std::function<void()> task = std::move(tasks_.front());
+        tasks_.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+        return true;
+    }
+
+    void ThreadPool::parallel_for(size_t count, size_t num_chunks,
+                                  const std::function<void(size_t, size_t)>& fn) {
+        if (count == 0) return;
+        num_chunks = std::clamp<size_t>(num_chunks, 1, count);
+        if (num_chunks == 1) {
+            fn(0, count);
+            return;
+        }
+
+        size_t chunk = (count + num_chunks - 1) / num_chunks;
+        num_chunks = (count + chunk - 1) / chunk;
+        std::atomic<size_t> remaining(num_chunks - 1);
+        std::condition_variable done_cv;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t c = 1; c < num_chunks; ++c) {
+                size_t begin = c * chunk;
+                size_t end = std::min(count, begin + chunk);
+                tasks_.emplace_back([&, begin, end] {
+                    fn(begin, end);
+                    // Under the lock, so the caller cannot see zero and
+                    // unwind done_cv before the notify
+                    std::lock_guard<std::mutex> done_lock(mutex_);
+                    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        done_cv.notify_all();
+                    }
+                });
+            }
+        }
+        cv_.notify_all();
+
+        fn(0, std::min(count, chunk));
+
+        // Help with queued work rather than sleeping on it
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (remaining.load(std::memory_order_acquire) != 0) {
+            if (!run_one_task(lock)) {
+                done_cv.wait(lock, [&] {
+                    return remaining.load(std::memory_order_acquire) == 0 || !tasks_.empty();
+                });
+            }
+        }
+    }
+
+    size_t ThreadPool::size() const {
+        return workers_.size();
+    }
+
+    ThreadPool& ThreadPool::shared() {
+        // The calling thread works too, so one fewer worker than cores
+        static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+        return pool;
+    }
+
+    size_t ThreadPool::resolve_threads(size_t requested, size_t count, size_t min_per_thread) {
+        size_t available = shared().size() + 1;
+        size_t wanted = requested == 0 ? available : requested;
+        size_t useful = std::max<size_t>(count / std::max<size_t>(min_per_thread, 1), 1);
+        return std::min(wanted, useful);
+    }
+}
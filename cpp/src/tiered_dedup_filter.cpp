@@ -0,0 +1,108 @@
+#include "tiered_dedup_filter.hpp"
+#include <memory>
+
+namespace quantamental {
+
+    // ============================================================================
+    // Constructors
+    // ============================================================================
+
+    TieredDedupFilter::TieredDedupFilter(std::shared_ptr<const BinaryFuseFilter> history, BloomFilter live)
+        : history_(std::move(history)), live_(std::move(live)) {}
+
+    TieredDedupFilter::TieredDedupFilter(std::shared_ptr<const BinaryFuseFilter> history,
+                                         size_t live_expected_elements,
+                                         double live_false_positive_rate, Layout layout)
+        : history_(std::move(history)),
+          live_(live_expected_elements, live_false_positive_rate, layout) {}
+
+    // ============================================================================
+    // Core Operations
+    // ============================================================================
+
+    void TieredDedupFilter::insert(std::string_view key) {
+        live_.insert(key);
+    }
+
+    bool TieredDedupFilter::possibly_contains(std::string_view key) const {
+        return history_->possibly_contains(key) || live_.possibly_contains(key);
+    }
+
+    bool TieredDedupFilter::insert_and_check(std::string_view key) {
+        if (history_->possibly_contains(key)) return false;
+        return live_.insert_and_check(key);
+    }
+
+    // ============================================================================
+    // Batch Operations
+    // ============================================================================
+
+    void TieredDedupFilter::insert_batch(const std::vector<std::string>& keys) {
+        live_.insert_batch(keys);
+    }
+
+    std::vector<size_t> TieredDedupFilter::filter_new(const std::vector<std::string>& keys) const {
+        std::vector<size_t> new_indices;
+        for (size_t i : history_->filter_new(keys)) {
+            if (!live_.possibly_contains(keys[i])) {
+                new_indices.push_back(i);
+            }
+        }
+        return new_indices;
+    }
+
+    void TieredDedupFilter::insert_batch(const KeyBuffer& keys, size_t num_threads) {
+        live_.insert_batch(keys, num_threads);
+    }
+
+    void TieredDedupFilter::filter_new_mask(const KeyBuffer& keys, bool* is_new, size_t num_threads) const {
+        history_->filter_new_mask(keys, is_new, num_threads);
+
+        auto live_new = std::make_unique<bool[]>(keys.size());
+        live_.filter_new_mask(keys, live_new.get(), num_threads);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            is_new[i] = is_new[i] && live_new[i];
+        }
+    }
+
+    // ============================================================================
+    // Statistics
+    // ============================================================================
+
+    double TieredDedupFilter::estimated_false_positive_rate() const {
+        double history_fpr = history_->num_keys() == 0 ? 0.0 : history_->false_positive_rate();
+        return 1.0 - (1.0 - history_fpr) * (1.0 - live_.estimated_false_positive_rate());
+    }
+
+    size_t TieredDedupFilter::size_bytes() const {
+        return history_->size_bytes() + live_.size_bytes();
+    }
+
+    uint64_t TieredDedupFilter::num_insertions() const {
+        return history_->num_keys() + live_.num_insertions();
+    }
+
+    // ============================================================================
+    // Tiers
+    // ============================================================================
+
+    const BinaryFuseFilter& TieredDedupFilter::history() const {
+        return *history_;
+    }
+
+    std::shared_ptr<const BinaryFuseFilter> TieredDedupFilter::shared_history() const {
+        return history_;
+    }
+
+    const BloomFilter& TieredDedupFilter::live() const {
+        return live_;
+    }
+
+    BloomFilter& TieredDedupFilter::live() {
+        return live_;
+    }
+
+    void TieredDedupFilter::set_history(std::shared_ptr<const BinaryFuseFilter> history) {
+        history_ = std::move(history);
+    }
+}
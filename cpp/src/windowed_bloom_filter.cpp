@@ -0,0 +1,386 @@
+#include "windowed_bloom_filter.hpp"
+#include "bloom_probe.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+
+namespace quantamental {
+    namespace {
+        constexpr size_t kMinKeysPerThread = 16384;   // Below this threads cost more than they save
+
+        int64_t floor_div(int64_t a, int64_t b) {
+            int64_t q = a / b;
+            return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+        }
+    }
+
+    // ============================================================================
+    // Constructor
+    // ============================================================================
+
+    WindowedBloomFilter::WindowedBloomFilter(size_t expected_per_bucket, double false_positive_rate,
+                                             uint32_t num_buckets, int64_t bucket_width)
+        : num_buckets_(std::clamp<uint32_t>(num_buckets, 1, kMaxBuckets)),
+          bucket_width_(std::max<int64_t>(bucket_width, 1)),
+          num_queries_(0) {
+        expected_per_bucket = std::max<size_t>(expected_per_bucket, 1);
+        num_slots_ = num_buckets_ + 1;
+        cell_bits_ = std::bit_ceil(num_slots_);
+        cell_shift_ = static_cast<uint32_t>(std::countr_zero(cell_bits_));
+        lane_shift_ = 6 - cell_shift_;
+
+        lane_ones_ = 0;
+        for (uint32_t lane = 0; lane < (1u << lane_shift_); ++lane) {
+            lane_ones_ |= 1ULL << (lane << cell_shift_);
+        }
+
+        num_cells_ = std::max<size_t>(
+            BloomFilter::optimal_num_bits(expected_per_bucket, false_positive_rate / num_buckets_), 2);
+        num_hashes_ = std::max<uint32_t>(BloomFilter::optimal_num_hashes(num_cells_, expected_per_bucket), 1);
+        num_words_ = (num_cells_ + (size_t(1) << lane_shift_) - 1) >> lane_shift_;
+        words_ = std::make_unique<uint64_t[]>(num_words_);
+
+        // Finish clearing a spare within half a bucket of inserts
+        expire_stride_ = std::max<size_t>((2 * num_words_ + expected_per_bucket - 1) / expected_per_bucket, 1);
+        slot_insertions_.assign(num_slots_, 0);
+
+        current_slot_ = 0;
+        spare_slot_ = 1;
+        expire_pos_ = num_words_;   // Nothing to clear yet
+        live_mask_ = ((num_slots_ == 64 ? 0 : (1ULL << num_slots_)) - 1) & ~(1ULL << spare_slot_);
+    }
+
+    // ============================================================================
+    // Cell Access
+    // ============================================================================
+    // Cell c lives in word c >> lane_shift_, at bit (c mod cells-per-word) *
+    // cell_bits_; bit s of a cell belongs to slot s.
+
+    uint64_t WindowedBloomFilter::probe_cells(detail::ProbeSequence probes) const {
+        const size_t lane_mask = (size_t(1) << lane_shift_) - 1;
+        uint64_t slots = live_mask_;
+        for (uint32_t i = 0; i < num_hashes_ && slots != 0; ++i) {
+            size_t cell = probes.next();
+            slots &= words_[cell >> lane_shift_] >> ((cell & lane_mask) << cell_shift_);
+        }
+        return slots;
+    }
+
+    bool WindowedBloomFilter::set_cells(detail::ProbeSequence probes) {
+        const size_t lane_mask = (size_t(1) << lane_shift_) - 1;
+        uint64_t newly_set = 0;
+        for (uint32_t i = 0; i < num_hashes_; ++i) {
+            size_t cell = probes.next();
+            uint64_t& word = words_[cell >> lane_shift_];
+            uint64_t bit = 1ULL << (((cell & lane_mask) << cell_shift_) + current_slot_);
+            newly_set |= bit & ~word;
+            word |= bit;
+        }
+        return newly_set != 0;
+    }
+
+    // ============================================================================
+    // Core Operations
+    // ============================================================================
+
+    void WindowedBloomFilter::insert(std::string_view key) {
+        insert_and_check(key);
+    }
+
+    bool WindowedBloomFilter::possibly_contains(std::string_view key) const {
+        detail::KeyHash hash = detail::hash_key(key.data(), key.size());
+        if (probe_cells(detail::probe_sequence(hash, num_cells_)) == 0) {
+            return false;
+        }
+        ++num_queries_;
+        return true;
+    }
+
+    bool WindowedBloomFilter::insert_and_check(std::string_view key) {
+        detail::ProbeSequence probes = detail::probe_sequence(
+            detail::hash_key(key.data(), key.size()), num_cells_);
+        bool is_new = probe_cells(probes) == 0;
+        if (set_cells(probes)) {
+            ++slot_insertions_[current_slot_];
+        }
+        expire_step(expire_stride_);
+        return is_new;
+    }
+
+    // ============================================================================
+    // Batch Operations
+    // ============================================================================
+    // Same three-stage pipeline as BloomFilter: hash a block of keys, prefetch
+    // every cell word, then probe.
+
+    template <bool Shared, typename KeyAt>
+    size_t WindowedBloomFilter::insert_range(size_t begin, size_t end, KeyAt&& key_at) {
+        const size_t lane_mask = (size_t(1) << lane_shift_) - 1;
+        constexpr size_t kBlock = detail::kBatchBlock;
+        const detail::ProbeReducer reducer(num_cells_);
+        size_t num_added = 0;
+
+        for (size_t base = begin; base < end; base += kBlock) {
+            size_t n = std::min(kBlock, end - base);
+
+            std::string_view keys[kBlock];
+            detail::KeyHash hashes[kBlock];
+            for (size_t i = 0; i < n; ++i) {
+                keys[i] = key_at(base + i);
+            }
+            detail::Murmur3Hash::hash_block(keys, n, hashes);
+
+            detail::ProbeSequence probes[kBlock];
+            for (size_t i = 0; i < n; ++i) {
+                probes[i] = detail::probe_sequence(hashes[i], reducer);
+            }
+            for (size_t i = 0; i < n; ++i) {
+                detail::ProbeSequence seq = probes[i];
+                for (uint32_t j = 0; j < num_hashes_; ++j) {
+                    BLOOM_PREFETCH_WRITE(words_.get() + (seq.next() >> lane_shift_));
+                }
+            }
+            for (size_t i = 0; i < n; ++i) {
+                if constexpr (Shared) {
+                    detail::ProbeSequence seq = probes[i];
+                    uint64_t newly_set = 0;
+                    for (uint32_t j = 0; j < num_hashes_; ++j) {
+                        size_t cell = seq.next();
+                        uint64_t bit = 1ULL << (((cell & lane_mask) << cell_shift_) + current_slot_);
+                        uint64_t old = std::atomic_ref<uint64_t>(words_[cell >> lane_shift_])
+                                           .fetch_or(bit, std::memory_order_relaxed);
+                        newly_set |= bit & ~old;
+                    }
+                    num_added += newly_set != 0;
+                } else {
+                    num_added += set_cells(probes[i]);
+                }
+            }
+        }
+        return num_added;
+    }
+
+    template <typename KeyAt>
+    size_t WindowedBloomFilter::filter_range(size_t begin, size_t end, KeyAt&& key_at, bool* is_new) const {
+        constexpr size_t kBlock = detail::kBatchBlock;
+        const detail::ProbeReducer reducer(num_cells_);
+        size_t num_seen = 0;
+
+        for (size_t base = begin; base < end; base += kBlock) {
+            size_t n = std::min(kBlock, end - base);
+
+            std::string_view keys[kBlock];
+            detail::KeyHash hashes[kBlock];
+            for (size_t i = 0; i < n; ++i) {
+                keys[i] = key_at(base + i);
+            }
+            detail::Murmur3Hash::hash_block(keys, n, hashes);
+
+            detail::ProbeSequence probes[kBlock];
+            for (size_t i = 0; i < n; ++i) {
+                probes[i] = detail::probe_sequence(hashes[i], reducer);
+            }
+            for (size_t i = 0; i < n; ++i) {
+                detail::ProbeSequence seq = probes[i];
+                for (uint32_t j = 0; j < num_hashes_; ++j) {
+                    BLOOM_PREFETCH_READ(words_.get() + (seq.next() >> lane_shift_));
+                }
+            }
+            for (size_t i = 0; i < n; ++i) {
+                is_new[base + i] = probe_cells(probes[i]) == 0;
+                num_seen += !is_new[base + i];
+            }
+        }
+        return num_seen;
+    }
+
+    void WindowedBloomFilter::insert_batch(const std::vector<std::string>& keys) {
+        slot_insertions_[current_slot_] += insert_range<false>(0, keys.size(), [&keys](size_t i) {
+            return std::string_view(keys[i]);
+        });
+        expire_step(expire_stride_ * keys.size());
+    }
+
+    std::vector<size_t> WindowedBloomFilter::filter_new(const std::vector<std::string>& keys) const {
+        auto is_new = std::make_unique<bool[]>(keys.size());
+        num_queries_ += filter_range(0, keys.size(), [&keys](size_t i) {
+            return std::string_view(keys[i]);
+        }, is_new.get());
+
+        std::vector<size_t> new_indices;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (is_new[i]) {
+                new_indices.push_back(i);
+            }
+        }
+        return new_indices;
+    }
+
+    void WindowedBloomFilter::insert_batch(const KeyBuffer& keys, size_t num_threads) {
+        auto key_at = [&keys](size_t i) { return keys[i]; };
+        size_t threads = ThreadPool::resolve_threads(num_threads, keys.size(), kMinKeysPerThread);
+
+        if (threads <= 1) {
+            slot_insertions_[current_slot_] += insert_range<false>(0, keys.size(), key_at);
+        } else {
+            std::atomic<uint64_t> num_added(0);
+            ThreadPool::shared().parallel_for(keys.size(), threads, [&](size_t begin, size_t end) {
+                num_added.fetch_add(insert_range<true>(begin, end, key_at), std::memory_order_relaxed);
+            });
+            slot_insertions_[current_slot_] += num_added.load();
+        }
+        expire_step(expire_stride_ * keys.size());
+    }
+
+    void WindowedBloomFilter::filter_new_mask(const KeyBuffer& keys, bool* is_new,
+                                              size_t num_threads) const {
+        auto key_at = [&keys](size_t i) { return keys[i]; };
+        size_t threads = ThreadPool::resolve_threads(num_threads, keys.size(), kMinKeysPerThread);
+
+        if (threads <= 1) {
+            num_queries_ += filter_range(0, keys.size(), key_at, is_new);
+            return;
+        }
+
+        std::atomic<uint64_t> num_seen(0);
+        ThreadPool::shared().parallel_for(keys.size(), threads, [&](size_t begin, size_t end) {
+            num_seen.fetch_add(filter_range(begin, end, key_at, is_new), std::memory_order_relaxed);
+        });
+        num_queries_ += num_seen.load();
+    }
+
+    // ============================================================================
+    // Window Control
+    // ============================================================================
+
+    size_t WindowedBloomFilter::advance_to(int64_t time) {
+        int64_t bucket = floor_div(time, bucket_width_);
+        if (!current_bucket_) {
+            current_bucket_ = bucket;
+            return 0;
+        }
+        if (bucket <= *current_bucket_) return 0;
+
+        size_t steps = static_cast<size_t>(bucket - *current_bucket_);
+        current_bucket_ = bucket;
+        if (steps >= num_buckets_) {
+            // The whole window expired; one pass beats rotating through it
+            std::fill_n(words_.get(), num_words_, 0);
+            std::fill(slot_insertions_.begin(), slot_insertions_.end(), 0);
+            expire_pos_ = num_words_;
+            return steps;
+        }
+        for (size_t i = 0; i < steps; ++i) {
+            rotate();
+        }
+        return steps;
+    }
+
+    void WindowedBloomFilter::rotate() {
+        // The spare takes the new bucket, so it must be fully clear first;
+        // inserts normally got there already
+        finish_expire();
+        current_slot_ = spare_slot_;
+        spare_slot_ = (current_slot_ + 1) % num_slots_;
+
+        // The oldest bucket becomes the spare: gone from queries right away,
+        // its bits cleared incrementally from here on
+        live_mask_ = (live_mask_ | (1ULL << current_slot_)) & ~(1ULL << spare_slot_);
+        slot_insertions_[spare_slot_] = 0;
+        expire_pos_ = 0;
+    }
+
+    size_t WindowedBloomFilter::expire_step(size_t max_words) {
+        size_t end = std::min(num_words_, expire_pos_ + std::min(max_words, num_words_));
+        const uint64_t keep = ~(lane_ones_ << spare_slot_);
+        for (size_t w = expire_pos_; w < end; ++w) {
+            words_[w] &= keep;
+        }
+        expire_pos_ = end;
+        return num_words_ - expire_pos_;
+    }
+
+    void WindowedBloomFilter::finish_expire() {
+        expire_step(num_words_);
+    }
+
+    // ============================================================================
+    // Statistics
+    // ============================================================================
+
+    WindowedBloomFilter::BloomFilterStats WindowedBloomFilter::get_stats() const {
+        const uint64_t live_cells = lane_ones_ * live_mask_;
+        uint64_t bits_set = 0;
+        for (size_t w = 0; w < num_words_; ++w) {
+            bits_set += std::popcount(words_[w] & live_cells);
+        }
+        uint64_t live_bits = static_cast<uint64_t>(num_cells_) * std::popcount(live_mask_);
+
+        return BloomFilterStats{
+            num_insertions(),
+            num_queries_,
+            live_bits,
+            bits_set,
+            num_hashes_,
+            static_cast<double>(bits_set) / live_bits,
+            estimated_false_positive_rate()
+        };
+    }
+
+    double WindowedBloomFilter::fill_ratio() const {
+        return get_stats().fill_ratio;
+    }
+
+    // A key is a false positive if any live bucket reports it: 1 - prod(1 - p_i)
+    double WindowedBloomFilter::estimated_false_positive_rate() const {
+        double pass = 1.0;
+        for (uint32_t s = 0; s < num_slots_; ++s) {
+            if (live_mask_ & (1ULL << s)) {
+                pass *= 1.0 - BloomFilter::false_positive_rate(num_cells_, slot_insertions_[s], num_hashes_);
+            }
+        }
+        return 1.0 - pass;
+    }
+
+    size_t WindowedBloomFilter::size_bits() const {
+        return num_words_ * 64;
+    }
+
+    size_t WindowedBloomFilter::size_bytes() const {
+        return num_words_ * sizeof(uint64_t);
+    }
+
+    uint64_t WindowedBloomFilter::num_insertions() const {
+        uint64_t insertions = 0;
+        for (uint32_t s = 0; s < num_slots_; ++s) {
+            if (live_mask_ & (1ULL << s)) insertions += slot_insertions_[s];
+        }
+        return insertions;
+    }
+
+    uint32_t WindowedBloomFilter::num_buckets() const {
+        return num_buckets_;
+    }
+
+    int64_t WindowedBloomFilter::bucket_width() const {
+        return bucket_width_;
+    }
+
+    std::optional<int64_t> WindowedBloomFilter::current_bucket() const {
+        return current_bucket_;
+    }
+
+    size_t WindowedBloomFilter::pending_expire_words() const {
+        return num_words_ - expire_pos_;
+    }
+
+    void WindowedBloomFilter::clear() {
+        std::fill_n(words_.get(), num_words_, 0);
+        std::fill(slot_insertions_.begin(), slot_insertions_.end(), 0);
+        num_queries_ = 0;
+        expire_pos_ = num_words_;
+        current_bucket_.reset();
+    }
+}
@@ -0,0 +1,160 @@
+// Tests for Backtester
+#include <gtest/gtest.h>
+
+#include "backtester.hpp"
+#include "test_helpers.hpp"
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace quantamental;
+using namespace quantamental::test;
+
+struct Panels {
+    std::vector<double> scores;
+    std::vector<double> returns;
+    std::vector<double> volatility;
+};
+
+Panels random_panels(size_t num_dates, size_t num_tickers, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    std::uniform_real_distribution<double> vol(0.01, 0.04);
+    Panels panels;
+    for (size_t k = 0; k < num_dates * num_tickers; ++k) {
+        panels.scores.push_back(normal(rng));
+        panels.returns.push_back(0.01 * normal(rng) + 0.002 * panels.scores.back());
+        panels.volatility.push_back(vol(rng));
+    }
+    // Gaps keep tickers out of the book
+    panels.scores[3] = kNaN;
+    panels.returns[7] = kNaN;
+    return panels;
+}
+
+// Two dates of four names, long the best and short the worst
+TEST(Backtester, TopBottomMatchesAHandComputedBook) {
+    const std::vector<double> scores{4.0, 3.0, 2.0, 1.0,
+                                     1.0, 2.0, 3.0, 4.0};
+    const std::vector<double> returns{0.02, 0.0, 0.0, -0.01,
+                                      0.01, 0.0, 0.0, 0.03};
+    auto backtester = Backtester::create(scores.data(), returns.data(), nullptr, nullptr, 2, 4, 1);
+    ASSERT_TRUE(backtester.has_value());
+
+    BacktestConfig config;
+    config.top_k = 1;
+    config.cost_bps = 10.0;
+    BacktestSummary summary;
+    std::vector<double> series(Backtester::kNumSeries * 2);
+    ASSERT_TRUE(backtester->run(config, summary, series.data()));
+
+    // Day 0 trades in from cash
+    const double net0 = 0.5 * 0.02 + 0.5 * 0.01 - 1.0 * 1e-3;
+    // Day 1 flips the drifted book
+    const double drifted_long = 0.5 * 1.02 / (1.0 + net0);
+    const double drifted_short = -0.5 * 0.99 / (1.0 + net0);
+    const double turnover1 = std::abs(-0.5 - drifted_long) + std::abs(0.5 - drifted_short);
+    const double gross1 = -0.5 * 0.01 + 0.5 * 0.03;
+    const double net1 = gross1 - turnover1 * 1e-3;
+
+    EXPECT_NEAR(series[Backtester::NetReturn * 2 + 0], net0, 1e-15);
+    EXPECT_NEAR(series[Backtester::NetReturn * 2 + 1], net1, 1e-15);
+    EXPECT_NEAR(series[Backtester::GrossReturn * 2 + 1], gross1, 1e-15);
+    EXPECT_NEAR(series[Backtester::Turnover * 2 + 0], 1.0, 1e-15);
+    EXPECT_NEAR(series[Backtester::Turnover * 2 + 1], turnover1, 1e-15);
+    EXPECT_NEAR(summary.total_return, (1.0 + net0) * (1.0 + net1) - 1.0, 1e-15);
+    EXPECT_NEAR(summary.total_cost, (1.0 + turnover1) * 1e-3, 1e-15);
+    EXPECT_EQ(summary.hit_rate, 1.0);
+    EXPECT_EQ(summary.max_drawdown, 0.0);
+}
+
+TEST(Backtester, RejectsConfigsItCannotRun) {
+    const Panels panels = random_panels(10, 8, 1);
+    EXPECT_FALSE(Backtester::create(panels.scores.data(), panels.returns.data(), nullptr, nullptr, 0, 8).has_value());
+
+    auto backtester = Backtester::create(panels.scores.data(), panels.returns.data(), nullptr, nullptr, 10, 8);
+    ASSERT_TRUE(backtester.has_value());
+    BacktestConfig config;
+    config.top_k = 0;
+    EXPECT_FALSE(backtester->accepts(config));
+    config.top_k = 2;
+    config.weighting = Weighting::VolScaled;   // No volatility panel
+    EXPECT_FALSE(backtester->accepts(config));
+    BacktestSummary summary;
+    EXPECT_FALSE(backtester->run(config, summary));
+    config.weighting = Weighting::Rank;
+    config.cost_bps = -1.0;
+    EXPECT_FALSE(backtester->accepts(config));
+    config.cost_bps = 5.0;
+    EXPECT_TRUE(backtester->accepts(config));
+}
+
+// Scores equal to the target rank perfectly on every date
+TEST(Backtester, ScoresEqualToTheTargetHaveUnitIC) {
+    const Panels panels = random_panels(20, 12, 2);
+    auto backtester = Backtester::create(panels.returns.data(), panels.returns.data(), nullptr, nullptr, 20, 12);
+    ASSERT_TRUE(backtester.has_value());
+    ASSERT_EQ(backtester->ic().size(), 20u);
+    for (size_t d = 0; d < 20; ++d) {
+        EXPECT_NEAR(backtester->ic()[d], 1.0, 1e-12) << "date " << d;
+        EXPECT_NEAR(backtester->rank_ic()[d], 1.0, 1e-12) << "date " << d;
+    }
+}
+
+TEST(Backtester, MaxTurnoverCapsEveryRebalance) {
+    const size_t D = 30, T = 40;
+    const Panels panels = random_panels(D, T, 3);
+    auto backtester = Backtester::create(panels.scores.data(), panels.returns.data(), nullptr, nullptr, D, T);
+    ASSERT_TRUE(backtester.has_value());
+
+    BacktestConfig config;
+    config.top_k = 5;
+    config.max_turnover = 0.3;
+    BacktestSummary summary;
+    std::vector<double> series(Backtester::kNumSeries * D);
+    ASSERT_TRUE(backtester->run(config, summary, series.data()));
+    EXPECT_NEAR(series[Backtester::Turnover * D], 0.3, 1e-12);
+    for (size_t d = 0; d < D; ++d) EXPECT_LE(series[Backtester::Turnover * D + d], 0.3 + 1e-12);
+}
+
+TEST(Backtester, SweepMatchesSingleRuns) {
+    const size_t D = 60, T = 50;
+    const Panels panels = random_panels(D, T, 4);
+    auto backtester = Backtester::create(panels.scores.data(), panels.returns.data(), panels.volatility.data(),
+                                         nullptr, D, T, 3);
+    ASSERT_TRUE(backtester.has_value());
+
+    std::vector<BacktestConfig> configs(4);
+    configs[0].top_k = 5;
+    configs[1].weighting = Weighting::Rank;
+    configs[1].gross_exposure = 2.0;
+    configs[2].weighting = Weighting::VolScaled;
+    configs[2].top_k = 10;
+    configs[3].long_only = true;
+    configs[3].top_k = 8;
+    configs[3].max_turnover = 0.5;
+
+    const size_t stride = Backtester::kNumSeries * D;
+    std::vector<BacktestSummary> summaries(configs.size());
+    std::vector<double> series(configs.size() * stride);
+    ASSERT_TRUE(backtester->sweep(configs.data(), configs.size(), summaries.data(), series.data()));
+
+    for (size_t c = 0; c < configs.size(); ++c) {
+        SCOPED_TRACE("config " + std::to_string(c));
+        BacktestSummary single;
+        std::vector<double> single_series(stride);
+        ASSERT_TRUE(backtester->run(configs[c], single, single_series.data()));
+        EXPECT_TRUE(same_double(summaries[c].total_return, single.total_return));
+        EXPECT_TRUE(same_double(summaries[c].sharpe, single.sharpe));
+        EXPECT_TRUE(same_double(summaries[c].mean_turnover, single.mean_turnover));
+        for (size_t k = 0; k < stride; ++k) {
+            ASSERT_TRUE(same_double(series[c * stride + k], single_series[k])) << "element " << k;
+        }
+    }
+}
+
+}
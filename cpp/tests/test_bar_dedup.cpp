@@ -0,0 +1,91 @@
+// Tests for BarDeduplicator
+#include <gtest/gtest.h>
+
+#include "bar_dedup.hpp"
+#include "test_helpers.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using namespace quantamental;
+using namespace quantamental::test;
+
+using Status = BarDeduplicator::Status;
+
+TEST(BarDeduplicator, ClassifiesRepeatsWithinAndAcrossBatches) {
+    BarDeduplicator dedup(1000);
+    const std::vector<uint32_t> ids{1, 2, 1, 1};
+    const std::vector<int64_t> timestamps{100, 100, 100, 200};
+    const std::vector<double> values{1.0, 2.0, 3.0, 4.0};
+    BarBatch batch{ids.data(), timestamps.data(), nullptr, values.data(), 1, ids.size()};
+
+    std::vector<Status> status(batch.size);
+    EXPECT_EQ(dedup.classify(batch, status.data()), 3u);
+    EXPECT_EQ(status, (std::vector<Status>{Status::New, Status::New, Status::Duplicate, Status::New}));
+
+    // The same bars again are all resends
+    EXPECT_EQ(dedup.classify(batch, status.data()), 0u);
+    for (Status s : status) EXPECT_EQ(s, Status::Duplicate);
+}
+
+TEST(BarDeduplicator, NewRevisionsAreKept) {
+    BarDeduplicator dedup(1000);
+    const std::vector<uint32_t> ids{7, 7, 7, 7};
+    const std::vector<int64_t> timestamps{100, 100, 100, 200};
+    const std::vector<int64_t> revisions{1, 1, 2, 1};
+    BarBatch batch{ids.data(), timestamps.data(), revisions.data(), nullptr, 0, ids.size()};
+
+    std::vector<Status> status(batch.size);
+    EXPECT_EQ(dedup.classify(batch, status.data()), 3u);
+    EXPECT_EQ(status, (std::vector<Status>{Status::New, Status::Duplicate, Status::Revised, Status::New}));
+}
+
+TEST(BarDeduplicator, IngestCompactsKeptRowsInOrder) {
+    BarDeduplicator dedup(1000);
+    const std::vector<uint32_t> ids{3, 3, 4, 3};
+    const std::vector<int64_t> timestamps{10, 10, 10, 10};
+    const std::vector<int64_t> revisions{0, 0, 0, 5};
+    const std::vector<double> values{1.0, 1.5, 2.0, 2.5, 3.0, 3.5, 4.0, 4.5};
+    BarBatch batch{ids.data(), timestamps.data(), revisions.data(), values.data(), 2, ids.size()};
+
+    std::vector<Status> status(batch.size);
+    std::vector<uint32_t> out_ids(batch.size);
+    std::vector<int64_t> out_timestamps(batch.size), out_revisions(batch.size);
+    std::vector<double> out_values(batch.size * 2);
+    BarColumns out{out_ids.data(), out_timestamps.data(), out_revisions.data(), out_values.data()};
+
+    ASSERT_EQ(dedup.ingest(batch, status.data(), out), 3u);
+    EXPECT_EQ(std::vector<uint32_t>(out_ids.begin(), out_ids.begin() + 3), (std::vector<uint32_t>{3, 4, 3}));
+    EXPECT_EQ(std::vector<int64_t>(out_revisions.begin(), out_revisions.begin() + 3), (std::vector<int64_t>{0, 0, 5}));
+    EXPECT_EQ(std::vector<double>(out_values.begin(), out_values.begin() + 6),
+              (std::vector<double>{1.0, 1.5, 3.0, 3.5, 4.0, 4.5}));
+}
+
+// A deduplicator resumed from its saved filter still knows every bar
+TEST(BarDeduplicator, ResumesFromASavedFilter) {
+    BarDeduplicator dedup(1000);
+    std::vector<uint32_t> ids;
+    std::vector<int64_t> timestamps;
+    for (uint32_t i = 0; i < 200; ++i) {
+        ids.push_back(i % 20);
+        timestamps.push_back(1000 + i);
+    }
+    BarBatch batch{ids.data(), timestamps.data(), nullptr, nullptr, 0, ids.size()};
+    std::vector<Status> status(batch.size);
+    ASSERT_EQ(dedup.classify(batch, status.data()), batch.size);
+
+    const std::string path = temp_path("bar_dedup.bloom");
+    ASSERT_TRUE(dedup.filter().save_to_file(path));
+    auto loaded = BloomFilter::load_from_file(path);
+    ASSERT_TRUE(loaded.has_value());
+    BarDeduplicator resumed(std::move(*loaded));
+    EXPECT_EQ(resumed.classify(batch, status.data()), 0u);
+    std::remove(path.c_str());
+}
+
+}
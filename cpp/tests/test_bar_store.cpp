@@ -0,0 +1,134 @@
+// Tests for BarStore
+#include <gtest/gtest.h>
+
+#include "bar_store.hpp"
+#include "test_helpers.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace quantamental;
+using namespace quantamental::test;
+
+// Field-major rows whose values encode (date, field, ticker)
+std::vector<double> make_rows(const std::vector<int64_t>& dates, size_t num_tickers) {
+    std::vector<double> values;
+    for (int64_t date : dates) {
+        for (size_t f = 0; f < BarStore::kNumFields; ++f) {
+            for (size_t j = 0; j < num_tickers; ++j) {
+                values.push_back(static_cast<double>(date * 100 + static_cast<int64_t>(f * 10 + j)));
+            }
+        }
+    }
+    return values;
+}
+
+double expected_value(int64_t date, BarStore::Field field, size_t ticker) {
+    return static_cast<double>(date * 100 + static_cast<int64_t>(static_cast<size_t>(field) * 10 + ticker));
+}
+
+void remove_store(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + ".lock").c_str());
+}
+
+TEST(BarStore, AppendedBarsReadBackAfterReopen) {
+    const std::string path = temp_path("bar_store_reopen.bin");
+    remove_store(path);
+    {
+        auto store = BarStore::create(path, {"AAPL", "MSFT"}, 8, "America/New_York");
+        ASSERT_TRUE(store.has_value());
+        const std::vector<int64_t> dates{10, 20, 30};
+        const std::vector<double> values = make_rows(dates, 2);
+        ASSERT_TRUE(store->append(dates.data(), dates.size(), values.data()));
+        // Dates must increase past the last one
+        const int64_t stale = 30;
+        EXPECT_FALSE(store->append(&stale, 1, values.data()));
+        ASSERT_TRUE(store->flush());
+    }
+
+    auto store = BarStore::open(path);
+    ASSERT_TRUE(store.has_value());
+    EXPECT_FALSE(store->writable());
+    EXPECT_EQ(store->timezone(), "America/New_York");
+    ASSERT_EQ(store->num_dates(), 3u);
+    EXPECT_EQ(store->dates()[2], 30);
+    EXPECT_EQ(store->find_ticker("MSFT"), std::optional<size_t>(1));
+    EXPECT_FALSE(store->find_ticker("GOOG").has_value());
+    EXPECT_EQ(store->date_rows(15, 30), std::make_pair(size_t{1}, size_t{3}));
+
+    for (size_t j = 0; j < 2; ++j) {
+        const double* close = store->column(BarStore::Field::Close, j);
+        for (size_t row = 0; row < 3; ++row) {
+            EXPECT_EQ(close[row], expected_value(store->dates()[row], BarStore::Field::Close, j));
+        }
+    }
+    // Read-only stores refuse writes
+    const int64_t next = 40;
+    const std::vector<double> values = make_rows({next}, 2);
+    EXPECT_FALSE(store->append(&next, 1, values.data()));
+    EXPECT_FALSE(store->add_ticker("GOOG").has_value());
+    remove_store(path);
+}
+
+TEST(BarStore, GrowingPastCapacityKeepsEveryBar) {
+    const std::string path = temp_path("bar_store_grow.bin");
+    remove_store(path);
+    auto store = BarStore::create(path, {"AAPL"}, 2);
+    ASSERT_TRUE(store.has_value());
+
+    std::vector<int64_t> dates;
+    for (int64_t d = 1; d <= 9; ++d) {
+        dates.push_back(d);
+        const std::vector<double> values = make_rows({d}, store->num_tickers());
+        ASSERT_TRUE(store->append(&d, 1, values.data()));
+        if (d == 4) {
+            // A late ticker is NaN for every earlier date
+            ASSERT_EQ(store->add_ticker("MSFT"), std::optional<size_t>(1));
+            EXPECT_FALSE(store->add_ticker("AAPL").has_value());
+        }
+    }
+
+    ASSERT_EQ(store->num_dates(), dates.size());
+    for (size_t row = 0; row < dates.size(); ++row) {
+        EXPECT_EQ(store->column(BarStore::Field::Open, 0)[row], expected_value(dates[row], BarStore::Field::Open, 0));
+        const double msft = store->column(BarStore::Field::Volume, 1)[row];
+        if (dates[row] <= 4) {
+            EXPECT_TRUE(std::isnan(msft)) << "row " << row;
+        } else {
+            EXPECT_EQ(msft, expected_value(dates[row], BarStore::Field::Volume, 1)) << "row " << row;
+        }
+    }
+    remove_store(path);
+}
+
+TEST(BarStore, OneWriterAndReadersCatchUp) {
+    const std::string path = temp_path("bar_store_writer.bin");
+    remove_store(path);
+    auto writer = BarStore::create(path, {"AAPL"}, 4);
+    ASSERT_TRUE(writer.has_value());
+    EXPECT_FALSE(BarStore::open(path, true).has_value());
+
+    auto reader = BarStore::open(path);
+    ASSERT_TRUE(reader.has_value());
+    const int64_t date = 5;
+    const std::vector<double> values = make_rows({date}, 1);
+    ASSERT_TRUE(writer->append(&date, 1, values.data()));
+    // Appends in place show through the shared header
+    EXPECT_EQ(reader->num_dates(), 1u);
+
+    ASSERT_TRUE(writer->add_ticker("MSFT").has_value());
+    ASSERT_TRUE(reader->refresh());
+    EXPECT_EQ(reader->tickers(), (std::vector<std::string>{"AAPL", "MSFT"}));
+
+    writer.reset();
+    EXPECT_TRUE(BarStore::open(path, true).has_value());
+    remove_store(path);
+}
+
+}
@@ -0,0 +1,112 @@
+// Tests for BinaryFuseFilter and TieredDedupFilter
+#include <gtest/gtest.h>
+
+#include "binary_fuse_filter.hpp"
+#include "key_buffer.hpp"
+#include "test_helpers.hpp"
+#include "tiered_dedup_filter.hpp"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace quantamental;
+using namespace quantamental::test;
+
+// ============================================================================
+// BinaryFuseFilter
+// ============================================================================
+
+// No false negatives, repeats counted once, and absent keys hit at about
+// 2^-fingerprint bits
+TEST(BinaryFuseFilter, HoldsEveryKeyWithinTheFalsePositiveRate) {
+    auto keys = make_keys(20000);
+    const auto distinct = keys.size();
+    const auto repeats = make_keys(500);
+    keys.insert(keys.end(), repeats.begin(), repeats.end());
+    const auto absent = make_keys(200000, "MSFT|");
+    for (auto fingerprint : {BinaryFuseFilter::Fingerprint::Bits8, BinaryFuseFilter::Fingerprint::Bits16}) {
+        auto filter = BinaryFuseFilter::build(keys, fingerprint, 2);
+        ASSERT_TRUE(filter);
+        EXPECT_EQ(filter->num_keys(), distinct);
+        for (const auto& key : keys) ASSERT_TRUE(filter->possibly_contains(key));
+
+        size_t hits = 0;
+        for (const auto& key : absent) hits += filter->possibly_contains(key);
+        const double rate = static_cast<double>(hits) / absent.size();
+        EXPECT_LT(rate, 2.0 * filter->false_positive_rate()) << static_cast<int>(fingerprint) << " bits";
+    }
+}
+
+TEST(BinaryFuseFilter, FilterNewMaskMatchesSingleQueries) {
+    const size_t width = 12;
+    const size_t count = 30000;
+    std::string column(count * width, ' ');
+    std::vector<std::string> built;
+    for (size_t i = 0; i < count; ++i) {
+        std::string key = "K" + std::to_string(i * 7);
+        column.replace(i * width, key.size(), key);
+        if (i % 3 == 0) built.push_back(column.substr(i * width, width));
+    }
+    auto filter = BinaryFuseFilter::build(built);
+    ASSERT_TRUE(filter);
+
+    const KeyBuffer keys = KeyBuffer::fixed_width(column.data(), count, width);
+    std::unique_ptr<bool[]> is_new(new bool[count]);
+    filter->filter_new_mask(keys, is_new.get(), 4);
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT_EQ(is_new[i], !filter->possibly_contains(keys[i])) << i;
+        if (i % 3 == 0) {
+            ASSERT_FALSE(is_new[i]) << i;
+        }
+    }
+}
+
+TEST(BinaryFuseFilter, RoundTripsThroughFiles) {
+    auto keys = make_keys(5000);
+    const std::string path = temp_path("round_trip.bff");
+    for (auto fingerprint : {BinaryFuseFilter::Fingerprint::Bits8, BinaryFuseFilter::Fingerprint::Bits16}) {
+        auto filter = BinaryFuseFilter::build(keys, fingerprint, 1);
+        ASSERT_TRUE(filter);
+        ASSERT_TRUE(filter->save_to_file(path));
+        auto loaded = BinaryFuseFilter::load_from_file(path);
+        auto mapped = BinaryFuseFilter::open_mapped(path, true);
+        ASSERT_TRUE(loaded);
+        ASSERT_TRUE(mapped);
+        EXPECT_EQ(loaded->num_keys(), filter->num_keys());
+        EXPECT_EQ(loaded->fingerprint(), fingerprint);
+        for (const auto& key : keys) {
+            ASSERT_TRUE(loaded->possibly_contains(key));
+            ASSERT_TRUE(mapped->possibly_contains(key));
+        }
+        for (const auto& key : make_keys(2000, "MSFT|")) {
+            EXPECT_EQ(loaded->possibly_contains(key), filter->possibly_contains(key));
+        }
+    }
+    std::remove(path.c_str());
+}
+
+// ============================================================================
+// TieredDedupFilter
+// ============================================================================
+
+// A key is new only while it is in neither the frozen history nor the
+// live filter
+TEST(TieredDedupFilter, NewOnlyWhenInNeitherTier) {
+    const auto history_keys = make_keys(5000);
+    auto history = BinaryFuseFilter::build(history_keys, BinaryFuseFilter::Fingerprint::Bits16);
+    ASSERT_TRUE(history);
+    TieredDedupFilter dedup(std::make_shared<const BinaryFuseFilter>(std::move(*history)), 10000, 0.001);
+
+    for (const auto& key : history_keys) EXPECT_FALSE(dedup.insert_and_check(key));
+    size_t new_keys = 0;
+    for (const auto& key : make_keys(5000, "MSFT|")) new_keys += dedup.insert_and_check(key);
+    EXPECT_GT(new_keys, 4900u);   // A few may collide with the history fingerprints
+    for (const auto& key : make_keys(5000, "MSFT|")) EXPECT_FALSE(dedup.insert_and_check(key));
+    EXPECT_TRUE(dedup.filter_new(make_keys(5000, "MSFT|")).empty());
+}
+
+}
@@ -0,0 +1,387 @@
+// Tests for BloomFilter and its hash kernels
+#include <gtest/gtest.h>
+
+#include "bloom_filter.hpp"
+#include "bloom_probe.hpp"
+#include "key_buffer.hpp"
+#include "murmur_hash3.hpp"
+#include "test_helpers.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using namespace quantamental;
+using namespace quantamental::test;
+
+// ============================================================================
+// Blocked Layout
+// ============================================================================
+
+// Whole 512-bit blocks, no false negatives, and absent keys hit at about
+// the rate the filter was sized for
+TEST(BlockedLayout, HoldsEveryKeyNearTheTargetRate) {
+    const auto keys = make_keys(20000);
+    const auto absent = make_keys(200000, "MSFT|");
+    for (double rate : {0.01, 0.001}) {
+        BloomFilter filter(keys.size(), rate, BloomFilter::Layout::Blocked);
+        EXPECT_EQ(filter.layout(), BloomFilter::Layout::Blocked);
+        EXPECT_EQ(filter.size_bits() % BloomFilter::kBlockBits, 0u);
+        filter.insert_batch(keys);
+        for (const auto& key : keys) ASSERT_TRUE(filter.possibly_contains(key));
+
+        size_t hits = 0;
+        for (const auto& key : absent) hits += filter.possibly_contains(key);
+        EXPECT_LT(static_cast<double>(hits) / absent.size(), 1.5 * rate) << rate;
+        EXPECT_LE(filter.estimated_false_positive_rate(), rate);
+    }
+}
+
+// The batch paths give what one call per key gives
+TEST(BlockedLayout, BatchCallsMatchSingleCalls) {
+    const auto keys = make_keys(5000);
+    BloomFilter single(keys.size(), 0.01, BloomFilter::Layout::Blocked);
+    BloomFilter batch(keys.size(), 0.01, BloomFilter::Layout::Blocked);
+    for (size_t i = 0; i < keys.size(); i += 2) {
+        single.insert(keys[i]);
+        batch.insert(keys[i]);
+    }
+
+    std::vector<size_t> expected;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (!single.possibly_contains(keys[i])) expected.push_back(i);
+    }
+    EXPECT_EQ(batch.filter_new(keys), expected);
+
+    std::vector<std::string_view> views(keys.begin(), keys.end());
+    std::unique_ptr<bool[]> is_new(new bool[views.size()]);
+    batch.insert_and_check_batch(views.data(), views.size(), is_new.get());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ASSERT_EQ(is_new[i], single.insert_and_check(keys[i])) << i;
+    }
+    EXPECT_EQ(batch.get_stats().bits_set, single.get_stats().bits_set);
+}
+
+// Filters smaller than one block still work in the Standard layout
+TEST(BlockedLayout, TinyStandardFiltersWork) {
+    for (size_t num_bits : {size_t{1}, size_t{63}, size_t{100}, size_t{511}}) {
+        BloomFilter filter(num_bits, uint32_t{3});
+        filter.insert_batch(make_keys(10));
+        for (const auto& key : make_keys(10)) EXPECT_TRUE(filter.possibly_contains(key)) << num_bits;
+    }
+    BloomFilter empty(size_t{0}, 0.01);
+    empty.insert("AAPL");
+    EXPECT_TRUE(empty.possibly_contains("AAPL"));
+}
+
+// ============================================================================
+// Key Hashing
+// ============================================================================
+
+// The multi-key kernel hashes equal-length keys in SIMD lanes; every lane
+// must give the scalar MurmurHash3_x64_128, whatever the count and length
+TEST(KeyHashing, MultiKeyLanesMatchScalar) {
+    std::mt19937_64 rng(3);
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (int len = 0; len <= 70; ++len) {
+        for (size_t count = 1; count <= detail::kBatchBlock; ++count) {
+            std::vector<std::string> keys(count);
+            std::vector<const void*> pointers(count);
+            for (size_t i = 0; i < count; ++i) {
+                for (int b = 0; b < len; ++b) keys[i].push_back(static_cast<char>(byte(rng)));
+                pointers[i] = keys[i].data();
+            }
+            std::vector<uint64_t> lanes(2 * count);
+            MurmurHash3_x64_128_multi(pointers.data(), count, len, 0, lanes.data());
+            for (size_t i = 0; i < count; ++i) {
+                uint64_t scalar[2];
+                MurmurHash3_x64_128(keys[i].data(), len, 0, scalar);
+                ASSERT_EQ(lanes[2 * i], scalar[0])
+                    << MurmurHash3_multi_backend() << " len " << len << " count " << count;
+                ASSERT_EQ(lanes[2 * i + 1], scalar[1])
+                    << MurmurHash3_multi_backend() << " len " << len << " count " << count;
+            }
+        }
+    }
+}
+
+TEST(KeyHashing, HashBlockMatchesPerKeyHash) {
+    // Mixed lengths, so the block is split into several length groups
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < detail::kBatchBlock; ++i) {
+        keys.push_back("T" + std::string(i % 5, 'x') + "|" + std::to_string(i * 7919));
+    }
+    std::vector<std::string_view> views(keys.begin(), keys.end());
+    for (auto scheme : {BloomFilter::HashScheme::DoubleHashing, BloomFilter::HashScheme::WyHash}) {
+        std::vector<detail::KeyHash> block(views.size());
+        detail::hash_block(scheme, views.data(), views.size(), block.data());
+        for (size_t i = 0; i < views.size(); ++i) {
+            detail::KeyHash single = detail::hash_key(scheme, views[i].data(), views[i].size());
+            EXPECT_EQ(block[i].h1, single.h1);
+            EXPECT_EQ(block[i].h2, single.h2);
+        }
+    }
+}
+
+// The batch path hashes through hash_block; it must set the same bits as
+// inserting the keys one at a time
+TEST(KeyHashing, BatchInsertMatchesSingleInserts) {
+    auto keys = make_keys(5000);
+    for (auto layout : {BloomFilter::Layout::Standard, BloomFilter::Layout::Blocked}) {
+        for (auto scheme : {BloomFilter::HashScheme::DoubleHashing, BloomFilter::HashScheme::WyHash}) {
+            BloomFilter single(keys.size(), 0.01, layout, scheme);
+            BloomFilter batch(keys.size(), 0.01, layout, scheme);
+            for (const auto& key : keys) single.insert(key);
+            batch.insert_batch(keys);
+            EXPECT_EQ(single.get_stats().bits_set, batch.get_stats().bits_set);
+            for (const auto& key : make_keys(2000, "MSFT|")) {
+                EXPECT_EQ(single.possibly_contains(key), batch.possibly_contains(key));
+            }
+        }
+    }
+}
+
+// ============================================================================
+// Filter Files
+// ============================================================================
+
+TEST(FilterFiles, BloomFilterRoundTrips) {
+    auto keys = make_keys(3000);
+    auto others = make_keys(3000, "MSFT|");
+    const std::string path = temp_path("round_trip.bf");
+    for (auto layout : {BloomFilter::Layout::Standard, BloomFilter::Layout::Blocked}) {
+        for (auto scheme : {BloomFilter::HashScheme::DoubleHashing, BloomFilter::HashScheme::WyHash}) {
+            BloomFilter filter(keys.size(), 0.01, layout, scheme);
+            filter.insert_batch(keys);
+            ASSERT_TRUE(filter.save_to_file(path));
+
+            auto loaded = BloomFilter::load_from_file(path);
+            auto mapped = BloomFilter::open_mapped(path, BloomFilter::MapMode::ReadOnly, true);
+            ASSERT_TRUE(loaded);
+            ASSERT_TRUE(mapped);
+            EXPECT_TRUE(loaded->verify_checksum());
+            EXPECT_TRUE(mapped->is_mapped());
+            EXPECT_EQ(loaded->get_stats().num_insertions, filter.get_stats().num_insertions);
+            EXPECT_EQ(loaded->get_stats().bits_set, filter.get_stats().bits_set);
+            for (const auto& key : keys) {
+                ASSERT_TRUE(loaded->possibly_contains(key));
+                ASSERT_TRUE(mapped->possibly_contains(key));
+            }
+            for (const auto& key : others) {
+                EXPECT_EQ(loaded->possibly_contains(key), filter.possibly_contains(key));
+                EXPECT_EQ(mapped->possibly_contains(key), filter.possibly_contains(key));
+            }
+        }
+    }
+    std::remove(path.c_str());
+}
+
+TEST(FilterFiles, TruncatedBloomFileIsRejected) {
+    const std::string path = temp_path("truncated.bf");
+    BloomFilter filter(10000, 0.01);
+    filter.insert_batch(make_keys(1000));
+    ASSERT_TRUE(filter.save_to_file(path));
+
+    std::ifstream in(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size() - 8);
+    EXPECT_FALSE(BloomFilter::load_from_file(path));
+    EXPECT_FALSE(BloomFilter::open_mapped(path));
+    std::remove(path.c_str());
+}
+
+// Files from before the header: four counters and the words, read with one
+// MurmurHash3 per probe seeded by the probe's index
+TEST(FilterFiles, HeaderlessBloomFileLoadsAsSeeded) {
+    const uint64_t num_bits = 4096;
+    const uint32_t num_hashes = 4;
+    std::vector<uint64_t> words(num_bits / 64, 0);
+    auto keys = make_keys(200);
+    for (const auto& key : keys) {
+        for (uint32_t i = 0; i < num_hashes; ++i) {
+            uint64_t hash[2];
+            MurmurHash3_x64_128(key.data(), static_cast<int>(key.size()), i, hash);
+            const uint64_t bit = hash[0] % num_bits;
+            words[bit / 64] |= 1ULL << (bit % 64);
+        }
+    }
+
+    const std::string path = temp_path("headerless.bf");
+    {
+        std::ofstream out(path, std::ios::binary);
+        const uint64_t num_insertions = keys.size();
+        const uint64_t num_queries = 0;
+        out.write(reinterpret_cast<const char*>(&num_bits), sizeof(num_bits));
+        out.write(reinterpret_cast<const char*>(&num_hashes), sizeof(num_hashes));
+        out.write(reinterpret_cast<const char*>(&num_insertions), sizeof(num_insertions));
+        out.write(reinterpret_cast<const char*>(&num_queries), sizeof(num_queries));
+        out.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint64_t));
+    }
+    auto loaded = BloomFilter::load_from_file(path);
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(loaded->get_stats().bit_array_size, num_bits);
+    EXPECT_EQ(loaded->get_stats().num_hash_functions, num_hashes);
+    for (const auto& key : keys) EXPECT_TRUE(loaded->possibly_contains(key));
+    // Only files with the header can be mapped
+    EXPECT_FALSE(BloomFilter::open_mapped(path));
+    std::remove(path.c_str());
+}
+
+
+// ============================================================================
+// Merging
+// ============================================================================
+
+// Per-worker filters OR-ed together hold exactly the bits of one filter
+// fed every key
+TEST(BloomFilterMerge, UnionMatchesOneFilterOfAllKeys) {
+    const auto first = make_keys(4000);
+    const auto second = make_keys(4000, "MSFT|");
+    for (auto layout : {BloomFilter::Layout::Standard, BloomFilter::Layout::Blocked}) {
+        BloomFilter merged(8000, 0.01, layout);
+        BloomFilter other(8000, 0.01, layout);
+        BloomFilter all(8000, 0.01, layout);
+        merged.insert_batch(first);
+        other.insert_batch(second);
+        all.insert_batch(first);
+        all.insert_batch(second);
+
+        ASSERT_TRUE(merged.compatible_with(other));
+        ASSERT_TRUE(merged.merge_union(other, 2));
+        EXPECT_EQ(merged.get_stats().bits_set, all.get_stats().bits_set);
+        for (const auto& key : second) ASSERT_TRUE(merged.possibly_contains(key));
+        // Re-estimated from the set bits: near the keys merged in
+        EXPECT_NEAR(static_cast<double>(merged.num_insertions()), 8000.0, 400.0);
+    }
+}
+
+// An intersection keeps every key both sides hold
+TEST(BloomFilterMerge, IntersectionKeepsSharedKeys) {
+    const auto shared = make_keys(2000);
+    BloomFilter left(6000, 0.01);
+    BloomFilter right(6000, 0.01);
+    left.insert_batch(shared);
+    right.insert_batch(shared);
+    left.insert_batch(make_keys(2000, "MSFT|"));
+    right.insert_batch(make_keys(2000, "GOOG|"));
+    ASSERT_TRUE(left.merge_intersection(right));
+    for (const auto& key : shared) ASSERT_TRUE(left.possibly_contains(key));
+    size_t left_only = 0;
+    for (const auto& key : make_keys(2000, "MSFT|")) left_only += left.possibly_contains(key);
+    EXPECT_LT(left_only, 200u);
+}
+
+// Filters that map keys to different bits are refused and left as they were
+TEST(BloomFilterMerge, IncompatibleFiltersAreRefused) {
+    BloomFilter base(10000, 0.01);
+    base.insert_batch(make_keys(1000));
+    const auto bits_before = base.get_stats().bits_set;
+    const BloomFilter bigger(20000, 0.01);
+    const BloomFilter blocked(10000, 0.01, BloomFilter::Layout::Blocked);
+    const BloomFilter wyhash(10000, 0.01, BloomFilter::Layout::Standard, BloomFilter::HashScheme::WyHash);
+    for (const BloomFilter* other : {&bigger, &blocked, &wyhash}) {
+        EXPECT_FALSE(base.compatible_with(*other));
+        EXPECT_FALSE(base.merge_union(*other));
+        EXPECT_FALSE(base.merge_intersection(*other));
+    }
+    EXPECT_EQ(base.get_stats().bits_set, bits_before);
+}
+
+// The map-reduce build sets the bits a single-threaded build sets
+TEST(BloomFilterMerge, BuildParallelMatchesSequentialBuild) {
+    const auto keys = make_keys(50000);
+    std::string data;
+    std::vector<int64_t> offsets{0};
+    for (const auto& key : keys) {
+        data += key;
+        offsets.push_back(static_cast<int64_t>(data.size()));
+    }
+    const KeyBuffer column = KeyBuffer::with_offsets(data.data(), offsets.data(), keys.size());
+    for (auto layout : {BloomFilter::Layout::Standard, BloomFilter::Layout::Blocked}) {
+        for (auto scheme : {BloomFilter::HashScheme::DoubleHashing, BloomFilter::HashScheme::WyHash}) {
+            BloomFilter built = BloomFilter::build_parallel(column, keys.size(), 0.01, layout, scheme, 3);
+            BloomFilter sequential(keys.size(), 0.01, layout, scheme);
+            sequential.insert_batch(keys);
+            EXPECT_EQ(built.hash_scheme(), scheme);
+            EXPECT_EQ(built.get_stats().bits_set, sequential.get_stats().bits_set);
+            for (const auto& key : keys) ASSERT_TRUE(built.possibly_contains(key));
+        }
+    }
+}
+
+// ============================================================================
+// Statistics
+// ============================================================================
+
+// bits_set follows every insert path without a recount, and the metrics
+// count keys, new keys, queries and positives
+TEST(BloomFilterStats, CountersFollowEveryPath) {
+    const auto keys = make_keys(4000);
+    const auto absent = make_keys(4000, "MSFT|");
+    BloomFilter filter(keys.size(), 0.01);
+    filter.set_latency_sampling(1);
+    for (size_t i = 0; i < 1000; ++i) filter.insert(keys[i]);
+    filter.insert_batch(keys);
+    filter.insert_and_check(keys[0]);
+
+    BloomFilter recounted(keys.size(), 0.01);
+    recounted.insert_batch(keys);
+    ASSERT_TRUE(recounted.save_to_file(temp_path("stats.bf")));
+    auto loaded = BloomFilter::load_from_file(temp_path("stats.bf"));
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(filter.get_stats().bits_set, loaded->get_stats().bits_set);
+    std::remove(temp_path("stats.bf").c_str());
+
+    size_t positives = 0;
+    for (const auto& key : absent) positives += filter.possibly_contains(key);
+    auto stats = filter.get_stats();
+    EXPECT_EQ(stats.metrics.counters.inserts, 1000 + keys.size() + 1);
+    EXPECT_LE(stats.metrics.counters.new_keys, keys.size());   // Less the keys that were false positives
+    EXPECT_GT(stats.metrics.counters.new_keys, keys.size() - keys.size() / 50);
+    EXPECT_EQ(stats.metrics.counters.queries, absent.size());
+    EXPECT_EQ(stats.metrics.counters.positives, positives);
+    EXPECT_DOUBLE_EQ(stats.observed_positive_rate, static_cast<double>(positives) / absent.size());
+    // Sampling every call starts once the thread's current countdown runs out
+    EXPECT_GT(stats.metrics.single.samples, 0u);
+    EXPECT_LE(stats.metrics.single.samples, 1000 + 1 + absent.size());
+    EXPECT_EQ(stats.metrics.batch.samples, 1u);
+
+    filter.reset_metrics();
+    EXPECT_EQ(filter.get_stats().metrics.counters.inserts, 0u);
+}
+
+// num_insertions() counts every key passed to an insert, repeats included
+TEST(BloomFilterStats, NumInsertionsCountsEveryInsertedKey) {
+    const auto keys = make_keys(3000);
+    BloomFilter filter(10000, 0.01);
+    filter.insert(keys[0]);
+    filter.insert(keys[0]);
+    filter.insert_batch(keys);
+    EXPECT_EQ(filter.num_insertions(), keys.size() + 2);
+
+    std::string data;
+    std::vector<int64_t> offsets{0};
+    for (size_t i = 0; i < 2; ++i) {
+        for (const auto& key : keys) {
+            data += key;
+            offsets.push_back(static_cast<int64_t>(data.size()));
+        }
+    }
+    const KeyBuffer twice = KeyBuffer::with_offsets(data.data(), offsets.data(), offsets.size() - 1);
+    filter.insert_batch(twice, 2);
+    EXPECT_EQ(filter.num_insertions(), 3 * keys.size() + 2);
+
+    BloomFilter built = BloomFilter::build_parallel(twice, 10000, 0.01, BloomFilter::Layout::Standard,
+                                                    BloomFilter::HashScheme::DoubleHashing, 2);
+    EXPECT_EQ(built.num_insertions(), twice.size());
+}
+
+}
@@ -0,0 +1,166 @@
+// Tests for ConcurrentBloomFilter
+#include <gtest/gtest.h>
+
+#include "bloom_filter.hpp"
+#include "concurrent_bloom_filter.hpp"
+#include "key_buffer.hpp"
+#include "test_helpers.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace quantamental;
+using namespace quantamental::test;
+
+// A packed column of the keys, for the KeyBuffer overloads
+struct PackedKeys {
+    std::string data;
+    std::vector<int64_t> offsets{0};
+
+    explicit PackedKeys(const std::vector<std::string>& keys) {
+        for (const auto& key : keys) {
+            data += key;
+            offsets.push_back(static_cast<int64_t>(data.size()));
+        }
+    }
+
+    KeyBuffer buffer() const {
+        return KeyBuffer::with_offsets(data.data(), offsets.data(), offsets.size() - 1);
+    }
+};
+
+// Threads racing insert_and_check on the same keys: exactly one of them
+// sees each key as new
+TEST(ConcurrentBloomFilter, InsertAndCheckReportsEachKeyOnce) {
+    const auto keys = make_keys(20000);
+    const size_t num_threads = 4;
+    for (auto layout : {BloomFilter::Layout::Standard, BloomFilter::Layout::Blocked}) {
+        ConcurrentBloomFilter filter(keys.size(), 0.001, layout);
+        std::vector<std::atomic<uint32_t>> reported_new(keys.size());
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t] {
+                std::vector<size_t> order(keys.size());
+                for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+                std::shuffle(order.begin(), order.end(), std::mt19937_64(t));
+                for (size_t i : order) {
+                    if (filter.insert_and_check(keys[i])) reported_new[i].fetch_add(1);
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+
+        size_t reported = 0;
+        for (const auto& count : reported_new) {
+            ASSERT_LE(count.load(), 1u);
+            reported += count.load();
+        }
+        // Only a false positive against earlier keys hides a key from everyone
+        EXPECT_GT(reported, keys.size() - keys.size() / 100);
+    }
+}
+
+// Writers on every insert path, with readers alongside, end on exactly
+// the bits a single-threaded BloomFilter sets
+TEST(ConcurrentBloomFilter, ConcurrentInsertsLoseNoKeys) {
+    const size_t num_writers = 3;
+    std::vector<std::vector<std::string>> shares;
+    for (size_t t = 0; t < num_writers; ++t) shares.push_back(make_keys(8000, "T" + std::to_string(t) + "|"));
+    for (auto layout : {BloomFilter::Layout::Standard, BloomFilter::Layout::Blocked}) {
+        ConcurrentBloomFilter filter(30000, 0.01, layout);
+        std::atomic<bool> done{false};
+        std::vector<std::thread> threads;
+        threads.emplace_back([&] {
+            for (const auto& key : shares[0]) filter.insert(key);
+        });
+        threads.emplace_back([&] { filter.insert_batch(shares[1]); });
+        threads.emplace_back([&] {
+            PackedKeys column(shares[2]);
+            filter.insert_batch(column.buffer(), 1);
+        });
+        threads.emplace_back([&] {
+            const auto probes = make_keys(1000, "T0|");
+            while (!done.load()) {
+                for (const auto& key : probes) filter.possibly_contains(key);
+            }
+        });
+        for (size_t t = 0; t < num_writers; ++t) threads[t].join();
+        done.store(true);
+        threads.back().join();
+
+        BloomFilter reference(30000, 0.01, layout);
+        for (const auto& share : shares) {
+            reference.insert_batch(share);
+            for (const auto& key : share) ASSERT_TRUE(filter.possibly_contains(key));
+        }
+        EXPECT_EQ(filter.fill_ratio(), reference.fill_ratio());
+    }
+}
+
+// A loaded filter probes with the scheme of the file it came from, on the
+// single-key, vector and packed-column paths alike
+TEST(ConcurrentBloomFilter, LoadsBloomFilterFilesOfEveryScheme) {
+    const auto saved = make_keys(3000);
+    const auto single = make_keys(1000, "MSFT|");
+    const auto batch = make_keys(1000, "GOOG|");
+    const auto packed = make_keys(1000, "AMZN|");
+    const std::string path = temp_path("concurrent_scheme.bf");
+    for (auto layout : {BloomFilter::Layout::Standard, BloomFilter::Layout::Blocked}) {
+        for (auto scheme : {BloomFilter::HashScheme::DoubleHashing, BloomFilter::HashScheme::WyHash}) {
+            BloomFilter reference(6000, 0.01, layout, scheme);
+            reference.insert_batch(saved);
+            ASSERT_TRUE(reference.save_to_file(path));
+
+            auto loaded = ConcurrentBloomFilter::load_from_file(path);
+            ASSERT_TRUE(loaded);
+            for (const auto& key : saved) ASSERT_TRUE(loaded->possibly_contains(key));
+            EXPECT_TRUE(loaded->filter_new(saved).empty());
+
+            // New keys land on the bits BloomFilter would set
+            for (const auto& key : single) loaded->insert(key);
+            loaded->insert_batch(batch);
+            PackedKeys column(packed);
+            loaded->insert_batch(column.buffer(), 2);
+            for (const auto& key : single) reference.insert(key);
+            reference.insert_batch(batch);
+            reference.insert_batch(packed);
+            EXPECT_EQ(loaded->fill_ratio(), reference.fill_ratio());
+
+            std::vector<char> is_new(packed.size());
+            loaded->filter_new_mask(column.buffer(), reinterpret_cast<bool*>(is_new.data()), 2);
+            for (char flag : is_new) EXPECT_FALSE(flag);
+
+            // And the file it writes back loads as the same BloomFilter
+            ASSERT_TRUE(loaded->save_to_file(path));
+            auto reloaded = BloomFilter::load_from_file(path);
+            ASSERT_TRUE(reloaded);
+            EXPECT_EQ(reloaded->hash_scheme(), scheme);
+            for (const auto& key : single) ASSERT_TRUE(reloaded->possibly_contains(key));
+            for (const auto& key : packed) ASSERT_TRUE(reloaded->possibly_contains(key));
+        }
+    }
+    std::remove(path.c_str());
+}
+
+
+// num_insertions() counts every key passed to an insert, repeats included
+TEST(ConcurrentBloomFilter, NumInsertionsCountsEveryInsertedKey) {
+    const auto keys = make_keys(3000);
+    ConcurrentBloomFilter filter(10000, 0.01);
+    filter.insert(keys[0]);
+    filter.insert(keys[0]);
+    filter.insert_batch(keys);
+    EXPECT_EQ(filter.num_insertions(), keys.size() + 2);
+    PackedKeys column(keys);
+    filter.insert_batch(column.buffer(), 2);
+    EXPECT_EQ(filter.num_insertions(), 2 * keys.size() + 2);
+}
+
+}
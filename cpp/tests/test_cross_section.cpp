@@ -0,0 +1,81 @@
+// Tests for the cross_section kernels
+#include <gtest/gtest.h>
+
+#include "cross_section.hpp"
+#include "test_helpers.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace quantamental;
+using namespace quantamental::test;
+
+void expect_row(const std::vector<double>& actual, const std::vector<double>& expected) {
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t j = 0; j < expected.size(); ++j) {
+        SCOPED_TRACE("ticker " + std::to_string(j));
+        expect_close_or_nan(actual[j], expected[j], 1e-12);
+    }
+}
+
+// Ties share their average rank, as DataFrame.rank(axis=1)
+TEST(CrossSection, RankAveragesTiesAndSkipsNaN) {
+    const std::vector<double> row{3.0, 1.0, kNaN, 3.0, 2.0};
+    std::vector<double> out(row.size());
+    cross_section::rank(row.data(), out.data(), 1, row.size());
+    expect_row(out, {3.5, 1.0, kNaN, 3.5, 2.0});
+    cross_section::rank(row.data(), out.data(), 1, row.size(), true);
+    expect_row(out, {0.875, 0.25, kNaN, 0.875, 0.5});
+}
+
+TEST(CrossSection, ZscoreUsesSampleStd) {
+    const std::vector<double> panel{1.0, 2.0, 3.0, kNaN,     // Mean 2, std 1
+                                    5.0, 5.0, 5.0, 5.0,      // Flat
+                                    kNaN, 7.0, kNaN, kNaN};  // One value
+    std::vector<double> out(panel.size());
+    cross_section::zscore(panel.data(), out.data(), 3, 4);
+    expect_row(out, {-1.0, 0.0, 1.0, kNaN, kNaN, kNaN, kNaN, kNaN, kNaN, kNaN, kNaN, kNaN});
+}
+
+// Linear-interpolated quantiles, as DataFrame.quantile
+TEST(CrossSection, WinsorizeClipsToRowQuantiles) {
+    std::vector<double> row{10.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0};
+    cross_section::winsorize(row.data(), row.data(), 1, row.size(), 0.1, 0.9);
+    expect_row(row, {9.1, 1.9, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0});
+}
+
+TEST(CrossSection, DemeanByGroupLeavesUngroupedNaN) {
+    const std::vector<double> row{1.0, 3.0, 10.0, 20.0, 5.0, kNaN};
+    const std::vector<int32_t> groups{0, 0, 1, 1, -1, 1};
+    std::vector<double> out(row.size());
+    cross_section::demean_by_group(row.data(), out.data(), 1, row.size(), groups.data());
+    expect_row(out, {-1.0, 1.0, -5.0, 5.0, kNaN, kNaN});
+}
+
+// Rows split across threads, in place, give the single-threaded result
+TEST(CrossSection, ThreadedInPlaceMatchesSingleThreaded) {
+    const size_t num_dates = 300;
+    const size_t num_tickers = 57;
+    std::mt19937_64 rng(17);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<double> panel(num_dates * num_tickers);
+    for (double& x : panel) x = uniform(rng) < 0.05 ? kNaN : std::round(normal(rng) * 4.0);   // Ties
+
+    std::vector<double> expected(panel.size());
+    std::vector<double> in_place = panel;
+    cross_section::rank(panel.data(), expected.data(), num_dates, num_tickers, true, 1);
+    cross_section::rank(in_place.data(), in_place.data(), num_dates, num_tickers, true, 3);
+    for (size_t i = 0; i < panel.size(); ++i) ASSERT_TRUE(same_double(in_place[i], expected[i])) << i;
+
+    in_place = panel;
+    cross_section::zscore(panel.data(), expected.data(), num_dates, num_tickers, 1);
+    cross_section::zscore(in_place.data(), in_place.data(), num_dates, num_tickers, 3);
+    for (size_t i = 0; i < panel.size(); ++i) ASSERT_TRUE(same_double(in_place[i], expected[i])) << i;
+}
+
+}
@@ -0,0 +1,93 @@
+// Tests for FilterCheckpointer
+#include <gtest/gtest.h>
+
+#include "bloom_filter.hpp"
+#include "concurrent_bloom_filter.hpp"
+#include "filter_checkpointer.hpp"
+#include "test_helpers.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace {
+
+using namespace quantamental;
+using namespace quantamental::test;
+
+// Whatever was inserted before the last checkpoint survives in base + log
+TEST(FilterCheckpointer, RecoversEveryCheckpointedKey) {
+    const std::string base = temp_path("checkpoint.base");
+    const std::string log = base + ".log";
+    auto filter = std::make_shared<ConcurrentBloomFilter>(20000, 0.01, BloomFilter::Layout::Blocked);
+    auto checkpointer = FilterCheckpointer::start(filter, CheckpointConfig{base, "", 0, 0.0, false});
+    ASSERT_TRUE(checkpointer);
+
+    auto first = make_keys(5000);
+    auto second = make_keys(5000, "MSFT|");
+    filter->insert_batch(first);
+    ASSERT_TRUE(checkpointer->checkpoint());
+    filter->insert_batch(second);
+    ASSERT_TRUE(checkpointer->checkpoint());
+    EXPECT_EQ(checkpointer->stats().checkpoints, 2u);
+
+    auto recovered = FilterCheckpointer::recover(base, log);
+    ASSERT_TRUE(recovered);
+    for (const auto& key : first) ASSERT_TRUE(recovered->possibly_contains(key));
+    for (const auto& key : second) ASSERT_TRUE(recovered->possibly_contains(key));
+    EXPECT_EQ(recovered->fill_ratio(), filter->fill_ratio());
+
+    // A torn trailing record ends the replay without losing the intact ones
+    {
+        std::ofstream out(log, std::ios::binary | std::ios::app);
+        const char garbage[40] = {1, 2, 3};
+        out.write(garbage, sizeof(garbage));
+    }
+    auto torn = FilterCheckpointer::recover(base, log);
+    ASSERT_TRUE(torn);
+    for (const auto& key : second) ASSERT_TRUE(torn->possibly_contains(key));
+
+    // After compaction the base alone holds everything
+    ASSERT_TRUE(checkpointer->compact());
+    checkpointer->stop();
+    auto compacted = FilterCheckpointer::recover(base, log);
+    ASSERT_TRUE(compacted);
+    for (const auto& key : second) ASSERT_TRUE(compacted->possibly_contains(key));
+    std::remove(base.c_str());
+    std::remove(log.c_str());
+}
+
+
+// A filter resumed from a BloomFilter file keeps that file's hash scheme
+// through checkpoints and recovery
+TEST(FilterCheckpointer, RecoversFiltersOfEveryScheme) {
+    const std::string saved_path = temp_path("checkpoint_scheme.bf");
+    const std::string base = temp_path("checkpoint_scheme.base");
+    const std::string log = base + ".log";
+    auto first = make_keys(3000);
+    auto second = make_keys(3000, "MSFT|");
+    for (auto scheme : {BloomFilter::HashScheme::DoubleHashing, BloomFilter::HashScheme::WyHash}) {
+        BloomFilter saved(10000, 0.01, BloomFilter::Layout::Standard, scheme);
+        saved.insert_batch(first);
+        ASSERT_TRUE(saved.save_to_file(saved_path));
+        std::shared_ptr<ConcurrentBloomFilter> filter = ConcurrentBloomFilter::load_from_file(saved_path);
+        ASSERT_TRUE(filter);
+
+        auto checkpointer = FilterCheckpointer::start(filter, CheckpointConfig{base, "", 0, 0.0, false});
+        ASSERT_TRUE(checkpointer);
+        filter->insert_batch(second);
+        ASSERT_TRUE(checkpointer->checkpoint());
+        checkpointer->stop();
+
+        auto recovered = FilterCheckpointer::recover(base, log);
+        ASSERT_TRUE(recovered);
+        for (const auto& key : first) ASSERT_TRUE(recovered->possibly_contains(key));
+        for (const auto& key : second) ASSERT_TRUE(recovered->possibly_contains(key));
+    }
+    std::remove(saved_path.c_str());
+    std::remove(base.c_str());
+    std::remove(log.c_str());
+}
+
+}
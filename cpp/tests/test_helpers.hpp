@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "indicator_engine.hpp"
+
+#ifndef QUANTAMENTAL_TEST_HELPERS_HPP
+#define QUANTAMENTAL_TEST_HELPERS_HPP
+
+// Fixtures shared by the C++ library tests
+namespace quantamental::test {
+
+inline constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// Equal as doubles, NaN matching NaN
+inline bool same_double(double a, double b) {
+    return (std::isnan(a) && std::isnan(b)) || a == b;
+}
+
+inline void expect_close_or_nan(double actual, double expected, double tolerance) {
+    if (std::isnan(expected)) {
+        EXPECT_TRUE(std::isnan(actual)) << actual;
+    } else {
+        EXPECT_NEAR(actual, expected, tolerance);
+    }
+}
+
+inline std::string temp_path(const std::string& name) {
+    return ::testing::TempDir() + "quantamental_test_" + name;
+}
+
+inline std::vector<std::string> make_keys(size_t count, const std::string& prefix = "AAPL|2024-01-") {
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; ++i) keys.push_back(prefix + std::to_string(i));
+    return keys;
+}
+
+// A geometric random walk of closes with random volumes
+struct Bars {
+    std::vector<double> close;
+    std::vector<double> volume;
+};
+
+inline Bars random_walk(size_t n, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> step(0.0, 0.015);
+    std::uniform_real_distribution<double> volume(1e5, 5e6);
+    Bars bars;
+    double price = 100.0;
+    for (size_t t = 0; t < n; ++t) {
+        price *= std::exp(step(rng));
+        bars.close.push_back(price);
+        bars.volume.push_back(std::round(volume(rng)));
+    }
+    return bars;
+}
+
+// Short windows, so a few hundred bars cover every warm-up
+inline IndicatorConfig small_config() {
+    IndicatorConfig config;
+    config.horizons = {1, 5};
+    config.sma_windows = {3, 10, 30};
+    config.rsi_period = 6;
+    return config;
+}
+
+}
+#endif
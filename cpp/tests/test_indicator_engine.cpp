@@ -0,0 +1,183 @@
+// Tests for IndicatorEngine
+#include <gtest/gtest.h>
+
+#include "indicator_engine.hpp"
+#include "test_helpers.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace quantamental;
+using namespace quantamental::test;
+
+// The pandas expressions of TechnicalFeatures, written out plainly
+std::vector<double> pct_change(const std::vector<double>& x, size_t periods) {
+    std::vector<double> out(x.size(), kNaN);
+    for (size_t t = periods; t < x.size(); ++t) out[t] = x[t] / x[t - periods] - 1.0;
+    return out;
+}
+
+std::vector<double> rolling_mean(const std::vector<double>& x, size_t window) {
+    std::vector<double> out(x.size(), kNaN);
+    for (size_t t = window - 1; t < x.size(); ++t) {
+        double sum = 0.0;
+        for (size_t k = t + 1 - window; k <= t; ++k) sum += x[k];
+        out[t] = sum / window;
+    }
+    return out;
+}
+
+std::vector<double> rolling_std(const std::vector<double>& x, size_t window) {
+    std::vector<double> out(x.size(), kNaN);
+    for (size_t t = window - 1; t < x.size(); ++t) {
+        double sum = 0.0;
+        bool complete = true;
+        for (size_t k = t + 1 - window; k <= t; ++k) {
+            complete = complete && !std::isnan(x[k]);
+            sum += x[k];
+        }
+        if (!complete || window < 2) continue;
+        const double mean = sum / window;
+        double squares = 0.0;
+        for (size_t k = t + 1 - window; k <= t; ++k) squares += (x[k] - mean) * (x[k] - mean);
+        out[t] = std::sqrt(squares / (window - 1));
+    }
+    return out;
+}
+
+// ewm(span, adjust=False).mean()
+std::vector<double> ewm(const std::vector<double>& x, int span) {
+    const double alpha = 2.0 / (span + 1.0);
+    std::vector<double> out(x.size());
+    for (size_t t = 0; t < x.size(); ++t) out[t] = t == 0 ? x[0] : (1.0 - alpha) * out[t - 1] + alpha * x[t];
+    return out;
+}
+
+std::vector<double> reference_column(const std::string& name, const Bars& bars, const IndicatorConfig& config) {
+    const auto& close = bars.close;
+    auto suffix_int = [&](const std::string& prefix) {
+        return std::stoi(name.substr(prefix.size()));
+    };
+    if (name.rfind("return_", 0) == 0) return pct_change(close, suffix_int("return_"));
+    if (name.rfind("sma_", 0) == 0) return rolling_mean(close, suffix_int("sma_"));
+    if (name.rfind("ema_", 0) == 0) return ewm(close, suffix_int("ema_"));
+    if (name.rfind("volatility_", 0) == 0) return rolling_std(pct_change(close, 1), suffix_int("volatility_"));
+    if (name.rfind("volume_sma_", 0) == 0) return rolling_mean(bars.volume, suffix_int("volume_sma_"));
+    if (name.rfind("volume_ratio_", 0) == 0) {
+        auto mean = rolling_mean(bars.volume, suffix_int("volume_ratio_"));
+        for (size_t t = 0; t < mean.size(); ++t) mean[t] = bars.volume[t] / mean[t];
+        return mean;
+    }
+    if (name.rfind("rsi_", 0) == 0) {
+        std::vector<double> gain(close.size(), 0.0), loss(close.size(), 0.0);
+        for (size_t t = 1; t < close.size(); ++t) {
+            const double delta = close[t] - close[t - 1];
+            gain[t] = delta > 0 ? delta : 0.0;
+            loss[t] = delta < 0 ? -delta : 0.0;
+        }
+        auto avg_gain = ewm(gain, config.rsi_period);
+        auto avg_loss = ewm(loss, config.rsi_period);
+        std::vector<double> rsi(close.size());
+        for (size_t t = 0; t < close.size(); ++t) rsi[t] = 100.0 - 100.0 / (1.0 + avg_gain[t] / avg_loss[t]);
+        return rsi;
+    }
+    auto fast = ewm(close, config.macd_fast);
+    auto slow = ewm(close, config.macd_slow);
+    std::vector<double> macd(close.size());
+    for (size_t t = 0; t < close.size(); ++t) macd[t] = fast[t] - slow[t];
+    if (name == "macd") return macd;
+    auto signal = ewm(macd, config.macd_signal);
+    if (name == "macd_signal") return signal;
+    for (size_t t = 0; t < close.size(); ++t) macd[t] -= signal[t];
+    return macd;   // macd_hist
+}
+
+TEST(IndicatorEngine, MatchesPandasExpressions) {
+    const IndicatorConfig config = small_config();
+    auto engine = IndicatorEngine::create(config);
+    ASSERT_TRUE(engine);
+    const size_t n = 300;
+    const Bars bars = random_walk(n, 5);
+    std::vector<double> out(engine->num_columns() * n);
+    engine->compute(bars.close.data(), bars.volume.data(), n, out.data());
+
+    for (size_t c = 0; c < engine->num_columns(); ++c) {
+        const std::string& name = engine->columns()[c];
+        const auto expected = reference_column(name, bars, config);
+        for (size_t t = 0; t < n; ++t) {
+            SCOPED_TRACE(name + " at " + std::to_string(t));
+            expect_close_or_nan(out[c * n + t], expected[t], 1e-9 * std::max(1.0, std::abs(expected[t])));
+        }
+    }
+}
+
+TEST(IndicatorEngine, RejectsEmptyWindows) {
+    IndicatorConfig config = small_config();
+    config.sma_windows = {10, 0};
+    EXPECT_FALSE(IndicatorEngine::create(config));
+}
+
+// Each ticker of a panel, with NaN closes where it has no bar, gets exactly
+// compute() over its own bars
+TEST(IndicatorEngine, PanelMatchesPerTicker) {
+    auto engine = IndicatorEngine::create(small_config());
+    ASSERT_TRUE(engine);
+    const size_t num_dates = 160;
+    const size_t num_tickers = 19;   // Not a whole number of SIMD lanes
+    const size_t num_columns = engine->num_columns();
+
+    std::mt19937_64 rng(9);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<double> close(num_dates * num_tickers, kNaN);
+    std::vector<double> volume(num_dates * num_tickers, kNaN);
+    for (size_t j = 0; j < num_tickers; ++j) {
+        const Bars bars = random_walk(num_dates, 100 + j);
+        const size_t listed = j % 4 == 1 ? 40 : 0;                      // Listed late
+        const size_t delisted = j % 5 == 2 ? 120 : num_dates;           // Delisted early
+        for (size_t d = listed; d < delisted; ++d) {
+            if (j % 3 == 0 && uniform(rng) < 0.1) continue;             // Halted
+            close[d * num_tickers + j] = bars.close[d];
+            volume[d * num_tickers + j] = bars.volume[d];
+        }
+    }
+
+    std::vector<double> panel(num_columns * num_dates * num_tickers);
+    engine->compute_panel(close.data(), volume.data(), num_dates, num_tickers, panel.data(), 2);
+
+    for (size_t j = 0; j < num_tickers; ++j) {
+        std::vector<size_t> dates;
+        Bars own;
+        for (size_t d = 0; d < num_dates; ++d) {
+            if (std::isnan(close[d * num_tickers + j])) continue;
+            dates.push_back(d);
+            own.close.push_back(close[d * num_tickers + j]);
+            own.volume.push_back(volume[d * num_tickers + j]);
+        }
+        const size_t n = dates.size();
+        std::vector<double> single(num_columns * n);
+        engine->compute(own.close.data(), own.volume.data(), n, single.data());
+
+        for (size_t c = 0; c < num_columns; ++c) {
+            const double* column = panel.data() + c * num_dates * num_tickers;
+            size_t bar = 0;
+            for (size_t d = 0; d < num_dates; ++d) {
+                const double value = column[d * num_tickers + j];
+                if (bar < n && dates[bar] == d) {
+                    ASSERT_TRUE(same_double(value, single[c * n + bar]))
+                        << engine->columns()[c] << " ticker " << j << " date " << d << " ("
+                        << IndicatorEngine::panel_backend() << ")";
+                    ++bar;
+                } else {
+                    ASSERT_TRUE(std::isnan(value)) << engine->columns()[c] << " ticker " << j << " date " << d;
+                }
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,91 @@
+// Tests for IndicatorState
+#include <gtest/gtest.h>
+
+#include "indicator_engine.hpp"
+#include "indicator_state.hpp"
+#include "test_helpers.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace quantamental;
+using namespace quantamental::test;
+
+// Appending bars one at a time, through a save and load, gives exactly the
+// rows compute() gives for the whole history
+TEST(IndicatorState, SavedStateContinuesLikeFullHistory) {
+    const IndicatorConfig config = small_config();
+    auto engine = IndicatorEngine::create(config);
+    auto state = IndicatorState::create(config);
+    ASSERT_TRUE(engine);
+    ASSERT_TRUE(state);
+    const size_t n = 200;
+    const size_t split = 77;
+    const size_t num_columns = engine->num_columns();
+    const Bars bars = random_walk(n, 21);
+    std::vector<double> full(num_columns * n);
+    engine->compute(bars.close.data(), bars.volume.data(), n, full.data());
+
+    std::vector<double> row(num_columns);
+    for (size_t t = 0; t < split; ++t) {
+        ASSERT_TRUE(state->append(static_cast<int64_t>(t), bars.close[t], bars.volume[t], row.data()));
+        for (size_t c = 0; c < num_columns; ++c) ASSERT_TRUE(same_double(row[c], full[c * n + t]));
+    }
+
+    const std::string path = temp_path("state.qind");
+    ASSERT_TRUE(state->save_to_file(path));
+    auto loaded = IndicatorState::load_from_file(path);
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(loaded->num_bars(), split);
+    EXPECT_EQ(loaded->last_timestamp(), std::optional<int64_t>(split - 1));
+
+    // A bar already applied is rejected and changes nothing
+    EXPECT_FALSE(loaded->append(static_cast<int64_t>(split - 1), 1.0, 1.0, row.data()));
+
+    const size_t rest = n - split;
+    std::vector<int64_t> timestamps(rest);
+    for (size_t k = 0; k < rest; ++k) timestamps[k] = static_cast<int64_t>(split + k);
+    std::vector<double> out(num_columns * rest);
+    ASSERT_TRUE(loaded->append_batch(timestamps.data(), bars.close.data() + split, bars.volume.data() + split,
+                                     rest, out.data()));
+    for (size_t c = 0; c < num_columns; ++c) {
+        for (size_t k = 0; k < rest; ++k) {
+            ASSERT_TRUE(same_double(out[c * rest + k], full[c * n + split + k]))
+                << engine->columns()[c] << " at " << split + k;
+        }
+    }
+    std::remove(path.c_str());
+}
+
+TEST(IndicatorState, DamagedFilesAreRejected) {
+    auto state = IndicatorState::create(small_config());
+    ASSERT_TRUE(state);
+    const Bars bars = random_walk(50, 4);
+    std::vector<double> row(state->num_columns());
+    for (size_t t = 0; t < bars.close.size(); ++t) {
+        state->append(static_cast<int64_t>(t), bars.close[t], bars.volume[t], row.data());
+    }
+    const std::string path = temp_path("damaged.qind");
+    ASSERT_TRUE(state->save_to_file(path));
+    std::ifstream in(path, std::ios::binary);
+    const std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size() / 2);
+    EXPECT_FALSE(IndicatorState::load_from_file(path));
+
+    std::string flipped = bytes;
+    flipped[bytes.size() - 5] ^= 0x10;
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(flipped.data(), flipped.size());
+    EXPECT_FALSE(IndicatorState::load_from_file(path));
+    std::remove(path.c_str());
+}
+
+}
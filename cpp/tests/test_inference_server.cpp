@@ -0,0 +1,171 @@
+// Tests for InferenceServer
+#include <gtest/gtest.h>
+
+#include "feature_cache.hpp"
+#include "inference_server.hpp"
+#include "test_helpers.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using namespace quantamental;
+using namespace quantamental::test;
+namespace protocol = quantamental::inference_protocol;
+
+MlpModel make_model(size_t input_dim) {
+    const std::vector<MlpModel::Layer> layers{{input_dim, 16, MlpModel::Activation::ReLU},
+                                              {16, 2, MlpModel::Activation::Identity}};
+    std::mt19937_64 rng(5);
+    std::normal_distribution<float> normal(0.0f, 0.3f);
+    std::vector<std::vector<float>> weights, biases;
+    for (const auto& layer : layers) {
+        weights.emplace_back(layer.out * layer.in);
+        biases.emplace_back(layer.out);
+        for (float& w : weights.back()) w = normal(rng);
+        for (float& b : biases.back()) b = normal(rng);
+    }
+    return *MlpModel::create({1, 5}, layers, weights, biases);
+}
+
+TEST(InferenceServer, StartRejectsBadConfigs) {
+    InferenceServerConfig config;
+    config.socket_path = temp_path("inference_bad.sock");
+    config.max_batch = 0;
+    EXPECT_EQ(InferenceServer::start(make_model(4), config), nullptr);
+
+    config.max_batch = 8;
+    config.feature_cache_path = temp_path("inference_missing.cache");
+    std::remove(config.feature_cache_path.c_str());
+    EXPECT_EQ(InferenceServer::start(make_model(4), config), nullptr);
+}
+
+#if !defined(_WIN32)
+struct Response {
+    protocol::ResponseHeader header;
+    std::vector<float> outputs;
+};
+
+struct Client {
+    int fd = -1;
+
+    explicit Client(const std::string& socket_path) {
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    ~Client() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    void send(protocol::RequestKind kind, uint64_t request_id, uint32_t ticker,
+              const std::vector<float>& features = {}) {
+        protocol::RequestHeader header{protocol::kRequestMagic, protocol::kVersion,
+                                       static_cast<uint16_t>(kind), request_id, ticker,
+                                       static_cast<uint32_t>(features.size())};
+        std::vector<char> frame(sizeof(header) + features.size() * sizeof(float));
+        std::memcpy(frame.data(), &header, sizeof(header));
+        if (!features.empty()) {
+            std::memcpy(frame.data() + sizeof(header), features.data(), features.size() * sizeof(float));
+        }
+        ASSERT_EQ(::write(fd, frame.data(), frame.size()), static_cast<ssize_t>(frame.size()));
+    }
+
+    bool read_exact(void* out, size_t bytes) {
+        char* p = static_cast<char*>(out);
+        while (bytes > 0) {
+            ssize_t got = ::read(fd, p, bytes);
+            if (got <= 0) return false;
+            p += got;
+            bytes -= static_cast<size_t>(got);
+        }
+        return true;
+    }
+
+    // Responses may come back out of order, so they are keyed by request_id
+    std::map<uint64_t, Response> receive(size_t count) {
+        std::map<uint64_t, Response> responses;
+        for (size_t i = 0; i < count; ++i) {
+            Response response;
+            if (!read_exact(&response.header, sizeof(response.header))) break;
+            response.outputs.resize(response.header.num_outputs);
+            if (!read_exact(response.outputs.data(), response.outputs.size() * sizeof(float))) break;
+            responses[response.header.request_id] = response;
+        }
+        return responses;
+    }
+};
+
+TEST(InferenceServer, AnswersEveryPipelinedRequest) {
+    const size_t dim = 6;
+    const std::string cache_path = temp_path("inference.cache");
+    auto cache = FeatureCache::create(cache_path, 4, dim);
+    ASSERT_TRUE(cache.has_value());
+    const std::vector<float> cached{0.5f, -1.0f, 0.25f, 2.0f, 0.0f, 1.5f};
+    ASSERT_TRUE(cache->write(1, cached.data(), 20240102));
+
+    InferenceServerConfig config;
+    config.socket_path = temp_path("inference.sock");
+    config.max_batch = 4;
+    config.pin_workers = false;
+    config.feature_cache_path = cache_path;
+    auto server = InferenceServer::start(make_model(dim), config);
+    ASSERT_NE(server, nullptr);
+
+    const std::vector<float> inline_features{1.0f, 2.0f, -0.5f, 0.0f, 0.75f, -2.0f};
+    MlpEngine engine(make_model(dim), 1);
+    std::vector<float> expected_inline(2), expected_cached(2);
+    engine.predict(inline_features.data(), 1, expected_inline.data());
+    engine.predict(cached.data(), 1, expected_cached.data());
+
+    Client client(config.socket_path);
+    ASSERT_GE(client.fd, 0);
+    client.send(protocol::RequestKind::Score, 10, 0, inline_features);
+    client.send(protocol::RequestKind::ScoreCached, 11, 1);
+    client.send(protocol::RequestKind::ScoreCached, 12, 3);          // Never written
+    client.send(protocol::RequestKind::Score, 13, 0, {1.0f, 2.0f});  // Wrong feature count
+    client.send(protocol::RequestKind::ScoreCached, 14, 9);          // Past the cache
+    auto responses = client.receive(5);
+    ASSERT_EQ(responses.size(), 5u);
+
+    for (const auto& [id, response] : responses) EXPECT_EQ(response.header.magic, protocol::kResponseMagic);
+    EXPECT_EQ(responses[10].header.status, static_cast<uint16_t>(protocol::Status::Ok));
+    EXPECT_EQ(responses[11].header.status, static_cast<uint16_t>(protocol::Status::Ok));
+    EXPECT_EQ(responses[12].header.status, static_cast<uint16_t>(protocol::Status::NotCached));
+    EXPECT_EQ(responses[13].header.status, static_cast<uint16_t>(protocol::Status::BadRequest));
+    EXPECT_EQ(responses[14].header.status, static_cast<uint16_t>(protocol::Status::BadRequest));
+    ASSERT_EQ(responses[10].outputs.size(), 2u);
+    ASSERT_EQ(responses[11].outputs.size(), 2u);
+    for (size_t k = 0; k < 2; ++k) {
+        EXPECT_NEAR(responses[10].outputs[k], expected_inline[k], 1e-5);
+        EXPECT_NEAR(responses[11].outputs[k], expected_cached[k], 1e-5);
+    }
+
+    server->stop();
+    const InferenceServer::Stats stats = server->stats();
+    EXPECT_EQ(stats.requests, 3u);
+    EXPECT_EQ(stats.bad_requests, 2u);
+    EXPECT_EQ(stats.rejected, 0u);
+    EXPECT_EQ(stats.connections, 1u);
+    std::remove(cache_path.c_str());
+}
+#endif
+
+}
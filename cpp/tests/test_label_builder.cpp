@@ -0,0 +1,123 @@
+// Tests for LabelBuilder
+#include <gtest/gtest.h>
+
+#include "label_builder.hpp"
+#include "test_helpers.hpp"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace quantamental;
+using namespace quantamental::test;
+
+// Date-major panel of independent random walks
+std::vector<double> make_panel(size_t num_dates, size_t num_tickers) {
+    std::vector<double> panel(num_dates * num_tickers);
+    for (size_t j = 0; j < num_tickers; ++j) {
+        const Bars bars = random_walk(num_dates, 100 + j);
+        for (size_t d = 0; d < num_dates; ++d) panel[d * num_tickers + j] = bars.close[d];
+    }
+    return panel;
+}
+
+// Sample std of the vol_window daily log returns ending at d, NaN in warm-up
+double reference_sigma(const std::vector<double>& close, size_t T, size_t j, size_t d, size_t w) {
+    if (d < w) return kNaN;
+    double mean = 0.0;
+    std::vector<double> r;
+    for (size_t t = d + 1 - w; t <= d; ++t) {
+        r.push_back(std::log(close[t * T + j]) - std::log(close[(t - 1) * T + j]));
+        mean += r.back();
+    }
+    mean /= static_cast<double>(w);
+    double ss = 0.0;
+    for (double x : r) ss += (x - mean) * (x - mean);
+    return std::sqrt(ss / static_cast<double>(w - 1));
+}
+
+TEST(LabelBuilder, CreateRejectsBadConfigs) {
+    EXPECT_FALSE(LabelBuilder::create(LabelConfig{{1, 0}, 20}).has_value());
+    EXPECT_FALSE(LabelBuilder::create(LabelConfig{{1, 5}, 1}).has_value());
+    auto builder = LabelBuilder::create(LabelConfig{{3}, 2});
+    ASSERT_TRUE(builder.has_value());
+    EXPECT_EQ(builder->columns(),
+              (std::vector<std::string>{"fwd_return_3d", "fwd_log_return_3d", "fwd_vol_scaled_3d", "fwd_excess_3d"}));
+}
+
+TEST(LabelBuilder, MatchesReferenceLabels) {
+    const size_t D = 120, T = 5, known = 110;
+    const std::vector<int> horizons{1, 5, 20};
+    const size_t w = 10;
+    auto builder = LabelBuilder::create(LabelConfig{horizons, static_cast<int>(w)});
+    ASSERT_TRUE(builder.has_value());
+
+    const std::vector<double> close = make_panel(D, T);
+    const std::vector<double> benchmark = random_walk(D, 7).close;
+    std::vector<double> out(builder->columns().size() * D * T);
+    builder->build(close.data(), benchmark.data(), D, T, known, out.data());
+
+    const size_t plane = D * T;
+    for (size_t i = 0; i < horizons.size(); ++i) {
+        const size_t h = static_cast<size_t>(horizons[i]);
+        for (size_t d = 0; d < D; ++d) {
+            for (size_t j = 0; j < T; ++j) {
+                SCOPED_TRACE("h " + std::to_string(h) + " date " + std::to_string(d) + " ticker " + std::to_string(j));
+                double simple = kNaN, log_return = kNaN, excess = kNaN, scaled = kNaN;
+                if (d + h < known) {
+                    simple = close[(d + h) * T + j] / close[d * T + j] - 1.0;
+                    log_return = std::log(close[(d + h) * T + j] / close[d * T + j]);
+                    excess = simple - (benchmark[d + h] / benchmark[d] - 1.0);
+                    scaled = log_return / (reference_sigma(close, T, j, d, w) * std::sqrt(static_cast<double>(h)));
+                }
+                const double* o = out.data() + i * 4 * plane + d * T + j;
+                expect_close_or_nan(o[0], simple, 1e-12);
+                expect_close_or_nan(o[plane], log_return, 1e-12);
+                expect_close_or_nan(o[2 * plane], scaled, 1e-9);
+                expect_close_or_nan(o[3 * plane], excess, 1e-12);
+            }
+        }
+    }
+}
+
+TEST(LabelBuilder, MissingInputsGiveNaN) {
+    const size_t D = 40, T = 3;
+    auto builder = LabelBuilder::create(LabelConfig{{2}, 5});
+    ASSERT_TRUE(builder.has_value());
+
+    std::vector<double> close = make_panel(D, T);
+    close[10 * T + 1] = kNaN;
+    std::vector<double> out(4 * D * T);
+    builder->build(close.data(), nullptr, D, T, D, out.data());
+
+    const size_t plane = D * T;
+    // Entry and exit on the gap are both missing
+    for (size_t d : {8u, 10u}) {
+        EXPECT_TRUE(std::isnan(out[d * T + 1]));
+        EXPECT_TRUE(std::isnan(out[plane + d * T + 1]));
+    }
+    EXPECT_FALSE(std::isnan(out[9 * T + 1]));
+    EXPECT_FALSE(std::isnan(out[10 * T + 0]));
+    // No benchmark, no excess
+    for (size_t k = 0; k < plane; ++k) EXPECT_TRUE(std::isnan(out[3 * plane + k]));
+}
+
+TEST(LabelBuilder, ThreadedBuildMatchesSingleThread) {
+    // Enough tickers for several tiles
+    const size_t D = 60, T = 200;
+    auto builder = LabelBuilder::create(LabelConfig{{1, 5}, 10});
+    ASSERT_TRUE(builder.has_value());
+
+    const std::vector<double> close = make_panel(D, T);
+    const std::vector<double> benchmark = random_walk(D, 7).close;
+    std::vector<double> serial(8 * D * T), threaded(8 * D * T);
+    builder->build(close.data(), benchmark.data(), D, T, D, serial.data(), 1);
+    builder->build(close.data(), benchmark.data(), D, T, D, threaded.data(), 4);
+    for (size_t k = 0; k < serial.size(); ++k) {
+        ASSERT_TRUE(same_double(serial[k], threaded[k])) << "element " << k;
+    }
+}
+
+}
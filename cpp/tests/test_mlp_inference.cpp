@@ -0,0 +1,95 @@
+// Tests for MlpModel and MlpEngine
+#include <gtest/gtest.h>
+
+#include "mlp_inference.hpp"
+#include "test_helpers.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace quantamental;
+using namespace quantamental::test;
+
+double activate(MlpModel::Activation activation, double x) {
+    switch (activation) {
+        case MlpModel::Activation::ReLU: return x > 0.0 ? x : 0.0;
+        case MlpModel::Activation::Tanh: return std::tanh(x);
+        case MlpModel::Activation::Sigmoid: return 1.0 / (1.0 + std::exp(-x));
+        default: return x;
+    }
+}
+
+// A dense forward pass in double, weights in nn.Linear layout (out x in)
+std::vector<double> reference_forward(const std::vector<MlpModel::Layer>& layers,
+                                      const std::vector<std::vector<float>>& weights,
+                                      const std::vector<std::vector<float>>& biases, const float* x) {
+    std::vector<double> values(x, x + layers.front().in);
+    for (size_t l = 0; l < layers.size(); ++l) {
+        std::vector<double> next(layers[l].out);
+        for (size_t o = 0; o < layers[l].out; ++o) {
+            double sum = biases[l][o];
+            for (size_t i = 0; i < layers[l].in; ++i) sum += weights[l][o * layers[l].in + i] * values[i];
+            next[o] = activate(layers[l].activation, sum);
+        }
+        values = std::move(next);
+    }
+    return values;
+}
+
+TEST(MlpInference, MatchesReferenceForwardPass) {
+    const std::vector<MlpModel::Layer> layers{{37, 64, MlpModel::Activation::ReLU},
+                                              {64, 19, MlpModel::Activation::Tanh},
+                                              {19, 3, MlpModel::Activation::Sigmoid}};
+    std::mt19937_64 rng(13);
+    std::normal_distribution<float> normal(0.0f, 0.3f);
+    std::vector<std::vector<float>> weights, biases;
+    for (const auto& layer : layers) {
+        weights.emplace_back(layer.out * layer.in);
+        biases.emplace_back(layer.out);
+        for (float& w : weights.back()) w = normal(rng);
+        for (float& b : biases.back()) b = normal(rng);
+    }
+    auto model = MlpModel::create({1, 5, 20}, layers, weights, biases);
+    ASSERT_TRUE(model);
+
+    const size_t rows = 2 * MlpEngine::kBlockRows + 5;   // Whole blocks and a partial one
+    std::vector<float> x(rows * 37);
+    for (float& v : x) v = normal(rng) * 3.0f;
+    std::vector<float> out(rows * 3);
+    MlpEngine engine(*model, 1);
+    engine.predict(x.data(), rows, out.data());
+    for (size_t r = 0; r < rows; ++r) {
+        const auto expected = reference_forward(layers, weights, biases, x.data() + r * 37);
+        for (size_t o = 0; o < 3; ++o) EXPECT_NEAR(out[r * 3 + o], expected[o], 1e-5) << "row " << r;
+    }
+
+    // The pooled path and a saved copy of the model give the same forecasts
+    std::vector<float> pooled(rows * 3);
+    MlpEngine(*model).predict(x.data(), rows, pooled.data());
+    const std::string path = temp_path("model.qmlp");
+    ASSERT_TRUE(model->save_to_file(path));
+    auto loaded = MlpModel::load_from_file(path);
+    ASSERT_TRUE(loaded);
+    std::vector<float> reloaded(rows * 3);
+    MlpEngine(*loaded, 1).predict(x.data(), rows, reloaded.data());
+    for (size_t i = 0; i < out.size(); ++i) {
+        EXPECT_EQ(pooled[i], out[i]);
+        EXPECT_EQ(reloaded[i], out[i]);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(MlpInference, RejectsLayersThatDoNotChain) {
+    const std::vector<MlpModel::Layer> layers{{4, 8, MlpModel::Activation::ReLU},
+                                              {7, 2, MlpModel::Activation::Identity}};
+    std::vector<std::vector<float>> weights{std::vector<float>(32), std::vector<float>(14)};
+    std::vector<std::vector<float>> biases{std::vector<float>(8), std::vector<float>(2)};
+    EXPECT_FALSE(MlpModel::create({1, 5}, layers, weights, biases));
+}
+
+}
@@ -0,0 +1,130 @@
+// Tests for RollingCovariance
+#include <gtest/gtest.h>
+
+#include "rolling_covariance.hpp"
+#include "test_helpers.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace quantamental;
+using namespace quantamental::test;
+
+// Two-pass pairwise-complete covariance and correlation of tickers i and j
+// over the last `window` rows of a dates x tickers panel
+struct PairReference {
+    double cov;
+    double corr;
+};
+
+PairReference reference_pair(const std::vector<double>& panel, size_t num_tickers, size_t num_dates,
+                             size_t window, size_t i, size_t j, size_t min_periods) {
+    std::vector<double> xs;
+    std::vector<double> ys;
+    for (size_t d = num_dates - std::min(num_dates, window); d < num_dates; ++d) {
+        const double x = panel[d * num_tickers + i];
+        const double y = panel[d * num_tickers + j];
+        if (std::isnan(x) || std::isnan(y)) continue;
+        xs.push_back(x);
+        ys.push_back(y);
+    }
+    const size_t n = xs.size();
+    if (n < min_periods) return {kNaN, kNaN};
+    double mean_x = 0.0, mean_y = 0.0;
+    for (size_t k = 0; k < n; ++k) {
+        mean_x += xs[k];
+        mean_y += ys[k];
+    }
+    mean_x /= n;
+    mean_y /= n;
+    double sxx = 0.0, syy = 0.0, sxy = 0.0;
+    for (size_t k = 0; k < n; ++k) {
+        sxx += (xs[k] - mean_x) * (xs[k] - mean_x);
+        syy += (ys[k] - mean_y) * (ys[k] - mean_y);
+        sxy += (xs[k] - mean_x) * (ys[k] - mean_y);
+    }
+    const double corr = sxx > 0.0 && syy > 0.0 ? sxy / std::sqrt(sxx * syy) : kNaN;
+    return {sxy / (n - 1.0), corr};
+}
+
+TEST(RollingCovariance, MatchesTwoPassReference) {
+    const size_t num_tickers = 11;
+    const size_t num_dates = 400;
+    std::vector<size_t> windows{5, 20, 60};
+    std::mt19937_64 rng(7);
+    std::normal_distribution<double> noise(0.0, 0.01);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    std::vector<double> panel(num_dates * num_tickers);
+    for (size_t d = 0; d < num_dates; ++d) {
+        for (size_t j = 0; j < num_tickers; ++j) {
+            panel[d * num_tickers + j] = uniform(rng) < 0.1 ? kNaN : 100.0 + j + noise(rng);
+        }
+    }
+
+    auto rolling = RollingCovariance::create(num_tickers, windows, 3);
+    ASSERT_TRUE(rolling);
+    // Uneven batches cross the recentering points mid-batch
+    for (size_t first = 0; first < num_dates;) {
+        const size_t count = std::min<size_t>(1 + first % 37, num_dates - first);
+        rolling->update(panel.data() + first * num_tickers, count);
+        first += count;
+    }
+    ASSERT_EQ(rolling->num_dates(), num_dates);
+
+    std::vector<double> cov(num_tickers * num_tickers);
+    std::vector<double> corr(num_tickers * num_tickers);
+    for (size_t w = 0; w < windows.size(); ++w) {
+        rolling->covariance(w, cov.data());
+        rolling->correlation(w, corr.data());
+        for (size_t i = 0; i < num_tickers; ++i) {
+            for (size_t j = 0; j < num_tickers; ++j) {
+                auto expected = reference_pair(panel, num_tickers, num_dates, windows[w], i, j, 3);
+                expect_close_or_nan(cov[i * num_tickers + j], expected.cov, 1e-12);
+                expect_close_or_nan(corr[i * num_tickers + j], expected.corr, 1e-9);
+            }
+        }
+    }
+}
+
+// A series that settles on a value other than its first must read as flat:
+// NaN correlation (diagonal included) and zero variance, however long it
+// has been flat and however many dates have slid through the sums
+TEST(RollingCovariance, ConstantSeriesAwayFromFirstValueIsFlat) {
+    const size_t num_tickers = 3;
+    const size_t num_dates = 1000;
+    std::vector<size_t> windows{10, 50};
+    std::mt19937_64 rng(11);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    std::vector<double> panel(num_dates * num_tickers);
+    for (size_t d = 0; d < num_dates; ++d) {
+        panel[d * num_tickers + 0] = d < 30 ? 50.0 + noise(rng) : 12.345678;
+        panel[d * num_tickers + 1] = noise(rng);
+        panel[d * num_tickers + 2] = noise(rng);
+    }
+
+    auto rolling = RollingCovariance::create(num_tickers, windows);
+    ASSERT_TRUE(rolling);
+    std::vector<double> cov(num_tickers * num_tickers);
+    std::vector<double> corr(num_tickers * num_tickers);
+    for (size_t d = 0; d < num_dates; ++d) {
+        rolling->update(panel.data() + d * num_tickers);
+        if (d < 30 + windows.back()) continue;
+        for (size_t w = 0; w < windows.size(); ++w) {
+            rolling->covariance(w, cov.data());
+            rolling->correlation(w, corr.data());
+            ASSERT_EQ(cov[0], 0.0) << "date " << d;
+            ASSERT_TRUE(std::isnan(corr[0])) << "date " << d;
+            ASSERT_TRUE(std::isnan(corr[1])) << "date " << d;
+            ASSERT_TRUE(std::isnan(corr[2])) << "date " << d;
+            ASSERT_EQ(corr[4], 1.0);
+        }
+    }
+}
+
+}
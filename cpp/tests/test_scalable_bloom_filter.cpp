@@ -0,0 +1,86 @@
+// Tests for ScalableBloomFilter
+#include <gtest/gtest.h>
+
+#include "scalable_bloom_filter.hpp"
+#include "test_helpers.hpp"
+
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+using namespace quantamental;
+using namespace quantamental::test;
+
+// Parameters that would give a layer no probes or no size are refused
+TEST(ScalableBloomFilter, RejectsParametersOutOfRange) {
+    const double inf = std::numeric_limits<double>::infinity();
+    for (double rate : {0.0, 1.0, -0.1, 2.0, kNaN}) {
+        EXPECT_THROW(ScalableBloomFilter(1000, rate), std::invalid_argument) << rate;
+    }
+    for (double growth : {1.0, 0.5, inf, kNaN}) {
+        EXPECT_THROW(ScalableBloomFilter(1000, 0.01, BloomFilter::Layout::Standard, growth),
+                     std::invalid_argument) << growth;
+    }
+    for (double ratio : {0.0, 1.0, kNaN}) {
+        EXPECT_THROW(ScalableBloomFilter(1000, 0.01, BloomFilter::Layout::Standard, 2.0, ratio),
+                     std::invalid_argument) << ratio;
+        EXPECT_THROW(ScalableBloomFilter(1000, 0.01, BloomFilter::Layout::Standard, 2.0, 0.5, ratio),
+                     std::invalid_argument) << ratio;
+    }
+    EXPECT_NO_THROW(ScalableBloomFilter(0, 0.5, BloomFilter::Layout::Blocked, 1.5, 0.9, 0.9));
+}
+
+
+// Ten times the initial capacity adds layers, loses no key, and keeps the
+// compound FPR under the requested rate
+TEST(ScalableBloomFilter, GrowsWithoutLosingKeysOrTheRate) {
+    const auto keys = make_keys(20000);
+    const auto absent = make_keys(100000, "MSFT|");
+    for (auto layout : {BloomFilter::Layout::Standard, BloomFilter::Layout::Blocked}) {
+        ScalableBloomFilter filter(2000, 0.01, layout);
+        filter.insert_batch(keys);
+        EXPECT_GT(filter.num_layers(), 2u);
+        EXPECT_LT(filter.false_positive_bound(), 0.01);
+        for (const auto& key : keys) ASSERT_TRUE(filter.possibly_contains(key));
+
+        size_t hits = 0;
+        for (const auto& key : absent) hits += filter.possibly_contains(key);
+        EXPECT_LT(static_cast<double>(hits) / absent.size(), 0.01);
+    }
+}
+
+// Repeats are not re-inserted, so they never push the filter into a new layer
+TEST(ScalableBloomFilter, RepeatsDoNotGrowTheFilter) {
+    const auto keys = make_keys(1500);
+    ScalableBloomFilter filter(2000, 0.01);
+    for (int pass = 0; pass < 5; ++pass) filter.insert_batch(keys);
+    EXPECT_EQ(filter.num_layers(), 1u);
+    EXPECT_TRUE(filter.filter_new(keys).empty());
+    EXPECT_FALSE(filter.insert_and_check(keys[0]));
+    EXPECT_TRUE(filter.insert_and_check("MSFT|new"));
+}
+
+TEST(ScalableBloomFilter, RoundTripsThroughFiles) {
+    const auto keys = make_keys(9000);
+    ScalableBloomFilter filter(1000, 0.01, BloomFilter::Layout::Blocked, 3.0, 0.8, 0.4);
+    filter.insert_batch(keys);
+    const std::string path = temp_path("scalable.qsbf");
+    ASSERT_TRUE(filter.save_to_file(path));
+    auto loaded = ScalableBloomFilter::load_from_file(path);
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(loaded->num_layers(), filter.num_layers());
+    EXPECT_EQ(loaded->capacity(), filter.capacity());
+    EXPECT_EQ(loaded->layout(), BloomFilter::Layout::Blocked);
+    for (const auto& key : keys) ASSERT_TRUE(loaded->possibly_contains(key));
+
+    // It keeps growing on the loaded parameters
+    loaded->insert_batch(make_keys(20000, "MSFT|"));
+    filter.insert_batch(make_keys(20000, "MSFT|"));
+    EXPECT_EQ(loaded->num_layers(), filter.num_layers());
+    std::remove(path.c_str());
+}
+
+}
@@ -0,0 +1,89 @@
+// Tests for WindowedBloomFilter
+#include <gtest/gtest.h>
+
+#include "test_helpers.hpp"
+#include "windowed_bloom_filter.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace quantamental;
+using namespace quantamental::test;
+
+size_t count_contained(const WindowedBloomFilter& filter, const std::vector<std::string>& keys) {
+    size_t found = 0;
+    for (const auto& key : keys) found += filter.possibly_contains(key);
+    return found;
+}
+
+// A day's keys stay for num_buckets days and are gone the day after
+TEST(WindowedBloomFilter, KeysExpireWithTheirBucket) {
+    const uint32_t num_buckets = 5;
+    WindowedBloomFilter filter(4000, 0.01, num_buckets, 1);
+    EXPECT_EQ(filter.advance_to(100), 0u);   // Sets the clock
+    EXPECT_EQ(filter.current_bucket(), std::optional<int64_t>(100));
+
+    std::vector<std::vector<std::string>> days;
+    for (int64_t day = 0; day < 12; ++day) {
+        if (day > 0) {
+            EXPECT_EQ(filter.advance_to(100 + day), 1u);
+        }
+        days.push_back(make_keys(3000, "D" + std::to_string(day) + "|"));
+        filter.insert_batch(days.back());
+        for (int64_t old = 0; old <= day; ++old) {
+            const size_t found = count_contained(filter, days[old]);
+            if (day - old < num_buckets) {
+                ASSERT_EQ(found, days[old].size()) << "day " << old << " on day " << day;
+            } else {
+                ASSERT_LT(found, days[old].size() / 50) << "day " << old << " on day " << day;
+            }
+        }
+    }
+    // Times that go backwards are ignored, and a jump drops the whole window
+    EXPECT_EQ(filter.advance_to(50), 0u);
+    EXPECT_EQ(filter.advance_to(111 + 2 * num_buckets), 2 * num_buckets);
+    EXPECT_LT(count_contained(filter, days.back()), days.back().size() / 50);
+}
+
+// Inserting a key again moves it into the current bucket
+TEST(WindowedBloomFilter, InsertRefreshesAKey) {
+    WindowedBloomFilter filter(1000, 0.001, 3, 1);
+    EXPECT_TRUE(filter.insert_and_check("AAPL|2024-01-02"));
+    filter.rotate();
+    filter.rotate();
+    EXPECT_FALSE(filter.insert_and_check("AAPL|2024-01-02"));   // Refreshed
+    filter.rotate();
+    filter.rotate();
+    EXPECT_TRUE(filter.possibly_contains("AAPL|2024-01-02"));
+    filter.rotate();
+    EXPECT_FALSE(filter.possibly_contains("AAPL|2024-01-02"));
+    EXPECT_TRUE(filter.insert_and_check("AAPL|2024-01-02"));
+}
+
+// Idle expiry clears the dropped bucket; the batch query agrees with the
+// single-key one
+TEST(WindowedBloomFilter, ExpireStepClearsTheDroppedBucket) {
+    const auto keys = make_keys(4000);
+    WindowedBloomFilter filter(4000, 0.01, 2, 1);
+    filter.insert_batch(keys);
+    filter.rotate();
+    filter.rotate();
+    EXPECT_GT(filter.pending_expire_words(), 0u);
+    while (filter.expire_step(64) > 0) {
+    }
+    EXPECT_EQ(filter.pending_expire_words(), 0u);
+    EXPECT_EQ(filter.fill_ratio(), 0.0);
+
+    filter.insert_batch(make_keys(2000));
+    std::vector<size_t> expected;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (!filter.possibly_contains(keys[i])) expected.push_back(i);
+    }
+    EXPECT_EQ(filter.filter_new(keys), expected);
+    EXPECT_GE(expected.size(), 1900u);
+}
+
+}
@@ -0,0 +1,140 @@
+// inference_server.cpp
+//
+// Serves an exported MLP (src/models/inference.py export_mlp) on a Unix
+// domain socket until SIGINT or SIGTERM, printing latency stats as it goes.
+// Clients: src/models/client.py, or anything speaking the protocol in
+// inference_server.hpp.
+//
+//   inference_server --model models/mlp.qmlp --socket /tmp/quantamental.sock
+//       --max-batch 64 --max-wait-us 200 --workers 2 --feature-cache /dev/shm/features.qfc
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include <pthread.h>
+#include <signal.h>
+
+#include "inference_server.hpp"
+#include "mlp_inference.hpp"
+
+using quantamental::InferenceServer;
+using quantamental::InferenceServerConfig;
+using quantamental::MlpModel;
+
+namespace {
+
+void usage(const char* program) {
+    std::fprintf(stderr,
+                 "usage: %s --model FILE --socket PATH [--max-batch N] [--max-wait-us N]\n"
+                 "          [--workers N] [--queue-capacity N] [--feature-cache FILE]\n"
+                 "          [--no-pin] [--stats-every SECONDS]\n",
+                 program);
+}
+
+bool parse_count(const char* text, unsigned long long& value) {
+    char* end = nullptr;
+    value = std::strtoull(text, &end, 10);
+    return end != text && *end == '\0';
+}
+
+void print_stats(const InferenceServer::Stats& stats) {
+    std::printf("requests=%llu batches=%llu mean_batch=%.1f rejected=%llu bad=%llu connections=%llu\n"
+                "  queue   p50=%.1fus p99=%.1fus max=%.1fus\n"
+                "  compute p50=%.1fus p99=%.1fus max=%.1fus\n",
+                static_cast<unsigned long long>(stats.requests),
+                static_cast<unsigned long long>(stats.batches), stats.mean_batch_size,
+                static_cast<unsigned long long>(stats.rejected),
+                static_cast<unsigned long long>(stats.bad_requests),
+                static_cast<unsigned long long>(stats.connections),
+                stats.queue.p50_us, stats.queue.p99_us, stats.queue.max_us,
+                stats.compute.p50_us, stats.compute.p99_us, stats.compute.max_us);
+    std::fflush(stdout);
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::string model_path;
+    InferenceServerConfig config;
+    unsigned long long stats_every = 10;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* next = i + 1 < argc ? argv[i + 1] : nullptr;
+        unsigned long long value = 0;
+        if (std::strcmp(arg, "--no-pin") == 0) {
+            config.pin_workers = false;
+            continue;
+        }
+        if (next == nullptr) {
+            usage(argv[0]);
+            return 2;
+        }
+        ++i;
+        if (std::strcmp(arg, "--model") == 0) {
+            model_path = next;
+        } else if (std::strcmp(arg, "--socket") == 0) {
+            config.socket_path = next;
+        } else if (std::strcmp(arg, "--feature-cache") == 0) {
+            config.feature_cache_path = next;
+        } else if (!parse_count(next, value)) {
+            usage(argv[0]);
+            return 2;
+        } else if (std::strcmp(arg, "--max-batch") == 0) {
+            config.max_batch = value;
+        } else if (std::strcmp(arg, "--max-wait-us") == 0) {
+            config.max_wait_us = static_cast<uint32_t>(value);
+        } else if (std::strcmp(arg, "--workers") == 0) {
+            config.num_workers = value;
+        } else if (std::strcmp(arg, "--queue-capacity") == 0) {
+            config.queue_capacity = value;
+        } else if (std::strcmp(arg, "--stats-every") == 0) {
+            stats_every = value;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (model_path.empty() || config.socket_path.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    auto model = MlpModel::load_from_file(model_path);
+    if (!model) {
+        std::fprintf(stderr, "cannot load model %s\n", model_path.c_str());
+        return 1;
+    }
+
+    // Blocked before the server's threads start, so they inherit the mask
+    // and the signals are only ever taken by sigtimedwait below
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    auto server = InferenceServer::start(*model, config);
+    if (!server) {
+        std::fprintf(stderr, "cannot start server on %s\n", config.socket_path.c_str());
+        return 1;
+    }
+    std::printf("serving %s (%zu -> %zu, %s kernels) on %s: max_batch=%zu max_wait=%uus workers=%zu\n",
+                model_path.c_str(), model->input_dim(), model->output_dim(), MlpModel::backend(),
+                config.socket_path.c_str(), config.max_batch, config.max_wait_us, config.num_workers);
+    std::fflush(stdout);
+
+    for (;;) {
+        timespec timeout{static_cast<time_t>(stats_every > 0 ? stats_every : 3600), 0};
+        int signal = sigtimedwait(&signals, nullptr, &timeout);
+        if (signal == SIGINT || signal == SIGTERM) break;
+        if (stats_every > 0) print_stats(server->stats());
+    }
+
+    server->stop();
+    print_stats(server->stats());
+    return 0;
+}
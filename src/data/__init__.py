@@ -1,5 +1,7 @@
 from .fetcher import DataFetcher
+from .ingest import BarIngest
 
 __all__ = [
     "DataFetcher",
+    "BarIngest",
 ]
\ No newline at end of file
@@ -4,14 +4,22 @@ Download OHLCV market data from Yahoo Finance and save to Parquet.
 
 from pathlib import Path
 from typing import List, Dict, Optional
+import numpy as np
 import pandas as pd
 import yfinance as yf
 
 from src.utils.config import get_config
 from src.utils.logger import get_logger
 
+try:
+    from quantamental import BarStore
+except ImportError:  # C++ module not built; Parquet only
+    BarStore = None
+
 logger = get_logger(__name__)
 
+OHLCV_FIELDS = ['Open', 'High', 'Low', 'Close', 'Volume']
+
 class DataFetcher:
     """Fetch OHLCV data from Yahoo Finance and save to Parquet format."""
     
@@ -196,4 +204,125 @@ class DataFetcher:
         df = pd.read_parquet(file_path)
 
         logger.info(f"Loaded {len(df)} rows, {df['ticker'].nunique()} unique tickers")
-        return df
\ No newline at end of file
+        return df
+
+    def _store_rows(self, data: Dict[str, pd.DataFrame], tickers: List[str],
+                    calendar: pd.DatetimeIndex) -> np.ndarray:
+        """
+        (dates, 5, tickers) OHLCV block on the calendar, NaN where a ticker
+        has no bar (or is not in data).
+        """
+        values = np.full((len(calendar), len(OHLCV_FIELDS), len(tickers)), np.nan)
+        for j, ticker in enumerate(tickers):
+            if ticker in data:
+                frame = data[ticker].reindex(calendar)
+                values[:, :, j] = frame[OHLCV_FIELDS].to_numpy(dtype=np.float64)
+        return values
+
+    def save_to_store(self, data: Dict[str, pd.DataFrame], filename: str) -> Path:
+        """
+        Save ticker DataFrames to a memory-mapped columnar BarStore: one
+        contiguous column per field and ticker over the union of dates.
+
+        Args:
+            data: Dictionary mapping tickers to DataFrames
+            filename: Output filename (e.g., 'sp500.qbar')
+
+        Returns:
+            Path to saved file
+        """
+        if BarStore is None:
+            raise RuntimeError("BarStore requires the quantamental C++ module")
+        tickers = list(data)
+        calendar = pd.DatetimeIndex(sorted(set().union(*(df.index for df in data.values()))))
+
+        output_path = self.data_dir / filename
+        store = BarStore.create(str(output_path), tickers, date_capacity=max(2 * len(calendar), 4096),
+                                timezone=str(calendar.tz) if calendar.tz is not None else '')
+        if store is None:
+            raise IOError(f"Could not create bar store {output_path}")
+        store.append(calendar.asi8, self._store_rows(data, tickers, calendar))
+        store.flush()
+
+        logger.info(f"Saved {len(tickers)} tickers x {len(calendar)} dates to {output_path}")
+        return output_path
+
+    def update_store(self, data: Dict[str, pd.DataFrame], filename: str) -> int:
+        """
+        Append the bars of data after the store's last date in place (no
+        rewrite); tickers new to the store are added first.
+
+        Returns:
+            Number of dates appended
+        """
+        if BarStore is None:
+            raise RuntimeError("BarStore requires the quantamental C++ module")
+        store = BarStore.open(str(self.data_dir / filename), writable=True)
+        if store is None:
+            raise IOError(f"Could not open bar store {filename}")
+
+        for ticker in data:
+            if ticker not in store.tickers():
+                store.add_ticker(ticker)
+
+        stored = store.dates()
+        last = stored[-1] if len(stored) else np.iinfo(np.int64).min
+        calendar = pd.DatetimeIndex(sorted(set().union(*(df.index for df in data.values()))))
+        calendar = calendar[calendar.asi8 > last]
+        if len(calendar):
+            store.append(calendar.asi8, self._store_rows(data, store.tickers(), calendar))
+            store.flush()
+
+        logger.info(f"Appended {len(calendar)} dates to {filename}")
+        return len(calendar)
+
+    def load_from_store(self, filename: str, field: str = 'Close',
+                        tickers: Optional[List[str]] = None,
+                        start: Optional[str] = None, end: Optional[str] = None) -> pd.DataFrame:
+        """
+        Load one field as a dates x tickers DataFrame from a BarStore. The
+        file is memory-mapped: only the requested columns and dates are paged
+        in, and with tickers=None the frame is a view of the mapping. The
+        index has the timezone the store was saved with (naive if none).
+
+        Args:
+            filename: BarStore filename to load
+            field: One of Open, High, Low, Close, Volume
+            tickers: Subset of tickers (default: all)
+            start, end: Inclusive date bounds (default: all dates), taken in
+                the store's timezone when they carry none
+
+        Returns:
+            DataFrame indexed by date with one column per ticker
+        """
+        if BarStore is None:
+            raise RuntimeError("BarStore requires the quantamental C++ module")
+        store = BarStore.open(str(self.data_dir / filename))
+        if store is None:
+            raise IOError(f"Could not open bar store {filename}")
+
+        dates = store.dates()
+        tz = store.timezone() or None
+
+        # The store keeps DatetimeIndex.asi8: UTC nanoseconds for aware
+        # dates, wall-clock nanoseconds for naive ones
+        def bound(value: Optional[str]) -> Optional[int]:
+            if value is None:
+                return None
+            stamp = pd.Timestamp(value)
+            if tz is not None and stamp.tzinfo is None:
+                stamp = stamp.tz_localize(tz)
+            return stamp.value
+
+        bounds = {'start': bound(start), 'end': bound(end)}
+        begin, stop = store.date_rows(**bounds)
+        index = pd.DatetimeIndex(dates[begin:stop])
+        if tz is not None:
+            index = index.tz_localize('UTC').tz_convert(tz)
+
+        if tickers is None:
+            values = store.panel(field.lower(), **bounds)
+            return pd.DataFrame(values.T, index=index, columns=store.tickers(), copy=False)
+        columns = store.query(field.lower(), tickers, **bounds)
+        return pd.DataFrame(columns, index=index)
+
@@ -0,0 +1,112 @@
+"""
+Deduplicate incoming OHLCV bars before they are stored.
+"""
+
+from pathlib import Path
+from typing import Dict, List, Optional
+import numpy as np
+import pandas as pd
+
+from src.utils.config import get_config
+from src.utils.logger import get_logger
+from src.data.fetcher import OHLCV_FIELDS
+
+try:
+    from quantamental import BarDeduplicator
+except ImportError:  # C++ module not built
+    BarDeduplicator = None
+
+logger = get_logger(__name__)
+
+class BarIngest:
+    """Drop bars that were already ingested, keeping vendor corrections."""
+
+    def __init__(self, expected_bars: Optional[int] = None,
+                 false_positive_rate: Optional[float] = None,
+                 filter_path: Optional[str] = None):
+        """
+        Bars are keyed by (ticker id, timestamp[, revision]) as packed
+        binary keys in a Bloom filter; no per-row key strings are built.
+        Ticker ids are assigned in first-seen order and saved next to the
+        filter, so a resumed filter maps tickers the same way.
+
+        Args:
+            expected_bars: Filter capacity (default: bloom_filter.expected_elements)
+            false_positive_rate: Filter FPR (default: bloom_filter.false_positive_rate)
+            filter_path: Resume from a filter saved with save()
+        """
+        if BarDeduplicator is None:
+            raise RuntimeError("BarIngest requires the quantamental C++ module")
+        config = get_config()['bloom_filter']
+
+        if filter_path is not None:
+            self.dedup = BarDeduplicator.with_filter_file(filter_path)
+            if self.dedup is None:
+                raise IOError(f"Could not load dedup filter {filter_path}")
+            tickers = Path(filter_path + '.tickers').read_text().split()
+        else:
+            self.dedup = BarDeduplicator(expected_bars or config['expected_elements'],
+                                         false_positive_rate or config['false_positive_rate'])
+            tickers = []
+        self.tickers: List[str] = tickers
+        self._ticker_ids: Dict[str, int] = {t: i for i, t in enumerate(tickers)}
+
+        logger.info(f"BarIngest initialized ({self.dedup!r})")
+
+    def ticker_id(self, ticker: str) -> int:
+        """Stable integer id of a ticker, assigned on first use."""
+        if ticker not in self._ticker_ids:
+            self._ticker_ids[ticker] = len(self.tickers)
+            self.tickers.append(ticker)
+        return self._ticker_ids[ticker]
+
+    def ingest(self, data: Dict[str, pd.DataFrame],
+               revision_column: Optional[str] = None) -> Dict[str, pd.DataFrame]:
+        """
+        Keep only the bars not seen before. With revision_column set (e.g. a
+        vendor sequence number), a bar seen with a different revision is a
+        correction and is kept; a repeat of the same revision is dropped.
+
+        Args:
+            data: Dictionary mapping tickers to OHLCV DataFrames
+            revision_column: Integer column telling corrected bars apart
+
+        Returns:
+            Dictionary of the kept bars per ticker (tickers with none omitted)
+        """
+        frames = {t: df for t, df in data.items() if len(df)}
+        if not frames:
+            return {}
+
+        ticker_ids = np.concatenate([np.full(len(df), self.ticker_id(t), dtype=np.uint32)
+                                     for t, df in frames.items()])
+        timestamps = np.concatenate([pd.DatetimeIndex(df.index).asi8 for df in frames.values()])
+        values = np.concatenate([df[OHLCV_FIELDS].to_numpy(dtype=np.float64) for df in frames.values()])
+        revisions = None
+        if revision_column is not None:
+            revisions = np.concatenate([df[revision_column].to_numpy(dtype=np.int64)
+                                        for df in frames.values()])
+
+        kept = self.dedup.ingest(ticker_ids, timestamps, values, revisions=revisions)
+
+        # asi8 is UTC nanoseconds; restore the input's timezone
+        index = pd.DatetimeIndex(kept['timestamps'], name='Date')
+        tz = pd.DatetimeIndex(next(iter(frames.values())).index).tz
+        if tz is not None:
+            index = index.tz_localize('UTC').tz_convert(tz)
+        columns = pd.DataFrame(kept['values'], columns=OHLCV_FIELDS, index=index)
+        if revision_column is not None:
+            columns[revision_column] = kept['revisions']
+        result = {self.tickers[i]: group for i, group in columns.groupby(kept['ticker_ids'], sort=False)}
+
+        status = kept['status']
+        logger.info(f"Ingested {len(status)} bars: "
+                    f"{int((status == int(BarDeduplicator.Status.New)).sum())} new, "
+                    f"{int((status == int(BarDeduplicator.Status.Revised)).sum())} revised")
+        return result
+
+    def save(self, filepath: str) -> None:
+        """Save the filter and ticker ids; resume with BarIngest(filter_path=filepath)."""
+        if not self.dedup.filter().save_to_file(filepath):
+            raise IOError(f"Could not save dedup filter {filepath}")
+        Path(filepath + '.tickers').write_text('\n'.join(self.tickers))
@@ -4,5 +4,8 @@ Features package for technical analysis indicators.
 This package provides technical analysis features like SMA, RSI, etc.
 """
 from .technical import TechnicalFeatures
+from .cross_section import CrossSectionalFeatures
+from .labels import ForwardLabels
+from .risk import RollingRisk
 
-__all__ = ['TechnicalFeatures']
\ No newline at end of file
+__all__ = ['TechnicalFeatures', 'CrossSectionalFeatures', 'ForwardLabels', 'RollingRisk']
\ No newline at end of file
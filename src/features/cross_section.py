@@ -0,0 +1,73 @@
+import numpy as np
+import pandas as pd
+
+from src.utils.logger import get_logger
+
+try:
+    from quantamental import (cross_sectional_demean, cross_sectional_rank,
+                              cross_sectional_winsorize, cross_sectional_zscore)
+    NATIVE = True
+except ImportError:  # C++ module not built; fall back to pandas
+    NATIVE = False
+
+logger = get_logger(__name__)
+
+class CrossSectionalFeatures:
+    """
+    Per-date transforms across tickers of a wide (dates x tickers) feature
+    frame, e.g. one frame of TechnicalFeatures.compute_panel. NaN marks a
+    missing value: it is left out of each date's statistics and stays NaN.
+    The C++ kernels are used when available (threaded across dates, no
+    copy of float64 input); the pandas fallback gives the same values.
+    """
+
+    def __init__(self, num_threads: int = 0):
+        self.num_threads = num_threads
+        logger.info(f"CrossSectionalFeatures initialized (native kernels: {NATIVE})")
+
+    def _wrap(self, values: np.ndarray, df: pd.DataFrame) -> pd.DataFrame:
+        return pd.DataFrame(values, index=df.index, columns=df.columns, copy=False)
+
+    def zscore(self, df: pd.DataFrame) -> pd.DataFrame:
+        """
+        (x - date mean) / date std, std with ddof=1.
+        """
+        if NATIVE:
+            return self._wrap(cross_sectional_zscore(df.to_numpy(dtype=np.float64),
+                                                     num_threads=self.num_threads), df)
+        std = df.std(axis=1)
+        result = df.sub(df.mean(axis=1), axis=0).div(std.where(std > 0), axis=0)
+        return result
+
+    def rank(self, df: pd.DataFrame, pct: bool = False) -> pd.DataFrame:
+        """
+        Rank within each date, ties averaged (DataFrame.rank(axis=1)).
+        """
+        if NATIVE:
+            return self._wrap(cross_sectional_rank(df.to_numpy(dtype=np.float64), pct=pct,
+                                                   num_threads=self.num_threads), df)
+        return df.rank(axis=1, pct=pct)
+
+    def winsorize(self, df: pd.DataFrame, lower: float = 0.01, upper: float = 0.99) -> pd.DataFrame:
+        """
+        Clip each date to its lower / upper quantiles.
+        """
+        if NATIVE:
+            return self._wrap(cross_sectional_winsorize(df.to_numpy(dtype=np.float64),
+                                                        lower=lower, upper=upper,
+                                                        num_threads=self.num_threads), df)
+        quantiles = df.quantile([lower, upper], axis=1)
+        return df.clip(lower=quantiles.loc[lower], upper=quantiles.loc[upper], axis=0)
+
+    def sector_neutral(self, df: pd.DataFrame, sectors: pd.Series) -> pd.DataFrame:
+        """
+        Subtract each date's sector mean. sectors maps ticker -> sector;
+        tickers without a sector come out NaN.
+        """
+        codes, _ = pd.factorize(sectors.reindex(df.columns))
+        if NATIVE:
+            return self._wrap(cross_sectional_demean(df.to_numpy(dtype=np.float64), codes,
+                                                     num_threads=self.num_threads), df)
+        groups = pd.Series(codes, index=df.columns).where(codes >= 0)
+        means = df.T.groupby(groups).transform('mean').T
+        return df - means
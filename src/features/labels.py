@@ -0,0 +1,51 @@
+from typing import List, Optional
+import numpy as np
+import pandas as pd
+
+from src.utils.config import get_config
+from src.utils.logger import get_logger
+
+try:
+    from quantamental import LabelBuilder
+except ImportError:  # C++ module not built
+    LabelBuilder = None
+
+logger = get_logger(__name__)
+
+class ForwardLabels:
+    def __init__(self, vol_window: int = 20):
+        """
+        Forecast targets for features.horizons: forward simple, log,
+        vol-scaled and benchmark-excess returns.
+        """
+        if LabelBuilder is None:
+            raise RuntimeError("ForwardLabels requires the quantamental C++ module")
+        config = get_config()
+
+        self.horizons = config['features']['horizons']
+        self.builder = LabelBuilder(horizons=self.horizons, vol_window=vol_window)
+
+        logger.info(f"ForwardLabels initialized ({len(self.columns)} labels)")
+
+    @property
+    def columns(self) -> List[str]:
+        return self.builder.columns()
+
+    def build(self, close: pd.DataFrame, benchmark: Optional[pd.Series] = None,
+              end: Optional[pd.Timestamp] = None, num_threads: int = 0) -> np.ndarray:
+        """
+        Labels for a wide (dates x tickers) close frame as one contiguous
+        (labels, dates, tickers) float64 tensor, in self.columns order.
+        Tickers missing a date hold NaN there. With end set (e.g. the last
+        training date), labels that would look past it are NaN.
+        """
+        bench = None
+        if benchmark is not None:
+            bench = benchmark.reindex(close.index).to_numpy(dtype=np.float64)
+
+        known = None
+        if end is not None:
+            known = int(close.index.searchsorted(end, side='right'))
+
+        return self.builder.build(close.to_numpy(dtype=np.float64), benchmark=bench,
+                                  num_known_dates=known, num_threads=num_threads)
@@ -0,0 +1,98 @@
+from typing import List, Optional, Sequence
+import numpy as np
+import pandas as pd
+
+from src.utils.config import get_config
+from src.utils.logger import get_logger
+
+try:
+    from quantamental import RollingCovariance
+except ImportError:  # C++ module not built
+    RollingCovariance = None
+
+logger = get_logger(__name__)
+
+KINDS = ('covariance', 'correlation', 'shrunk')
+
+class RollingRisk:
+    def __init__(self, tickers: Sequence[str], windows: Optional[List[int]] = None,
+                 min_periods: int = 2):
+        """
+        Rolling covariance / correlation matrices of the universe over
+        features.risk_windows, updated a date at a time. Tickers missing a
+        date (NaN) are left out of the pairs they belong to for that date.
+        """
+        if RollingCovariance is None:
+            raise RuntimeError("RollingRisk requires the quantamental C++ module")
+        if windows is None:
+            windows = get_config()['features'].get('risk_windows', [20, 60, 120])
+
+        self.tickers = list(tickers)
+        self.windows = [int(w) for w in windows]
+        self.engine = RollingCovariance(len(self.tickers), self.windows, min_periods)
+
+        logger.info(f"RollingRisk initialized ({len(self.tickers)} tickers, windows {self.windows}, "
+                    f"{self.engine.memory_bytes() / 1e6:.1f} MB, {RollingCovariance.backend()})")
+
+    def update(self, returns: pd.DataFrame, num_threads: int = 0) -> None:
+        """Feed a wide (dates x tickers) returns frame, or one date as a Series."""
+        if isinstance(returns, pd.Series):
+            returns = returns.to_frame().T
+        values = returns.reindex(columns=self.tickers).to_numpy(dtype=np.float64)
+        self.engine.update(values, num_threads=num_threads)
+
+    def matrix(self, window: int, kind: str = 'covariance', shrinkage: float = 0.1,
+               out: Optional[np.ndarray] = None, num_threads: int = 0) -> np.ndarray:
+        """
+        Current (tickers, tickers) matrix for a window length in self.windows.
+        kind 'shrunk' blends the covariance toward constant correlation by
+        shrinkage. out= writes into an existing float64 array instead.
+        """
+        index = self._window_index(window)
+        if kind == 'covariance':
+            return self.engine.covariance(index, out=out, num_threads=num_threads)
+        if kind == 'correlation':
+            return self.engine.correlation(index, out=out, num_threads=num_threads)
+        if kind == 'shrunk':
+            return self.engine.shrunk_covariance(index, shrinkage, out=out, num_threads=num_threads)
+        raise ValueError(f"kind must be one of {KINDS}")
+
+    def frame(self, window: int, kind: str = 'covariance', shrinkage: float = 0.1) -> pd.DataFrame:
+        return pd.DataFrame(self.matrix(window, kind, shrinkage), index=self.tickers, columns=self.tickers)
+
+    def snapshots(self, returns: pd.DataFrame, window: int, kind: str = 'covariance',
+                  dates: Optional[Sequence[pd.Timestamp]] = None, shrinkage: float = 0.1,
+                  num_threads: int = 0) -> np.ndarray:
+        """
+        Feed returns and take the matrix as of each date in dates (default:
+        every date of returns) into one contiguous (dates, tickers, tickers)
+        float64 array. Dates between snapshots go through in one batch.
+        """
+        if kind not in KINDS:
+            raise ValueError(f"kind must be one of {KINDS}")
+        self._window_index(window)
+        values = returns.reindex(columns=self.tickers).to_numpy(dtype=np.float64)
+        if dates is None:
+            ends = np.arange(1, len(returns) + 1)
+        else:
+            ends = returns.index.searchsorted(pd.DatetimeIndex(dates), side='right')
+
+        n = len(self.tickers)
+        stack = np.empty((len(ends), n, n), dtype=np.float64)
+        fed = 0
+        for k, end in enumerate(ends):
+            if end < fed:
+                raise ValueError("dates must be ascending")
+            if end > fed:
+                self.engine.update(values[fed:end], num_threads=num_threads)
+                fed = end
+            self.matrix(window, kind, shrinkage, out=stack[k], num_threads=num_threads)
+        if fed < len(values):
+            self.engine.update(values[fed:], num_threads=num_threads)
+        return stack
+
+    def _window_index(self, window: int) -> int:
+        try:
+            return self.windows.index(int(window))
+        except ValueError:
+            raise ValueError(f"window {window} is not one of {self.windows}") from None
@@ -5,6 +5,12 @@ import pandas as pd
 from src.utils.config import get_config
 from src.utils.logger import get_logger
 
+try:
+    from quantamental import IndicatorEngine, IndicatorState
+except ImportError:  # C++ module not built; fall back to pandas
+    IndicatorEngine = None
+    IndicatorState = None
+
 logger = get_logger(__name__)
 
 class TechnicalFeatures:
@@ -19,7 +25,13 @@ class TechnicalFeatures:
         self.sma_windows = config['features']['sma_windows']
         self.rsi_period = config['features']['rsi_period']
 
-        logger.info("TechnicalFeatures initialized")
+        self.engine = None
+        if IndicatorEngine is not None:
+            self.engine = IndicatorEngine(horizons=self.horizons,
+                                          sma_windows=self.sma_windows,
+                                          rsi_period=self.rsi_period)
+
+        logger.info(f"TechnicalFeatures initialized (native engine: {self.engine is not None})")
 
     def compute_returns(self, df: pd.DataFrame, windows: List[int] = None) -> pd.DataFrame:
         """
@@ -142,7 +154,11 @@ class TechnicalFeatures:
         """
         Compute all technical features and concatenate into single DataFrame.
         Includes: returns, SMA, EMA, RSI, MACD, volatility, volume features.
+        Uses the C++ IndicatorEngine (one pass, same values) when available.
         """
+        if self.engine is not None:
+            return self.compute_all_native(df)
+
         features = [
             self.compute_returns(df),
             self.compute_sma(df),
@@ -154,4 +170,64 @@ class TechnicalFeatures:
         ]
 
         result = pd.concat(features, axis=1)
-        return result
\ No newline at end of file
+        return result
+
+    def compute_all_native(self, df: pd.DataFrame) -> pd.DataFrame:
+        """
+        compute_all through the C++ IndicatorEngine in a single fused pass.
+        The engine fills one (num_columns, n) array; the DataFrame wraps its
+        transpose without copying.
+        """
+        close = df['Close'].to_numpy(dtype=np.float64)
+        volume = df['Volume'].to_numpy(dtype=np.float64)
+
+        values = self.engine.compute(close, volume)
+        return pd.DataFrame(values.T, index=df.index, columns=self.engine.columns(), copy=False)
+
+    def new_state(self) -> "IndicatorState":
+        """
+        Empty per-ticker IndicatorState for these windows, to be fed by
+        update_all and kept on disk with save_to_file / load_from_file.
+        """
+        if IndicatorState is None:
+            raise RuntimeError("IndicatorState requires the quantamental C++ module")
+        return IndicatorState(horizons=self.horizons,
+                              sma_windows=self.sma_windows,
+                              rsi_period=self.rsi_period)
+
+    def update_all(self, state: "IndicatorState", df: pd.DataFrame) -> pd.DataFrame:
+        """
+        Incremental compute_all for the daily job. Appends the bars of df
+        after state.last_timestamp() (df may repeat history already applied)
+        and returns their feature rows, equal to compute_all's rows for the
+        full history. The cost depends on the number of new bars only.
+        """
+        timestamps = pd.DatetimeIndex(df.index).asi8
+        last = state.last_timestamp()
+        if last is not None:
+            new_bars = timestamps > last
+            df = df[new_bars]
+            timestamps = timestamps[new_bars]
+
+        close = df['Close'].to_numpy(dtype=np.float64)
+        volume = df['Volume'].to_numpy(dtype=np.float64)
+
+        values = state.append_batch(timestamps, close, volume)
+        return pd.DataFrame(values.T, index=df.index, columns=state.columns(), copy=False)
+
+    def compute_panel(self, close: pd.DataFrame, volume: pd.DataFrame,
+                      num_threads: int = 0) -> dict:
+        """
+        compute_all for a whole universe at once. close and volume are wide
+        (dates x tickers) frames on the same index and columns; a NaN close
+        means the ticker has no bar that date. Returns {feature: DataFrame}
+        of dates x tickers, each a view into the engine's output.
+        """
+        if self.engine is None:
+            raise RuntimeError("compute_panel requires the quantamental C++ module")
+        volume = volume.reindex(index=close.index, columns=close.columns)
+        values = self.engine.compute_panel(close.to_numpy(dtype=np.float64),
+                                           volume.to_numpy(dtype=np.float64),
+                                           num_threads=num_threads)
+        return {name: pd.DataFrame(values[c], index=close.index, columns=close.columns, copy=False)
+                for c, name in enumerate(self.engine.columns())}
@@ -0,0 +1,12 @@
+from .backtest import Backtest
+from .client import InferenceClient, InferenceError
+from .inference import export_mlp, load_engine, max_abs_difference
+
+__all__ = [
+    "Backtest",
+    "InferenceClient",
+    "InferenceError",
+    "export_mlp",
+    "load_engine",
+    "max_abs_difference",
+]
@@ -0,0 +1,94 @@
+"""
+Backtest model scores with the native cross-sectional backtester.
+"""
+
+import itertools
+from typing import Any, Dict, Iterable, List, Mapping, Optional, Tuple
+import numpy as np
+import pandas as pd
+
+from src.utils.config import get_config
+from src.utils.logger import get_logger
+
+try:
+    from quantamental import BacktestConfig, Backtester, Weighting
+except ImportError:  # C++ module not built
+    BacktestConfig = Backtester = Weighting = None
+
+logger = get_logger(__name__)
+
+_WEIGHTINGS = ('top_bottom', 'rank', 'vol_scaled')
+
+class Backtest:
+    def __init__(self, scores: pd.DataFrame, returns: pd.DataFrame,
+                 volatility: Optional[pd.DataFrame] = None,
+                 ic_target: Optional[pd.DataFrame] = None, num_threads: int = 0):
+        """
+        Daily-rebalanced backtest of wide (dates x tickers) model scores.
+
+        returns[d] is what a position held from d earns until the next
+        rebalance (e.g. the fwd_return_1d label); returns, volatility and
+        ic_target are aligned to the scores' dates and tickers. Scores are
+        sorted and the daily IC computed once here, so run() and sweep()
+        only walk the weights.
+        """
+        if Backtester is None:
+            raise RuntimeError("Backtest requires the quantamental C++ module")
+        self.defaults = get_config().get('backtest', {})
+        self.index = scores.index
+        self.columns = scores.columns
+
+        def panel(frame: Optional[pd.DataFrame]) -> Optional[np.ndarray]:
+            if frame is None:
+                return None
+            return frame.reindex(index=self.index, columns=self.columns).to_numpy(dtype=np.float64)
+
+        self.backtester = Backtester(scores.to_numpy(dtype=np.float64), panel(returns),
+                                     volatility=panel(volatility), ic_target=panel(ic_target),
+                                     num_threads=num_threads)
+        logger.info(f"Backtest initialized ({len(self.index)} dates x {len(self.columns)} tickers)")
+
+    def config(self, weighting: str = 'top_bottom', **params: Any) -> 'BacktestConfig':
+        """
+        BacktestConfig for a weighting ('top_bottom', 'rank' or 'vol_scaled')
+        and overrides of top_k, long_only, gross_exposure, cost_bps and
+        max_turnover; the rest come from the backtest config section.
+        """
+        if weighting not in _WEIGHTINGS:
+            raise ValueError(f"weighting must be one of {_WEIGHTINGS}")
+        values = {key: self.defaults[key] for key in ('top_k', 'cost_bps', 'max_turnover')
+                  if key in self.defaults}
+        values.update(params)
+        kind = {'top_bottom': Weighting.TopBottom, 'rank': Weighting.Rank,
+                'vol_scaled': Weighting.VolScaled}[weighting]
+        return BacktestConfig(weighting=kind, **values)
+
+    def run(self, weighting: str = 'top_bottom', **params: Any) -> Tuple[Dict[str, float], pd.DataFrame]:
+        """
+        Summary metrics and the per-date series (net_return, gross_return,
+        turnover, drawdown, ic, rank_ic) of one config
+        """
+        summary, series = self.backtester.run(self.config(weighting, **params))
+        frame = pd.DataFrame(series, index=self.index)
+        frame['ic'] = self.backtester.ic()
+        frame['rank_ic'] = self.backtester.rank_ic()
+        return summary.to_dict(), frame
+
+    def sweep(self, grid: Mapping[str, Iterable[Any]]) -> pd.DataFrame:
+        """
+        Summary metrics for every combination of a parameter grid, e.g.
+        {'weighting': ['top_bottom', 'rank'], 'top_k': [20, 50]}, run
+        across threads. One row per combination, parameters first.
+        """
+        keys = list(grid)
+        combos: List[Dict[str, Any]] = [dict(zip(keys, values))
+                                        for values in itertools.product(*(grid[k] for k in keys))]
+        configs = [self.config(**combo) for combo in combos]
+        summaries, _ = self.backtester.sweep(configs)
+        return pd.DataFrame([{**combo, **summary.to_dict()}
+                             for combo, summary in zip(combos, summaries)])
+
+    def ic(self) -> pd.DataFrame:
+        """Daily IC and rank IC of the scores against ic_target"""
+        return pd.DataFrame({'ic': self.backtester.ic(), 'rank_ic': self.backtester.rank_ic()},
+                            index=self.index)
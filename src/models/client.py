@@ -0,0 +1,147 @@
+"""
+Client for the native inference server (cpp/tools/inference_server.cpp, or
+InferenceServer.start in-process).
+"""
+
+import itertools
+import socket
+import struct
+from collections import deque
+from typing import Dict, Optional, Sequence, Tuple
+import numpy as np
+
+from src.utils.config import get_config
+from src.utils.logger import get_logger
+
+logger = get_logger(__name__)
+
+# Wire format from cpp/include/inference_server.hpp (native byte order)
+_REQUEST = struct.Struct('=IHHQII')   # magic, version, kind, request_id, ticker, num_features
+_RESPONSE = struct.Struct('=IHHQII')  # magic, status, num_outputs, request_id, queue_us, compute_us
+_REQUEST_MAGIC = 0x464E4951
+_RESPONSE_MAGIC = 0x534E4951
+_VERSION = 1
+_SCORE, _SCORE_CACHED = 0, 1
+_OK, _BAD_REQUEST, _NOT_CACHED, _BUSY = 0, 1, 2, 3
+_MAX_IN_FLIGHT = 256
+
+class InferenceError(RuntimeError):
+    """The server rejected a request or broke the protocol."""
+
+class InferenceClient:
+    """Score feature vectors through the inference server's socket."""
+
+    def __init__(self, socket_path: Optional[str] = None, timeout: float = 5.0):
+        """
+        Args:
+            socket_path: Server socket (default: inference.socket_path)
+            timeout: Seconds to wait on the socket before giving up
+        """
+        self.socket_path = socket_path or get_config()['inference']['socket_path']
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.settimeout(timeout)
+        self.sock.connect(self.socket_path)
+        self._ids = itertools.count()
+        self.last_queue_us = 0
+        self.last_compute_us = 0
+
+    def score(self, features: np.ndarray) -> np.ndarray:
+        """Forecasts (one per horizon) for one float32 feature vector."""
+        return self.score_many(np.asarray(features, dtype=np.float32).reshape(1, -1))[0]
+
+    def score_cached(self, ticker_id: int) -> Optional[np.ndarray]:
+        """
+        Forecasts for a ticker whose features the server reads from its
+        FeatureCache row ticker_id; None if that row was never written.
+        """
+        outputs, found = self.score_cached_many([ticker_id])
+        return outputs[0] if found[0] else None
+
+    def score_many(self, features: np.ndarray) -> np.ndarray:
+        """
+        Score a (rows, input_dim) batch as single-row requests, all sent
+        before the first reply is read, so the server batches them with
+        whatever else is in flight.
+        """
+        features = np.ascontiguousarray(features, dtype=np.float32)
+        if features.ndim != 2:
+            raise ValueError("features must be 2-D (rows, input_dim)")
+        frames = [_REQUEST.pack(_REQUEST_MAGIC, _VERSION, _SCORE, 0, 0, features.shape[1]) + row.tobytes()
+                  for row in features]
+        results = self._round_trip(frames)
+        return np.stack([results[i][1] for i in range(len(frames))]) if frames else np.empty((0, 0), np.float32)
+
+    def score_cached_many(self, ticker_ids: Sequence[int]) -> Tuple[np.ndarray, np.ndarray]:
+        """
+        Score tickers from the server's feature cache. Returns (outputs,
+        found): rows whose cache entry was never written are NaN and
+        False in found.
+        """
+        frames = [_REQUEST.pack(_REQUEST_MAGIC, _VERSION, _SCORE_CACHED, 0, int(t), 0) for t in ticker_ids]
+        results = self._round_trip(frames)
+        found = np.array([results[i][0] == _OK for i in range(len(frames))], dtype=bool)
+        width = max((len(results[i][1]) for i in range(len(frames))), default=0)
+        outputs = np.full((len(frames), width), np.nan, dtype=np.float32)
+        for i in np.flatnonzero(found):
+            outputs[i] = results[i][1]
+        return outputs, found
+
+    def _round_trip(self, frames) -> Dict[int, Tuple[int, np.ndarray]]:
+        """
+        Send every frame, keeping at most _MAX_IN_FLIGHT unanswered so
+        neither side's socket buffer fills, and resend those the server
+        answered Busy. Returns {frame index: (status, outputs)}.
+        """
+        results: Dict[int, Tuple[int, np.ndarray]] = {}
+        queue = deque(range(len(frames)))
+        in_flight: Dict[int, int] = {}   # request_id -> frame index
+        while queue or in_flight:
+            while queue and len(in_flight) < _MAX_IN_FLIGHT:
+                index = queue.popleft()
+                request_id = next(self._ids)
+                in_flight[request_id] = index
+                # request_id sits at bytes 8:16 of the header
+                frame = frames[index]
+                self.sock.sendall(frame[:8] + struct.pack('=Q', request_id) + frame[16:])
+
+            status, request_id, outputs = self._read_response()
+            index = in_flight.pop(request_id, None)
+            if index is None:
+                raise InferenceError(f"Unexpected response id {request_id}")
+            if status == _BUSY:
+                logger.debug("Server busy, resending request")
+                queue.append(index)
+            elif status == _BAD_REQUEST:
+                raise InferenceError("Server rejected the request (feature count or ticker id "
+                                     "does not match the model / feature cache)")
+            else:
+                results[index] = (status, outputs)
+        return results
+
+    def _read_response(self) -> Tuple[int, int, np.ndarray]:
+        header = self._recv_exact(_RESPONSE.size)
+        magic, status, num_outputs, request_id, queue_us, compute_us = _RESPONSE.unpack(header)
+        if magic != _RESPONSE_MAGIC:
+            raise InferenceError("Bad response header")
+        self.last_queue_us, self.last_compute_us = queue_us, compute_us
+        outputs = np.frombuffer(self._recv_exact(4 * num_outputs), dtype=np.float32)
+        return status, request_id, outputs
+
+    def _recv_exact(self, size: int) -> bytes:
+        chunks, remaining = [], size
+        while remaining > 0:
+            chunk = self.sock.recv(remaining)
+            if not chunk:
+                raise InferenceError("Server closed the connection")
+            chunks.append(chunk)
+            remaining -= len(chunk)
+        return b''.join(chunks)
+
+    def close(self) -> None:
+        self.sock.close()
+
+    def __enter__(self) -> 'InferenceClient':
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
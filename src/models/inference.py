@@ -0,0 +1,82 @@
+"""
+Export PyTorch MLPs to the C++ inference engine and check they agree.
+"""
+
+from typing import List, Optional
+import numpy as np
+import torch
+from torch import nn
+
+from src.utils.config import get_config
+from src.utils.logger import get_logger
+
+try:
+    from quantamental import MlpEngine, MlpModel
+except ImportError:  # C++ module not built
+    MlpEngine = MlpModel = None
+
+logger = get_logger(__name__)
+
+def _require_module():
+    if MlpModel is None:
+        raise RuntimeError("C++ inference requires the quantamental C++ module")
+
+def export_mlp(model: nn.Module, filepath: str, horizons: Optional[List[int]] = None) -> None:
+    """
+    Save a PyTorch MLP in the engine's weight format.
+
+    The model's leaf modules, in registration order, must be nn.Linear layers
+    each optionally followed by one ReLU, Tanh or Sigmoid (Dropout and
+    Identity are skipped, as in eval mode). The last Linear needs one output
+    per horizon.
+
+    Args:
+        model: e.g. an nn.Sequential
+        filepath: Output file (e.g. 'models/mlp.qmlp')
+        horizons: Forecast horizons of the outputs (default: features.horizons)
+    """
+    _require_module()
+    if horizons is None:
+        horizons = get_config()['features']['horizons']
+
+    activations = {nn.ReLU: MlpModel.Activation.ReLU, nn.Tanh: MlpModel.Activation.Tanh,
+                   nn.Sigmoid: MlpModel.Activation.Sigmoid}
+    weights, biases, layer_activations = [], [], []
+    for module in model.modules():
+        if isinstance(module, nn.Linear):
+            weights.append(module.weight.detach().cpu().numpy().astype(np.float32))
+            bias = module.bias
+            biases.append(np.zeros(module.out_features, np.float32) if bias is None
+                          else bias.detach().cpu().numpy().astype(np.float32))
+            layer_activations.append(MlpModel.Activation.Identity)
+        elif type(module) in activations:
+            if not weights or layer_activations[-1] != MlpModel.Activation.Identity:
+                raise ValueError(f"{type(module).__name__} must directly follow a Linear layer")
+            layer_activations[-1] = activations[type(module)]
+        elif len(list(module.children())) == 0 and not isinstance(module, (nn.Dropout, nn.Identity)):
+            raise ValueError(f"Unsupported module for C++ inference: {type(module).__name__}")
+
+    MlpModel(horizons, weights, biases, layer_activations).save_to_file(filepath)
+    logger.info(f"Exported {len(weights)}-layer MLP to {filepath}")
+
+def load_engine(filepath: str, num_threads: int = 0) -> 'MlpEngine':
+    """Load an exported model into an engine with its arena preallocated."""
+    _require_module()
+    model = MlpModel.load_from_file(filepath)
+    if model is None:
+        raise IOError(f"Could not load model {filepath}")
+    engine = MlpEngine(model, num_threads=num_threads)
+    logger.info(f"Loaded {model!r} ({MlpModel.backend()} kernels, {engine.arena_bytes()} arena bytes)")
+    return engine
+
+def max_abs_difference(model: nn.Module, engine: 'MlpEngine', x: np.ndarray) -> float:
+    """
+    Largest absolute difference between the PyTorch model (in eval mode)
+    and the engine on the same float32 batch. Summation order differs, so
+    expect float32 rounding noise (~1e-6), not zero.
+    """
+    x = np.ascontiguousarray(x, dtype=np.float32)
+    model.eval()
+    with torch.no_grad():
+        expected = model(torch.from_numpy(x)).cpu().numpy()
+    return float(np.max(np.abs(engine.predict(x) - expected)))